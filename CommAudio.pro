@@ -25,23 +25,77 @@ DEFINES += QT_DEPRECATED_WARNINGS
 CONFIG += c++11
 
 SOURCES += \
+        audiocodec.cpp \
         audiodevice.cpp \
+        callsession.cpp \
+        capturering.cpp \
+        channelmanager.cpp \
         client.cpp \
+        conferencebridge.cpp \
         connectiondevice.cpp \
+        datagramio.cpp \
+        decodeahead.cpp \
+        driftcompensator.cpp \
+        fanout.cpp \
+        fec.cpp \
+        formatconverter.cpp \
         filehandler.cpp \
+        latencymeter.cpp \
+        lossconcealer.cpp \
         main.cpp \
         mainwindow.cpp \
         mediahandler.cpp \
-        server.cpp
+        nackscheduler.cpp \
+        packetpool.cpp \
+        playbackring.cpp \
+        receivering.cpp \
+        retransmitbuffer.cpp \
+        sampleconvert.cpp \
+        server.cpp \
+        sockettuner.cpp \
+        streamchannel.cpp \
+        streampacket.cpp \
+        streamrelay.cpp \
+        streamreceiver.cpp \
+        tracksource.cpp \
+        voiceactivity.cpp \
+        wavheader.cpp
 
 HEADERS += \
+        audiocodec.h \
         audiodevice.h \
+        callsession.h \
+        capturering.h \
+        channelmanager.h \
         client.h \
+        conferencebridge.h \
         connectiondevice.h \
+        datagramio.h \
+        decodeahead.h \
+        driftcompensator.h \
+        fanout.h \
+        fec.h \
+        formatconverter.h \
         filehandler.h \
+        latencymeter.h \
+        lossconcealer.h \
         mainwindow.h \
         mediahandler.h \
-        server.h
+        nackscheduler.h \
+        packetpool.h \
+        playbackring.h \
+        receivering.h \
+        retransmitbuffer.h \
+        sampleconvert.h \
+        server.h \
+        sockettuner.h \
+        streamchannel.h \
+        streampacket.h \
+        streamrelay.h \
+        streamreceiver.h \
+        tracksource.h \
+        voiceactivity.h \
+        wavheader.h
 
 FORMS += \
         mainwindow.ui
@@ -62,6 +116,6 @@ DISTFILES += \
 RESOURCES += \
     icons.qrc
 
-win32:LIBS += -lWS2_32
+win32:LIBS += -lWS2_32 -liphlpapi
 
 #
@@ -0,0 +1,806 @@
+/*------------------------------------------------------------------------------------------------------------------
+-- SOURCE FILE: 	audiocodec.cpp - Compresses 16 bit PCM for the stream and for voice calls.
+--
+--
+-- PROGRAM: 		Communication Audio Program
+--
+-- FUNCTIONS:
+--                  AudioCodec *create(uint8_t id, const StreamDescriptor &format)
+--                  bool supports(uint8_t id, const StreamDescriptor &format)
+--                  const char *getName(uint8_t id)
+--                  double getMicrosPerSecond(const Statistics &stats)
+--                  static int runFromArguments(int argc, char *argv[])
+--                  static QString benchmark(int seconds)
+--                  AudioCodec(uint8_t id, const StreamDescriptor &format)
+--                  int encode(const char *pcm, int bytes, char *out, Statistics *stats)
+--                  int decode(const char *data, int bytes, char *pcm, int capacity, Statistics *stats)
+--                  G711Codec(uint8_t id, const StreamDescriptor &format)
+--                  int G711Codec::encodeSamples(const char *pcm, int samples, char *out)
+--                  void G711Codec::decodeSamples(const char *data, int samples, char *pcm)
+--                  ImaAdpcmCodec(const StreamDescriptor &format)
+--                  ~ImaAdpcmCodec()
+--                  int ImaAdpcmCodec::getEncodedSize(int pcmBytes) const
+--                  int ImaAdpcmCodec::getDecodedSize(int codedBytes) const
+--                  int ImaAdpcmCodec::encodeSamples(const char *pcm, int samples, char *out)
+--                  void ImaAdpcmCodec::decodeSamples(const char *data, int samples, char *pcm)
+--
+-- DATE: 			October 19, 2026
+--
+-- REVISIONS:       October 19, 2026 - Add --codec-bench, the cost and quality of each codec - agent
+--
+-- DESIGNER: 		agent
+--
+-- PROGRAMMER: 		agent
+--
+-- NOTES:
+--      A codec sits between the audio source and the packetizer on the sending side and between the receiver
+--      and the player on the listening side. The codec id travels in the stream descriptor, or in every voice
+--      packet, so the listener always knows how to decode what it gets. Raw PCM is CODEC_PCM and has no codec
+--      object at all.
+--
+--      G.711 u-law and A-law turn each 16 bit sample into one byte (2:1). Both directions are a single table
+--      lookup per sample. The encode tables are indexed by the top 14 (u-law) or 13 (A-law) bits of the
+--      sample, which are the only bits the G.711 encoders look at, so the lookup gives exactly the same result
+--      as the reference bit twiddling. The tables are built the first time a G.711 codec is created.
+--
+--      IMA-ADPCM turns each sample into 4 bits (about 4:1). Every call to encode() produces a block that
+--      starts with the predictor and step index of each channel, the same way WAV IMA-ADPCM blocks do, so
+--      every packet decodes on its own and a lost packet does not break the ones after it.
+--
+--      Both work on 16 bit samples, signed or unsigned, in the byte order of the machine, which is little
+--      endian like WAV files and the QAudioFormat the players use. encode() and decode() time themselves with
+--      the performance counter when given a Statistics, so the cost of a codec per second of audio can be
+--      shown next to the other stream statistics. --codec-bench measures the same figures headless for every
+--      codec, along with the signal to noise ratio each one leaves.
+--
+--------------------------------------------------------------------------------------------------------------------*/
+#include "audiocodec.h"
+#include <cmath>
+#include <cstdlib>
+#include <vector>
+
+static const int16_t imaStepTable[IMA_ADPCM_STEPS] = {
+    7, 8, 9, 10, 11, 12, 13, 14, 16, 17, 19, 21, 23, 25, 28, 31, 34, 37, 41, 45, 50, 55, 60, 66, 73, 80, 88,
+    97, 107, 118, 130, 143, 157, 173, 190, 209, 230, 253, 279, 307, 337, 371, 408, 449, 494, 544, 598, 658,
+    724, 796, 876, 963, 1060, 1166, 1282, 1411, 1552, 1707, 1878, 2066, 2272, 2499, 2749, 3024, 3327, 3660,
+    4026, 4428, 4871, 5358, 5894, 6484, 7132, 7845, 8630, 9493, 10442, 11487, 12635, 13899, 15289, 16818,
+    18500, 20350, 22385, 24623, 27086, 29794, 32767
+};
+
+static const int8_t imaIndexTable[16] = {
+    -1, -1, -1, -1, 2, 4, 6, 8, -1, -1, -1, -1, 2, 4, 6, 8
+};
+
+static int linearToUlaw(int sample) {
+    static const int segmentEnd[8] = {0x3F, 0x7F, 0xFF, 0x1FF, 0x3FF, 0x7FF, 0xFFF, 0x1FFF};
+    int mask = 0xFF;
+    int segment = 0;
+    sample >>= 2;
+    if (sample < 0) {
+        sample = -sample;
+        mask = 0x7F;
+    }
+    if (sample > 8159) {
+        sample = 8159;
+    }
+    sample += 0x21;
+    while (segment < 8 && sample > segmentEnd[segment]) {
+        segment++;
+    }
+    if (segment >= 8) {
+        return 0x7F ^ mask;
+    }
+    return ((segment << 4) | ((sample >> (segment + 1)) & 0x0F)) ^ mask;
+}
+
+static int ulawToLinear(int value) {
+    value = ~value;
+    int t = (((value & 0x0F) << 3) + 0x84) << ((value & 0x70) >> 4);
+    return (value & 0x80) ? (0x84 - t) : (t - 0x84);
+}
+
+static int linearToAlaw(int sample) {
+    static const int segmentEnd[8] = {0x1F, 0x3F, 0x7F, 0xFF, 0x1FF, 0x3FF, 0x7FF, 0xFFF};
+    int mask = 0xD5;
+    int segment = 0;
+    sample >>= 3;
+    if (sample < 0) {
+        mask = 0x55;
+        sample = -sample - 1;
+    }
+    while (segment < 8 && sample > segmentEnd[segment]) {
+        segment++;
+    }
+    if (segment >= 8) {
+        return 0x7F ^ mask;
+    }
+    int value = segment << 4;
+    value |= (segment < 2 ? (sample >> 1) : (sample >> segment)) & 0x0F;
+    return value ^ mask;
+}
+
+static int alawToLinear(int value) {
+    value ^= 0x55;
+    int t = (value & 0x0F) << 4;
+    int segment = (value & 0x70) >> 4;
+    if (segment == 0) {
+        t += 8;
+    } else {
+        t += 0x108;
+        if (segment > 1) {
+            t <<= segment - 1;
+        }
+    }
+    return (value & 0x80) ? t : -t;
+}
+
+struct G711Tables {
+    uint8_t ulawEncode[1 << 14];
+    uint8_t alawEncode[1 << 13];
+    int16_t ulawDecode[256];
+    int16_t alawDecode[256];
+
+    G711Tables() {
+        for (int i = 0; i < (1 << 14); i++) {
+            ulawEncode[i] = (uint8_t)linearToUlaw((int16_t)(uint16_t)(i << 2));
+        }
+        for (int i = 0; i < (1 << 13); i++) {
+            alawEncode[i] = (uint8_t)linearToAlaw((int16_t)(uint16_t)(i << 3));
+        }
+        for (int i = 0; i < 256; i++) {
+            ulawDecode[i] = (int16_t)ulawToLinear(i);
+            alawDecode[i] = (int16_t)alawToLinear(i);
+        }
+    }
+};
+
+static const G711Tables &getG711Tables() {
+    static const G711Tables tables;
+    return tables;
+}
+
+static uint64_t readCounter() {
+    LARGE_INTEGER counter;
+    QueryPerformanceCounter(&counter);
+    return (uint64_t)counter.QuadPart;
+}
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	create
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	AudioCodec *create(uint8_t id, const StreamDescriptor &format)
+--                                 id - an AudioCodecId
+--                                 format - PCM format the codec encodes from and decodes to
+--
+-- RETURNS:     Returns a new codec, or nullptr for CODEC_PCM and for formats the codec cannot handle
+--
+-------------------------------------------------------------------------------------------------------------------*/
+AudioCodec *AudioCodec::create(uint8_t id, const StreamDescriptor &format) {
+    if (id == CODEC_PCM || !supports(id, format)) {
+        return nullptr;
+    }
+    if (id == CODEC_IMA_ADPCM) {
+        return new ImaAdpcmCodec(format);
+    }
+    return new G711Codec(id, format);
+}
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	supports
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	bool supports(uint8_t id, const StreamDescriptor &format)
+--                            id - an AudioCodecId
+--                            format - PCM format to encode
+--
+-- RETURNS:     Returns true if audio in this format can be sent with the codec
+--
+-- NOTES:
+--              Every codec handles 16 bit integer samples. Anything else can only be sent as PCM.
+--
+-------------------------------------------------------------------------------------------------------------------*/
+bool AudioCodec::supports(uint8_t id, const StreamDescriptor &format) {
+    if (id == CODEC_PCM) {
+        return true;
+    }
+    return id < CODEC_COUNT && format.sampleSize == 16 && format.sampleType != SAMPLE_FLOAT &&
+            format.channels > 0 && format.frameSize == 2 * format.channels;
+}
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	getName
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	const char *getName(uint8_t id)
+--                                  id - an AudioCodecId
+--
+-- RETURNS:     Returns the name of the codec for the statistics
+--
+-------------------------------------------------------------------------------------------------------------------*/
+const char *AudioCodec::getName(uint8_t id) {
+    switch (id) {
+    case CODEC_PCM:
+        return "PCM";
+    case CODEC_ULAW:
+        return "G.711 u-law";
+    case CODEC_ALAW:
+        return "G.711 A-law";
+    case CODEC_IMA_ADPCM:
+        return "IMA-ADPCM";
+    default:
+        return "unknown";
+    }
+}
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	getMicrosPerSecond
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	double getMicrosPerSecond(const Statistics &stats)
+--                                        stats - statistics filled in by encode() or decode()
+--
+-- RETURNS:     Returns the microseconds of CPU time spent per second of audio
+--
+-------------------------------------------------------------------------------------------------------------------*/
+double AudioCodec::getMicrosPerSecond(const Statistics &stats) {
+    LARGE_INTEGER frequency;
+    QueryPerformanceFrequency(&frequency);
+    if (stats.audioMicros == 0 || frequency.QuadPart == 0) {
+        return 0;
+    }
+    double busyMicros = stats.busyTicks * 1000000.0 / frequency.QuadPart;
+    return busyMicros * 1000000.0 / stats.audioMicros;
+}
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	runFromArguments
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	static int runFromArguments(int argc, char *argv[])
+--                          argc - number of command line arguments
+--                          argv - the command line arguments
+--
+-- RETURNS:     The process exit code
+--
+-- NOTES:
+--              The form is
+--                  --codec-bench [seconds of audio]
+--              The benchmark prints its result and returns.
+--
+-------------------------------------------------------------------------------------------------------------------*/
+int AudioCodec::runFromArguments(int argc, char *argv[]) {
+    if (strcmp(argv[1], "--codec-bench") != 0) {
+        qDebug() << "Usage: --codec-bench [seconds of audio]\n";
+        return 1;
+    }
+    int seconds = argc >= 3 ? atoi(argv[2]) : CODEC_BENCH_SECONDS;
+    qDebug() << benchmark(seconds > 0 ? seconds : CODEC_BENCH_SECONDS);
+    return 0;
+}
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	benchmark
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	static QString benchmark(int seconds)
+--                                seconds - length of the audio put through each codec
+--
+-- RETURNS:     A summary of every codec in both formats
+--
+-- NOTES:
+--              Every codec encodes and decodes seconds of two tones with a little noise, CODEC_BENCH_PACKET_MS
+--              at a time as a call or stream would, in the players' 8 kHz unsigned stereo and in 44.1 kHz
+--              signed stereo. The cost comes from the same Statistics the stream reports, as microseconds of
+--              work per second of audio. The bit rate counts the coded bytes only, and the signal to noise
+--              ratio compares the decoded audio with what went in.
+--
+-------------------------------------------------------------------------------------------------------------------*/
+QString AudioCodec::benchmark(int seconds) {
+    StreamDescriptor formats[2] = {
+        { 8000, 2, 16, SAMPLE_UNSIGNED, CODEC_PCM, 4 },
+        { 44100, 2, 16, SAMPLE_SIGNED, CODEC_PCM, 4 }
+    };
+    QString summary = QString("Codec benchmark, %1 s of audio in %2 ms packets")
+            .arg(seconds)
+            .arg(CODEC_BENCH_PACKET_MS);
+    for (const StreamDescriptor &format : formats) {
+        int frames = (int)(format.sampleRate * CODEC_BENCH_PACKET_MS / 1000);
+        int packets = seconds * 1000 / CODEC_BENCH_PACKET_MS;
+        uint16_t signFlip = format.sampleType == SAMPLE_UNSIGNED ? 0x8000 : 0;
+        std::vector<int16_t> input((size_t)frames * format.channels);
+        std::vector<char> pcm(input.size() * 2);
+        std::vector<char> coded(AUDIO_DECODE_MAX);
+        std::vector<char> decoded(AUDIO_DECODE_MAX);
+        summary.append(QString(" | %1 Hz:").arg(format.sampleRate));
+        for (uint8_t id = CODEC_ULAW; id < CODEC_COUNT; id++) {
+            AudioCodec *codec = create(id, format);
+            if (codec == nullptr) {
+                continue;
+            }
+            Statistics encoding;
+            Statistics decoding;
+            double signal = 0;
+            double noise = 0;
+            uint32_t random = 1;
+            for (int packet = 0; packet < packets; packet++) {
+                for (int i = 0; i < frames; i++) {
+                    double t = (double)(packet * frames + i) / format.sampleRate;
+                    random = random * 1103515245 + 12345;
+                    int16_t sample = (int16_t)(6000 * sin(2 * 3.14159265358979 * 440 * t) +
+                                               3000 * sin(2 * 3.14159265358979 * 1250 * t) +
+                                               (int)((random >> 16) % 601) - 300);
+                    for (int c = 0; c < format.channels; c++) {
+                        input[i * format.channels + c] = sample;
+                        uint16_t value = (uint16_t)sample ^ signFlip;
+                        memcpy(&pcm[(i * format.channels + c) * 2], &value, 2);
+                    }
+                }
+                int codedBytes = codec->encode(pcm.data(), (int)pcm.size(), coded.data(), &encoding);
+                int length = codec->decode(coded.data(), codedBytes, decoded.data(), (int)decoded.size(), &decoding);
+                for (int i = 0; i < length / 2 && i < (int)input.size(); i++) {
+                    uint16_t value;
+                    memcpy(&value, &decoded[i * 2], 2);
+                    double error = (double)(int16_t)(value ^ signFlip) - input[i];
+                    signal += (double)input[i] * input[i];
+                    noise += error * error;
+                }
+            }
+            summary.append(QString(" %1 %2 kbit/s, encode %3 us/s, decode %4 us/s, SNR %5 dB;")
+                           .arg(getName(id))
+                           .arg(encoding.codedBytes * 8.0 / seconds / 1000, 0, 'f', 0)
+                           .arg(getMicrosPerSecond(encoding), 0, 'f', 1)
+                           .arg(getMicrosPerSecond(decoding), 0, 'f', 1)
+                           .arg(noise > 0 ? 10 * log10(signal / noise) : 0, 0, 'f', 1));
+            delete codec;
+        }
+    }
+    return summary;
+}
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	AudioCodec
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	AudioCodec(uint8_t id, const StreamDescriptor &format)
+--                         id - the AudioCodecId of the subclass
+--                         format - PCM format the codec encodes from and decodes to
+--
+-- RETURNS:     NA
+--
+-- NOTES:
+--              Unsigned samples are turned into signed ones by flipping the top bit.
+--
+-------------------------------------------------------------------------------------------------------------------*/
+AudioCodec::AudioCodec(uint8_t id, const StreamDescriptor &format) : id(id), channels(format.channels) {
+    byteRate = format.sampleRate * format.frameSize;
+    signFlip = format.sampleType == SAMPLE_UNSIGNED ? 0x8000 : 0;
+}
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	encode
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	int encode(const char *pcm, int bytes, char *out, Statistics *stats)
+--                         pcm - whole frames of PCM
+--                         bytes - number of PCM bytes
+--                         out - destination, must hold getEncodedSize(bytes) bytes
+--                         stats - time and byte counters to add to, or nullptr
+--
+-- RETURNS:     Returns the number of encoded bytes
+--
+-------------------------------------------------------------------------------------------------------------------*/
+int AudioCodec::encode(const char *pcm, int bytes, char *out, Statistics *stats) {
+    uint64_t start = stats ? readCounter() : 0;
+    int length = encodeSamples(pcm, bytes / 2, out);
+    if (stats) {
+        stats->busyTicks += readCounter() - start;
+        stats->audioMicros += byteRate ? (uint64_t)bytes * 1000000 / byteRate : 0;
+        stats->pcmBytes += bytes;
+        stats->codedBytes += length;
+    }
+    return length;
+}
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	decode
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	int decode(const char *data, int bytes, char *pcm, int capacity, Statistics *stats)
+--                         data - encoded audio, as produced by one call to encode()
+--                         bytes - number of encoded bytes
+--                         pcm - destination for the decoded samples
+--                         capacity - size of pcm in bytes
+--                         stats - time and byte counters to add to, or nullptr
+--
+-- RETURNS:     Returns the number of PCM bytes, or -1 if the data is malformed or does not fit
+--
+-------------------------------------------------------------------------------------------------------------------*/
+int AudioCodec::decode(const char *data, int bytes, char *pcm, int capacity, Statistics *stats) {
+    int length = getDecodedSize(bytes);
+    if (length < 0 || length > capacity) {
+        return -1;
+    }
+    uint64_t start = stats ? readCounter() : 0;
+    decodeSamples(data, length / 2, pcm);
+    if (stats) {
+        stats->busyTicks += readCounter() - start;
+        stats->audioMicros += byteRate ? (uint64_t)length * 1000000 / byteRate : 0;
+        stats->pcmBytes += length;
+        stats->codedBytes += bytes;
+    }
+    return length;
+}
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	G711Codec
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	G711Codec(uint8_t id, const StreamDescriptor &format)
+--                        id - CODEC_ULAW or CODEC_ALAW
+--                        format - PCM format the codec encodes from and decodes to
+--
+-- RETURNS:     NA
+--
+-------------------------------------------------------------------------------------------------------------------*/
+G711Codec::G711Codec(uint8_t id, const StreamDescriptor &format) : AudioCodec(id, format) {
+    const G711Tables &tables = getG711Tables();
+    if (id == CODEC_ALAW) {
+        encodeTable = tables.alawEncode;
+        encodeShift = 3;
+        decodeTable = tables.alawDecode;
+    } else {
+        encodeTable = tables.ulawEncode;
+        encodeShift = 2;
+        decodeTable = tables.ulawDecode;
+    }
+}
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	encodeSamples
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	int encodeSamples(const char *pcm, int samples, char *out)
+--                                pcm - 16 bit samples
+--                                samples - number of samples
+--                                out - destination, one byte per sample
+--
+-- RETURNS:     Returns the number of encoded bytes
+--
+-------------------------------------------------------------------------------------------------------------------*/
+int G711Codec::encodeSamples(const char *pcm, int samples, char *out) {
+    for (int i = 0; i < samples; i++) {
+        out[i] = (char)encodeTable[(uint16_t)readSample(pcm + 2 * i) >> encodeShift];
+    }
+    return samples;
+}
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	decodeSamples
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	void decodeSamples(const char *data, int samples, char *pcm)
+--                                 data - one byte per sample
+--                                 samples - number of samples
+--                                 pcm - destination for the 16 bit samples
+--
+-- RETURNS:     void
+--
+-------------------------------------------------------------------------------------------------------------------*/
+void G711Codec::decodeSamples(const char *data, int samples, char *pcm) {
+    for (int i = 0; i < samples; i++) {
+        writeSample(pcm + 2 * i, decodeTable[(uint8_t)data[i]]);
+    }
+}
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	ImaAdpcmCodec
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	ImaAdpcmCodec(const StreamDescriptor &format)
+--                            format - PCM format the codec encodes from and decodes to
+--
+-- RETURNS:     NA
+--
+-- NOTES:
+--              The step index of each channel carries on from one block to the next so the encoder does not
+--              have to adapt again at the start of every packet.
+--
+-------------------------------------------------------------------------------------------------------------------*/
+ImaAdpcmCodec::ImaAdpcmCodec(const StreamDescriptor &format) : AudioCodec(CODEC_IMA_ADPCM, format) {
+    stepIndex = new int[channels]();
+}
+
+ImaAdpcmCodec::~ImaAdpcmCodec() {
+    delete[] stepIndex;
+}
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	getEncodedSize
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	int getEncodedSize(int pcmBytes) const
+--                                 pcmBytes - number of PCM bytes to encode
+--
+-- RETURNS:     Returns the size of the encoded block
+--
+-- NOTES:
+--              Block layout: one header per channel of predictor(2) stepIndex(1) reserved(1), then one nibble
+--              per sample in frame order, low nibble first.
+--
+-------------------------------------------------------------------------------------------------------------------*/
+int ImaAdpcmCodec::getEncodedSize(int pcmBytes) const {
+    return IMA_ADPCM_CHANNEL_HEADER * channels + (pcmBytes / 2 + 1) / 2;
+}
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	getDecodedSize
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	int getDecodedSize(int codedBytes) const
+--                                 codedBytes - size of an encoded block
+--
+-- RETURNS:     Returns the number of PCM bytes in the block, or -1 if it is too short to be one
+--
+-- NOTES:
+--              A mono block with an odd number of samples ends in a padding nibble, which decodes to one extra
+--              sample. Senders avoid this by encoding an even number of frames.
+--
+-------------------------------------------------------------------------------------------------------------------*/
+int ImaAdpcmCodec::getDecodedSize(int codedBytes) const {
+    int nibbles = (codedBytes - IMA_ADPCM_CHANNEL_HEADER * channels) * 2;
+    if (nibbles < 0) {
+        return -1;
+    }
+    return nibbles / channels * channels * 2;
+}
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	encodeSamples
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	int encodeSamples(const char *pcm, int samples, char *out)
+--                                pcm - whole frames of 16 bit samples
+--                                samples - number of samples
+--                                out - destination, must hold getEncodedSize(2 * samples) bytes
+--
+-- RETURNS:     Returns the number of encoded bytes
+--
+-- NOTES:
+--              Each channel's predictor starts at its first sample. The step table lookup and the three
+--              compare and subtract steps are the standard IMA encoder.
+--
+-------------------------------------------------------------------------------------------------------------------*/
+int ImaAdpcmCodec::encodeSamples(const char *pcm, int samples, char *out) {
+    int predictor[256];
+    char *nibbles = out + IMA_ADPCM_CHANNEL_HEADER * channels;
+    for (int c = 0; c < channels; c++) {
+        predictor[c] = c < samples ? readSample(pcm + 2 * c) : 0;
+        char *header = out + IMA_ADPCM_CHANNEL_HEADER * c;
+        header[0] = (char)(predictor[c] & 0xFF);
+        header[1] = (char)((predictor[c] >> 8) & 0xFF);
+        header[2] = (char)stepIndex[c];
+        header[3] = 0;
+    }
+    memset(nibbles, 0, (samples + 1) / 2);
+
+    for (int i = 0, c = 0; i < samples; i++) {
+        int step = imaStepTable[stepIndex[c]];
+        int diff = readSample(pcm + 2 * i) - predictor[c];
+        int nibble = 0;
+        if (diff < 0) {
+            nibble = 8;
+            diff = -diff;
+        }
+        int delta = step >> 3;
+        if (diff >= step) {
+            nibble |= 4;
+            diff -= step;
+            delta += step;
+        }
+        step >>= 1;
+        if (diff >= step) {
+            nibble |= 2;
+            diff -= step;
+            delta += step;
+        }
+        step >>= 1;
+        if (diff >= step) {
+            nibble |= 1;
+            delta += step;
+        }
+        predictor[c] += (nibble & 8) ? -delta : delta;
+        if (predictor[c] > 32767) {
+            predictor[c] = 32767;
+        } else if (predictor[c] < -32768) {
+            predictor[c] = -32768;
+        }
+        stepIndex[c] += imaIndexTable[nibble];
+        if (stepIndex[c] < 0) {
+            stepIndex[c] = 0;
+        } else if (stepIndex[c] >= IMA_ADPCM_STEPS) {
+            stepIndex[c] = IMA_ADPCM_STEPS - 1;
+        }
+        nibbles[i >> 1] |= (char)(nibble << ((i & 1) * 4));
+        if (++c == channels) {
+            c = 0;
+        }
+    }
+    return IMA_ADPCM_CHANNEL_HEADER * channels + (samples + 1) / 2;
+}
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	decodeSamples
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	void decodeSamples(const char *data, int samples, char *pcm)
+--                                 data - an encoded block
+--                                 samples - number of samples in the block
+--                                 pcm - destination for the 16 bit samples
+--
+-- RETURNS:     void
+--
+-- NOTES:
+--              Decoding only uses the block's own headers, so blocks can be decoded in any order or skipped.
+--
+-------------------------------------------------------------------------------------------------------------------*/
+void ImaAdpcmCodec::decodeSamples(const char *data, int samples, char *pcm) {
+    int predictor[256];
+    int index[256];
+    const unsigned char *nibbles = (const unsigned char *)data + IMA_ADPCM_CHANNEL_HEADER * channels;
+    for (int c = 0; c < channels; c++) {
+        const unsigned char *header = (const unsigned char *)data + IMA_ADPCM_CHANNEL_HEADER * c;
+        predictor[c] = (int16_t)(uint16_t)(header[0] | (header[1] << 8));
+        index[c] = header[2] < IMA_ADPCM_STEPS ? header[2] : IMA_ADPCM_STEPS - 1;
+    }
+
+    for (int i = 0, c = 0; i < samples; i++) {
+        int nibble = (nibbles[i >> 1] >> ((i & 1) * 4)) & 0x0F;
+        int step = imaStepTable[index[c]];
+        int delta = step >> 3;
+        if (nibble & 4) {
+            delta += step;
+        }
+        if (nibble & 2) {
+            delta += step >> 1;
+        }
+        if (nibble & 1) {
+            delta += step >> 2;
+        }
+        predictor[c] += (nibble & 8) ? -delta : delta;
+        if (predictor[c] > 32767) {
+            predictor[c] = 32767;
+        } else if (predictor[c] < -32768) {
+            predictor[c] = -32768;
+        }
+        index[c] += imaIndexTable[nibble];
+        if (index[c] < 0) {
+            index[c] = 0;
+        } else if (index[c] >= IMA_ADPCM_STEPS) {
+            index[c] = IMA_ADPCM_STEPS - 1;
+        }
+        writeSample(pcm + 2 * i, (int16_t)predictor[c]);
+        if (++c == channels) {
+            c = 0;
+        }
+    }
+}
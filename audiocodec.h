@@ -0,0 +1,93 @@
+#pragma once
+#include <windows.h>
+#include <cstdint>
+#include <cstring>
+#include <QDebug>
+#include <QString>
+#include "streampacket.h"
+
+#define AUDIO_DECODE_MAX (4 * STREAM_PAYLOAD_SIZE)
+#define IMA_ADPCM_CHANNEL_HEADER 4
+#define IMA_ADPCM_STEPS 89
+#define CODEC_BENCH_SECONDS 60
+#define CODEC_BENCH_PACKET_MS 20
+
+class AudioCodec {
+public:
+    struct Statistics {
+        uint64_t audioMicros = 0;
+        uint64_t busyTicks = 0;
+        uint64_t pcmBytes = 0;
+        uint64_t codedBytes = 0;
+    };
+
+    static AudioCodec *create(uint8_t id, const StreamDescriptor &format);
+    static bool supports(uint8_t id, const StreamDescriptor &format);
+    static const char *getName(uint8_t id);
+    static double getMicrosPerSecond(const Statistics &stats);
+    static int runFromArguments(int argc, char *argv[]);
+    static QString benchmark(int seconds);
+    virtual ~AudioCodec() = default;
+
+    int encode(const char *pcm, int bytes, char *out, Statistics *stats = nullptr);
+    int decode(const char *data, int bytes, char *pcm, int capacity, Statistics *stats = nullptr);
+    virtual int getEncodedSize(int pcmBytes) const = 0;
+    virtual int getDecodedSize(int codedBytes) const = 0;
+
+    uint8_t getId() const {
+        return id;
+    }
+
+protected:
+    AudioCodec(uint8_t id, const StreamDescriptor &format);
+    virtual int encodeSamples(const char *pcm, int samples, char *out) = 0;
+    virtual void decodeSamples(const char *data, int samples, char *pcm) = 0;
+
+    int16_t readSample(const char *pcm) const {
+        uint16_t value;
+        memcpy(&value, pcm, 2);
+        return (int16_t)(value ^ signFlip);
+    }
+    void writeSample(char *pcm, int16_t sample) const {
+        uint16_t value = (uint16_t)sample ^ signFlip;
+        memcpy(pcm, &value, 2);
+    }
+
+    uint8_t id;
+    int channels;
+    uint32_t byteRate;
+    uint16_t signFlip;
+};
+
+class G711Codec : public AudioCodec {
+public:
+    G711Codec(uint8_t id, const StreamDescriptor &format);
+    int getEncodedSize(int pcmBytes) const override {
+        return pcmBytes / 2;
+    }
+    int getDecodedSize(int codedBytes) const override {
+        return codedBytes * 2;
+    }
+
+private:
+    const uint8_t *encodeTable;
+    int encodeShift;
+    const int16_t *decodeTable;
+
+    int encodeSamples(const char *pcm, int samples, char *out) override;
+    void decodeSamples(const char *data, int samples, char *pcm) override;
+};
+
+class ImaAdpcmCodec : public AudioCodec {
+public:
+    ImaAdpcmCodec(const StreamDescriptor &format);
+    ~ImaAdpcmCodec();
+    int getEncodedSize(int pcmBytes) const override;
+    int getDecodedSize(int codedBytes) const override;
+
+private:
+    int *stepIndex;
+
+    int encodeSamples(const char *pcm, int samples, char *out) override;
+    void decodeSamples(const char *data, int samples, char *pcm) override;
+};
@@ -1,11 +1,27 @@
 #include "audiodevice.h"
 
+static StreamDescriptor describe(const QAudioFormat &format) {
+    StreamDescriptor descriptor = {};
+    descriptor.sampleRate = (uint32_t)format.sampleRate();
+    descriptor.channels = (uint8_t)format.channelCount();
+    descriptor.sampleSize = (uint8_t)format.sampleSize();
+    if (format.sampleType() == QAudioFormat::Float) {
+        descriptor.sampleType = SAMPLE_FLOAT;
+    } else if (format.sampleType() == QAudioFormat::UnSignedInt) {
+        descriptor.sampleType = SAMPLE_UNSIGNED;
+    } else {
+        descriptor.sampleType = SAMPLE_SIGNED;
+    }
+    descriptor.frameSize = (uint16_t)(descriptor.channels * descriptor.sampleSize / 8);
+    return descriptor;
+}
+
 /*-----------------------------------------------------------------------------------------------------------------
 -- Function:    AudioDevice
 --
 -- DATE:		March  23, 2020
 --
--- REVISIONS:   NA
+-- REVISIONS:   October 19, 2026 - Create the ring the player pulls received audio from - agent
 --
 -- DESIGNER: 	Ellaine Chan
 --
@@ -36,13 +52,42 @@ AudioDevice::AudioDevice(QObject *parent)
         qWarning() << "Raw audio format not supported by backend, cannot play audio.";
     }
 
+    outputFormat = format;
     player = new QAudioOutput(format);
     mic = new QAudioInput(format, this);
+    playRing = new PlaybackRing();
+    playRing->setFormat(describe(format));
 
     connect(player, &QAudioOutput::stateChanged, this, &AudioDevice::handleStateChanged);
     connect(mic, SIGNAL(stateChanged(QAudio::State)), this, SLOT(handleMicStateChanged(QAudio::State)));
 }
 
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:    ~AudioDevice
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:   NA
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:   ~AudioDevice()
+--
+-- RETURNS:     NA
+--
+-- NOTES:
+--
+-- Stops and deletes the player before the playback ring it pulls from.
+-------------------------------------------------------------------------------------------------------------------*/
+AudioDevice::~AudioDevice() {
+    disconnect(player, &QAudioOutput::stateChanged, this, &AudioDevice::handleStateChanged);
+    player->stop();
+    delete player;
+    delete playRing;
+}
+
 //! Device Play  -------------------------------------------------------------------
 
 /*-----------------------------------------------------------------------------------------------------------------
@@ -79,7 +124,7 @@ void AudioDevice::playFile(QString filename) {
 --
 -- DATE:		March  23, 2020
 --
--- REVISIONS:   NA
+-- REVISIONS:   October 19, 2026 - Start the player on the thread that owns it - agent
 --
 -- DESIGNER: 	Ellaine Chan
 --
@@ -91,11 +136,45 @@ void AudioDevice::playFile(QString filename) {
 --
 -- NOTES:
 --
--- Sets up the audio device to start playing for a buffer instead of a file.
+-- Sets up the audio device to start playing for a buffer instead of a file. The network threads call this, so
+-- startPlayback is called on the thread that owns the player and this waits for it to finish.
 -------------------------------------------------------------------------------------------------------------------*/
 void AudioDevice::playFromBuffer() {
+    if (QThread::currentThread() == thread()) {
+        startPlayback();
+        return;
+    }
+    QMetaObject::invokeMethod(this, "startPlayback", Qt::BlockingQueuedConnection);
+}
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:    startPlayback
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:   NA
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:   void startPlayback()
+--
+-- RETURNS:     NA
+--
+-- NOTES:
+--
+-- Starts the player pulling from the playback ring, emptied first. Audio added from then on is played in order.
+-------------------------------------------------------------------------------------------------------------------*/
+void AudioDevice::startPlayback() {
+    player->stop();
+    playRing->clear();
+    if (!playRing->isOpen()) {
+        playRing->open(QIODevice::ReadOnly | QIODevice::Unbuffered);
+    }
     player->setBufferSize(DATA_BUFSIZE);
-    device = player->start();
+    player->start(playRing);
+    pushing = true;
 }
 
 /*-----------------------------------------------------------------------------------------------------------------
@@ -121,8 +200,270 @@ void AudioDevice::playFromBufferSilent() {
     serverStreaming = true;
     serverFirstPass = true;
     player->setVolume(0);
+    startPlayback();
+}
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:    requestStreamFormat
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:   NA
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:   void requestStreamFormat(const StreamDescriptor &format)
+--                                       format - format announced for the stream
+--
+-- RETURNS:     NA
+--
+-- NOTES:
+--
+-- Calls setStreamFormat on the thread that owns the player and waits for it to finish, so the caller can write
+-- samples in the new format as soon as this returns.
+-------------------------------------------------------------------------------------------------------------------*/
+void AudioDevice::requestStreamFormat(const StreamDescriptor &format) {
+    if (QThread::currentThread() == thread()) {
+        setStreamFormat(format.sampleRate, format.channels, format.sampleSize, format.sampleType);
+        return;
+    }
+    QMetaObject::invokeMethod(this, "setStreamFormat", Qt::BlockingQueuedConnection,
+                              Q_ARG(int, (int)format.sampleRate), Q_ARG(int, format.channels),
+                              Q_ARG(int, format.sampleSize), Q_ARG(int, format.sampleType));
+}
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:    requestFlush
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:   NA
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:   void requestFlush()
+--
+-- RETURNS:     NA
+--
+-- NOTES:
+--
+-- Calls flushPlayBuffer on the thread that owns the player and waits for it to finish, so the next samples
+-- written are the next ones heard.
+-------------------------------------------------------------------------------------------------------------------*/
+void AudioDevice::requestFlush() {
+    if (QThread::currentThread() == thread()) {
+        flushPlayBuffer();
+        return;
+    }
+    QMetaObject::invokeMethod(this, "flushPlayBuffer", Qt::BlockingQueuedConnection);
+}
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:    requestCapture
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:   NA
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:   void requestCapture(CaptureRing *ring)
+--                                  ring - ring the microphone audio is written into
+--
+-- RETURNS:     NA
+--
+-- NOTES:
+--
+-- Calls startCapture on the thread that owns the microphone and waits for it to finish.
+-------------------------------------------------------------------------------------------------------------------*/
+void AudioDevice::requestCapture(CaptureRing *ring) {
+    if (QThread::currentThread() == thread()) {
+        startCapture(ring);
+        return;
+    }
+    QMetaObject::invokeMethod(this, "startCapture", Qt::BlockingQueuedConnection, Q_ARG(QIODevice*, ring));
+}
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:    requestStopCapture
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:   NA
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:   void requestStopCapture()
+--
+-- RETURNS:     NA
+--
+-- NOTES:
+--
+-- Calls stopCapture on the thread that owns the microphone and waits for it to finish, so the ring can be freed
+-- as soon as this returns.
+-------------------------------------------------------------------------------------------------------------------*/
+void AudioDevice::requestStopCapture() {
+    if (QThread::currentThread() == thread()) {
+        stopCapture();
+        return;
+    }
+    QMetaObject::invokeMethod(this, "stopCapture", Qt::BlockingQueuedConnection);
+}
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:    getInputFormat
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:   October 19, 2026 - Share the conversion with getOutputFormat - agent
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:   StreamDescriptor getInputFormat() const
+--
+-- RETURNS:     Returns the format the microphone records in, as PCM
+--
+-- NOTES:
+--
+-- Used to describe recorded audio in voice packets.
+-------------------------------------------------------------------------------------------------------------------*/
+StreamDescriptor AudioDevice::getInputFormat() const {
+    return describe(mic->format());
+}
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:    getOutputFormat
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:   NA
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:   StreamDescriptor getOutputFormat() const
+--
+-- RETURNS:     Returns the format the player plays, as PCM
+--
+-- NOTES:
+--
+-- This is the stream's format unless the sound card cannot play it, in which case audio must be converted to
+-- this format before it is written.
+-------------------------------------------------------------------------------------------------------------------*/
+StreamDescriptor AudioDevice::getOutputFormat() const {
+    return describe(outputFormat);
+}
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:    setStreamFormat
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:   October 19, 2026 - Fall back to the nearest format the sound card plays - agent
+--              October 19, 2026 - Restart on the playback ring, emptied of the old format - agent
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:   void setStreamFormat(int sampleRate, int channels, int sampleSize, int sampleType)
+--                                   sampleRate - samples per second
+--                                   channels - number of interleaved channels
+--                                   sampleSize - bits per sample
+--                                   sampleType - a StreamSampleType value
+--
+-- RETURNS:     NA
+--
+-- NOTES:
+--
+-- Changes the format the player expects. QAudioOutput cannot change format once created, so the player is
+-- replaced and, if it was playing from a buffer, restarted in the same mode with the same volume. This is a slot
+-- so the network threads can call it with a blocking queued connection and the player is only ever touched
+-- from the thread that owns it. If the sound card cannot play the format, the player is set up in the nearest
+-- format it can play and the caller converts the audio (see getOutputFormat).
+-------------------------------------------------------------------------------------------------------------------*/
+void AudioDevice::setStreamFormat(int sampleRate, int channels, int sampleSize, int sampleType) {
+    QAudioFormat format = outputFormat;
+    format.setSampleRate(sampleRate);
+    format.setChannelCount(channels);
+    format.setSampleSize(sampleSize);
+    if (sampleType == SAMPLE_FLOAT) {
+        format.setSampleType(QAudioFormat::Float);
+    } else if (sampleType == SAMPLE_UNSIGNED) {
+        format.setSampleType(QAudioFormat::UnSignedInt);
+    } else {
+        format.setSampleType(QAudioFormat::SignedInt);
+    }
+    QAudioDeviceInfo info(QAudioDeviceInfo::defaultOutputDevice());
+    if (!info.isFormatSupported(format)) {
+        qWarning() << "Stream format not supported by backend, converting to the nearest supported format.";
+        format = info.nearestFormat(format);
+    }
+    if (format == outputFormat) {
+        return;
+    }
+
+    qreal volume = player->volume();
+    bool restart = pushing;
+    disconnect(player, &QAudioOutput::stateChanged, this, &AudioDevice::handleStateChanged);
+    player->stop();
+    delete player;
+
+    outputFormat = format;
+    player = new QAudioOutput(format);
+    player->setVolume(volume);
+    connect(player, &QAudioOutput::stateChanged, this, &AudioDevice::handleStateChanged);
+    playRing->setFormat(describe(format));
+    playRing->clear();
+    if (restart) {
+        serverFirstPass = serverStreaming;
+        player->setBufferSize(DATA_BUFSIZE);
+        player->start(playRing);
+    }
+}
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:    flushPlayBuffer
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:   October 19, 2026 - Empty the playback ring too - agent
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:   void flushPlayBuffer()
+--
+-- RETURNS:     NA
+--
+-- NOTES:
+--
+-- Drops the audio written to the player that has not been played yet, for when the stream jumps to another
+-- place in the track. The player is restarted in the same mode, the way setStreamFormat does.
+-------------------------------------------------------------------------------------------------------------------*/
+void AudioDevice::flushPlayBuffer() {
+    if (!pushing) {
+        return;
+    }
+    disconnect(player, &QAudioOutput::stateChanged, this, &AudioDevice::handleStateChanged);
+    player->reset();
+    connect(player, &QAudioOutput::stateChanged, this, &AudioDevice::handleStateChanged);
+    playRing->clear();
+    serverFirstPass = serverStreaming;
     player->setBufferSize(DATA_BUFSIZE);
-    device = player->start();
+    player->start(playRing);
 }
 
 /*-----------------------------------------------------------------------------------------------------------------
@@ -130,25 +471,115 @@ void AudioDevice::playFromBufferSilent() {
 --
 -- DATE:		March  23, 2020
 --
--- REVISIONS:   NA
+-- REVISIONS:   October 19, 2026 - Push into the playback ring instead of writing to the player - agent
+--              October 19, 2026 - One writer per device again - agent
 --
 -- DESIGNER: 	Ellaine Chan
 --
 -- PROGRAMMER: 	Ellaine Chan
 --
--- INTERFACE:   void addToPlayBuffer(QByteArray buffer)
+-- INTERFACE:   void addToPlayBuffer(const char *data, int length)
+--                                   data - whole frames of audio in the player's format
+--                                   length - size of the audio
 --
 -- RETURNS:     NA
 --
 -- NOTES:
 --
--- Writes new audio data for the device to play.
+-- Writes new audio data for the device to play. Only one thread may add audio to a device, so the stream and a
+-- call each play through their own, and the audio is copied, so the caller can reuse its buffer straight away.
+-------------------------------------------------------------------------------------------------------------------*/
+void AudioDevice::addToPlayBuffer(const char *data, int length) {
+    playRing->push(data, length);
+}
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:    getPlayBufferFill
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:   October 19, 2026 - Count the audio waiting in the playback ring - agent
+--              October 19, 2026 - Count only the playback ring - agent
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:   int getPlayBufferFill() const
+--
+-- RETURNS:     Returns how many bytes added to the playback ring have not been taken by the player yet
+--
+-- NOTES:
+--
+-- Used to see whether the stream arrives faster or slower than the player plays it. In pull mode the player
+-- keeps its own buffer topped up from the ring, so that part is always full and says nothing about the drift;
+-- only the ring's fill moves.
+-------------------------------------------------------------------------------------------------------------------*/
+int AudioDevice::getPlayBufferFill() const {
+    return (int)playRing->getFill();
+}
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:    getPlayBufferSize
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:   NA
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:   int getPlayBufferSize() const
+--
+-- RETURNS:     Returns the size of the player's buffer in bytes
+--
+-- NOTES:
+--
+-- The backend may pick a different size than the one asked for in playFromBuffer, so this is the real one.
+-------------------------------------------------------------------------------------------------------------------*/
+int AudioDevice::getPlayBufferSize() const {
+    return player->bufferSize();
+}
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:    getPlaybackStatistics
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:   NA
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:   PlaybackRing::Statistics getPlaybackStatistics() const
+--
+-- RETURNS:     Returns the playback ring's counters
+--
+-------------------------------------------------------------------------------------------------------------------*/
+PlaybackRing::Statistics AudioDevice::getPlaybackStatistics() const {
+    return playRing->getStatistics();
+}
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:    describePlayback
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:   NA
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:   QString describePlayback() const
+--
+-- RETURNS:     Returns the audio waiting in the playback ring and its underruns and overruns, as text
+--
 -------------------------------------------------------------------------------------------------------------------*/
-void AudioDevice::addToPlayBuffer(QByteArray buffer) {
-        streaming = 1;
-        byteArray = buffer;
-        device->write(byteArray);
-        device->seek(0);
+QString AudioDevice::describePlayback() const {
+    return playRing->describe();
 }
 
 //! Microphone Record -------------------------------------------------------------------
@@ -278,6 +709,56 @@ void AudioDevice::stopRecordingBuff()
     mic->stop();
 }
 
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:    startCapture
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:   NA
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:   void startCapture(QIODevice *ring)
+--                                ring - ring the microphone audio is written into
+--
+-- RETURNS:     NA
+--
+-- NOTES:
+--
+-- Starts the microphone writing straight into memory, for a call to send from as the audio arrives.
+-------------------------------------------------------------------------------------------------------------------*/
+void AudioDevice::startCapture(QIODevice *ring)
+{
+    ring->open(QIODevice::WriteOnly | QIODevice::Unbuffered);
+    mic->start(ring);
+}
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:    stopCapture
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:   NA
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:   void stopCapture()
+--
+-- RETURNS:     NA
+--
+-- NOTES:
+--
+-- Stops the microphone started by startCapture.
+-------------------------------------------------------------------------------------------------------------------*/
+void AudioDevice::stopCapture()
+{
+    mic->stop();
+}
+
 //! Slots States -------------------------------------------------------------------
 
 /*-----------------------------------------------------------------------------------------------------------------
@@ -11,6 +11,7 @@
 #include <string>
 #include <iostream>
 #include <QTimer>
+#include <QThread>
 #define REC_MAX_SIZE 5
 #define BUFF_SIZE 4096
 #include <QIODevice>
@@ -18,6 +19,9 @@
 #include <QDebug>
 #include <QObject>
 #include <QBuffer>
+#include "streampacket.h"
+#include "capturering.h"
+#include "playbackring.h"
 #define DATA_BUFSIZE 4000
 #define MIC_BUFF 1000
 
@@ -25,19 +29,27 @@ class AudioDevice: public QObject {
     Q_OBJECT
 public:
     AudioDevice(QObject *parent = nullptr);
+    ~AudioDevice();
     QFile source_file_v2;
     QFile recording;
     void playFile(QString filename);
     void playFromBuffer();
     void playFromBufferSilent();
-    void addToPlayBuffer(QByteArray buffer);
+    void addToPlayBuffer(const char *data, int length);
+    void requestStreamFormat(const StreamDescriptor &format);
+    void requestFlush();
+    void requestCapture(CaptureRing *ring);
+    void requestStopCapture();
+    StreamDescriptor getInputFormat() const;
+    StreamDescriptor getOutputFormat() const;
+    int getPlayBufferFill() const;
+    int getPlayBufferSize() const;
+    PlaybackRing::Statistics getPlaybackStatistics() const;
+    QString describePlayback() const;
 
-    QByteArray byteArray;
-    int streaming;
-     
     QAudioInput *mic;
     QAudioOutput *player;
-    QIODevice *device;
+    PlaybackRing *playRing;
 
     void pauseFile();
     void stopFile();
@@ -56,13 +68,20 @@ public:
     bool serverFirstPass = false;
     bool serverStreaming = false;
     bool playingFromFile = false;
+    bool pushing = false;
   
 private:
     QBuffer *qbuffer;
+    QAudioFormat outputFormat;
 
 public slots:
+    void startPlayback();
     void handleStateChanged(QAudio::State newState);
     void handleMicStateChanged(QAudio::State newState);
+    void setStreamFormat(int sampleRate, int channels, int sampleSize, int sampleType);
+    void flushPlayBuffer();
+    void startCapture(QIODevice *ring);
+    void stopCapture();
   
 
 signals:
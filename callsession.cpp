@@ -0,0 +1,1031 @@
+/*------------------------------------------------------------------------------------------------------------------
+-- SOURCE FILE: 	callsession.cpp - One two way voice call on one UDP socket.
+--
+--
+-- PROGRAM: 		Communication Audio Program
+--
+-- FUNCTIONS:
+--                  CallSession(AudioDevice *audioDevice, u_short localPort)
+--                  ~CallSession()
+--                  int getFrameBytes(const StreamDescriptor &format, int &frameMs)
+--                  static int runFromArguments(int argc, char *argv[])
+--                  static QString benchmark(int seconds, int frameMs)
+--                  bool start(const char *peerHost, u_short peerPort)
+--                  void hangUp()
+--                  QString getStatistics()
+--                  DWORD run(LPVOID lpParameter)
+--                  void loop()
+--                  void sendFrame()
+--                  void receive(const char *datagram, int bytes, const SOCKADDR_IN &from)
+--                  void playVoice(const char *datagram, int bytes)
+--                  void useFormat(const StreamDescriptor &format)
+--                  void receiveComfortNoise(const StreamPacketHeader &header, const char *payload)
+--                  void playComfortNoise()
+--                  void sendProbe()
+--                  void receiveEcho(const StreamPacketHeader &header, const char *payload)
+--
+-- DATE: 			October 19, 2026
+--
+-- REVISIONS:       October 19, 2026 - Send comfort noise markers instead of silence - agent
+--                  October 19, 2026 - Tell callers apart by source id - agent
+--                  October 19, 2026 - Measure the delay by stage and probe the round trip - agent
+--                  October 19, 2026 - Size the socket's buffers for the call - agent
+--                  October 19, 2026 - Take every stamp from the performance counter - agent
+--                  October 19, 2026 - Add --voice-bench, one way delay over loopback - agent
+--                  October 19, 2026 - Leave the session to its owner and lock its statistics - agent
+--
+-- DESIGNER: 		agent
+--
+-- PROGRAMMER: 		agent
+--
+-- NOTES:
+--      A call used to be two unrelated halves: the Client sent the mic to the peer's port from one socket and
+--      thread, and the Server played what arrived on another port, socket and thread. A CallSession is the
+--      whole call. It binds one UDP socket, sends the mic's frames from it and plays the frames that arrive on
+--      it, all on one thread that sleeps until a frame has been captured, a datagram has arrived or the call is
+--      hung up. Each side only needs its own port open, and everything about a call lives in its session, so a
+--      process can hold as many sessions as it has audio devices for.
+--
+--      Every session picks a random source id and puts it in each packet it sends. A session started with a
+--      peer calls it, and takes the first source to answer from that address as its peer. One started without
+--      waits, and the first source that sends to it becomes its peer; its audio then goes back to the address
+--      the peer sends from, which is also the way through any NAT or firewall in front of the caller. Once the
+--      peer is known, packets from any other source are dropped, even from the same address, while the peer's
+--      own packets are followed to a new address. A waiting session whose peer has sent nothing for
+--      CALL_PEER_TIMEOUT_MS takes the next caller instead.
+--
+--      --voice-bench sends simulated mic audio over loopback the old way, as 1000 byte blobs with a Sleep(100)
+--      after each, and as frames sent when they are complete, and gives the age of the audio on arrival. It
+--      is raw sendto and recvfrom only: no CaptureRing, CallSession, jitter handling or playback, so it shows
+--      what the send schedule costs and nothing about the rest of the call's path.
+--
+--      Frames are captured into a CaptureRing and sent as soon as each is complete, numbered and stamped with
+--      their capture time. Frames received are reordered by sequence number and gaps are filled by the loss
+--      concealer. Once the peer is known an echo probe goes to it every LATENCY_PROBE_MS, which gives the
+--      round trip and how far the peer's clock is from ours, so the capture stamps give the time each frame
+--      spent getting here even when the two sides run on different machines. That and the audio queued in
+--      the player ahead of the frame add up to the mouth to ear delay. Frames go straight to the player, so
+--      a call has no jitter buffer stage of its own.
+--
+--      Frames VoiceActivity finds silent are not sent. A comfort noise marker goes out at the start of the
+--      silence and every CNG_REFRESH_FRAMES frames after it, and the other side plays noise at the level it
+--      carries, one frame of the peer's length at a time, until voice comes back.
+--
+--      The socket's buffers are sized by a SocketTuner for the larger of the two directions' PCM rates, the
+--      round trip and the most that arrived in one wake, and are sized again as those change.
+--
+--      hangUp() only asks the session's thread to finish. The thread stops the mic and emits ended(), queued
+--      to the owner, who then reads the last statistics and deletes the session. Stopping the mic waits on the
+--      thread that owns the AudioDevice, so the owner must not wait on the call's thread in turn. The GUI
+--      reads the statistics while the call runs, so the thread handles each wake under statsLock.
+--
+--------------------------------------------------------------------------------------------------------------------*/
+#include "callsession.h"
+#include <cstdlib>
+
+static QString runVoiceLoopback(int frameMs, int seconds) {
+    SOCKET receiver = socket(AF_INET, SOCK_DGRAM, 0);
+    SOCKET sender = socket(AF_INET, SOCK_DGRAM, 0);
+    if (receiver == INVALID_SOCKET || sender == INVALID_SOCKET) {
+        return QString("could not open sockets, error %1").arg(WSAGetLastError());
+    }
+    SOCKADDR_IN local = {};
+    local.sin_family = AF_INET;
+    local.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    int size = sizeof(local);
+    u_long nonBlocking = 1;
+    if (bind(receiver, (struct sockaddr *)&local, sizeof(local)) == SOCKET_ERROR ||
+            getsockname(receiver, (struct sockaddr *)&local, &size) == SOCKET_ERROR ||
+            ioctlsocket(receiver, FIONBIO, &nonBlocking) == SOCKET_ERROR) {
+        int error = WSAGetLastError();
+        closesocket(receiver);
+        closesocket(sender);
+        return QString("could not set up the receiver, error %1").arg(error);
+    }
+
+    // The players' old format, which the mic recorded in
+    StreamDescriptor format = { 8000, 2, 16, SAMPLE_UNSIGNED, CODEC_PCM, 4 };
+    double chunkMs = frameMs > 0 ? frameMs : 1000.0 * CALL_BENCH_OLD_BYTES / (format.sampleRate * format.frameSize);
+    int audioBytes = frameMs > 0 ? CallSession::getFrameBytes(format, frameMs) : CALL_BENCH_OLD_BYTES;
+    std::vector<char> audio(audioBytes, 0x55);
+    char packet[DATA_BUFSIZE];
+    char arrived[DATA_BUFSIZE];
+    DWORD startedAt = LatencyMeter::now();
+    uint32_t sent = 0;
+    uint32_t received = 0;
+    double totalAge = 0;
+    DWORD firstAge = 0;
+    DWORD lastAge = 0;
+
+    for (uint32_t index = 0; LatencyMeter::now() - startedAt < (DWORD)seconds * 1000; index++) {
+        DWORD capturedAt = startedAt + (DWORD)(index * chunkMs);
+        DWORD completeAt = startedAt + (DWORD)((index + 1) * chunkMs);
+        // Nothing can be sent before its last sample has been captured
+        int32_t early = (int32_t)(completeAt - LatencyMeter::now());
+        if (early > 0) {
+            Sleep((DWORD)early);
+        }
+        int bytes;
+        if (frameMs > 0) {
+            bytes = StreamPacket::buildVoice(0, format, index, capturedAt, audio.data(), audioBytes, packet);
+        } else {
+            // The old blobs carried no stamp, so the bench puts one where the audio would start
+            memcpy(audio.data(), &capturedAt, sizeof(capturedAt));
+            memcpy(packet, audio.data(), audioBytes);
+            bytes = audioBytes;
+        }
+        if (sendto(sender, packet, bytes, 0, (struct sockaddr *)&local, sizeof(local)) < 0) {
+            continue;
+        }
+        sent++;
+
+        DWORD sentAt = LatencyMeter::now();
+        int length;
+        while ((length = recvfrom(receiver, arrived, DATA_BUFSIZE, 0, NULL, NULL)) <= 0 &&
+               LatencyMeter::now() - sentAt < CALL_BENCH_WAIT_MS) {
+        }
+        if (length > 0) {
+            DWORD stamp;
+            StreamPacketHeader header;
+            if (frameMs > 0 && StreamPacket::readHeader(arrived, length, header)) {
+                stamp = header.timestamp;
+            } else {
+                memcpy(&stamp, arrived, sizeof(stamp));
+            }
+            DWORD age = LatencyMeter::now() - stamp;
+            firstAge = received == 0 ? age : firstAge;
+            lastAge = age;
+            totalAge += age;
+            received++;
+        }
+        if (frameMs == 0) {
+            Sleep(CALL_BENCH_OLD_SLEEP_MS);
+        }
+    }
+    closesocket(receiver);
+    closesocket(sender);
+    return QString("%1 sent, %2 ms of audio each, first sample %3 ms old on arrival on average, %4 ms at the start,"
+                   " %5 ms at the end")
+            .arg((qint64)sent)
+            .arg(chunkMs, 0, 'f', 2)
+            .arg(received > 0 ? totalAge / received : 0, 0, 'f', 1)
+            .arg((qint64)firstAge)
+            .arg((qint64)lastAge);
+}
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	CallSession
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:   October 19, 2026 - Pick a source id - agent
+--              October 19, 2026 - Set up the statistics lock - agent
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	CallSession(AudioDevice *audioDevice, u_short localPort)
+--                          audioDevice - device whose mic is sent and whose player plays the peer
+--                          localPort - port to send and receive on, 0 for any
+--
+-- RETURNS:     NA
+--
+-------------------------------------------------------------------------------------------------------------------*/
+CallSession::CallSession(AudioDevice *audioDevice, u_short localPort) : audioDevice(audioDevice), localPort(localPort) {
+    stopEvent = CreateEvent(NULL, TRUE, FALSE, NULL);
+    InitializeCriticalSection(&statsLock);
+    source = StreamPacket::newSource();
+}
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	~CallSession
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	~CallSession()
+--
+-- RETURNS:     NA
+--
+-- NOTES:
+--              A session that started is only deleted after it has emitted ended(). Its thread has nothing
+--              left to do by then but return, which is waited for before anything is freed.
+--
+-------------------------------------------------------------------------------------------------------------------*/
+CallSession::~CallSession() {
+    if (thread != NULL) {
+        WaitForSingleObject(thread, INFINITE);
+    }
+    delete io;
+    delete tuner;
+    if (sock != INVALID_SOCKET) {
+        closesocket(sock);
+        WSACleanup();
+    }
+    if (readEvent != WSA_INVALID_EVENT) {
+        WSACloseEvent(readEvent);
+    }
+    if (thread != NULL) {
+        CloseHandle(thread);
+    }
+    CloseHandle(stopEvent);
+    DeleteCriticalSection(&statsLock);
+    delete capture;
+    delete encoder;
+    delete decoder;
+}
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	getFrameBytes
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:   October 19, 2026 - Leave room for the source id - agent
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	static int getFrameBytes(const StreamDescriptor &format, int &frameMs)
+--                                       format - format the mic records in
+--                                       frameMs - length of a frame, set to the length used
+--
+-- RETURNS:     The size of one voice frame in bytes
+--
+-- NOTES:
+--              Frames are 10, 20 or 40 ms, anything else gets CALL_FRAME_MS. A frame too big to send as raw PCM
+--              in one voice packet is halved until it fits.
+--
+-------------------------------------------------------------------------------------------------------------------*/
+int CallSession::getFrameBytes(const StreamDescriptor &format, int &frameMs) {
+    if (frameMs != 10 && frameMs != 20 && frameMs != 40) {
+        frameMs = CALL_FRAME_MS;
+    }
+    int bytes = (int)(format.sampleRate * frameMs / 1000) * format.frameSize;
+    while (bytes > STREAM_PAYLOAD_SIZE - VOICE_PREFIX_SIZE && frameMs > 10) {
+        frameMs /= 2;
+        bytes = (int)(format.sampleRate * frameMs / 1000) * format.frameSize;
+    }
+    return bytes;
+}
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	runFromArguments
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	static int runFromArguments(int argc, char *argv[])
+--                          argc - number of command line arguments
+--                          argv - the command line arguments
+--
+-- RETURNS:     The process exit code
+--
+-- NOTES:
+--              The form is
+--                  --voice-bench [seconds per mode] [frame ms]
+--              The benchmark prints its result and returns.
+--
+-------------------------------------------------------------------------------------------------------------------*/
+int CallSession::runFromArguments(int argc, char *argv[]) {
+    if (strcmp(argv[1], "--voice-bench") != 0) {
+        qDebug() << "Usage: --voice-bench [seconds per mode] [frame ms]\n";
+        return 1;
+    }
+    int seconds = argc >= 3 ? atoi(argv[2]) : CALL_BENCH_SECONDS;
+    int frameMs = argc >= 4 ? atoi(argv[3]) : CALL_FRAME_MS;
+    WSADATA wsaData;
+    if (WSAStartup(0x0202, &wsaData) != 0) {
+        qDebug() << "WSAStartup failed with error \n" << WSAGetLastError();
+        return 1;
+    }
+    qDebug() << benchmark(seconds > 0 ? seconds : CALL_BENCH_SECONDS, frameMs);
+    WSACleanup();
+    return 0;
+}
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	benchmark
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:   October 19, 2026 - Say the delay is the raw socket path only - agent
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	static QString benchmark(int seconds, int frameMs)
+--                                seconds - how long each mode runs
+--                                frameMs - length of the frames in the second mode, 10, 20 or 40
+--
+-- RETURNS:     A one line summary of both modes
+--
+-- NOTES:
+--              A mic recording the players' old 8 kHz stereo is played along the performance counter, and
+--              what it captures goes over loopback to a socket read straight after each send. The first mode is
+--              the old joinCall: CALL_BENCH_OLD_BYTES at a time with a Sleep(CALL_BENCH_OLD_SLEEP_MS) after
+--              each, which sends 31 ms of audio every 100 ms and so falls further behind the longer the call
+--              runs. The second sends each voice frame, stamped with its capture time, as soon as its last
+--              sample is in. The age of the first sample of each datagram when it arrives is the one way delay
+--              of the send schedule and the socket alone. Neither mode goes through a CaptureRing, a
+--              CallSession, its jitter handling or a player, which need an AudioDevice the bench cannot open,
+--              so their delay comes on top of it in a real call.
+--
+-------------------------------------------------------------------------------------------------------------------*/
+QString CallSession::benchmark(int seconds, int frameMs) {
+    StreamDescriptor format = { 8000, 2, 16, SAMPLE_UNSIGNED, CODEC_PCM, 4 };
+    getFrameBytes(format, frameMs);
+    return QString("Voice benchmark, raw sendto/recvfrom over loopback only (no capture ring, CallSession,"
+                   " jitter buffer or playback), %1 s per mode | %2 byte blobs every %3 ms: %4 | %5 ms frames: %6")
+            .arg(seconds)
+            .arg(CALL_BENCH_OLD_BYTES)
+            .arg(CALL_BENCH_OLD_SLEEP_MS)
+            .arg(runVoiceLoopback(0, seconds))
+            .arg(frameMs)
+            .arg(runVoiceLoopback(frameMs, seconds));
+}
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	start
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:   October 19, 2026 - Check captured frames for speech - agent
+--              October 19, 2026 - Remember whether the session answers or calls - agent
+--              October 19, 2026 - Size the socket's buffers - agent
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	bool start(const char *peerHost, u_short peerPort)
+--                         peerHost - host name or address to call, nullptr to wait for a caller
+--                         peerPort - port the peer's session is on
+--
+-- RETURNS:     True if the call is running. Otherwise the caller still owns the session and deletes it.
+--
+-------------------------------------------------------------------------------------------------------------------*/
+bool CallSession::start(const char *peerHost, u_short peerPort) {
+    WSADATA wsaData;
+    if (WSAStartup(0x0202, &wsaData) != 0) {
+        qDebug() << "WSAStartup failed with error" << WSAGetLastError();
+        return false;
+    }
+    if ((sock = socket(PF_INET, SOCK_DGRAM, 0)) == INVALID_SOCKET) {
+        qDebug() << "Failed to get a call socket" << WSAGetLastError();
+        WSACleanup();
+        return false;
+    }
+
+    SOCKADDR_IN local = {};
+    local.sin_family = AF_INET;
+    local.sin_addr.s_addr = htonl(INADDR_ANY);
+    local.sin_port = htons(localPort);
+    if (bind(sock, (PSOCKADDR)&local, sizeof(local)) == SOCKET_ERROR) {
+        qDebug() << "bind() failed for the call with error" << WSAGetLastError();
+        return false;
+    }
+
+    if (peerHost != nullptr) {
+        struct hostent *hp;
+        if ((hp = gethostbyname(peerHost)) == NULL) {
+            qDebug() << "Unknown peer address" << peerHost;
+            return false;
+        }
+        peer.sin_family = AF_INET;
+        peer.sin_port = htons(peerPort);
+        memcpy((char *)&peer.sin_addr, hp->h_addr, hp->h_length);
+        peerKnown = true;
+    }
+    answering = !peerKnown;
+
+    if ((readEvent = WSACreateEvent()) == WSA_INVALID_EVENT || WSAEventSelect(sock, readEvent, FD_READ)) {
+        qDebug() << "Failed to tie event to the call socket" << WSAGetLastError();
+        return false;
+    }
+    io = new DatagramIO(sock);
+    io->enableReceiveCoalescing();
+
+    sendFormat = audioDevice->getInputFormat();
+    activity.setFormat(sendFormat);
+    frameBytes = getFrameBytes(sendFormat, frameMs);
+    frame.resize(frameBytes);
+    capture = new CaptureRing(frameBytes);
+    encoder = AudioCodec::create(codec, sendFormat);
+    sendFormat.codec = encoder ? codec : CODEC_PCM;
+    tuner = new SocketTuner(sock, SocketTuner::BOTH, sendFormat.sampleRate * sendFormat.frameSize);
+
+    if ((thread = CreateThread(NULL, 0, run, this, 0, NULL)) == NULL) {
+        qDebug() << "CreateThread failed with error" << GetLastError();
+        return false;
+    }
+    return true;
+}
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	hangUp
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	void hangUp()
+--
+-- RETURNS:     void
+--
+-- NOTES:
+--              Asks the session's thread to end the call. The session emits ended() once it has, and is
+--              deleted by whoever started it after that.
+--
+-------------------------------------------------------------------------------------------------------------------*/
+void CallSession::hangUp() {
+    SetEvent(stopEvent);
+}
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	getStatistics
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:   October 19, 2026 - Report the talk ratio and comfort noise - agent
+--              October 19, 2026 - Report the peer's moves - agent
+--              October 19, 2026 - Report the latency histograms instead of the average delay - agent
+--              October 19, 2026 - Report the socket's buffer sizes and the kernel's drops - agent
+--              October 19, 2026 - Report the playback ring's underruns and overruns - agent
+--              October 19, 2026 - Report malformed datagrams - agent
+--              October 19, 2026 - Read the counters under the statistics lock - agent
+--              October 19, 2026 - Append the latency buckets to the CSV file - agent
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	QString getStatistics()
+--
+-- RETURNS:     A one line summary of the call
+--
+-- NOTES:
+--              Called from the GUI thread. The session's thread holds statsLock while it handles each wake, so
+--              the counters, the latency histograms and the tuner are read between wakes, never halfway
+--              through one.
+--
+-------------------------------------------------------------------------------------------------------------------*/
+QString CallSession::getStatistics() {
+    EnterCriticalSection(&statsLock);
+    Statistics call = stats;
+    CaptureRing::Statistics captured = capture->getStatistics();
+    VoiceActivity::Statistics talk = activity.getStatistics();
+    QString delays = latency.describe();
+    latency.writeCsv("call");
+    QString buffers = tuner->describe();
+    LeaveCriticalSection(&statsLock);
+    QString talkRatio = QString("not measured");
+    if (talk.speechFrames + talk.silentFrames > 0) {
+        talkRatio = QString("%1%").arg(100.0 * talk.speechFrames / (talk.speechFrames + talk.silentFrames), 0, 'f', 1);
+    }
+    return QString("Call: %1 frames of %2 ms sent, %3 dropped behind | %4 received, %5 concealed, %6 late, "
+                   "%16 malformed, %7 from other sources, peer moved %13 times | Latency: %8 | Talk: %9 of the time, "
+                   "%10 comfort noise markers sent, %11 received, %12 ms of comfort noise played | Socket buffers: %14"
+                   " | Playback: %15")
+            .arg((qint64)call.framesSent)
+            .arg((qint64)frameMs)
+            .arg((qint64)captured.skipped)
+            .arg((qint64)call.framesReceived)
+            .arg((qint64)call.concealed)
+            .arg((qint64)call.late)
+            .arg((qint64)call.strangers)
+            .arg(delays)
+            .arg(talkRatio)
+            .arg((qint64)call.markersSent)
+            .arg((qint64)call.markersReceived)
+            .arg((qint64)call.comfortMs)
+            .arg((qint64)call.moves)
+            .arg(buffers)
+            .arg(audioDevice->describePlayback())
+            .arg((qint64)call.malformed);
+}
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	run
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:   October 19, 2026 - Tell the owner the call ended instead of deleting the session - agent
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	static DWORD WINAPI run(LPVOID lpParameter)
+--                                      lpParameter - the session
+--
+-- RETURNS:     0
+--
+-- NOTES:
+--              Thread entry. Runs the call until it is hung up or fails, then emits ended(), which reaches the
+--              owner on its own thread.
+--
+-------------------------------------------------------------------------------------------------------------------*/
+DWORD WINAPI CallSession::run(LPVOID lpParameter) {
+    CallSession *session = (CallSession *)lpParameter;
+    session->loop();
+    emit session->ended();
+    return 0;
+}
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	loop
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:   October 19, 2026 - Wake every peer frame to play comfort noise - agent
+--              October 19, 2026 - Send echo probes - agent
+--              October 19, 2026 - Retune the socket's buffers - agent
+--              October 19, 2026 - End the call if the wait fails - agent
+--              October 19, 2026 - Hold the statistics lock while handling a wake - agent
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	void loop()
+--
+-- RETURNS:     void
+--
+-- NOTES:
+--              Starts the player and the mic, then wakes for whichever comes first: a captured frame, a
+--              datagram or the hang up. Every frame and datagram waiting is handled in each wake, and the
+--              frames, probes and echo replies sent in it go out together. While the peer is silent it also
+--              wakes at least once a peer frame to play comfort noise, and once a peer is known at least
+--              once every LATENCY_PROBE_MS to probe it. The bytes read in each wake and the round trip go
+--              to the socket's tuner. A failed wait ends the call, as a hang up would. Each wake is
+--              handled under statsLock so getStatistics never sees one half done.
+--
+-------------------------------------------------------------------------------------------------------------------*/
+void CallSession::loop() {
+    audioDevice->playFromBuffer();
+    audioDevice->requestCapture(capture);
+
+    HANDLE events[3] = { stopEvent, readEvent, capture->getFrameEvent() };
+    DWORD wait = INFINITE;
+    while (true) {
+        DWORD woke = WaitForMultipleObjects(3, events, FALSE, wait);
+        if (woke == WAIT_OBJECT_0) {
+            break;
+        }
+        if (woke == WAIT_FAILED) {
+            qDebug() << "WaitForMultipleObjects failed for the call with error" << GetLastError();
+            break;
+        }
+        EnterCriticalSection(&statsLock);
+        WSAResetEvent(readEvent);
+        wakeBytes = 0;
+        io->receive([this](const char *datagram, int bytes, const SOCKADDR_IN &from) {
+            wakeBytes += bytes;
+            receive(datagram, bytes, from);
+        });
+        while (capture->readFrame(frame.data(), 0)) {
+            sendFrame();
+        }
+        sendProbe();
+        io->flush();
+        playComfortNoise();
+        const LatencyHistogram &roundTrips = latency.getHistogram(LatencyMeter::ROUND_TRIP);
+        tuner->update(roundTrips.getCount() > 0 ? roundTrips.getPercentile(95) : 0, wakeBytes, LatencyMeter::now());
+        wait = comfortActive ? (DWORD)peerFrameMs : peerKnown ? LATENCY_PROBE_MS : INFINITE;
+        LeaveCriticalSection(&statsLock);
+    }
+
+    audioDevice->requestStopCapture();
+}
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	sendFrame
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:   October 19, 2026 - Send a comfort noise marker now and then instead of silent frames - agent
+--              October 19, 2026 - Name the session's source in each packet - agent
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	void sendFrame()
+--
+-- RETURNS:     void
+--
+-- NOTES:
+--              Sends the frame just read from the capture ring, or drops it while no one has called yet.
+--              A frame's sequence number is its number in the capture, so frames the ring dropped show up as
+--              gaps to conceal. Its timestamp is when its first sample was captured, counted along the mic's
+--              clock from the earliest start seen so far, so frames are stamped exactly a frame apart however
+--              unevenly they are sent. A silent frame is replaced by a comfort noise marker on the first and
+--              every CNG_REFRESH_FRAMES frame of the silence, and by nothing otherwise.
+--
+-------------------------------------------------------------------------------------------------------------------*/
+void CallSession::sendFrame() {
+    uint64_t index = capture->getFrameIndex();
+    DWORD start = LatencyMeter::now() - frameMs - (DWORD)(index * frameMs);
+    if (!captureStartKnown || (int32_t)(start - captureStart) < 0) {
+        captureStart = start;
+        captureStartKnown = true;
+    }
+    if (!peerKnown) {
+        return;
+    }
+    DWORD timestamp = captureStart + (DWORD)(index * frameMs);
+    if (suppressSilence && !activity.isSpeech(frame.data(), frameBytes)) {
+        if (silentRun++ % CNG_REFRESH_FRAMES == 0) {
+            int bytes = StreamPacket::buildComfortNoise(source, sendFormat, (uint32_t)index, timestamp,
+                                                        activity.getNoiseLevel(), packet);
+            io->queue(packet, bytes, peer);
+            stats.markersSent++;
+        }
+        return;
+    }
+    silentRun = 0;
+
+    const char *audio = frame.data();
+    int length = frameBytes;
+    if (encoder) {
+        length = encoder->encode(frame.data(), frameBytes, encoded);
+        audio = encoded;
+    }
+    int bytes = StreamPacket::buildVoice(source, sendFormat, (uint32_t)index, timestamp, audio, length, packet);
+    io->queue(packet, bytes, peer);
+    stats.framesSent++;
+}
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	receive
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:   October 19, 2026 - Pick the peer by source id and follow it between addresses - agent
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	void receive(const char *datagram, int bytes, const SOCKADDR_IN &from)
+--                           datagram - datagram read from the call socket
+--                           bytes - size of the datagram
+--                           from - address it came from
+--
+-- RETURNS:     void
+--
+-- NOTES:
+--              The first source to send voice to a waiting session becomes its peer, and a calling session's
+--              peer is the first source to answer from the address it called. Datagrams that name no source
+--              are only played if they come from the peer's address.
+--
+-------------------------------------------------------------------------------------------------------------------*/
+void CallSession::receive(const char *datagram, int bytes, const SOCKADDR_IN &from) {
+    bool fromPeer = peerKnown && from.sin_addr.s_addr == peer.sin_addr.s_addr && from.sin_port == peer.sin_port;
+    uint32_t sender;
+    if (!StreamPacket::readSource(datagram, bytes, sender)) {
+        if (fromPeer) {
+            playVoice(datagram, bytes);
+        } else {
+            stats.strangers++;
+        }
+        return;
+    }
+
+    DWORD now = LatencyMeter::now();
+    if (peerSource != 0 && sender != peerSource) {
+        if (!answering || now - peerHeardAt <= CALL_PEER_TIMEOUT_MS) {
+            stats.strangers++;
+            return;
+        }
+        qDebug() << "call peer went quiet, answering the next caller";
+        peerSource = 0;
+        peerKnown = false;
+        fromPeer = false;
+        sequenceKnown = false;
+        comfortActive = false;
+    }
+    if (peerSource == 0) {
+        if (peerKnown && !fromPeer) {
+            stats.strangers++;
+            return;
+        }
+        peerSource = sender;
+        if (!peerKnown) {
+            peer = from;
+            peerKnown = true;
+            qDebug() << "call from" << inet_ntoa(from.sin_addr) << ntohs(from.sin_port);
+        }
+    } else if (!fromPeer) {
+        peer = from;
+        stats.moves++;
+        qDebug() << "call peer moved to" << inet_ntoa(from.sin_addr) << ntohs(from.sin_port);
+    }
+    peerHeardAt = now;
+    playVoice(datagram, bytes);
+}
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	playVoice
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:   October 19, 2026 - Hand comfort noise markers on and carry on after them - agent
+--              October 19, 2026 - Record the transit and output queue delays and hand echoes on - agent
+--              October 19, 2026 - Drop malformed datagrams instead of playing them - agent
+--              October 19, 2026 - Keep the peer frame length at least a call frame - agent
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	void playVoice(const char *datagram, int bytes)
+--                             datagram - datagram received from the peer
+--                             bytes - size of the datagram
+--
+-- RETURNS:     void
+--
+-- NOTES:
+--              Decodes a voice packet with the codec it names, switching the player and the decoder when the
+--              peer's format changes. Comfort noise markers go to receiveComfortNoise, echoes to receiveEcho,
+--              and any other datagram, or a voice packet that does not parse, is counted and dropped rather
+--              than played. The first voice packet after comfort noise carries straight on from it, since
+--              the frames in between were silence rather than lost.
+--              A gap in the sequence numbers is filled by the loss concealer before the packet plays, up to
+--              CALL_MAX_CONCEALED packets. A packet that arrives after its place was filled is dropped, and a
+--              larger jump in either direction is taken as the peer starting over.
+--              The time since a frame's capture stamp is its transit, and what is queued in the player ahead of
+--              it is how long it waits to be heard. Together they are the mouth to ear delay.
+--
+-------------------------------------------------------------------------------------------------------------------*/
+void CallSession::playVoice(const char *datagram, int bytes) {
+    StreamPacketHeader header;
+    StreamDescriptor format;
+    uint32_t sender;
+    const char *audio;
+    int length;
+    bool parsed = StreamPacket::readHeader(datagram, bytes, header);
+    if (parsed && header.type == PACKET_COMFORT_NOISE) {
+        receiveComfortNoise(header, datagram + STREAM_HEADER_SIZE);
+        return;
+    }
+    if (parsed && header.type == PACKET_ECHO) {
+        receiveEcho(header, datagram + STREAM_HEADER_SIZE);
+        return;
+    }
+    if (!parsed || header.type != PACKET_VOICE ||
+            !StreamPacket::readVoice(datagram + STREAM_HEADER_SIZE, header.length, sender, format, audio, length)) {
+        stats.malformed++;
+        return;
+    }
+    useFormat(format);
+    if (comfortActive) {
+        comfortActive = false;
+        nextSequence = header.sequence;
+    }
+    int32_t gap = (int32_t)(header.sequence - nextSequence);
+    if (sequenceKnown && gap < 0 && gap > -CALL_MAX_CONCEALED) {
+        stats.late++;
+        return;
+    }
+    uint32_t transit;
+    if (latency.getTransit(header.timestamp, LatencyMeter::now(), transit)) {
+        uint32_t queued = (uint32_t)((uint64_t)audioDevice->getPlayBufferFill() * 1000 /
+                                     ((uint64_t)format.sampleRate * format.frameSize));
+        latency.record(LatencyMeter::TRANSIT, transit);
+        latency.record(LatencyMeter::OUTPUT_QUEUE, queued);
+        latency.record(LatencyMeter::MOUTH_TO_EAR, transit + queued);
+    }
+    if (sequenceKnown && gap > 0 && gap <= CALL_MAX_CONCEALED) {
+        for (int i = 0; i < gap; i++) {
+            int concealed = concealer.conceal(decodeBuffer, AUDIO_DECODE_MAX);
+            if (concealed > 0) {
+                stats.concealed++;
+                audioDevice->addToPlayBuffer(decodeBuffer, concealed);
+            }
+        }
+    }
+    nextSequence = header.sequence + 1;
+    sequenceKnown = true;
+    if (format.codec != CODEC_PCM) {
+        if (decoder == nullptr || (length = decoder->decode(audio, length, decodeBuffer, AUDIO_DECODE_MAX)) < 0) {
+            return;
+        }
+        audio = decodeBuffer;
+    }
+    if (length > 0) {
+        int heardMs = (int)((uint64_t)length * 1000 / ((uint64_t)format.sampleRate * format.frameSize));
+        peerFrameMs = heardMs > CALL_FRAME_MS ? heardMs : CALL_FRAME_MS;
+    }
+    audio = concealer.play(audio, length);
+    audioDevice->addToPlayBuffer(audio, length);
+    stats.framesReceived++;
+}
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	useFormat
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:   October 19, 2026 - Size the socket for the faster direction - agent
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	void useFormat(const StreamDescriptor &format)
+--                             format - format named by a packet from the peer
+--
+-- RETURNS:     void
+--
+-- NOTES:
+--              Switches the player, the decoder, the concealer and the comfort noise when the peer's format
+--              changes, and takes the change as the peer starting over.
+--
+-------------------------------------------------------------------------------------------------------------------*/
+void CallSession::useFormat(const StreamDescriptor &format) {
+    if (StreamPacket::sameFormat(format, receiveFormat)) {
+        return;
+    }
+    receiveFormat = format;
+    delete decoder;
+    decoder = AudioCodec::create(format.codec, format);
+    concealer.setFormat(format);
+    comfort.setFormat(format);
+    sequenceKnown = false;
+    comfortActive = false;
+    audioDevice->requestStreamFormat(format);
+    uint32_t receiveRate = format.sampleRate * format.frameSize;
+    uint32_t sendRate = sendFormat.sampleRate * sendFormat.frameSize;
+    tuner->setRate(receiveRate > sendRate ? receiveRate : sendRate);
+}
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	receiveComfortNoise
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	void receiveComfortNoise(const StreamPacketHeader &header, const char *payload)
+--                                       header - header of a comfort noise marker
+--                                       payload - its payload
+--
+-- RETURNS:     void
+--
+-- NOTES:
+--              The peer has gone quiet. Starts comfort noise at the marker's level from now, or changes the
+--              level of the noise already playing. A marker older than the last packet played is ignored.
+--
+-------------------------------------------------------------------------------------------------------------------*/
+void CallSession::receiveComfortNoise(const StreamPacketHeader &header, const char *payload) {
+    StreamDescriptor format;
+    uint32_t sender;
+    uint8_t level;
+    if (!StreamPacket::readComfortNoise(payload, header.length, sender, format, level)) {
+        return;
+    }
+    useFormat(format);
+    int32_t gap = (int32_t)(header.sequence - nextSequence);
+    if (sequenceKnown && gap < 0 && gap > -CALL_MAX_CONCEALED) {
+        stats.late++;
+        return;
+    }
+    stats.markersReceived++;
+    comfort.setLevel(level);
+    nextSequence = header.sequence + 1;
+    sequenceKnown = true;
+    if (!comfortActive && comfort.isActive()) {
+        comfortActive = true;
+        comfortNextAt = LatencyMeter::now();
+        concealer.clearHistory();
+        playComfortNoise();
+    }
+}
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	playComfortNoise
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:   October 19, 2026 - Never step by less than a call frame - agent
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	void playComfortNoise()
+--
+-- RETURNS:     void
+--
+-- NOTES:
+--              Writes a frame of noise for every peer frame of time gone by, so the player keeps the same
+--              amount queued as it had when the peer went quiet. After a long stall it starts counting again
+--              from now rather than catching up in a burst.
+--
+-------------------------------------------------------------------------------------------------------------------*/
+void CallSession::playComfortNoise() {
+    if (!comfortActive || peerFrameMs <= 0) {
+        return;
+    }
+    DWORD now = LatencyMeter::now();
+    if ((int32_t)(now - comfortNextAt) > CALL_MAX_CONCEALED * peerFrameMs) {
+        comfortNextAt = now;
+    }
+    int frames = (int)(receiveFormat.sampleRate * peerFrameMs / 1000);
+    int maxFrames = AUDIO_DECODE_MAX / (2 * receiveFormat.channels);
+    frames = frames < maxFrames ? frames : maxFrames;
+    while ((int32_t)(now - comfortNextAt) >= 0) {
+        int bytes = comfort.generate(decodeBuffer, frames);
+        audioDevice->addToPlayBuffer(decodeBuffer, bytes);
+        comfortNextAt += peerFrameMs;
+        stats.comfortMs += peerFrameMs;
+    }
+}
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	sendProbe
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	void sendProbe()
+--
+-- RETURNS:     void
+--
+-- NOTES:
+--              Queues an echo probe to the peer once every LATENCY_PROBE_MS, stamped with our clock.
+--
+-------------------------------------------------------------------------------------------------------------------*/
+void CallSession::sendProbe() {
+    DWORD now = LatencyMeter::now();
+    if (!peerKnown || !latency.isProbeDue(now)) {
+        return;
+    }
+    int bytes = StreamPacket::buildEcho(source, false, 0, now, packet);
+    io->queue(packet, bytes, peer);
+}
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	receiveEcho
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	void receiveEcho(const StreamPacketHeader &header, const char *payload)
+--                               header - header of an echo packet from the peer
+--                               payload - its payload
+--
+-- RETURNS:     void
+--
+-- NOTES:
+--              Answers the peer's probe at once with our clock, or gives the answer to one of ours to the
+--              latency meter.
+--
+-------------------------------------------------------------------------------------------------------------------*/
+void CallSession::receiveEcho(const StreamPacketHeader &header, const char *payload) {
+    uint32_t sender;
+    bool reply;
+    uint32_t origin;
+    if (!StreamPacket::readEcho(payload, header.length, sender, reply, origin)) {
+        return;
+    }
+    DWORD now = LatencyMeter::now();
+    if (reply) {
+        latency.receiveReply(origin, header.timestamp, now);
+        return;
+    }
+    int bytes = StreamPacket::buildEcho(source, true, header.timestamp, now, packet);
+    io->queue(packet, bytes, peer);
+}
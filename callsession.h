@@ -0,0 +1,117 @@
+#pragma once
+#include <winsock2.h>
+#include <windows.h>
+#include <cstdint>
+#include <vector>
+#include <QDebug>
+#include <QObject>
+#include <QString>
+#include "audiodevice.h"
+#include "audiocodec.h"
+#include "capturering.h"
+#include "datagramio.h"
+#include "latencymeter.h"
+#include "lossconcealer.h"
+#include "sockettuner.h"
+#include "streampacket.h"
+#include "voiceactivity.h"
+
+#define CALL_FRAME_MS 20
+#define CALL_MAX_CONCEALED 8
+#define CALL_PEER_TIMEOUT_MS 5000
+#define CALL_BENCH_SECONDS 10
+#define CALL_BENCH_OLD_BYTES 1000
+#define CALL_BENCH_OLD_SLEEP_MS 100
+#define CALL_BENCH_WAIT_MS 50
+
+class CallSession : public QObject {
+    Q_OBJECT
+
+public:
+    struct Statistics {
+        uint32_t framesSent = 0;
+        uint32_t framesReceived = 0;
+        uint32_t concealed = 0;
+        uint32_t late = 0;
+        uint32_t malformed = 0;
+        uint32_t strangers = 0;
+        uint32_t moves = 0;
+        uint32_t markersSent = 0;
+        uint32_t markersReceived = 0;
+        uint64_t comfortMs = 0;
+    };
+
+    CallSession(AudioDevice *audioDevice, u_short localPort);
+    ~CallSession();
+    CallSession(const CallSession&) = delete;
+    void operator=(const CallSession&) = delete;
+
+    static int getFrameBytes(const StreamDescriptor &format, int &frameMs);
+    static int runFromArguments(int argc, char *argv[]);
+    static QString benchmark(int seconds, int frameMs);
+    bool start(const char *peerHost, u_short peerPort);
+    void hangUp();
+    QString getStatistics();
+
+    uint8_t codec = CODEC_ULAW;
+    int frameMs = CALL_FRAME_MS;
+    bool suppressSilence = true;
+
+signals:
+    void ended();
+
+private:
+    AudioDevice *audioDevice;
+    u_short localPort;
+    SOCKET sock = INVALID_SOCKET;
+    WSAEVENT readEvent = WSA_INVALID_EVENT;
+    HANDLE stopEvent;
+    HANDLE thread = NULL;
+    CRITICAL_SECTION statsLock;
+    DatagramIO *io = nullptr;
+    SocketTuner *tuner = nullptr;
+    uint32_t wakeBytes = 0;
+    SOCKADDR_IN peer = {};
+    bool peerKnown = false;
+    bool answering = false;
+    uint32_t source;
+    uint32_t peerSource = 0;
+    DWORD peerHeardAt = 0;
+
+    CaptureRing *capture = nullptr;
+    std::vector<char> frame;
+    int frameBytes = 0;
+    StreamDescriptor sendFormat = {};
+    AudioCodec *encoder = nullptr;
+    char encoded[STREAM_PAYLOAD_SIZE];
+    char packet[DATA_BUFSIZE];
+    DWORD captureStart = 0;
+    bool captureStartKnown = false;
+    VoiceActivity activity;
+    uint32_t silentRun = 0;
+
+    StreamDescriptor receiveFormat = {};
+    AudioCodec *decoder = nullptr;
+    char decodeBuffer[AUDIO_DECODE_MAX];
+    LossConcealer concealer;
+    uint32_t nextSequence = 0;
+    bool sequenceKnown = false;
+    int peerFrameMs = CALL_FRAME_MS;
+    ComfortNoise comfort;
+    bool comfortActive = false;
+    DWORD comfortNextAt = 0;
+
+    LatencyMeter latency;
+    Statistics stats;
+
+    static DWORD WINAPI run(LPVOID lpParameter);
+    void loop();
+    void sendFrame();
+    void receive(const char *datagram, int bytes, const SOCKADDR_IN &from);
+    void playVoice(const char *datagram, int bytes);
+    void useFormat(const StreamDescriptor &format);
+    void receiveComfortNoise(const StreamPacketHeader &header, const char *payload);
+    void playComfortNoise();
+    void sendProbe();
+    void receiveEcho(const StreamPacketHeader &header, const char *payload);
+};
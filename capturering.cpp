@@ -0,0 +1,234 @@
+/*------------------------------------------------------------------------------------------------------------------
+-- SOURCE FILE: 	capturering.cpp - Hands microphone audio to a sending thread through memory.
+--
+--
+-- PROGRAM: 		Communication Audio Program
+--
+-- FUNCTIONS:
+--                  CaptureRing(int frameBytes)
+--                  ~CaptureRing()
+--                  bool readFrame(char *frame, DWORD timeoutMs)
+--                  void clear()
+--                  qint64 readData(char *data, qint64 maxSize)
+--                  qint64 writeData(const char *data, qint64 maxSize)
+--
+-- DATE: 			October 19, 2026
+--
+-- REVISIONS:       October 19, 2026 - Number the frames read so callers can timestamp them - agent
+--                  October 19, 2026 - Let the reader wait on the frame event with its other events - agent
+--
+-- DESIGNER: 		agent
+--
+-- PROGRAMMER: 		agent
+--
+-- NOTES:
+--      The microphone is started on the ring, so QAudioInput writes its audio straight into it on the thread that
+--      owns the AudioDevice. A call's sending thread takes the audio back out one frame at a time and sends each
+--      frame as soon as it is complete. Nothing is written to disk, the memory used is fixed, and a frame waits
+--      in the ring only as long as it takes to fill.
+--
+--      There is exactly one writer and one reader, so the ring needs no lock. Each side only moves its own
+--      running count of bytes, written or taken, and reads the other's. The writer publishes its count after
+--      the audio is copied in, so the reader never sees bytes that are not there yet. The writer sets an event
+--      once a whole frame is waiting, and the reader sleeps on it, either in readFrame or together with its
+--      other events, reading with no timeout when it fires.
+--
+--      If the reader falls behind, sending the backlog would only make the call later. When more than
+--      CAPTURE_MAX_BACKLOG frames are waiting, all but the newest are dropped. If the ring itself fills, the
+--      microphone's write is dropped whole so the samples stay aligned.
+--
+--      Frames are numbered from the start of capture, counting the dropped ones, so a frame's number times its
+--      duration is where it falls on the microphone's clock.
+--
+--------------------------------------------------------------------------------------------------------------------*/
+#include "capturering.h"
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	CaptureRing
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	CaptureRing(int frameBytes)
+--                          frameBytes - size of the frames given to readFrame
+--
+-- RETURNS:     NA
+--
+-- NOTES:
+--              The ring holds at least CAPTURE_RING_FRAMES frames and is a power of two so the running counts
+--              can wrap around freely.
+--
+-------------------------------------------------------------------------------------------------------------------*/
+CaptureRing::CaptureRing(int frameBytes) : frameBytes(frameBytes) {
+    ringSize = 1;
+    while (ringSize < (uint32_t)frameBytes * CAPTURE_RING_FRAMES) {
+        ringSize <<= 1;
+    }
+    ring = new char[ringSize];
+    frameEvent = CreateEvent(NULL, FALSE, FALSE, NULL);
+}
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	~CaptureRing
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	~CaptureRing()
+--
+-- RETURNS:     NA
+--
+-- NOTES:
+--              The microphone must have been stopped first.
+--
+-------------------------------------------------------------------------------------------------------------------*/
+CaptureRing::~CaptureRing() {
+    CloseHandle(frameEvent);
+    delete[] ring;
+}
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	readFrame
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	bool readFrame(char *frame, DWORD timeoutMs)
+--                             frame - buffer of frameBytes for the audio
+--                             timeoutMs - longest to wait for a frame to fill
+--
+-- RETURNS:     True if a frame was read, false if none was complete in time
+--
+-- NOTES:
+--              Only called by the one reading thread. getFrameIndex then gives the number of the frame read.
+--
+-------------------------------------------------------------------------------------------------------------------*/
+bool CaptureRing::readFrame(char *frame, DWORD timeoutMs) {
+    DWORD start = GetTickCount();
+    uint32_t available;
+    while ((available = (uint32_t)(written - taken)) < (uint32_t)frameBytes) {
+        DWORD waited = GetTickCount() - start;
+        if (waited >= timeoutMs || WaitForSingleObject(frameEvent, timeoutMs - waited) == WAIT_TIMEOUT) {
+            if ((uint32_t)(written - taken) < (uint32_t)frameBytes) {
+                return false;
+            }
+        }
+    }
+    MemoryBarrier();
+
+    uint32_t waiting = available / frameBytes;
+    if (waiting > CAPTURE_MAX_BACKLOG) {
+        InterlockedExchangeAdd(&taken, (LONG)((waiting - 1) * frameBytes));
+        stats.skipped += waiting - 1;
+        frameIndex += waiting - 1;
+    }
+
+    uint32_t at = (uint32_t)taken & (ringSize - 1);
+    uint32_t first = ringSize - at < (uint32_t)frameBytes ? ringSize - at : (uint32_t)frameBytes;
+    memcpy(frame, ring + at, first);
+    memcpy(frame + first, ring, frameBytes - first);
+    InterlockedExchangeAdd(&taken, frameBytes);
+    frameIndex++;
+    stats.frames++;
+    return true;
+}
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	clear
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	void clear()
+--
+-- RETURNS:     void
+--
+-- NOTES:
+--              Drops everything waiting, so the next frame read starts with the newest audio. The whole frames
+--              dropped are still counted in the frame numbers. Only called by the reading thread.
+--
+-------------------------------------------------------------------------------------------------------------------*/
+void CaptureRing::clear() {
+    uint32_t available = (uint32_t)(written - taken);
+    InterlockedExchangeAdd(&taken, (LONG)available);
+    frameIndex += available / frameBytes;
+}
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	readData
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	qint64 readData(char *data, qint64 maxSize)
+--
+-- RETURNS:     -1, the ring is only read with readFrame
+--
+-------------------------------------------------------------------------------------------------------------------*/
+qint64 CaptureRing::readData(char *, qint64) {
+    return -1;
+}
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	writeData
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	qint64 writeData(const char *data, qint64 maxSize)
+--                               data - audio from the microphone
+--                               maxSize - size of the audio
+--
+-- RETURNS:     maxSize, so the microphone never stalls
+--
+-- NOTES:
+--              Called by QAudioInput on the thread that owns it.
+--
+-------------------------------------------------------------------------------------------------------------------*/
+qint64 CaptureRing::writeData(const char *data, qint64 maxSize) {
+    uint32_t used = (uint32_t)(written - taken);
+    if (maxSize > (qint64)(ringSize - used)) {
+        stats.overruns++;
+        return maxSize;
+    }
+    uint32_t bytes = (uint32_t)maxSize;
+    uint32_t at = (uint32_t)written & (ringSize - 1);
+    uint32_t first = ringSize - at < bytes ? ringSize - at : bytes;
+    memcpy(ring + at, data, first);
+    memcpy(ring, data + first, bytes - first);
+    InterlockedExchangeAdd(&written, (LONG)bytes);
+    if (used + bytes >= (uint32_t)frameBytes) {
+        SetEvent(frameEvent);
+    }
+    return maxSize;
+}
@@ -0,0 +1,54 @@
+#pragma once
+#include <windows.h>
+#include <cstdint>
+#include <cstring>
+#include <QIODevice>
+
+#define CAPTURE_RING_FRAMES 16
+#define CAPTURE_MAX_BACKLOG 3
+
+class CaptureRing : public QIODevice {
+public:
+    struct Statistics {
+        uint64_t frames = 0;
+        uint32_t skipped = 0;
+        uint32_t overruns = 0;
+    };
+
+    CaptureRing(int frameBytes);
+    ~CaptureRing();
+    CaptureRing(const CaptureRing&) = delete;
+    void operator=(const CaptureRing&) = delete;
+
+    bool readFrame(char *frame, DWORD timeoutMs);
+    void clear();
+    bool isSequential() const override {
+        return true;
+    }
+    int getFrameBytes() const {
+        return frameBytes;
+    }
+    HANDLE getFrameEvent() const {
+        return frameEvent;
+    }
+    uint64_t getFrameIndex() const {
+        return frameIndex - 1;
+    }
+    Statistics getStatistics() const {
+        return stats;
+    }
+
+protected:
+    qint64 readData(char *data, qint64 maxSize) override;
+    qint64 writeData(const char *data, qint64 maxSize) override;
+
+private:
+    int frameBytes;
+    char *ring;
+    uint32_t ringSize;
+    volatile LONG written = 0;
+    volatile LONG taken = 0;
+    HANDLE frameEvent;
+    uint64_t frameIndex = 0;
+    Statistics stats;
+};
@@ -0,0 +1,790 @@
+/*------------------------------------------------------------------------------------------------------------------
+-- SOURCE FILE: 	channelmanager.cpp - Runs every multicast stream channel of the server from one thread.
+--
+--
+-- PROGRAM: 		Communication Audio Program
+--
+-- FUNCTIONS:
+--                  ChannelManager()
+--                  static int runFromArguments(int argc, char *argv[])
+--                  static QString benchmark(int channels, int seconds)
+--                  int addChannel(const std::vector<std::string> &playlist, const std::string &group, int port,
+--                                 int ttl)
+--                  bool openSendSocket(int ttl)
+--                  DWORD pacingThread(LPVOID lpParameter)
+--                  void stop()
+--                  StreamChannel *findChannel(int id)
+--                  bool pauseChannel(int id)
+--                  bool resumeChannel(int id)
+--                  bool seekChannel(int id, uint32_t positionMs)
+--                  bool skipChannel(int id, int32_t deltaMs)
+--                  bool getChannelPosition(int id, uint32_t &positionMs, uint32_t &lengthMs, bool &paused)
+--                  int getChannelCount()
+--                  QString getStatistics()
+--                  uint64_t nowMicros() const
+--
+-- DATE: 			October 19, 2026
+--
+-- REVISIONS:       October 19, 2026 - Channels stream a playlist - agent
+--                  October 19, 2026 - Channels compress with streamCodec - agent
+--                  October 19, 2026 - Send each wake's datagrams as one batch - agent
+--                  October 19, 2026 - Channels can serve unicast subscribers only - agent
+--                  October 19, 2026 - Pause, resume and seek channels - agent
+--                  October 19, 2026 - Add --channel-bench, channels per core - agent
+--
+-- DESIGNER: 		agent
+--
+-- PROGRAMMER: 		agent
+--
+-- NOTES:
+--      The ChannelManager is a singleton since the server process has one set of stations. Each station is a
+--      StreamChannel with its own source, multicast group and port. All of them are driven by one pacing thread
+--      and send through one multicast socket, with their datagrams kept in one PacketPool that holds a
+--      retransmission ring's worth of packets for every channel.
+--
+--      The pacing thread sleeps until the earliest channel deadline, but never less than CHANNEL_TICK_MS, and
+--      wakes early when a NACK arrives on any repair socket. Every wake sends the packets of all channels that
+--      are due within CHANNEL_SEND_AHEAD_US, so adding channels adds packets to each wake rather than more
+--      wakes, and the fixed per wake cost is shared. The datagrams of a wake are queued on one DatagramIO and
+--      flushed at the end of the pass, so a channel's packets to its group can leave in one segmented send.
+--      Setting sendOffload to false before the first channel starts sends them one at a time instead, which
+--      is the baseline to compare against.
+--
+--      Every channel also serves listeners that subscribe by unicast. Setting streamMulticast to false before
+--      a channel is added leaves that channel unicast only, for networks that block multicast.
+--
+--      The UI pauses, resumes and seeks a channel through the manager, which does it under the same lock the
+--      pacing thread holds for a pass, so a channel never changes in the middle of one, and then wakes the
+--      thread so the change goes out at once.
+--
+--      The statistics report how busy the pacing thread was, which gives an estimate of how many channels one
+--      core could carry at the current load. --channel-bench measures the same thing headless, with 1, 2, 4
+--      and up to a given number of channels all playing a generated tone, to show how the cost grows.
+--
+--------------------------------------------------------------------------------------------------------------------*/
+#include "channelmanager.h"
+#include <cmath>
+#include <cstdlib>
+
+static void writeU32(FILE *file, uint32_t value) {
+    unsigned char bytes[4] = { (unsigned char)value, (unsigned char)(value >> 8), (unsigned char)(value >> 16),
+                               (unsigned char)(value >> 24) };
+    fwrite(bytes, 1, 4, file);
+}
+
+static void writeU16(FILE *file, uint16_t value) {
+    unsigned char bytes[2] = { (unsigned char)value, (unsigned char)(value >> 8) };
+    fwrite(bytes, 1, 2, file);
+}
+
+static bool writeBenchTrack(const char *fileName) {
+    FILE *file = fopen(fileName, "wb");
+    if (file == NULL) {
+        return false;
+    }
+    uint32_t frames = 44100 * CHANNEL_BENCH_TRACK_SECONDS;
+    fwrite("RIFF", 1, 4, file);
+    writeU32(file, 36 + frames * 4);
+    fwrite("WAVEfmt ", 1, 8, file);
+    writeU32(file, 16);
+    writeU16(file, 1);
+    writeU16(file, 2);
+    writeU32(file, 44100);
+    writeU32(file, 44100 * 4);
+    writeU16(file, 4);
+    writeU16(file, 16);
+    fwrite("data", 1, 4, file);
+    writeU32(file, frames * 4);
+    for (uint32_t i = 0; i < frames; i++) {
+        int16_t sample = (int16_t)(8000 * sin(2 * 3.14159265358979 * 440 * i / 44100));
+        writeU16(file, (uint16_t)sample);
+        writeU16(file, (uint16_t)sample);
+    }
+    bool written = ferror(file) == 0;
+    fclose(file);
+    return written;
+}
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	ChannelManager
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	ChannelManager()
+--
+-- RETURNS:     NA
+--
+-------------------------------------------------------------------------------------------------------------------*/
+ChannelManager::ChannelManager() {
+    InitializeCriticalSection(&lock);
+    QueryPerformanceFrequency(&frequency);
+}
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	runFromArguments
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	static int runFromArguments(int argc, char *argv[])
+--                          argc - number of command line arguments
+--                          argv - the command line arguments
+--
+-- RETURNS:     The process exit code
+--
+-- NOTES:
+--              The form is
+--                  --channel-bench [channels] [seconds]
+--              The benchmark prints its result and returns.
+--
+-------------------------------------------------------------------------------------------------------------------*/
+int ChannelManager::runFromArguments(int argc, char *argv[]) {
+    if (strcmp(argv[1], "--channel-bench") != 0) {
+        qDebug() << "Usage: --channel-bench [channels] [seconds]\n";
+        return 1;
+    }
+    int channels = argc >= 3 ? atoi(argv[2]) : CHANNEL_BENCH_CHANNELS;
+    int seconds = argc >= 4 ? atoi(argv[3]) : CHANNEL_BENCH_SECONDS;
+    if (channels < 1 || channels > MAX_STREAM_CHANNELS) {
+        channels = CHANNEL_BENCH_CHANNELS;
+    }
+    WSADATA wsaData;
+    if (WSAStartup(0x0202, &wsaData) != 0) {
+        qDebug() << "WSAStartup failed with error \n" << WSAGetLastError();
+        return 1;
+    }
+    qDebug() << benchmark(channels, seconds > 0 ? seconds : CHANNEL_BENCH_SECONDS);
+    WSACleanup();
+    return 0;
+}
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	benchmark
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	static QString benchmark(int channels, int seconds)
+--                                channels - most channels to run at once
+--                                seconds - how long each step runs
+--
+-- RETURNS:     A summary of every step
+--
+-- NOTES:
+--              Writes a CHANNEL_BENCH_TRACK_SECONDS 44.1 kHz stereo tone to CHANNEL_BENCH_TRACK and streams it
+--              on 1, 2, 4 and so on up to channels channels, each step for seconds, with the manager's current
+--              codec and FEC settings. Every channel has its own port on CHANNEL_BENCH_GROUP, sent with a TTL of
+--              0 so nothing leaves the machine. The share of a core is the time the pacing thread spent in its
+--              passes over the length of the step.
+--
+-------------------------------------------------------------------------------------------------------------------*/
+QString ChannelManager::benchmark(int channels, int seconds) {
+    if (!writeBenchTrack(CHANNEL_BENCH_TRACK)) {
+        return QString("Could not write %1").arg(CHANNEL_BENCH_TRACK);
+    }
+    ChannelManager *manager = getInstance();
+    std::vector<std::string> playlist(1, CHANNEL_BENCH_TRACK);
+    QString summary = QString("Channel benchmark, %1 for %2 s per step")
+            .arg(AudioCodec::getName(manager->streamCodec))
+            .arg(seconds);
+    for (int count = 1; ; count = count * 2 < channels ? count * 2 : channels) {
+        int added = 0;
+        for (int i = 0; i < count; i++) {
+            added += manager->addChannel(playlist, CHANNEL_BENCH_GROUP, CHANNEL_BENCH_PORT + 2 * i, 0) > 0 ? 1 : 0;
+        }
+        EnterCriticalSection(&manager->lock);
+        uint64_t startedAt = manager->nowMicros();
+        uint64_t busy = manager->busyMicros;
+        DWORD packets = manager->packetsSent;
+        LeaveCriticalSection(&manager->lock);
+        Sleep(seconds * 1000);
+        EnterCriticalSection(&manager->lock);
+        double elapsed = (double)(manager->nowMicros() - startedAt);
+        double load = (manager->busyMicros - busy) / elapsed;
+        double packetRate = (manager->packetsSent - packets) / (elapsed / 1000000);
+        LeaveCriticalSection(&manager->lock);
+        manager->stop();
+
+        summary.append(QString(" | %1 channels: %2% of one core, %3 packets/s, about %4 channels per core")
+                       .arg(added)
+                       .arg(load * 100, 0, 'f', 2)
+                       .arg(packetRate, 0, 'f', 0)
+                       .arg(load > 0 ? added / load : 0, 0, 'f', 0));
+        if (count >= channels || added < count) {
+            break;
+        }
+    }
+    remove(CHANNEL_BENCH_TRACK);
+    return summary;
+}
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	nowMicros
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	uint64_t nowMicros() const
+--
+-- RETURNS:     Returns the performance counter in microseconds
+--
+-- NOTES:
+--              Splits the division so the multiply cannot overflow however long the machine has been up.
+--
+-------------------------------------------------------------------------------------------------------------------*/
+uint64_t ChannelManager::nowMicros() const {
+    LARGE_INTEGER counter;
+    QueryPerformanceCounter(&counter);
+    uint64_t ticks = (uint64_t)counter.QuadPart;
+    uint64_t perSecond = (uint64_t)frequency.QuadPart;
+    return ticks / perSecond * 1000000 + ticks % perSecond * 1000000 / perSecond;
+}
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	addChannel
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:   October 19, 2026 - Take a playlist instead of a single file - agent
+--              October 19, 2026 - Pass streamCodec to the channel - agent
+--              October 19, 2026 - Channels send through the shared DatagramIO - agent
+--              October 19, 2026 - Apply streamMulticast to the channel - agent
+--              October 19, 2026 - Grow the packet pool by a retransmission ring per channel - agent
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	int addChannel(const std::vector<std::string> &playlist, const std::string &group, int port,
+--                             int ttl)
+--                             playlist - audio files the channel streams in a loop
+--                             group - multicast group address
+--                             port - multicast port, must not be used by another channel
+--                             ttl - multicast TTL, only used when the first channel opens the send socket
+--
+-- RETURNS:     Returns the channel id, or -1 if the channel could not be started
+--
+-- NOTES:
+--              The channel starts streaming on the next wake of the pacing thread, which is started with the
+--              first channel. WSAStartup must already have been called.
+--
+-------------------------------------------------------------------------------------------------------------------*/
+int ChannelManager::addChannel(const std::vector<std::string> &playlist, const std::string &group, int port, int ttl) {
+    int id = -1;
+    EnterCriticalSection(&lock);
+    for (StreamChannel *channel : channels) {
+        int gap = channel->getPort() - port;
+        if (gap >= -STREAM_REPAIR_PORT_OFFSET && gap <= STREAM_REPAIR_PORT_OFFSET) {
+            qDebug() << "port" << port << "overlaps channel" << channel->getId() << "\n";
+            LeaveCriticalSection(&lock);
+            return -1;
+        }
+    }
+    if (channels.size() >= MAX_STREAM_CHANNELS) {
+        qDebug() << "too many channels \n";
+    } else if (sendSocket != INVALID_SOCKET || openSendSocket(ttl)) {
+        if (pool == nullptr) {
+            pool = new PacketPool(CHANNEL_POOL_PACKETS);
+        }
+        pool->grow((int)(channels.size() + 1) * CHANNEL_POOL_PACKETS);
+        StreamChannel *channel = new StreamChannel(nextId, playlist, group, port, fecGroupSize, streamCodec,
+                                                   sender, pool);
+        channel->setMulticast(streamMulticast);
+        if (channel->open()) {
+            channels.push_back(channel);
+            id = nextId++;
+        } else {
+            qDebug() << "unusable stream source \n";
+            delete channel;
+        }
+    }
+    LeaveCriticalSection(&lock);
+    if (id < 0) {
+        return -1;
+    }
+
+    if (!running) {
+        running = true;
+        reportedAt = nowMicros();
+        if ((thread = CreateThread(NULL, 0, pacingThread, NULL, 0, NULL)) == NULL) {
+            qDebug() << "CreateThread failed with error \n" << GetLastError();
+            running = false;
+        }
+    } else {
+        WSASetEvent(wakeEvent);
+    }
+    return id;
+}
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	openSendSocket
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:   October 19, 2026 - Wrap the socket in a DatagramIO - agent
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	bool openSendSocket(int ttl)
+--                                  ttl - multicast TTL
+--
+-- RETURNS:     Returns false if the socket could not be set up
+--
+-- NOTES:
+--              Creates the socket every channel multicasts through and the event used to wake the pacing
+--              thread when channels change.
+--
+-------------------------------------------------------------------------------------------------------------------*/
+bool ChannelManager::openSendSocket(int ttl) {
+    SOCKADDR_IN address;
+    if ((sendSocket = socket(AF_INET, SOCK_DGRAM, 0)) == INVALID_SOCKET) {
+        qDebug() << "Failed to get a socket \n" << WSAGetLastError();
+        return false;
+    }
+    memset(&address, 0, sizeof(address));
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_ANY);
+    address.sin_port = 0;
+    if (bind(sendSocket, (PSOCKADDR) &address, sizeof(address)) == SOCKET_ERROR) {
+        qDebug() << "bind() failed with error \n" << WSAGetLastError();
+        closesocket(sendSocket);
+        sendSocket = INVALID_SOCKET;
+        return false;
+    }
+    if (setsockopt(sendSocket, IPPROTO_IP, IP_MULTICAST_TTL, (char *)&ttl, sizeof(ttl)) == SOCKET_ERROR) {
+        qDebug() << "Failed to setsockopt to set ttl \n" << WSAGetLastError();
+    }
+    bool fFlag = FALSE;
+    if (setsockopt(sendSocket, IPPROTO_IP, IP_MULTICAST_LOOP, (char *)&fFlag, sizeof(fFlag)) == SOCKET_ERROR) {
+        qDebug() << "Failed to setsockopt to disable loopback \n" << WSAGetLastError();
+    }
+    if (wakeEvent == WSA_INVALID_EVENT && (wakeEvent = WSACreateEvent()) == WSA_INVALID_EVENT) {
+        qDebug() << "WSACreateEvent() failed with error \n" << WSAGetLastError();
+        closesocket(sendSocket);
+        sendSocket = INVALID_SOCKET;
+        return false;
+    }
+    sender = new DatagramIO(sendSocket);
+    if (sendOffload && !sender->enableSendOffload()) {
+        qDebug() << "UDP segmentation offload unavailable, sending one datagram per call \n";
+    }
+    return true;
+}
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	pacingThread
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:   October 19, 2026 - Flush the batched datagrams once per pass - agent
+--              October 19, 2026 - Find the channel of a signalled event by the slot it was given - agent
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	DWORD pacingThread(LPVOID lpParameter)
+--                                 lpParameter - unused
+--
+-- RETURNS:     Returns false if waiting on the events fails
+--
+-- NOTES:
+--              Each pass answers NACKs for the channels whose repair socket woke the thread, sends everything
+--              that is due, and waits for the earliest deadline, a NACK, or a change to the channel list.
+--              Only channels with a repair socket have an event in the wait, so each pass records which channel
+--              owns each slot. The wait reports the first signalled slot and later ones may be signalled too,
+--              so the channels owning that slot and every later one are serviced on the next pass.
+--
+-------------------------------------------------------------------------------------------------------------------*/
+DWORD WINAPI ChannelManager::pacingThread(LPVOID lpParameter) {
+    ChannelManager *manager = ChannelManager::getInstance();
+    WSAEVENT events[MAX_STREAM_CHANNELS + 1];
+    StreamChannel *owners[MAX_STREAM_CHANNELS + 1];
+    StreamChannel *signalled[MAX_STREAM_CHANNELS];
+    DWORD signalledCount = 0;
+    DWORD index = WSA_WAIT_TIMEOUT;
+
+    while (manager->running) {
+        uint64_t now = manager->nowMicros();
+        uint64_t next = UINT64_MAX;
+        DWORD count = 1;
+        events[0] = manager->wakeEvent;
+
+        EnterCriticalSection(&manager->lock);
+        manager->wakeups++;
+        for (size_t i = 0; i < manager->channels.size(); i++) {
+            StreamChannel *channel = manager->channels[i];
+            for (DWORD k = 0; k < signalledCount; k++) {
+                if (signalled[k] == channel) {
+                    channel->serviceRepairs();
+                    break;
+                }
+            }
+            manager->packetsSent += channel->pump(now);
+            if (channel->getNextDeadline() < next) {
+                next = channel->getNextDeadline();
+            }
+            if (channel->getRepairEvent() != WSA_INVALID_EVENT) {
+                owners[count] = channel;
+                events[count++] = channel->getRepairEvent();
+            }
+        }
+        manager->sender->flush();
+        uint64_t done = manager->nowMicros();
+        manager->busyMicros += done - now;
+        LeaveCriticalSection(&manager->lock);
+
+        DWORD timeout = WSA_INFINITE;
+        if (next != UINT64_MAX) {
+            uint64_t wake = next - CHANNEL_SEND_AHEAD_US;
+            timeout = wake > done ? (DWORD)((wake - done) / 1000) : 0;
+            if (timeout < CHANNEL_TICK_MS) {
+                timeout = CHANNEL_TICK_MS;
+            }
+        }
+        index = WSAWaitForMultipleEvents(count, events, FALSE, timeout, FALSE);
+        if (index == WSA_WAIT_FAILED) {
+            qDebug() << "WSAWaitForMultipleEvents failed with error \n" << WSAGetLastError();
+            manager->running = false;
+            return FALSE;
+        }
+        if (index == WSA_WAIT_EVENT_0) {
+            WSAResetEvent(events[0]);
+        }
+        // The owners are only compared with the channel list, so one removed meanwhile is never touched
+        signalledCount = 0;
+        DWORD first = index == WSA_WAIT_TIMEOUT ? count : index - WSA_WAIT_EVENT_0;
+        for (DWORD slot = first > 0 ? first : 1; slot < count; slot++) {
+            signalled[signalledCount++] = owners[slot];
+        }
+    }
+    return TRUE;
+}
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	stop
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:   October 19, 2026 - Free the DatagramIO - agent
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	void stop()
+--
+-- RETURNS:     void
+--
+-- NOTES:
+--              Stops the pacing thread and closes every channel and the multicast socket.
+--
+-------------------------------------------------------------------------------------------------------------------*/
+void ChannelManager::stop() {
+    if (running) {
+        running = false;
+        WSASetEvent(wakeEvent);
+        WaitForSingleObject(thread, INFINITE);
+    }
+    if (thread != NULL) {
+        CloseHandle(thread);
+        thread = NULL;
+    }
+    EnterCriticalSection(&lock);
+    for (StreamChannel *channel : channels) {
+        delete channel;
+    }
+    channels.clear();
+    delete sender;
+    sender = nullptr;
+    if (sendSocket != INVALID_SOCKET) {
+        closesocket(sendSocket);
+        sendSocket = INVALID_SOCKET;
+    }
+    LeaveCriticalSection(&lock);
+}
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	findChannel
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	StreamChannel *findChannel(int id)
+--                                 id - channel id returned by addChannel
+--
+-- RETURNS:     Returns the channel, or nullptr if there is none with that id
+--
+-- NOTES:
+--              The caller holds the lock.
+--
+-------------------------------------------------------------------------------------------------------------------*/
+StreamChannel *ChannelManager::findChannel(int id) {
+    for (StreamChannel *channel : channels) {
+        if (channel->getId() == id) {
+            return channel;
+        }
+    }
+    return nullptr;
+}
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	pauseChannel
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	bool pauseChannel(int id)
+--                                  id - channel id returned by addChannel
+--
+-- RETURNS:     Returns false if there is no such channel
+--
+-------------------------------------------------------------------------------------------------------------------*/
+bool ChannelManager::pauseChannel(int id) {
+    EnterCriticalSection(&lock);
+    StreamChannel *channel = findChannel(id);
+    if (channel != nullptr) {
+        channel->pause();
+    }
+    LeaveCriticalSection(&lock);
+    if (channel != nullptr) {
+        WSASetEvent(wakeEvent);
+    }
+    return channel != nullptr;
+}
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	resumeChannel
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	bool resumeChannel(int id)
+--                                   id - channel id returned by addChannel
+--
+-- RETURNS:     Returns false if there is no such channel
+--
+-------------------------------------------------------------------------------------------------------------------*/
+bool ChannelManager::resumeChannel(int id) {
+    EnterCriticalSection(&lock);
+    StreamChannel *channel = findChannel(id);
+    if (channel != nullptr) {
+        channel->resume();
+    }
+    LeaveCriticalSection(&lock);
+    if (channel != nullptr) {
+        WSASetEvent(wakeEvent);
+    }
+    return channel != nullptr;
+}
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	seekChannel
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	bool seekChannel(int id, uint32_t positionMs)
+--                                 id - channel id returned by addChannel
+--                                 positionMs - time in the current track to carry on from
+--
+-- RETURNS:     Returns false if there is no such channel or its track cannot seek there
+--
+-- NOTES:
+--              A seek in a WAV track is one fseek, so the pacing thread is held off for no longer than a pass.
+--
+-------------------------------------------------------------------------------------------------------------------*/
+bool ChannelManager::seekChannel(int id, uint32_t positionMs) {
+    EnterCriticalSection(&lock);
+    StreamChannel *channel = findChannel(id);
+    bool sought = channel != nullptr && channel->seek(positionMs);
+    LeaveCriticalSection(&lock);
+    if (sought) {
+        WSASetEvent(wakeEvent);
+    }
+    return sought;
+}
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	skipChannel
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	bool skipChannel(int id, int32_t deltaMs)
+--                                 id - channel id returned by addChannel
+--                                 deltaMs - how far to jump, negative to go back
+--
+-- RETURNS:     Returns false if there is no such channel or its track cannot seek there
+--
+-------------------------------------------------------------------------------------------------------------------*/
+bool ChannelManager::skipChannel(int id, int32_t deltaMs) {
+    EnterCriticalSection(&lock);
+    StreamChannel *channel = findChannel(id);
+    bool sought = channel != nullptr && channel->skip(deltaMs);
+    LeaveCriticalSection(&lock);
+    if (sought) {
+        WSASetEvent(wakeEvent);
+    }
+    return sought;
+}
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	getChannelPosition
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	bool getChannelPosition(int id, uint32_t &positionMs, uint32_t &lengthMs, bool &paused)
+--                                        id - channel id returned by addChannel
+--                                        positionMs - set to the position in the current track
+--                                        lengthMs - set to the length of the current track, 0 if unknown
+--                                        paused - set to whether the channel is paused
+--
+-- RETURNS:     Returns false if there is no such channel
+--
+-------------------------------------------------------------------------------------------------------------------*/
+bool ChannelManager::getChannelPosition(int id, uint32_t &positionMs, uint32_t &lengthMs, bool &paused) {
+    EnterCriticalSection(&lock);
+    StreamChannel *channel = findChannel(id);
+    if (channel != nullptr) {
+        positionMs = channel->getPositionMs();
+        lengthMs = channel->getLengthMs();
+        paused = channel->isPaused();
+    }
+    LeaveCriticalSection(&lock);
+    return channel != nullptr;
+}
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	getChannelCount
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	int getChannelCount()
+--
+-- RETURNS:     Returns the number of channels that have been started
+--
+-------------------------------------------------------------------------------------------------------------------*/
+int ChannelManager::getChannelCount() {
+    EnterCriticalSection(&lock);
+    int count = (int)channels.size();
+    LeaveCriticalSection(&lock);
+    return count;
+}
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	getStatistics
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:   October 19, 2026 - Add datagrams per send call - agent
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	QString getStatistics()
+--
+-- RETURNS:     Returns a summary of the pacing thread followed by one line per channel
+--
+-- NOTES:
+--              Rates cover the time since the previous call. The load is the share of that time the pacing
+--              thread spent working, and dividing the channel count by it estimates how many channels of the
+--              same kind one core could carry. Datagrams per send call show how well the sends are batched.
+--
+-------------------------------------------------------------------------------------------------------------------*/
+QString ChannelManager::getStatistics() {
+    EnterCriticalSection(&lock);
+    uint64_t now = nowMicros();
+    uint64_t elapsed = now > reportedAt ? now - reportedAt : 1;
+    double seconds = elapsed / 1000000.0;
+    double load = (double)(busyMicros - reportedBusy) / elapsed;
+    int count = (int)channels.size();
+    QString summary = QString("Pacing: %1 channels, %2 packets/s, %3 wakeups/s, %4% of one core")
+            .arg(count)
+            .arg((packetsSent - reportedPackets) / seconds, 0, 'f', 1)
+            .arg((wakeups - reportedWakeups) / seconds, 0, 'f', 1)
+            .arg(load * 100, 0, 'f', 2);
+    if (load > 0) {
+        summary.append(QString(", about %1 channels per core").arg((qint64)(count / load)));
+    }
+    if (sender != nullptr) {
+        const DatagramIO::Statistics &io = sender->getStatistics();
+        DWORD calls = io.sendCalls - reportedSendCalls;
+        summary.append(QString(" | Sends: %1 datagrams/s in %2 calls/s, segmentation offload %3")
+                       .arg((io.datagramsSent - reportedDatagrams) / seconds, 0, 'f', 1)
+                       .arg(calls / seconds, 0, 'f', 1)
+                       .arg(sender->isSendOffloaded() ? "on" : "off"));
+        reportedDatagrams = io.datagramsSent;
+        reportedSendCalls = io.sendCalls;
+    }
+    for (StreamChannel *channel : channels) {
+        summary.append("\n").append(channel->getStatistics());
+    }
+    reportedAt = now;
+    reportedBusy = busyMicros;
+    reportedPackets = packetsSent;
+    reportedWakeups = wakeups;
+    LeaveCriticalSection(&lock);
+    return summary;
+}
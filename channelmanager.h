@@ -0,0 +1,74 @@
+#pragma once
+#include <winsock2.h>
+#include <windows.h>
+#include <vector>
+#include <string>
+#include <QString>
+#include <QDebug>
+#include "streamchannel.h"
+
+#define MAX_STREAM_CHANNELS 32
+#define CHANNEL_TICK_MS 10
+#define CHANNEL_POOL_PACKETS RETRANSMIT_RING_SIZE
+#define CHANNEL_BENCH_CHANNELS MAX_STREAM_CHANNELS
+#define CHANNEL_BENCH_SECONDS 5
+#define CHANNEL_BENCH_GROUP "239.255.42.1"
+#define CHANNEL_BENCH_PORT 41000
+#define CHANNEL_BENCH_TRACK "channel-bench.wav"
+#define CHANNEL_BENCH_TRACK_SECONDS 10
+
+class ChannelManager {
+private:
+    ChannelManager();
+    static DWORD WINAPI pacingThread(LPVOID lpParameter);
+    bool openSendSocket(int ttl);
+    StreamChannel *findChannel(int id);
+
+    std::vector<StreamChannel *> channels;
+    CRITICAL_SECTION lock;
+    PacketPool *pool = nullptr;
+    SOCKET sendSocket = INVALID_SOCKET;
+    DatagramIO *sender = nullptr;
+    WSAEVENT wakeEvent = WSA_INVALID_EVENT;
+    HANDLE thread = NULL;
+    volatile bool running = false;
+    int nextId = 1;
+    LARGE_INTEGER frequency;
+
+    DWORD wakeups = 0;
+    DWORD packetsSent = 0;
+    uint64_t busyMicros = 0;
+    DWORD reportedWakeups = 0;
+    DWORD reportedDatagrams = 0;
+    DWORD reportedSendCalls = 0;
+    DWORD reportedPackets = 0;
+    uint64_t reportedBusy = 0;
+    uint64_t reportedAt = 0;
+
+public:
+    static ChannelManager* getInstance() {
+        static ChannelManager* manager = new ChannelManager();
+        return manager;
+    }
+    void operator=(ChannelManager const&) = delete;
+    ~ChannelManager() = default;
+
+    static int runFromArguments(int argc, char *argv[]);
+    static QString benchmark(int channels, int seconds);
+
+    int fecGroupSize = DEFAULT_FEC_GROUP_SIZE;
+    uint8_t streamCodec = CODEC_IMA_ADPCM;
+    bool sendOffload = true;
+    bool streamMulticast = true;
+
+    int addChannel(const std::vector<std::string> &playlist, const std::string &group, int port, int ttl);
+    void stop();
+    bool pauseChannel(int id);
+    bool resumeChannel(int id);
+    bool seekChannel(int id, uint32_t positionMs);
+    bool skipChannel(int id, int32_t deltaMs);
+    bool getChannelPosition(int id, uint32_t &positionMs, uint32_t &lengthMs, bool &paused);
+    int getChannelCount();
+    QString getStatistics();
+    uint64_t nowMicros() const;
+};
@@ -6,10 +6,24 @@
 -- PROGRAM: 		Communication Audio Program
 --
 -- FUNCTIONS:
+--                  Client()
 --                  bool createSocket()
 --                  DWORD connectTCPServer(LPVOID lpParameter)
 --                  bool connectServer()
 --                  bool disconnectClient()
+--                  void sendDueNacks()
+--                  void sendJoin()
+--                  void sendSubscribe()
+--                  void sendProbe()
+--                  void readRepairs()
+--                  void receiveStream(const char *datagram, int bytes, const SOCKADDR_IN &from)
+--                  void tuneStreamSockets()
+--                  void useStreamFormat(AudioDevice *audioPlayer, const StreamDescriptor &format)
+--                  void playStreamAudio(AudioDevice *audioPlayer, const char *data, int length)
+--                  void concealStreamLoss(AudioDevice *audioPlayer)
+--                  void handleStreamDiscontinuity(AudioDevice *audioPlayer, DiscontinuityReason reason)
+--                  void writeStreamAudio(AudioDevice *audioPlayer, const char *data, int length)
+--                  QString getStreamStatistics()
 --
 -- DATE: 			March 20, 2020
 --
@@ -29,6 +43,31 @@
 --------------------------------------------------------------------------------------------------------------------*/
 #include "client.h"
 
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	Client
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	Client()
+--
+-- RETURNS:     NA
+--
+-- NOTES:
+--      streamLock is held while a stream is being set up and while its statistics are read, so the GUI never
+--      reads a receiver, scheduler, ring or tuner that the stream thread is replacing.
+--
+-------------------------------------------------------------------------------------------------------------------*/
+Client::Client()
+{
+    InitializeCriticalSection(&streamLock);
+}
+
 /*-----------------------------------------------------------------------------------------------------------------
 -- Function:	createSocket
 --
@@ -99,7 +138,7 @@ bool Client::createSocket(protocol type)
 --
 -- DATE:		February 12, 2020
 --
--- REVISIONS:
+-- REVISIONS:   October 19, 2026 - Size the send buffer for file transfers - agent
 --
 -- DESIGNER: 	Victor Phan
 --
@@ -122,6 +161,8 @@ DWORD Client::connectTCPServer(LPVOID lpParameter)
         qDebug() << "Failure creating socket." << WSAGetLastError();
         return false;
     }
+    SocketTuner fileTuner(Client::getInstance()->clientSocket, SocketTuner::SEND, SOCKET_FILE_RATE);
+    qDebug() << "File socket buffers:" << fileTuner.describe();
     Client::getInstance()->buf = (char *)malloc(CLIENT_DATABUF_SIZE);
     if (WSAConnect(Client::getInstance()->clientSocket,
                    (struct sockaddr *)&Client::getInstance()->serverAddressInfo,
@@ -236,7 +277,7 @@ bool Client::disconnectClient()
 --
 -- DATE:		April 3, 2020
 --
--- REVISIONS:
+-- REVISIONS:   October 19, 2026 - Stop the stream thread this one replaces - agent
 --
 -- DESIGNER: 	Ellaine Chan
 --
@@ -248,6 +289,9 @@ bool Client::disconnectClient()
 --
 -- NOTES:
 --      Calls create socket to set up the udp socket and creates a new thread to join a multicast stream.
+--      A stream thread already running is told to stop, and the new thread waits for it to finish before
+--      replacing anything it uses. The wait is left to the new thread because the old one may be waiting on
+--      the GUI thread to change the player's format.
 --
 -------------------------------------------------------------------------------------------------------------------*/
 void Client::joinStream()
@@ -261,13 +305,29 @@ void Client::joinStream()
 
     Client::clientSocket = createSocket(protocol::UDP);
 
+    if (streamStopEvent != NULL)
+    {
+        SetEvent(streamStopEvent);
+    }
+    StreamStart *start = new StreamStart;
+    start->audioPlayer = clientAudioPlayer;
+    start->stopEvent = CreateEvent(NULL, TRUE, FALSE, NULL);
+    start->previousThread = streamThread;
+    start->previousStopEvent = streamStopEvent;
 
-    if ((Client::getInstance()->threadHandle = CreateThread(NULL, 0, &joinMulticastStream, clientAudioPlayer, 0, &Client::getInstance()->threadArray[Client::getInstance()->threadIndex++])) == NULL)
+    // The new thread deletes start, so nothing in it is read once the thread is running
+    HANDLE stopEvent = start->stopEvent;
+    HANDLE thread;
+    if ((thread = CreateThread(NULL, 0, &joinMulticastStream, start, 0, &Client::getInstance()->threadArray[Client::getInstance()->threadIndex++])) == NULL)
     {
         qDebug() << "CreateThread failed with error %d\n"
                  << GetLastError();
+        CloseHandle(stopEvent);
+        delete start;
         return;
     }
+    streamThread = thread;
+    streamStopEvent = stopEvent;
 }
 
 /*-----------------------------------------------------------------------------------------------------------------
@@ -275,7 +335,24 @@ void Client::joinStream()
 --
 -- DATE:		April 3, 2020
 --
--- REVISIONS:
+-- REVISIONS:   October 19, 2026 - Feed datagrams through a StreamReceiver for reordering and FEC - agent
+--              October 19, 2026 - Keep one read posted and send NACKs over a unicast repair socket - agent
+--              October 19, 2026 - Switch the player to the format the server announces - agent
+--              October 19, 2026 - Report the title of the track that is playing - agent
+--              October 19, 2026 - Decode compressed streams before playing them - agent
+--              October 19, 2026 - Ask the server for a burst of recent audio on joining - agent
+--              October 19, 2026 - Read every waiting datagram on each wake - agent
+--              October 19, 2026 - Subscribe by unicast when no multicast arrives - agent
+--              October 19, 2026 - Join the group through openMulticastReceiver - agent
+--              October 19, 2026 - Conceal lost packets instead of skipping them - agent
+--              October 19, 2026 - Start each stream with no drift learned - agent
+--              October 19, 2026 - Start each stream with no resampler history - agent
+--              October 19, 2026 - Start cleanly after the server seeks or pauses - agent
+--              October 19, 2026 - Measure the stream's latency and probe the server - agent
+--              October 19, 2026 - Keep a ring of reads posted on the stream socket - agent
+--              October 19, 2026 - Size the sockets' receive buffers as the stream runs - agent
+--              October 19, 2026 - Replace the stream's state under streamLock - agent
+--              October 19, 2026 - Wait for the stream thread being replaced, and end on the stop event - agent
 --
 -- DESIGNER: 	Ellaine Chan
 --
@@ -286,85 +363,126 @@ void Client::joinStream()
 -- RETURNS:     void
 --
 -- NOTES:
---      Sets up socket to join a multicast stream. It loops recvFrom to read chunks of audio data
---      from the multicast socket continuously. RecFrom uses a completion routine to process received data.
+--      Sets up socket to join a multicast stream. A ReceiveRing keeps streamReceiveDepth reads posted on the
+--      multicast socket, so a burst of audio lands in the posted buffers instead of being dropped while the
+--      thread handles the packet before it. Their completion routines run while the loop waits.
+--      The loop also wakes every NACK_POLL_MS to read repairs and to NACK packets that are still missing.
+--      A join request goes to the server's repair port straight away if the server address was entered, or
+--      as soon as the first multicast packet shows where the stream comes from.
+--      The repair socket is non-blocking and read through a DatagramIO, so each wake handles every datagram
+--      that has arrived rather than one.
+--      If the server address is known but no multicast has arrived after SUBSCRIBE_FALLBACK_MS, the stream
+--      socket subscribes to the server by unicast and the stream comes in on the same socket.
+--      Every stream starts with a fresh LatencyMeter, and the server is probed from the repair socket.
+--      SocketTuners size the receive buffers of both sockets, and are updated on every wake.
+--      Everything the statistics read is replaced while holding streamLock.
+--      A thread started to replace another first waits for that one to end, so nothing of the old stream is
+--      freed while its reads are posted. The loop ends when the thread's stop event is set; the reads are
+--      then cancelled from this thread, which posted them, and their completion routines drained with
+--      ReceiveRing::stop before the sockets are closed. The thread that replaces it closes its handles.
 --
 -------------------------------------------------------------------------------------------------------------------*/
 DWORD WINAPI Client::joinMulticastStream(LPVOID lpParameter)
 {
-    AudioDevice *audioPlayer = (AudioDevice *)lpParameter;
+    StreamStart *start = (StreamStart *)lpParameter;
+    AudioDevice *audioPlayer = start->audioPlayer;
+    HANDLE stopEvent = start->stopEvent;
+    if (start->previousThread != NULL)
+    {
+        WaitForSingleObject(start->previousThread, INFINITE);
+        CloseHandle(start->previousThread);
+        CloseHandle(start->previousStopEvent);
+    }
+    delete start;
     qDebug() << "in joinMulticastStream!";
-    SOCKADDR_IN stLclAddr;
-    struct ip_mreq stMreq;
     SOCKET hSocket;
-    bool fFlag;
-    int nRet;
 
-    hSocket = socket(AF_INET,
-                     SOCK_DGRAM,
-                     0);
+    hSocket = openMulticastReceiver(DEFAULT_MULTICAST_ADDR, Client::getInstance()->port);
     if (hSocket == INVALID_SOCKET)
     {
-        printf("socket() failed, Err: %d\n", WSAGetLastError());
         WSACleanup();
         exit(1);
     }
-    fFlag = TRUE;
-    nRet = setsockopt(hSocket,
-                      SOL_SOCKET,
-                      SO_REUSEADDR,
-                      (char *)&fFlag,
-                      sizeof(fFlag));
-    if (nRet == SOCKET_ERROR)
-    {
-        printf("setsockopt() SO_REUSEADDR failed, Err: %d\n",
-               WSAGetLastError());
-    }
-    stLclAddr.sin_family = AF_INET;
-    stLclAddr.sin_addr.s_addr = htonl(INADDR_ANY);
-    stLclAddr.sin_port = htons(Client::getInstance()->port);
-    nRet = bind(hSocket,
-                (struct sockaddr *)&stLclAddr,
-                sizeof(stLclAddr));
-    if (nRet == SOCKET_ERROR)
-    {
-        printf("bind() port: %d failed, Err: %d\n", Client::getInstance()->port,
-               WSAGetLastError());
-    }
-
-    /* Join the multicast group so we can receive from it */
-    stMreq.imr_multiaddr.s_addr = inet_addr(DEFAULT_MULTICAST_ADDR);
-    stMreq.imr_interface.s_addr = INADDR_ANY;
-    nRet = setsockopt(hSocket,
-                      IPPROTO_IP,
-                      IP_ADD_MEMBERSHIP,
-                      (char *)&stMreq,
-                      sizeof(stMreq));
-    if (nRet == SOCKET_ERROR)
-    {
-        printf(
-                    "setsockopt() IP_ADD_MEMBERSHIP address %s failed, Err: %d\n",
-                    DEFAULT_MULTICAST_ADDR, WSAGetLastError());
-    }
-
-    //set up completion routine read
-    DWORD Flags, Index, RecvBytes;
-    WSAOVERLAPPED Overlapped;
+
+    //set up completion routine reads
+    DWORD Index;
     WSAEVENT readEvent;
-    LPSOCKET_INFORMATION SocketInfo;
+    WSAEVENT events[2];
+
+    EnterCriticalSection(&Client::getInstance()->streamLock);
+    delete Client::getInstance()->streamReceiver;
+    delete Client::getInstance()->nackScheduler;
+    Client::getInstance()->streamReceiver = new StreamReceiver(DEFAULT_PLAYOUT_DEPTH,
+        [audioPlayer](const char *data, int length) {
+            Client::getInstance()->playStreamAudio(audioPlayer, data, length);
+        },
+        [audioPlayer](const StreamDescriptor &format) {
+            Client::getInstance()->useStreamFormat(audioPlayer, format);
+        });
+    Client::getInstance()->streamReceiver->setTrackCallback([](const std::string &title) {
+        emit Client::getInstance()->streamTrackChanged(QString::fromStdString(title));
+    });
+    Client::getInstance()->streamReceiver->setLossCallback([audioPlayer]() {
+        Client::getInstance()->concealStreamLoss(audioPlayer);
+    });
+    Client::getInstance()->streamReceiver->setDiscontinuityCallback(
+        [audioPlayer](DiscontinuityReason reason, uint32_t) {
+            Client::getInstance()->handleStreamDiscontinuity(audioPlayer, reason);
+        });
+    Client::getInstance()->streamConcealer.reset();
+    Client::getInstance()->streamDrift.reset();
+    Client::getInstance()->streamConverter.reset();
+    Client::getInstance()->nackScheduler = new NackScheduler(GetTickCount() ^ (uint32_t)hSocket);
+    Client::getInstance()->streamReceiver->setNackScheduler(Client::getInstance()->nackScheduler);
+    Client::getInstance()->streamLatency = LatencyMeter();
+    Client::getInstance()->streamReceiver->setLatencyMeter(&Client::getInstance()->streamLatency);
+    Client::getInstance()->streamSenderKnown = false;
+    Client::getInstance()->repairsReceived = 0;
+    Client::getInstance()->repairsInTime = 0;
+    delete Client::getInstance()->streamDecoder;
+    Client::getInstance()->streamDecoder = nullptr;
+    Client::getInstance()->streamCodec = CODEC_PCM;
+    Client::getInstance()->decodeStats = AudioCodec::Statistics();
+    Client::getInstance()->joinAttempts = 0;
+    Client::getInstance()->firstAudioAt = 0;
+    Client::getInstance()->burstReceived = 0;
+    Client::getInstance()->joinStartedAt = GetTickCount();
+    Client::getInstance()->streamSocket = hSocket;
+    Client::getInstance()->subscribed = false;
+    delete Client::getInstance()->streamRing;
+    Client::getInstance()->streamRing = new ReceiveRing(hSocket, Client::getInstance()->streamReceiveDepth,
+        [](const char *datagram, int bytes, const SOCKADDR_IN &from) {
+            Client::getInstance()->receiveStream(datagram, bytes, from);
+        });
+    delete Client::getInstance()->streamTuner;
+    Client::getInstance()->streamTuner = new SocketTuner(hSocket, SocketTuner::RECEIVE, 0);
+
+    // A unicast server address lets the join request go out before any multicast arrives
+    unsigned long serverAddress = inet_addr(Client::getInstance()->ip.c_str());
+    ZeroMemory(&Client::getInstance()->joinAddress, sizeof(SOCKADDR_IN));
+    Client::getInstance()->joinAddress.sin_family = AF_INET;
+    Client::getInstance()->joinAddress.sin_addr.s_addr = serverAddress;
+    Client::getInstance()->joinAddressKnown = serverAddress != INADDR_NONE && serverAddress != INADDR_ANY &&
+            (ntohl(serverAddress) & 0xF0000000) != 0xE0000000;
 
-    if ((SocketInfo = (LPSOCKET_INFORMATION)GlobalAlloc(GPTR,
-                                                        sizeof(SOCKET_INFORMATION))) == NULL)
+    // Unicast socket used to send NACKs and receive the repairs the server sends back
+    if ((Client::getInstance()->repairSocket = socket(AF_INET, SOCK_DGRAM, 0)) == INVALID_SOCKET)
     {
-        qDebug() << "GlobalAlloc() failed with error \n"
-                 << GetLastError();
-        return 1;
+        printf("repair socket() failed, Err: %d\n", WSAGetLastError());
+        Client::getInstance()->repairSocket = 0;
+    }
+    delete Client::getInstance()->repairIO;
+    Client::getInstance()->repairIO = nullptr;
+    delete Client::getInstance()->repairTuner;
+    Client::getInstance()->repairTuner = nullptr;
+    if (Client::getInstance()->repairSocket != 0)
+    {
+        Client::getInstance()->repairIO = new DatagramIO(Client::getInstance()->repairSocket);
+        Client::getInstance()->repairIO->enableReceiveCoalescing();
+        Client::getInstance()->repairTuner = new SocketTuner(Client::getInstance()->repairSocket,
+                                                             SocketTuner::RECEIVE, 0);
     }
-    ZeroMemory(&(SocketInfo->Overlapped), sizeof(WSAOVERLAPPED));
-    SocketInfo->Socket = hSocket;
-    SocketInfo->DataBuf.len = DATA_BUFSIZE;
-    SocketInfo->DataBuf.buf = SocketInfo->Buffer;
-    SocketInfo->audioPlayer = audioPlayer;
+    LeaveCriticalSection(&Client::getInstance()->streamLock);
 
     if ((readEvent = WSACreateEvent()) == WSA_INVALID_EVENT)
     {
@@ -373,184 +491,699 @@ DWORD WINAPI Client::joinMulticastStream(LPVOID lpParameter)
         return 1;
     }
 
-    if (WSAEventSelect(hSocket, readEvent, FD_READ))
+    if (Client::getInstance()->repairSocket != 0 &&
+            WSAEventSelect(Client::getInstance()->repairSocket, readEvent, FD_READ))
     {
         qDebug() << "Faled to tie event to socket";
         return 1;
     }
-    SocketInfo->audioPlayer->playFromBuffer();
+    audioPlayer->playFromBuffer();
     qDebug() << "right before recvb!";
+    if (Client::getInstance()->streamRing->refill() == 0)
+    {
+        printf("failed to read\n");
+        Client::getInstance()->streamSocket = INVALID_SOCKET;
+        closeSocket(hSocket);
+        return -1;
+    }
+    events[0] = stopEvent;
+    events[1] = readEvent;
     while (true)
     {
-        Flags = 0;
-        Index = WSAWaitForMultipleEvents(1, &readEvent, FALSE, WSA_INFINITE, TRUE);
-        if (WSARecvFrom(hSocket, &(SocketInfo->DataBuf), 1, &RecvBytes, &Flags,
-                        NULL, NULL, &(SocketInfo->Overlapped), PlayStreamWorkerRoutine) == SOCKET_ERROR)
+        // Reads whose posting failed are posted again on the next wake
+        Client::getInstance()->streamRing->refill();
+        // Wakes for completed reads, repairs, or every NACK_POLL_MS to send NACKs that are due
+        Index = WSAWaitForMultipleEvents(2, events, FALSE, NACK_POLL_MS, TRUE);
+        if (Index == WSA_WAIT_EVENT_0)
+        {
+            break;
+        }
+        if (Index == WSA_WAIT_EVENT_0 + 1)
         {
-            printf("failed to read\n");
-            GlobalFree(SocketInfo);
-            closeSocket(hSocket);
-            return -1;
+            WSAResetEvent(readEvent);
+            Client::getInstance()->readRepairs();
         }
+        Client::getInstance()->sendJoin();
+        Client::getInstance()->sendSubscribe();
+        Client::getInstance()->sendProbe();
+        Client::getInstance()->sendDueNacks();
+        Client::getInstance()->tuneStreamSockets();
     }
+
+    // Cancel the posted reads and run their completion routines before anything they use can be freed
+    Client::getInstance()->streamRing->stop();
+    EnterCriticalSection(&Client::getInstance()->streamLock);
+    Client::getInstance()->streamSocket = INVALID_SOCKET;
+    LeaveCriticalSection(&Client::getInstance()->streamLock);
+    closeSocket(hSocket);
+    if (Client::getInstance()->repairSocket != 0)
+    {
+        closeSocket(Client::getInstance()->repairSocket);
+        Client::getInstance()->repairSocket = 0;
+    }
+    WSACloseEvent(readEvent);
+    return 0;
 }
 
 /*-----------------------------------------------------------------------------------------------------------------
--- Function:	PlayStreamWorkerRoutine
+-- Function:	sendDueNacks
 --
--- DATE:		April 3, 2020
+-- DATE:		October 19, 2026
 --
 -- REVISIONS:
 --
--- DESIGNER: 	Ellaine Chan
+-- DESIGNER: 	agent
 --
--- PROGRAMMER: 	Ellaine Chan
+-- PROGRAMMER: 	agent
 --
--- INTERFACE:	void PlayStreamWorkerRoutine(DWORD error, DWORD bytesTransferred, LPWSAOVERLAPPED overlapped, DWORD InFlags)
+-- INTERFACE:	void sendDueNacks()
 --
 -- RETURNS:     void
 --
 -- NOTES:
---      Processes received audio data from multicast socket. Writes the received message into the audio device
---      to play. If there is an error in receiving it will close the socket.
+--      Sends one NACK listing every missing packet whose suppression delay has run out. The NACK goes to the
+--      address the stream is multicast from, on the stream port + STREAM_REPAIR_PORT_OFFSET.
 --
 -------------------------------------------------------------------------------------------------------------------*/
-void CALLBACK Client::PlayStreamWorkerRoutine(DWORD error, DWORD bytesTransferred, LPWSAOVERLAPPED overlapped, DWORD InFlags)
+void Client::sendDueNacks()
 {
-    // Reference the WSAOVERLAPPED structure as a SOCKET_INFORMATION structure
-    LPSOCKET_INFORMATION SI = (LPSOCKET_INFORMATION)overlapped;
-    if (error != 0)
+    uint32_t sequences[NACK_MAX_SEQUENCES];
+    char nack[DATA_BUFSIZE];
+    if (repairSocket == 0 || !streamSenderKnown)
     {
-        qDebug() << "I/O operation failed with error: " << error;
+        return;
     }
-
-    if (error != 0 || bytesTransferred == 0)
+    int count = nackScheduler->collectDue(GetTickCount(), sequences, NACK_MAX_SEQUENCES);
+    if (count == 0)
     {
-        //Close the socket
-        QString message = QString("Read Complete on socket: ").append(QString::number(SI->Socket));
-        emit SI->device->sendMessageToScreen(message);
-        closeSocket(SI->Socket);
-        GlobalFree(SI);
         return;
     }
-    qDebug() << "received! Playing!";
-    SI->audioPlayer->addToPlayBuffer(QByteArray::fromRawData(SI->Buffer, bytesTransferred));
+    SOCKADDR_IN repairAddress = streamSenderAddr;
+    repairAddress.sin_port = htons((u_short)(port + STREAM_REPAIR_PORT_OFFSET));
+    int bytes = StreamPacket::buildNack(sequences, count, nack);
+    if (sendto(repairSocket, nack, bytes, 0, (struct sockaddr *)&repairAddress, sizeof(repairAddress)) < 0)
+    {
+        perror("send to \n");
+    }
 }
 
-
-//! Two Way Mic ------------------------------------------------------------
-
 /*-----------------------------------------------------------------------------------------------------------------
--- Function:    connectCall
+-- Function:	sendJoin
 --
--- DATE:		March  30, 2020
+-- DATE:		October 19, 2026
 --
--- REVISIONS:   NA
+-- REVISIONS:
 --
--- DESIGNER: 	Nicole Jingco
+-- DESIGNER: 	agent
 --
--- PROGRAMMER: 	Nicole Jingco
+-- PROGRAMMER: 	agent
 --
--- INTERFACE:
+-- INTERFACE:	void sendJoin()
 --
--- RETURNS:     NA
+-- RETURNS:     void
 --
 -- NOTES:
+--      Asks the server for the last joinBurstMs of audio so the playout buffer fills at once instead of from
+--      live packets. The request is repeated every JOIN_RETRY_MS, up to JOIN_MAX_ATTEMPTS times, until audio
+--      starts playing. A joinBurstMs of 0 turns the burst off.
 --
--- Used to call the start of receiving voice messages fro Two Way Mic
 -------------------------------------------------------------------------------------------------------------------*/
-void Client::connectCall()
+void Client::sendJoin()
 {
-    if (!startUpWSA()) {
-        qDebug() << "WSAStartup failed with error %d\n" << WSAGetLastError();
+    char join[DATA_BUFSIZE];
+    DWORD now = GetTickCount();
+    if (repairSocket == 0 || joinBurstMs == 0 || firstAudioAt != 0 || joinAttempts >= JOIN_MAX_ATTEMPTS ||
+            (joinAttempts > 0 && now - joinSentAt < JOIN_RETRY_MS))
+    {
         return;
     }
-
-    Client::clientSocket = createSocket(protocol::UDP);
-
-    if ((Client::getInstance()->threadHandle = CreateThread(NULL, 0, &joinCall, clientMicrophone, 0, &Client::getInstance()->threadArray[Client::getInstance()->threadIndex++])) == NULL) {
-        qDebug() << "CreateThread failed with error %d\n" << GetLastError();
+    SOCKADDR_IN serverAddress;
+    if (joinAddressKnown)
+    {
+        serverAddress = joinAddress;
+    }
+    else if (streamSenderKnown)
+    {
+        serverAddress = streamSenderAddr;
+    }
+    else
+    {
         return;
     }
+    serverAddress.sin_port = htons((u_short)(port + STREAM_REPAIR_PORT_OFFSET));
+    int bytes = StreamPacket::buildJoin(joinBurstMs, join);
+    if (sendto(repairSocket, join, bytes, 0, (struct sockaddr *)&serverAddress, sizeof(serverAddress)) < 0)
+    {
+        perror("send to \n");
+    }
+    joinAttempts++;
+    joinSentAt = now;
 }
 
 /*-----------------------------------------------------------------------------------------------------------------
--- Function:    joinCall
+-- Function:	sendSubscribe
 --
--- DATE:		March  30, 2020
+-- DATE:		October 19, 2026
 --
--- REVISIONS:   NA
+-- REVISIONS:   October 19, 2026 - Look for multicast in the receive ring's count - agent
 --
--- DESIGNER: 	Nicole Jingco
+-- DESIGNER: 	agent
 --
--- PROGRAMMER: 	Nicole Jingco
+-- PROGRAMMER: 	agent
 --
--- INTERFACE:
+-- INTERFACE:	void sendSubscribe()
 --
--- RETURNS:     NA
+-- RETURNS:     void
 --
 -- NOTES:
+--      Subscribes the stream socket to the server's repair port, so the server sends every stream packet to
+--      it by unicast, and renews the subscription every SUBSCRIBE_REFRESH_MS. The client subscribes when
+--      subscribeUnicast is set, or when nothing has come in on the multicast socket by SUBSCRIBE_FALLBACK_MS
+--      after joining. It needs the server's unicast address, since a multicast group cannot be subscribed to.
 --
--- This function creates a socekt, starts recording mic. it then reads the file the audio is sent to and
--- sends it to the client its connected too.
 -------------------------------------------------------------------------------------------------------------------*/
-DWORD WINAPI Client::joinCall(LPVOID lpParameter)
+void Client::sendSubscribe()
 {
-    AudioDevice* mic = (AudioDevice*) lpParameter;
-    bool fFlag = TRUE;
-    struct hostent *hp;
-    const char *ipAddress = Client::getInstance()->ip.c_str();
-    Client::getInstance()->fileHandler = new FileHandler("recording.wav");
-
-    qDebug() << "in call!";
-    SOCKADDR_IN addr;
-    SOCKET sock;
-    int err = 0;
-
-    mic->startRecording();
-
-    sock = socket(PF_INET , SOCK_DGRAM, 0);
-    if (sock == INVALID_SOCKET) {
-        printf ("socket() failed, Err: %d\n", WSAGetLastError());
-        WSACleanup();
-        exit(1);
+    char subscribe[DATA_BUFSIZE];
+    DWORD now = GetTickCount();
+    if (!joinAddressKnown || streamSocket == INVALID_SOCKET)
+    {
+        return;
     }
-
-    err = setsockopt(sock, SOL_SOCKET, SO_REUSEADDR, (char *)&fFlag, sizeof(fFlag));
-    if (err == SOCKET_ERROR) {
-        printf ("setsockopt() SO_REUSEADDR failed, Err: %d\n",
-                WSAGetLastError());
+    if (!subscribed)
+    {
+        if (!subscribeUnicast && (streamRing->getStatistics().datagramsReceived > 0 || now - joinStartedAt < SUBSCRIBE_FALLBACK_MS))
+        {
+            return;
+        }
+        subscribed = true;
     }
+    else if (now - subscribeSentAt < SUBSCRIBE_REFRESH_MS)
+    {
+        return;
+    }
+    SOCKADDR_IN serverAddress = joinAddress;
+    serverAddress.sin_port = htons((u_short)(port + STREAM_REPAIR_PORT_OFFSET));
+    int bytes = StreamPacket::buildSubscribe(subscribe);
+    if (sendto(streamSocket, subscribe, bytes, 0, (struct sockaddr *)&serverAddress, sizeof(serverAddress)) < 0)
+    {
+        perror("send to \n");
+    }
+    subscribeSentAt = now;
+}
 
-    if ((hp = gethostbyname(ipAddress)) == NULL)
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	sendProbe
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	void sendProbe()
+--
+-- RETURNS:     void
+--
+-- NOTES:
+--      Sends an echo probe to the server's repair port every LATENCY_PROBE_MS, to the same address join
+--      requests go to. The server answers on the repair socket with its own clock, which is the clock the
+--      stream's audio packets are stamped with, so the replies give both the round trip and the offset that
+--      turns those stamps into transit times.
+--
+-------------------------------------------------------------------------------------------------------------------*/
+void Client::sendProbe()
+{
+    char probe[DATA_BUFSIZE];
+    SOCKADDR_IN serverAddress;
+    if (joinAddressKnown)
     {
-        qDebug() << "Unknown server address\n";
-        return false;
+        serverAddress = joinAddress;
+    }
+    else if (streamSenderKnown)
+    {
+        serverAddress = streamSenderAddr;
     }
+    else
+    {
+        return;
+    }
+    DWORD now = GetTickCount();
+    if (repairSocket == 0 || !streamLatency.isProbeDue(now))
+    {
+        return;
+    }
+    serverAddress.sin_port = htons((u_short)(port + STREAM_REPAIR_PORT_OFFSET));
+    int bytes = StreamPacket::buildEcho(0, false, 0, now, probe);
+    if (sendto(repairSocket, probe, bytes, 0, (struct sockaddr *)&serverAddress, sizeof(serverAddress)) < 0)
+    {
+        perror("send to \n");
+    }
+}
 
-    addr.sin_family      = AF_INET;
-    addr.sin_port        = htons(Client::getInstance()->port);
-    addr.sin_addr.s_addr = htonl(INADDR_ANY);
-    memcpy((char *)&addr.sin_addr, hp->h_addr, hp->h_length);
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	readRepairs
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:   October 19, 2026 - Read through the repair DatagramIO - agent
+--              October 19, 2026 - Hand echo replies to the latency meter - agent
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	void readRepairs()
+--
+-- RETURNS:     void
+--
+-- NOTES:
+--      Reads every repaired packet waiting on the repair socket and hands it to the StreamReceiver. A repair
+--      counts as in time if it arrived before the packet's playout deadline. Anything that was not NACKed is
+--      part of a join burst and is counted separately. Replies to echo probes come back the same way.
+--
+-------------------------------------------------------------------------------------------------------------------*/
+void Client::readRepairs()
+{
+    int handled;
+    do
+    {
+        handled = repairIO->receive([this](const char *repair, int bytes, const SOCKADDR_IN &) {
+            StreamPacketHeader header;
+            if (!StreamPacket::readHeader(repair, bytes, header))
+            {
+                return;
+            }
+            uint32_t sender, origin;
+            bool reply;
+            if (header.type == PACKET_ECHO)
+            {
+                if (StreamPacket::readEcho(repair + STREAM_HEADER_SIZE, header.length, sender, reply, origin) && reply)
+                {
+                    streamLatency.receiveReply(origin, header.timestamp, GetTickCount());
+                }
+                return;
+            }
+            if (header.type != PACKET_AUDIO || !nackScheduler->wasRequested(header.sequence))
+            {
+                burstReceived++;
+                streamReceiver->receive(repair, bytes, GetTickCount());
+                return;
+            }
+            repairsReceived++;
+            if (streamReceiver->receive(repair, bytes, GetTickCount()))
+            {
+                repairsInTime++;
+            }
+        });
+    } while (handled >= DATAGRAM_BATCH_SIZE);
+}
 
-    //! Send from File Record --------------------------
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	receiveStream
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	void receiveStream(const char *datagram, int bytes, const SOCKADDR_IN &from)
+--                                 datagram - one datagram read from the stream socket
+--                                 bytes - its size
+--                                 from - where it came from
+--
+-- RETURNS:     void
+--
+-- NOTES:
+--      Called from the stream ring's completion routine. The datagram is passed to the StreamReceiver which
+--      reorders it, rebuilds lost packets from FEC parity and writes audio into the audio device in order.
+--      The sender's address is kept so a join request can go to it when the server address was not entered.
+--
+-------------------------------------------------------------------------------------------------------------------*/
+void Client::receiveStream(const char *datagram, int bytes, const SOCKADDR_IN &from)
+{
+    if (bytes <= 0)
+    {
+        return;
+    }
+    streamSenderAddr = from;
+    streamSenderKnown = true;
+    streamReceiver->receive(datagram, bytes, GetTickCount());
+}
 
-    FileHandler fileHandler("recording.wav");
-    char streamBuffer[MIC_BUFF];
-    int read = fileHandler.readFile(MIC_BUFF,streamBuffer);
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	tuneStreamSockets
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	void tuneStreamSockets()
+--
+-- RETURNS:     void
+--
+-- NOTES:
+--      Passes the 95th percentile of the round trips to the server to the tuners of both sockets. Repairs
+--      for a round trip's worth of loss can arrive together on the repair socket, after the join burst.
+--
+-------------------------------------------------------------------------------------------------------------------*/
+void Client::tuneStreamSockets()
+{
+    const LatencyHistogram &roundTrips = streamLatency.getHistogram(LatencyMeter::ROUND_TRIP);
+    uint32_t rttMs = roundTrips.getCount() > 0 ? roundTrips.getPercentile(95) : 0;
+    streamTuner->update(rttMs, 0, GetTickCount());
+    if (repairTuner != nullptr)
+    {
+        repairTuner->update(rttMs, 0, GetTickCount());
+    }
+}
 
-    while (Client::getInstance()->isConnected)
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	useStreamFormat
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:   October 19, 2026 - Size the loss concealer for the new format - agent
+--              October 19, 2026 - Aim the drift compensator at half the new player's buffer - agent
+--              October 19, 2026 - Convert the stream if the sound card cannot play it - agent
+--              October 19, 2026 - Size the sockets for the format and the join burst - agent
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	void useStreamFormat(AudioDevice *audioPlayer, const StreamDescriptor &format)
+--                                   audioPlayer - device the stream plays on
+--                                   format - format announced by the server
+--
+-- RETURNS:     void
+--
+-- NOTES:
+--              Called by the StreamReceiver when the first packet in a new format is about to play. Sets up a
+--              decoder for the announced codec and switches the player to the PCM format it decodes to. The
+--              drift compensator works before the conversion, so its target is in the stream's format. The
+--              target is half the player's buffer, kept waiting in the playback ring behind it.
+--
+-------------------------------------------------------------------------------------------------------------------*/
+void Client::useStreamFormat(AudioDevice *audioPlayer, const StreamDescriptor &format)
+{
+    delete streamDecoder;
+    streamDecoder = AudioCodec::create(format.codec, format);
+    streamCodec = format.codec;
+    if (format.codec != CODEC_PCM && streamDecoder == nullptr)
+    {
+        qDebug() << "Cannot decode" << AudioCodec::getName(format.codec) << "in this format \n";
+    }
+    streamConcealer.setFormat(format);
+    audioPlayer->requestStreamFormat(format);
+    if (streamConverter.setFormats(format, audioPlayer->getOutputFormat()))
     {
-        err = sendto(sock, (char*)streamBuffer, sizeof(streamBuffer), 0, (struct sockaddr*) &addr, sizeof(addr));
+        qDebug() << "Converting the stream to the player's format \n";
+    }
+    int bufferSize = audioPlayer->getPlayBufferSize();
+    streamDrift.setFormat(format, streamConverter.toInputBytes((bufferSize > 0 ? bufferSize : DATA_BUFSIZE) / 2));
+    uint32_t bytesPerSecond = format.sampleRate * format.frameSize;
+    streamTuner->setRate(bytesPerSecond);
+    if (repairTuner != nullptr)
+    {
+        repairTuner->setRate(bytesPerSecond);
+        repairTuner->update(0, (uint32_t)((uint64_t)bytesPerSecond * joinBurstMs / 1000), GetTickCount());
+    }
+}
 
-        if(err < 0)
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	playStreamAudio
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:   October 19, 2026 - Record the time to first audio - agent
+--              October 19, 2026 - Pass the audio through the loss concealer - agent
+--              October 19, 2026 - Write through writeStreamAudio - agent
+--              October 19, 2026 - Record the output queue and the whole delay - agent
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	void playStreamAudio(AudioDevice *audioPlayer, const char *data, int length)
+--                                   audioPlayer - device the stream plays on
+--                                   data - payload of an audio packet
+--                                   length - number of payload bytes
+--
+-- RETURNS:     void
+--
+-- NOTES:
+--              Decodes the payload if the stream is compressed. Payloads that cannot be decoded are dropped.
+--              Notes when the first audio of the stream plays, to measure how long joining took. The audio
+--              goes through the loss concealer, which keeps it as history and fades it in after a concealment.
+--              The audio already queued in the player is how long this packet will wait to be heard, and with
+--              its transit and its wait in the StreamReceiver makes up the delay from the server to the ear.
+--
+-------------------------------------------------------------------------------------------------------------------*/
+void Client::playStreamAudio(AudioDevice *audioPlayer, const char *data, int length)
+{
+    if (firstAudioAt == 0)
+    {
+        firstAudioAt = GetTickCount();
+    }
+    if (streamCodec != CODEC_PCM)
+    {
+        if (streamDecoder == nullptr ||
+                (length = streamDecoder->decode(data, length, decodeBuffer, AUDIO_DECODE_MAX, &decodeStats)) < 0)
+        {
+            return;
+        }
+        data = decodeBuffer;
+    }
+    StreamDescriptor output = audioPlayer->getOutputFormat();
+    if (output.sampleRate > 0 && output.frameSize > 0)
+    {
+        uint32_t queued = (uint32_t)((uint64_t)audioPlayer->getPlayBufferFill() * 1000 /
+                                     ((uint64_t)output.sampleRate * output.frameSize));
+        streamLatency.record(LatencyMeter::OUTPUT_QUEUE, queued);
+        if (streamReceiver->getPlayingDelay() != LATENCY_UNKNOWN)
         {
-            perror("send to \n");
+            streamLatency.record(LatencyMeter::MOUTH_TO_EAR, streamReceiver->getPlayingDelay() + queued);
         }
-        read = fileHandler.readFile(MIC_BUFF,streamBuffer);
-        Sleep(100);
     }
-    closesocket(sock);
+    data = streamConcealer.play(data, length);
+    writeStreamAudio(audioPlayer, data, length);
 }
 
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	concealStreamLoss
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:   October 19, 2026 - Write through writeStreamAudio - agent
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	void concealStreamLoss(AudioDevice *audioPlayer)
+--                                     audioPlayer - device the stream plays on
+--
+-- RETURNS:     void
+--
+-- NOTES:
+--              Called by the StreamReceiver at the turn of a packet that was lost. Plays audio made up from
+--              what came before it, so the audio after it keeps its timing and there is no click.
+--
+-------------------------------------------------------------------------------------------------------------------*/
+void Client::concealStreamLoss(AudioDevice *audioPlayer)
+{
+    int length = streamConcealer.conceal(decodeBuffer, AUDIO_DECODE_MAX);
+    if (length > 0)
+    {
+        writeStreamAudio(audioPlayer, decodeBuffer, length);
+    }
+}
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	handleStreamDiscontinuity
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	void handleStreamDiscontinuity(AudioDevice *audioPlayer, DiscontinuityReason reason)
+--                                             audioPlayer - device the stream plays on
+--                                             reason - why the stream breaks
+--
+-- RETURNS:     void
+--
+-- NOTES:
+--              Called by the StreamReceiver when the server seeks or pauses. After a seek the audio still in
+--              the player is from the old position, so it is dropped, along with the concealer's history and
+--              the resampler's. Either way the player's buffer is about to empty, so the drift compensator
+--              starts its average again rather than read that as drift.
+--
+-------------------------------------------------------------------------------------------------------------------*/
+void Client::handleStreamDiscontinuity(AudioDevice *audioPlayer, DiscontinuityReason reason)
+{
+    if (reason == DISCONTINUITY_SEEK)
+    {
+        streamConcealer.clearHistory();
+        streamConverter.reset();
+        audioPlayer->requestFlush();
+    }
+    streamDrift.restart();
+}
 
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	writeStreamAudio
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:   October 19, 2026 - Convert to the player's format last - agent
+--              October 19, 2026 - Add the audio without wrapping it in a QByteArray - agent
+--              October 19, 2026 - Steer on the playback ring's fill alone - agent
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	void writeStreamAudio(AudioDevice *audioPlayer, const char *data, int length)
+--                                    audioPlayer - device the stream plays on
+--                                    data - decoded audio, real or concealed
+--                                    length - number of bytes
+--
+-- RETURNS:     void
+--
+-- NOTES:
+--              Resamples the audio very slightly so the playback ring stays at its target depth however far
+--              the server's clock and the sound card's clock drift apart (see DriftCompensator). Then, if the
+--              sound card cannot play the stream's format, converts it to one it can (see FormatConverter).
+--
+-------------------------------------------------------------------------------------------------------------------*/
+void Client::writeStreamAudio(AudioDevice *audioPlayer, const char *data, int length)
+{
+    data = streamDrift.process(data, length, streamConverter.toInputBytes(audioPlayer->getPlayBufferFill()));
+    data = streamConverter.convert(data, length);
+    if (length > 0)
+    {
+        audioPlayer->addToPlayBuffer(data, length);
+    }
+}
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	getStreamStatistics
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:   October 19, 2026 - Count audio dropped before the format was known - agent
+--              October 19, 2026 - Add the codec and its decoding cost - agent
+--              October 19, 2026 - Add the time to first audio and the join burst - agent
+--              October 19, 2026 - Add datagrams read per wake - agent
+--              October 19, 2026 - Say whether the stream comes by unicast - agent
+--              October 19, 2026 - Add the packets concealed and the concealment cost - agent
+--              October 19, 2026 - Add the drift correction and the buffer depth - agent
+--              October 19, 2026 - Add the output conversion speed - agent
+--              October 19, 2026 - Add the seeks and pauses and the audio they dropped - agent
+--              October 19, 2026 - Add the latency histograms - agent
+--              October 19, 2026 - Show how full the stream's receive ring gets - agent
+--              October 19, 2026 - Add the sockets' buffer sizes and the kernel's drops - agent
+--              October 19, 2026 - Add the playback ring's underruns and overruns - agent
+--              October 19, 2026 - Add the resyncs and stray packets - agent
+--              October 19, 2026 - Read under streamLock and only once a stream is set up - agent
+--              October 19, 2026 - Append the latency buckets to the CSV file - agent
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	QString getStreamStatistics()
+--
+-- RETURNS:     Returns a one line summary of stream reception and repair
+--
+-- NOTES:
+--      Called from the GUI thread while the stream thread may be setting up a new stream, so the objects it
+--      reads are only touched while holding streamLock. The counters themselves may be a packet behind.
+--
+-------------------------------------------------------------------------------------------------------------------*/
+QString Client::getStreamStatistics()
+{
+    EnterCriticalSection(&streamLock);
+    if (streamReceiver == nullptr || nackScheduler == nullptr || streamRing == nullptr || streamTuner == nullptr)
+    {
+        LeaveCriticalSection(&streamLock);
+        return QString("Stream: not joined yet");
+    }
+    StreamReceiver::Statistics stream = streamReceiver->getStatistics();
+    NackScheduler::Statistics nacks = nackScheduler->getStatistics();
+    DriftCompensator::Statistics drift = streamDrift.getStatistics();
+    ReceiveRing::Statistics reads = streamRing->getStatistics();
+    double successRate = nacks.packetsRequested == 0 ? 0 : 100.0 * repairsInTime / nacks.packetsRequested;
+    QString firstAudio = firstAudioAt == 0 ? QString("not yet")
+                                           : QString("%1 ms").arg((qint64)(firstAudioAt - joinStartedAt));
+    QString conversion = !streamConverter.isActive() ? QString("not needed")
+        : QString("%1 million samples per second")
+          .arg(FormatConverter::getSamplesPerSecond(streamConverter.getStatistics()) / 1000000, 0, 'f', 1);
+    QString summary = QString("Stream: %1 received, %2 rebuilt, %3 lost, %4 late, %5 before format"
+                   " | NACKs: %6 sent for %7 packets, %8 suppressed | Repairs: %9 received, %10% before deadline"
+                   " | Codec: %11, decoding takes %12 us per second of audio"
+                   " | Join: first audio after %13, %14 burst packets"
+                   " | Reads: %15 datagrams, %16 reads posted, at most %17 filled at once, all filled %18 times,"
+                   " %19 failed posts"
+                   " | Delivery: %20"
+                   " | Concealment: %21 packets in %22 gaps, %23 us per second of audio"
+                   " | Drift: %24 ppm, buffer %25 ms for a %26 ms target, %27 frames added"
+                   " | Output conversion: %28"
+                   " | Jumps: %29 seeks and pauses, %30 stale packets dropped, %31 resyncs, %32 strays"
+                   " | Latency: %33"
+                   " | Socket buffers: stream %34; repairs %35"
+                   " | Playback: %36")
+            .arg((qint64)stream.received)
+            .arg((qint64)stream.recovered)
+            .arg((qint64)stream.lost)
+            .arg((qint64)stream.late)
+            .arg((qint64)stream.unformatted)
+            .arg((qint64)nacks.nacksSent)
+            .arg((qint64)nacks.packetsRequested)
+            .arg((qint64)nacks.suppressed)
+            .arg((qint64)repairsReceived)
+            .arg(successRate, 0, 'f', 1)
+            .arg(AudioCodec::getName(streamCodec))
+            .arg(AudioCodec::getMicrosPerSecond(decodeStats), 0, 'f', 1)
+            .arg(firstAudio)
+            .arg((qint64)burstReceived)
+            .arg((qint64)reads.datagramsReceived)
+            .arg(streamRing->getDepth())
+            .arg((qint64)reads.mostFilled)
+            .arg((qint64)reads.allFilled)
+            .arg((qint64)reads.postFailures)
+            .arg(subscribed ? "unicast subscription" : "multicast")
+            .arg((qint64)streamConcealer.getStatistics().packetsConcealed)
+            .arg((qint64)streamConcealer.getStatistics().lossEvents)
+            .arg(LossConcealer::getMicrosPerSecond(streamConcealer.getStatistics()), 0, 'f', 1)
+            .arg(drift.ppm, 0, 'f', 1)
+            .arg(drift.averageFillMs, 0, 'f', 1)
+            .arg(drift.targetMs, 0, 'f', 1)
+            .arg((qint64)drift.framesAdded)
+            .arg(conversion)
+            .arg((qint64)stream.discontinuities)
+            .arg((qint64)stream.skipped)
+            .arg((qint64)stream.resyncs)
+            .arg((qint64)stream.strays)
+            .arg(streamLatency.describe())
+            .arg(streamTuner->describe())
+            .arg(repairTuner != nullptr ? repairTuner->describe() : QString("no socket"))
+            .arg(clientAudioPlayer != nullptr ? clientAudioPlayer->describePlayback() : QString("no player"));
+    streamLatency.writeCsv("stream");
+    LeaveCriticalSection(&streamLock);
+    return summary;
+}
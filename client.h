@@ -6,23 +6,45 @@
 #include "server.h"
 #include "connectiondevice.h"
 #include "filehandler.h"
+#include "streamreceiver.h"
+#include "nackscheduler.h"
+#include "audiocodec.h"
+#include "datagramio.h"
+#include "lossconcealer.h"
+#include "driftcompensator.h"
+#include "formatconverter.h"
+#include "latencymeter.h"
+#include "receivering.h"
 
 
 #define CLIENT_DATABUF_SIZE 4096
+#define JOIN_BURST_MS 300
+#define JOIN_RETRY_MS 250
+#define JOIN_MAX_ATTEMPTS 3
+#define SUBSCRIBE_FALLBACK_MS 1500
+#define SUBSCRIBE_REFRESH_MS 2000
 
 class Client : public ConnectionDevice
 {
 
 private:
-    Client() = default;
+    struct StreamStart
+    {
+        AudioDevice *audioPlayer;
+        HANDLE stopEvent;
+        HANDLE previousThread;
+        HANDLE previousStopEvent;
+    };
+
+    Client();
     bool connected = false;
+    CRITICAL_SECTION streamLock;
     struct sockaddr_in serverAddressInfo, clientAddressInfo;
 
     bool createSocket(protocol type);
 
     static DWORD WINAPI connectTCPServer(LPVOID lpParameter);
     static DWORD WINAPI joinMulticastStream(LPVOID lpParameter);
-    static DWORD WINAPI joinCall(LPVOID lpParameter);
 
     LPSOCKET_INFORMATION getSocketInfo( AudioDevice *audioPlayer);
 
@@ -44,14 +66,41 @@ public:
         return connected;
     }
 
-    // Two Way Functions
-    void connectCall();
-    static DWORD WINAPI sendVoice(LPVOID lpParameter);
-    void endCall();
-
     AudioDevice *clientAudioPlayer;
-    AudioDevice *clientMicrophone;
-    FileHandler *fileHandler;
+    StreamReceiver *streamReceiver = nullptr;
+    NackScheduler *nackScheduler = nullptr;
+    SOCKET repairSocket = 0;
+    SOCKADDR_IN streamSenderAddr;
+    bool streamSenderKnown = false;
+    DWORD repairsReceived = 0;
+    DWORD repairsInTime = 0;
+    AudioCodec *streamDecoder = nullptr;
+    uint8_t streamCodec = CODEC_PCM;
+    AudioCodec::Statistics decodeStats;
+    char decodeBuffer[AUDIO_DECODE_MAX];
+    LossConcealer streamConcealer;
+    DriftCompensator streamDrift;
+    FormatConverter streamConverter;
+    LatencyMeter streamLatency;
+    uint16_t joinBurstMs = JOIN_BURST_MS;
+    SOCKADDR_IN joinAddress;
+    bool joinAddressKnown = false;
+    int joinAttempts = 0;
+    DWORD joinSentAt = 0;
+    DWORD joinStartedAt = 0;
+    DWORD firstAudioAt = 0;
+    DWORD burstReceived = 0;
+    ReceiveRing *streamRing = nullptr;
+    SocketTuner *streamTuner = nullptr;
+    SocketTuner *repairTuner = nullptr;
+    int streamReceiveDepth = RECEIVE_RING_DEPTH;
+    DatagramIO *repairIO = nullptr;
+    SOCKET streamSocket = INVALID_SOCKET;
+    HANDLE streamThread = NULL;
+    HANDLE streamStopEvent = NULL;
+    bool subscribeUnicast = false;
+    bool subscribed = false;
+    DWORD subscribeSentAt = 0;
 
     char recvBuf[CLIENT_DATABUF_SIZE];
     char sendBuf[CLIENT_DATABUF_SIZE];
@@ -64,10 +113,18 @@ public:
     std::string ip;
     std::string fileName;
     bool upload = false;
-    bool isConnected = false;
     void joinStream();
-    static void CALLBACK PlayStreamWorkerRoutine(DWORD error, DWORD bytesTransferred, LPWSAOVERLAPPED overlapped, DWORD InFlags);
-
-public slots:
-    void sendVoice(SOCKET, sockaddr_in, AudioDevice*);
+    void sendDueNacks();
+    void sendJoin();
+    void sendSubscribe();
+    void sendProbe();
+    void readRepairs();
+    void receiveStream(const char *datagram, int bytes, const SOCKADDR_IN &from);
+    void tuneStreamSockets();
+    void useStreamFormat(AudioDevice *audioPlayer, const StreamDescriptor &format);
+    void playStreamAudio(AudioDevice *audioPlayer, const char *data, int length);
+    void concealStreamLoss(AudioDevice *audioPlayer);
+    void handleStreamDiscontinuity(AudioDevice *audioPlayer, DiscontinuityReason reason);
+    void writeStreamAudio(AudioDevice *audioPlayer, const char *data, int length);
+    QString getStreamStatistics();
 };
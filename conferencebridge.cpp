@@ -0,0 +1,1097 @@
+/*------------------------------------------------------------------------------------------------------------------
+-- SOURCE FILE: 	conferencebridge.cpp - Mixes a call between several people on one UDP port.
+--
+--
+-- PROGRAM: 		Communication Audio Program
+--
+-- FUNCTIONS:
+--                  static int runFromArguments(int argc, char *argv[])
+--                  static QString benchmark(int participants, int seconds)
+--                  bool open()
+--                  void run()
+--                  void stop()
+--                  QString getStatistics() const
+--                  void receive(const char *datagram, int bytes, const SOCKADDR_IN &from)
+--                  Participant *find(uint32_t sender, const SOCKADDR_IN &from)
+--                  void useFormat(Participant *participant, const StreamDescriptor &format)
+--                  void restart(Participant *participant)
+--                  void pull(Participant *participant)
+--                  void mix()
+--                  void sendMix(Participant *participant, const int16_t *audio)
+--                  void evict()
+--                  QString describe(const Participant *participant) const
+--                  void receiveEcho(const StreamPacketHeader &header, const char *payload, const SOCKADDR_IN &from)
+--                  void sendProbes()
+--
+-- DATE: 			October 19, 2026
+--
+-- REVISIONS:       October 19, 2026 - Tell participants apart by source id - agent
+--                  October 19, 2026 - Measure each participant's transit and jitter buffer delay - agent
+--                  October 19, 2026 - Stamp participants' packets from the latency meter's clock - agent
+--                  October 19, 2026 - Measure what silence suppression saves the bridge - agent
+--
+-- DESIGNER: 		agent
+--
+-- PROGRAMMER: 		agent
+--
+-- NOTES:
+--      A call socket plays whatever reaches it, so two callers at once come out interleaved. The bridge sits
+--      between them instead. Everyone calls the bridge's port from an ordinary CallSession, and the source id
+--      in each voice packet says who is talking. Participants are kept in a hash map by source id. The first
+--      packet from a new source adds one, their mix goes to the address their latest packet came from, and
+--      one who has sent nothing for CONFERENCE_TIMEOUT_MS is dropped. Two callers behind one NAT address, or
+--      one caller hanging up and calling again from the same port, are still told apart. Each participant
+--      has their own counters, printed with the bridge's own every few seconds and when they leave.
+--
+--      Each participant has a small jitter buffer of decoded frames, placed by sequence number. Playing starts
+--      once CONFERENCE_JITTER_DEPTH frames are waiting, a missing frame is filled by the participant's loss
+--      concealer while later ones are waiting, and a buffer that runs dry waits to refill. A comfort noise
+--      marker ends the talker's turn once what came before it has played, so the silence after it is neither
+--      concealed nor counted as loss. Frames are turned into the bridge's own format as they leave the buffer.
+--      The bridge probes each participant every LATENCY_PROBE_MS and answers their probes, so the capture
+--      stamps on their frames give how long each took to arrive, and each frame's wait in the jitter buffer is
+--      timed from its arrival to its mix. Both are kept per participant and printed with their counters.
+--
+--      Every CONFERENCE_FRAME_MS the bridge takes one frame from each participant who is talking and adds them
+--      all into 32 bit sums with the SampleConvert kernels. Each participant then gets the sums less their own
+--      voice, clipped back to 16 bits, so nobody hears themselves. It goes out encoded with the codec they
+--      send with. Someone who is the only talker, or is listening to a silent room, gets a comfort noise
+--      marker now and then instead.
+--
+--      The bridge does all of this on one thread and times itself. Its statistics give the cost of a mix, the
+--      share of a core it keeps busy and how many participants a core could carry at that rate. It is started
+--      from the command line like the relay, with --conference, and --conference-bench measures the same work
+--      with simulated talkers and no network. The bench runs a room where people take turns twice, with every
+--      frame sent and with silence suppressed, so it shows the talk ratio and what suppression saves.
+--
+--------------------------------------------------------------------------------------------------------------------*/
+#include "conferencebridge.h"
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+
+static uint64_t readCounter() {
+    LARGE_INTEGER counter;
+    QueryPerformanceCounter(&counter);
+    return (uint64_t)counter.QuadPart;
+}
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	ConferenceBridge
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	ConferenceBridge(u_short port, uint32_t sampleRate, uint8_t channels)
+--                               port - port the participants call
+--                               sampleRate - rate the bridge mixes and sends at
+--                               channels - channels the bridge mixes and sends
+--
+-- RETURNS:     NA
+--
+-- NOTES:
+--              Nothing is opened until open() is called.
+--
+-------------------------------------------------------------------------------------------------------------------*/
+ConferenceBridge::ConferenceBridge(u_short port, uint32_t sampleRate, uint8_t channels) : port(port) {
+    source = StreamPacket::newSource();
+    mixFormat = FormatConverter::pcm16(sampleRate, channels);
+    frameSamples = (int)(sampleRate * CONFERENCE_FRAME_MS / 1000) * channels;
+    sum.resize(frameSamples);
+    mixed.resize(frameSamples);
+}
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	~ConferenceBridge
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	~ConferenceBridge()
+--
+-- RETURNS:     NA
+--
+-------------------------------------------------------------------------------------------------------------------*/
+ConferenceBridge::~ConferenceBridge() {
+    for (auto &entry : participants) {
+        delete entry.second;
+    }
+    delete io;
+    if (sock != INVALID_SOCKET) {
+        closesocket(sock);
+    }
+    WSAEVENT events[] = { readEvent, stopEvent };
+    for (WSAEVENT event : events) {
+        if (event != WSA_INVALID_EVENT) {
+            WSACloseEvent(event);
+        }
+    }
+}
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	runFromArguments
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	static int runFromArguments(int argc, char *argv[])
+--                          argc - number of command line arguments
+--                          argv - the command line arguments
+--
+-- RETURNS:     The process exit code
+--
+-- NOTES:
+--              The two forms are
+--                  --conference <port> [sample rate] [channels]
+--                  --conference-bench [participants] [seconds]
+--              The bridge then runs on the calling thread until the process is ended. The benchmark prints
+--              its result and returns.
+--
+-------------------------------------------------------------------------------------------------------------------*/
+int ConferenceBridge::runFromArguments(int argc, char *argv[]) {
+    WSADATA wsaData;
+    if (strcmp(argv[1], "--conference-bench") == 0) {
+        int count = argc >= 3 ? atoi(argv[2]) : CONFERENCE_BENCH_PARTICIPANTS;
+        int seconds = argc >= 4 ? atoi(argv[3]) : CONFERENCE_BENCH_SECONDS;
+        qDebug() << benchmark(count > 0 ? count : CONFERENCE_BENCH_PARTICIPANTS,
+                              seconds > 0 ? seconds : CONFERENCE_BENCH_SECONDS);
+        return 0;
+    }
+    if (argc < 3 || strcmp(argv[1], "--conference") != 0) {
+        qDebug() << "Usage: --conference <port> [sample rate] [channels]\n"
+                 << "       --conference-bench [participants] [seconds]\n";
+        return 1;
+    }
+    uint32_t sampleRate = argc >= 4 ? (uint32_t)atoi(argv[3]) : CONFERENCE_RATE;
+    uint8_t channels = argc >= 5 ? (uint8_t)atoi(argv[4]) : CONFERENCE_CHANNELS;
+    if (!SampleConvert::handles(FormatConverter::pcm16(sampleRate, channels))) {
+        qDebug() << "The bridge cannot mix at" << sampleRate << "Hz with" << channels << "channels";
+        return 1;
+    }
+    if (WSAStartup(0x0202, &wsaData) != 0) {
+        qDebug() << "WSAStartup failed with error \n" << WSAGetLastError();
+        return 1;
+    }
+
+    ConferenceBridge bridge((u_short)atoi(argv[2]), sampleRate, channels);
+    bool opened = bridge.open();
+    if (opened) {
+        bridge.run();
+    }
+    WSACleanup();
+    return opened ? 0 : 1;
+}
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	benchmark
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:   October 19, 2026 - Compare a turn-taking room with and without silence suppression - agent
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	static QString benchmark(int participants, int seconds)
+--                                participants - number of simulated participants
+--                                seconds - length of the simulated conference
+--
+-- RETURNS:     A one line summary of the run
+--
+-- NOTES:
+--              Participants take turns of CONFERENCE_BENCH_TURN_MS to talk, with a tone that swells and fades
+--              every CONFERENCE_BENCH_SYLLABLE_MS like syllables, and the rest of the time their microphones
+--              pick up a low hiss. Each one's frames go through a VoiceActivity as a
+--              CallSession's would. The room is run twice: once sending every frame as mu-law voice, as a call
+--              with silence suppression turned off does, and once sending only speech with a comfort noise
+--              marker every CNG_REFRESH_FRAMES silent frames. Packets are handed to the bridge as if read from
+--              the socket, and the bridge mixes and encodes a frame for each participant every tick, only
+--              without sending it. Ticks run back to back, so the time taken against the length of the
+--              conference is the share of one core the bridge would need. The summary gives the share of
+--              frames the detectors took for speech and how much the second run saved in bytes and in time.
+--
+-------------------------------------------------------------------------------------------------------------------*/
+QString ConferenceBridge::benchmark(int participants, int seconds) {
+    int syllableFrames = CONFERENCE_BENCH_SYLLABLE_MS / CONFERENCE_FRAME_MS;
+    StreamDescriptor format;
+    std::vector<std::vector<char>> voice(syllableFrames);
+    std::vector<std::vector<int16_t>> tone(syllableFrames);
+    std::vector<int16_t> quiet;
+    uint32_t seed = 0x2545F491;
+    QString summary;
+    double busy[2] = {};
+    uint64_t sent[2] = {};
+    VoiceActivity::Statistics talk = {};
+
+    for (int pass = 0; pass < 2; pass++) {
+        bool suppress = pass == 1;
+        ConferenceBridge *bridge = new ConferenceBridge(0);
+        format = bridge->mixFormat;
+        quiet.resize(bridge->frameSamples);
+        double step = 2 * 3.14159265358979 * 300 / format.sampleRate;
+        AudioCodec *encoder = AudioCodec::create(CODEC_ULAW, format);
+        for (int f = 0; f < syllableFrames; f++) {
+            double loudness = 3000 * sin(3.14159265358979 * (f + 0.5) / syllableFrames);
+            tone[f].resize(bridge->frameSamples);
+            for (int s = 0; s < bridge->frameSamples; s++) {
+                tone[f][s] = (int16_t)(loudness * sin(step * (s / format.channels)));
+            }
+            voice[f].resize(STREAM_PAYLOAD_SIZE);
+            voice[f].resize(encoder->encode((const char *)tone[f].data(), bridge->frameSamples * 2,
+                                            voice[f].data()));
+        }
+        delete encoder;
+        format.codec = CODEC_ULAW;
+
+        std::vector<SOCKADDR_IN> addresses(participants);
+        std::vector<VoiceActivity> activity(participants);
+        std::vector<uint32_t> silentRun(participants, 0);
+        for (int i = 0; i < participants; i++) {
+            memset(&addresses[i], 0, sizeof(addresses[i]));
+            addresses[i].sin_family = AF_INET;
+            addresses[i].sin_addr.s_addr = htonl(0x7F000001);
+            addresses[i].sin_port = htons((u_short)(10000 + i));
+            activity[i].setFormat(bridge->mixFormat);
+        }
+
+        char datagram[DATA_BUFSIZE];
+        int ticks = seconds * 1000 / CONFERENCE_FRAME_MS;
+        for (int tick = 0; tick < ticks; tick++) {
+            int talker = tick * CONFERENCE_FRAME_MS / CONFERENCE_BENCH_TURN_MS % participants;
+            for (int s = 0; s < bridge->frameSamples; s++) {
+                seed ^= seed << 13;
+                seed ^= seed >> 17;
+                seed ^= seed << 5;
+                quiet[s] = (int16_t)((int)(seed % (2 * CONFERENCE_BENCH_NOISE + 1)) - CONFERENCE_BENCH_NOISE);
+            }
+            for (int i = 0; i < participants; i++) {
+                const int16_t *pcm = i == talker ? tone[tick % syllableFrames].data() : quiet.data();
+                int bytes;
+                if (!activity[i].isSpeech((const char *)pcm, bridge->frameSamples * 2) && suppress) {
+                    if (silentRun[i]++ % CNG_REFRESH_FRAMES != 0) {
+                        continue;
+                    }
+                    bytes = StreamPacket::buildComfortNoise((uint32_t)(i + 1), format, (uint32_t)tick,
+                                                            (uint32_t)(tick * CONFERENCE_FRAME_MS),
+                                                            activity[i].getNoiseLevel(), datagram);
+                } else {
+                    silentRun[i] = 0;
+                    bytes = StreamPacket::buildVoice((uint32_t)(i + 1), format, (uint32_t)tick,
+                                                     (uint32_t)(tick * CONFERENCE_FRAME_MS),
+                                                     voice[tick % syllableFrames].data(),
+                                                     (int)voice[tick % syllableFrames].size(), datagram);
+                }
+                sent[pass] += bytes;
+                uint64_t began = readCounter();
+                bridge->receive(datagram, bytes, addresses[i]);
+                bridge->stats.busyTicks += readCounter() - began;
+            }
+            uint64_t began = readCounter();
+            bridge->mix();
+            bridge->stats.busyTicks += readCounter() - began;
+        }
+
+        LARGE_INTEGER frequency;
+        QueryPerformanceFrequency(&frequency);
+        bridge->stats.wallTicks = (uint64_t)seconds * frequency.QuadPart;
+        busy[pass] = (double)bridge->stats.busyTicks;
+        if (suppress) {
+            for (int i = 0; i < participants; i++) {
+                talk.speechFrames += activity[i].getStatistics().speechFrames;
+                talk.silentFrames += activity[i].getStatistics().silentFrames;
+            }
+        }
+        summary.append(QString(" | %1: %2 kB in, %3")
+                       .arg(suppress ? "Silence suppressed" : "Always sending")
+                       .arg((qint64)(sent[pass] / 1024))
+                       .arg(bridge->getStatistics()));
+        delete bridge;
+    }
+
+    uint32_t frames = talk.speechFrames + talk.silentFrames;
+    return QString("Conference benchmark, %1 participants taking %2 s turns for %3 s: talk %4% of the time,"
+                   " %5% less voice bandwidth, %6% less bridge time")
+            .arg(participants)
+            .arg(CONFERENCE_BENCH_TURN_MS / 1000.0, 0, 'f', 1)
+            .arg(seconds)
+            .arg(frames > 0 ? 100.0 * talk.speechFrames / frames : 0, 0, 'f', 1)
+            .arg(sent[0] > 0 ? 100.0 - 100.0 * sent[1] / sent[0] : 0, 0, 'f', 1)
+            .arg(busy[0] > 0 ? 100.0 - 100.0 * busy[1] / busy[0] : 0, 0, 'f', 1)
+            + summary;
+}
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	open
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	bool open()
+--
+-- RETURNS:     True if the bridge's port is open
+--
+-------------------------------------------------------------------------------------------------------------------*/
+bool ConferenceBridge::open() {
+    if ((sock = socket(PF_INET, SOCK_DGRAM, 0)) == INVALID_SOCKET) {
+        qDebug() << "Failed to get a conference socket" << WSAGetLastError();
+        return false;
+    }
+    SOCKADDR_IN local = {};
+    local.sin_family = AF_INET;
+    local.sin_addr.s_addr = htonl(INADDR_ANY);
+    local.sin_port = htons(port);
+    if (bind(sock, (PSOCKADDR)&local, sizeof(local)) == SOCKET_ERROR) {
+        qDebug() << "bind() failed for the conference with error" << WSAGetLastError();
+        return false;
+    }
+    if ((readEvent = WSACreateEvent()) == WSA_INVALID_EVENT || (stopEvent = WSACreateEvent()) == WSA_INVALID_EVENT ||
+            WSAEventSelect(sock, readEvent, FD_READ)) {
+        qDebug() << "Failed to tie event to the conference socket" << WSAGetLastError();
+        return false;
+    }
+    io = new DatagramIO(sock);
+    io->enableReceiveCoalescing();
+    qDebug() << "Conference bridge on port" << port << "mixing at" << mixFormat.sampleRate << "Hz";
+    return true;
+}
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	run
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:   October 19, 2026 - Report each participant - agent
+--              October 19, 2026 - Probe the participants - agent
+--              October 19, 2026 - Append each participant's latency buckets to the CSV file - agent
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	void run()
+--
+-- RETURNS:     void
+--
+-- NOTES:
+--              Reads whatever has arrived until the next mix is due, then mixes and sends every frame that has
+--              come due since the last one. A bridge that falls more than CONFERENCE_MAX_LATE_TICKS frames
+--              behind skips ahead rather than sending a burst.
+--
+-------------------------------------------------------------------------------------------------------------------*/
+void ConferenceBridge::run() {
+    WSAEVENT events[2] = { stopEvent, readEvent };
+    uint64_t startedAt = readCounter();
+    DWORD reportedAt = GetTickCount();
+    DWORD nextMixAt = reportedAt + CONFERENCE_FRAME_MS;
+    running = true;
+    while (running) {
+        int32_t wait = (int32_t)(nextMixAt - GetTickCount());
+        if (WSAWaitForMultipleEvents(2, events, FALSE, wait > 0 ? (DWORD)wait : 0, FALSE) == WSA_WAIT_FAILED) {
+            qDebug() << "WSAWaitForMultipleEvents failed with error \n" << WSAGetLastError();
+            break;
+        }
+
+        uint64_t began = readCounter();
+        WSAResetEvent(readEvent);
+        io->receive([this](const char *datagram, int bytes, const SOCKADDR_IN &from) {
+            receive(datagram, bytes, from);
+        });
+        DWORD now = GetTickCount();
+        int32_t behind = (int32_t)(now - nextMixAt);
+        if (behind > CONFERENCE_MAX_LATE_TICKS * CONFERENCE_FRAME_MS) {
+            stats.ticksSkipped += behind / CONFERENCE_FRAME_MS;
+            nextMixAt = now;
+        }
+        while ((int32_t)(now - nextMixAt) >= 0) {
+            mix();
+            nextMixAt += CONFERENCE_FRAME_MS;
+        }
+        sendProbes();
+        io->flush();
+        evict();
+        stats.busyTicks += readCounter() - began;
+        stats.wallTicks = readCounter() - startedAt;
+
+        if (now - reportedAt >= CONFERENCE_REPORT_MS) {
+            qDebug() << getStatistics();
+            for (auto &entry : participants) {
+                qDebug() << describe(entry.second);
+                QString source = QString("source %1").arg((qulonglong)entry.second->source, 8, 16, QChar('0'));
+                entry.second->latency.writeCsv(source);
+            }
+            reportedAt = now;
+        }
+    }
+}
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	stop
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	void stop()
+--
+-- RETURNS:     void
+--
+-- NOTES:
+--              May be called from another thread. run() returns once it wakes.
+--
+-------------------------------------------------------------------------------------------------------------------*/
+void ConferenceBridge::stop() {
+    running = false;
+    if (stopEvent != WSA_INVALID_EVENT) {
+        WSASetEvent(stopEvent);
+    }
+}
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	getStatistics
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:   October 19, 2026 - Count participants who moved - agent
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	QString getStatistics() const
+--
+-- RETURNS:     A one line summary of the conference
+--
+-- NOTES:
+--              The capacity is the average number of participants scaled by the share of a core left over,
+--              so it only means much once the room has been busy for a while.
+--
+-------------------------------------------------------------------------------------------------------------------*/
+QString ConferenceBridge::getStatistics() const {
+    LARGE_INTEGER frequency;
+    QueryPerformanceFrequency(&frequency);
+    double micros = 1000000.0 / frequency.QuadPart;
+    double average = stats.ticks > 0 ? stats.mixTicks * micros / stats.ticks : 0;
+    double load = stats.wallTicks > 0 ? 100.0 * stats.busyTicks / stats.wallTicks : 0;
+    double room = stats.ticks > 0 ? (double)stats.participantTicks / stats.ticks : 0;
+    double capacity = stats.busyTicks > 0 ? room * stats.wallTicks / stats.busyTicks : 0;
+    return QString("Conference on port %1: %2 taking part, %3 joined, %4 left, %5 turned away, %18 moved,"
+                   " %6 malformed"
+                   " | Voice: %7 frames in, %8 late, %9 concealed, %10 underruns, %11 mixes out,"
+                   " %12 comfort noise markers | Mix: %13 us a frame (at most %14 us), %15 frames skipped,"
+                   " %16% of one core, about %17 participants a core")
+            .arg(port)
+            .arg((qint64)participants.size())
+            .arg((qint64)stats.joined)
+            .arg((qint64)stats.left)
+            .arg((qint64)stats.turnedAway)
+            .arg((qint64)stats.malformed)
+            .arg((qint64)stats.framesReceived)
+            .arg((qint64)stats.late)
+            .arg((qint64)stats.concealed)
+            .arg((qint64)stats.underruns)
+            .arg((qint64)stats.framesSent)
+            .arg((qint64)stats.markersSent)
+            .arg(average, 0, 'f', 1)
+            .arg(stats.mixMaxTicks * micros, 0, 'f', 1)
+            .arg((qint64)stats.ticksSkipped)
+            .arg(load, 0, 'f', 2)
+            .arg((qint64)capacity)
+            .arg((qint64)stats.moved);
+}
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	receive
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:   October 19, 2026 - Find the participant by source id - agent
+--              October 19, 2026 - Record the transit and hand echoes on - agent
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	void receive(const char *datagram, int bytes, const SOCKADDR_IN &from)
+--                           datagram - datagram read from the bridge's socket
+--                           bytes - size of the datagram
+--                           from - address it came from
+--
+-- RETURNS:     void
+--
+-- NOTES:
+--              Decodes a voice packet into its sender's jitter buffer. While a participant is playing, a packet
+--              for a frame already played is late and one more than CONFERENCE_JITTER_SLOTS ahead means they
+--              started over. Between turns, the earliest packet waiting is where the next turn starts.
+--              A comfort noise marker takes a slot of its own and marks where the turn ends. Echoes go to
+--              receiveEcho.
+--
+-------------------------------------------------------------------------------------------------------------------*/
+void ConferenceBridge::receive(const char *datagram, int bytes, const SOCKADDR_IN &from) {
+    StreamPacketHeader header;
+    StreamDescriptor format;
+    uint32_t sender;
+    const char *audio = nullptr;
+    int length = 0;
+    uint8_t level;
+    const char *payload = datagram + STREAM_HEADER_SIZE;
+    bool parsed = StreamPacket::readHeader(datagram, bytes, header);
+    if (parsed && header.type == PACKET_ECHO) {
+        receiveEcho(header, payload, from);
+        return;
+    }
+    if (!parsed ||
+            !((header.type == PACKET_VOICE &&
+               StreamPacket::readVoice(payload, header.length, sender, format, audio, length)) ||
+              (header.type == PACKET_COMFORT_NOISE &&
+               StreamPacket::readComfortNoise(payload, header.length, sender, format, level)))) {
+        stats.malformed++;
+        return;
+    }
+    Participant *participant = find(sender, from);
+    if (participant == nullptr) {
+        return;
+    }
+    DWORD now = LatencyMeter::now();
+    participant->heardAt = now;
+    useFormat(participant, format);
+    if (!participant->mixable) {
+        return;
+    }
+
+    bool silent = header.type == PACKET_COMFORT_NOISE;
+    int32_t ahead = (int32_t)(header.sequence - participant->playSequence);
+    if (participant->playing) {
+        if (ahead < 0) {
+            stats.late++;
+            participant->stats.late++;
+            return;
+        }
+        if (ahead >= CONFERENCE_JITTER_SLOTS) {
+            restart(participant);
+            participant->playSequence = header.sequence;
+        }
+    } else if (silent && participant->buffered == 0) {
+        return;
+    } else if (participant->buffered == 0 || ahead < 0 || ahead >= CONFERENCE_JITTER_SLOTS) {
+        if (ahead <= -CONFERENCE_JITTER_SLOTS || ahead >= CONFERENCE_JITTER_SLOTS) {
+            restart(participant);
+        }
+        participant->playSequence = header.sequence;
+    }
+
+    if (!silent && format.codec != CODEC_PCM) {
+        if ((length = participant->decoder->decode(audio, length, decodeBuffer, AUDIO_DECODE_MAX)) < 0) {
+            stats.malformed++;
+            return;
+        }
+        audio = decodeBuffer;
+    }
+    Slot &slot = participant->jitter[header.sequence % CONFERENCE_JITTER_SLOTS];
+    if (slot.filled) {
+        if (slot.sequence == header.sequence) {
+            return;
+        }
+        participant->buffered--;
+    }
+    slot.sequence = header.sequence;
+    slot.filled = true;
+    slot.silent = silent;
+    slot.arrivedAt = now;
+    slot.audio.assign(audio, audio + (silent ? 0 : length));
+    participant->buffered++;
+    if (silent) {
+        participant->playing = true;
+    } else {
+        stats.framesReceived++;
+        participant->stats.framesReceived++;
+        uint32_t transit;
+        if (participant->latency.getTransit(header.timestamp, now, transit)) {
+            participant->latency.record(LatencyMeter::TRANSIT, transit);
+        }
+        if (participant->buffered >= CONFERENCE_JITTER_DEPTH) {
+            participant->playing = true;
+        }
+    }
+}
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	find
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	Participant *find(uint32_t sender, const SOCKADDR_IN &from)
+--                                sender - source id a packet names
+--                                from - address it came from
+--
+-- RETURNS:     The participant with that source id, added if new, or nullptr if the bridge is full
+--
+-- NOTES:
+--              A participant whose packets start coming from somewhere else is sent their mix there from now on.
+--
+-------------------------------------------------------------------------------------------------------------------*/
+ConferenceBridge::Participant *ConferenceBridge::find(uint32_t sender, const SOCKADDR_IN &from) {
+    auto found = participants.find(sender);
+    if (found != participants.end()) {
+        Participant *participant = found->second;
+        if (from.sin_addr.s_addr != participant->address.sin_addr.s_addr ||
+                from.sin_port != participant->address.sin_port) {
+            participant->address = from;
+            participant->stats.moves++;
+            stats.moved++;
+        }
+        return participant;
+    }
+    if (participants.size() >= CONFERENCE_MAX_PARTICIPANTS) {
+        stats.turnedAway++;
+        return nullptr;
+    }
+    Participant *participant = new Participant;
+    participant->source = sender;
+    participant->address = from;
+    participants[sender] = participant;
+    stats.joined++;
+    if (io != nullptr) {
+        qDebug() << inet_ntoa(from.sin_addr) << ntohs(from.sin_port) << "joined the conference";
+    }
+    return participant;
+}
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	useFormat
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	void useFormat(Participant *participant, const StreamDescriptor &format)
+--                             participant - participant a packet came from
+--                             format - format and codec named by the packet
+--
+-- RETURNS:     void
+--
+-- NOTES:
+--              Sets up the participant's decoder, converter and concealer for the format they send, and an
+--              encoder so they hear the mix with the same codec. A participant whose audio cannot be converted
+--              to the bridge's format is kept but neither heard nor sent to.
+--
+-------------------------------------------------------------------------------------------------------------------*/
+void ConferenceBridge::useFormat(Participant *participant, const StreamDescriptor &format) {
+    if (StreamPacket::sameFormat(format, participant->format)) {
+        return;
+    }
+    participant->format = format;
+    StreamDescriptor pcm = format;
+    pcm.codec = CODEC_PCM;
+    delete participant->decoder;
+    delete participant->encoder;
+    participant->decoder = nullptr;
+    participant->encoder = nullptr;
+    if (format.codec != CODEC_PCM) {
+        participant->decoder = AudioCodec::create(format.codec, pcm);
+        participant->encoder = AudioCodec::create(format.codec, mixFormat);
+    }
+    participant->mixable = SampleConvert::handles(pcm) && (format.codec == CODEC_PCM || participant->decoder != nullptr);
+    participant->converter.setFormats(pcm, mixFormat);
+    participant->concealer.setFormat(pcm);
+    restart(participant);
+}
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	restart
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	void restart(Participant *participant)
+--                           participant - participant to start over
+--
+-- RETURNS:     void
+--
+-------------------------------------------------------------------------------------------------------------------*/
+void ConferenceBridge::restart(Participant *participant) {
+    for (Slot &slot : participant->jitter) {
+        slot.filled = false;
+    }
+    participant->buffered = 0;
+    participant->playing = false;
+    participant->staged.clear();
+    participant->concealer.reset();
+    participant->converter.reset();
+}
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	pull
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:   October 19, 2026 - Time each frame's wait in the jitter buffer - agent
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	void pull(Participant *participant)
+--                        participant - participant to take this mix's frame from
+--
+-- RETURNS:     void
+--
+-- NOTES:
+--              Plays frames out of the jitter buffer in order until a whole mix frame is staged. Their frames
+--              need not be as long as the bridge's. A missing frame is concealed while later ones are waiting.
+--              When the buffer runs dry or a turn ends, whatever is staged is mixed padded with silence, and
+--              the participant is not talking if nothing was.
+--
+-------------------------------------------------------------------------------------------------------------------*/
+void ConferenceBridge::pull(Participant *participant) {
+    size_t need = (size_t)frameSamples;
+    while (participant->staged.size() < need && participant->playing) {
+        Slot &slot = participant->jitter[participant->playSequence % CONFERENCE_JITTER_SLOTS];
+        if (slot.filled && slot.sequence != participant->playSequence &&
+                (int32_t)(slot.sequence - participant->playSequence) < 0) {
+            slot.filled = false;
+            participant->buffered--;
+        }
+
+        const char *audio;
+        int bytes;
+        if (slot.filled && slot.sequence == participant->playSequence) {
+            slot.filled = false;
+            participant->buffered--;
+            participant->playSequence++;
+            if (slot.silent) {
+                // The turn is over; the next one starts at the earliest frame already waiting
+                participant->concealer.clearHistory();
+                bool waiting = false;
+                for (const Slot &next : participant->jitter) {
+                    if (next.filled && (!waiting || (int32_t)(next.sequence - participant->playSequence) < 0)) {
+                        participant->playSequence = next.sequence;
+                        waiting = true;
+                    }
+                }
+                participant->playing = participant->buffered >= CONFERENCE_JITTER_DEPTH;
+                continue;
+            }
+            participant->latency.record(LatencyMeter::JITTER_BUFFER, LatencyMeter::now() - slot.arrivedAt);
+            bytes = (int)slot.audio.size();
+            audio = participant->concealer.play(slot.audio.data(), bytes);
+        } else if (participant->buffered > 0) {
+            bytes = participant->concealer.conceal(decodeBuffer, AUDIO_DECODE_MAX);
+            audio = decodeBuffer;
+            participant->playSequence++;
+            stats.concealed++;
+            participant->stats.concealed++;
+        } else {
+            participant->playing = false;
+            stats.underruns++;
+            participant->stats.underruns++;
+            break;
+        }
+        if (bytes > 0) {
+            audio = participant->converter.convert(audio, bytes);
+            size_t staged = participant->staged.size();
+            participant->staged.resize(staged + bytes / 2);
+            memcpy(&participant->staged[staged], audio, (bytes / 2) * 2);
+        }
+    }
+
+    participant->talking = !participant->staged.empty();
+    if (participant->talking) {
+        size_t taken = participant->staged.size() < need ? participant->staged.size() : need;
+        participant->frame.assign(need, 0);
+        memcpy(participant->frame.data(), participant->staged.data(), taken * 2);
+        participant->staged.erase(participant->staged.begin(), participant->staged.begin() + taken);
+    }
+}
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	mix
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	void mix()
+--
+-- RETURNS:     void
+--
+-- NOTES:
+--              One pass adds every talker into the sums and a second takes each participant's own voice back
+--              out, so a mix costs a pass over the talkers and one over the listeners rather than one over
+--              everybody for each listener.
+--
+-------------------------------------------------------------------------------------------------------------------*/
+void ConferenceBridge::mix() {
+    uint64_t began = readCounter();
+    std::fill(sum.begin(), sum.end(), 0);
+    int talkers = 0;
+    for (auto &entry : participants) {
+        Participant *participant = entry.second;
+        pull(participant);
+        if (participant->talking) {
+            SampleConvert::accumulateS16(participant->frame.data(), sum.data(), frameSamples);
+            talkers++;
+        }
+    }
+
+    for (auto &entry : participants) {
+        Participant *participant = entry.second;
+        if (!participant->mixable) {
+            continue;
+        }
+        if (talkers - (participant->talking ? 1 : 0) == 0) {
+            if (participant->quietTicks++ % CNG_REFRESH_FRAMES == 0) {
+                StreamDescriptor format = mixFormat;
+                format.codec = participant->encoder ? participant->encoder->getId() : CODEC_PCM;
+                int bytes = StreamPacket::buildComfortNoise(source, format, participant->sendSequence,
+                                                            LatencyMeter::now(), CNG_MAX_LEVEL, packet);
+                if (io != nullptr) {
+                    io->queue(packet, bytes, participant->address);
+                }
+                stats.markersSent++;
+            }
+            participant->sendSequence++;
+            continue;
+        }
+        participant->quietTicks = 0;
+        SampleConvert::mixMinusS16(sum.data(), participant->talking ? participant->frame.data() : nullptr,
+                                   mixed.data(), frameSamples);
+        sendMix(participant, mixed.data());
+    }
+
+    uint64_t elapsed = readCounter() - began;
+    stats.ticks++;
+    stats.mixTicks += elapsed;
+    stats.mixMaxTicks = elapsed > stats.mixMaxTicks ? elapsed : stats.mixMaxTicks;
+    stats.participantTicks += participants.size();
+}
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	sendMix
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	void sendMix(Participant *participant, const int16_t *audio)
+--                           participant - participant to send to
+--                           audio - one frame of their mix in the bridge's format
+--
+-- RETURNS:     void
+--
+-- NOTES:
+--              The frame is stamped with the time it was mixed, since its voices were captured at different
+--              times on different clocks.
+--
+-------------------------------------------------------------------------------------------------------------------*/
+void ConferenceBridge::sendMix(Participant *participant, const int16_t *audio) {
+    StreamDescriptor format = mixFormat;
+    const char *payload = (const char *)audio;
+    int length = frameSamples * 2;
+    if (participant->encoder != nullptr) {
+        length = participant->encoder->encode(payload, length, encoded);
+        payload = encoded;
+        format.codec = participant->encoder->getId();
+    }
+    int bytes = StreamPacket::buildVoice(source, format, participant->sendSequence++, LatencyMeter::now(), payload,
+                                         length, packet);
+    if (io != nullptr) {
+        io->queue(packet, bytes, participant->address);
+    }
+    stats.framesSent++;
+}
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	evict
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	void evict()
+--
+-- RETURNS:     void
+--
+-- NOTES:
+--              Drops participants who have sent nothing, not even a comfort noise marker, for
+--              CONFERENCE_TIMEOUT_MS. A caller who hangs up sends nothing more, so this is how they leave.
+--
+-------------------------------------------------------------------------------------------------------------------*/
+void ConferenceBridge::evict() {
+    DWORD now = LatencyMeter::now();
+    for (auto entry = participants.begin(); entry != participants.end();) {
+        Participant *participant = entry->second;
+        if (now - participant->heardAt > CONFERENCE_TIMEOUT_MS) {
+            qDebug() << inet_ntoa(participant->address.sin_addr) << ntohs(participant->address.sin_port)
+                     << "left the conference:" << describe(participant);
+            delete participant;
+            entry = participants.erase(entry);
+            stats.left++;
+        } else {
+            ++entry;
+        }
+    }
+}
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	describe
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:   October 19, 2026 - Add the participant's latency - agent
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	QString describe(const Participant *participant) const
+--                               participant - participant to report on
+--
+-- RETURNS:     A one line summary of the participant's side of the conference
+--
+-------------------------------------------------------------------------------------------------------------------*/
+QString ConferenceBridge::describe(const Participant *participant) const {
+    return QString("Source %1 at %2:%3: %4 frames in, %5 late, %6 concealed, %7 underruns, moved %8 times,"
+                   " %9 frames waiting | Latency: %10")
+            .arg((qulonglong)participant->source, 8, 16, QChar('0'))
+            .arg(inet_ntoa(participant->address.sin_addr))
+            .arg(ntohs(participant->address.sin_port))
+            .arg((qint64)participant->stats.framesReceived)
+            .arg((qint64)participant->stats.late)
+            .arg((qint64)participant->stats.concealed)
+            .arg((qint64)participant->stats.underruns)
+            .arg((qint64)participant->stats.moves)
+            .arg((qint64)participant->buffered)
+            .arg(participant->latency.describe());
+}
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	receiveEcho
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	void receiveEcho(const StreamPacketHeader &header, const char *payload, const SOCKADDR_IN &from)
+--                               header - header of an echo packet
+--                               payload - its payload
+--                               from - address it came from
+--
+-- RETURNS:     void
+--
+-- NOTES:
+--              Answers a participant's probe at once with the bridge's clock, or gives the answer to one of the
+--              bridge's probes to that participant's latency meter. A probe counts as hearing from them.
+--
+-------------------------------------------------------------------------------------------------------------------*/
+void ConferenceBridge::receiveEcho(const StreamPacketHeader &header, const char *payload, const SOCKADDR_IN &from) {
+    uint32_t sender;
+    bool reply;
+    uint32_t origin;
+    if (!StreamPacket::readEcho(payload, header.length, sender, reply, origin)) {
+        stats.malformed++;
+        return;
+    }
+    Participant *participant = find(sender, from);
+    if (participant == nullptr) {
+        return;
+    }
+    DWORD now = LatencyMeter::now();
+    participant->heardAt = now;
+    if (reply) {
+        participant->latency.receiveReply(origin, header.timestamp, now);
+        return;
+    }
+    int bytes = StreamPacket::buildEcho(source, true, header.timestamp, now, packet);
+    if (io != nullptr) {
+        io->queue(packet, bytes, participant->address);
+    }
+}
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	sendProbes
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	void sendProbes()
+--
+-- RETURNS:     void
+--
+-- NOTES:
+--              Queues an echo probe to every participant whose last one was LATENCY_PROBE_MS ago.
+--
+-------------------------------------------------------------------------------------------------------------------*/
+void ConferenceBridge::sendProbes() {
+    DWORD now = LatencyMeter::now();
+    for (auto &entry : participants) {
+        Participant *participant = entry.second;
+        if (!participant->latency.isProbeDue(now)) {
+            continue;
+        }
+        int bytes = StreamPacket::buildEcho(source, false, 0, now, packet);
+        if (io != nullptr) {
+            io->queue(packet, bytes, participant->address);
+        }
+    }
+}
@@ -0,0 +1,142 @@
+#pragma once
+#include <winsock2.h>
+#include <windows.h>
+#include <cstdint>
+#include <vector>
+#include <unordered_map>
+#include <QDebug>
+#include <QString>
+#include "audiocodec.h"
+#include "datagramio.h"
+#include "formatconverter.h"
+#include "latencymeter.h"
+#include "lossconcealer.h"
+#include "sampleconvert.h"
+#include "streampacket.h"
+#include "voiceactivity.h"
+
+#define CONFERENCE_FRAME_MS 20
+#define CONFERENCE_RATE 8000
+#define CONFERENCE_CHANNELS 1
+#define CONFERENCE_MAX_PARTICIPANTS 64
+#define CONFERENCE_JITTER_SLOTS 16
+#define CONFERENCE_JITTER_DEPTH 2
+#define CONFERENCE_TIMEOUT_MS 5000
+#define CONFERENCE_MAX_LATE_TICKS 5
+#define CONFERENCE_REPORT_MS 5000
+#define CONFERENCE_BENCH_PARTICIPANTS 50
+#define CONFERENCE_BENCH_SECONDS 60
+#define CONFERENCE_BENCH_TURN_MS 3000
+#define CONFERENCE_BENCH_SYLLABLE_MS 240
+#define CONFERENCE_BENCH_NOISE 30
+
+class ConferenceBridge {
+public:
+    struct Statistics {
+        uint32_t joined = 0;
+        uint32_t left = 0;
+        uint32_t turnedAway = 0;
+        uint32_t moved = 0;
+        uint32_t malformed = 0;
+        uint64_t framesReceived = 0;
+        uint32_t late = 0;
+        uint32_t concealed = 0;
+        uint32_t underruns = 0;
+        uint64_t framesSent = 0;
+        uint64_t markersSent = 0;
+        uint64_t ticks = 0;
+        uint32_t ticksSkipped = 0;
+        uint64_t participantTicks = 0;
+        uint64_t mixTicks = 0;
+        uint64_t mixMaxTicks = 0;
+        uint64_t busyTicks = 0;
+        uint64_t wallTicks = 0;
+    };
+
+    ConferenceBridge(u_short port, uint32_t sampleRate = CONFERENCE_RATE, uint8_t channels = CONFERENCE_CHANNELS);
+    ~ConferenceBridge();
+    ConferenceBridge(const ConferenceBridge&) = delete;
+    void operator=(const ConferenceBridge&) = delete;
+
+    static int runFromArguments(int argc, char *argv[]);
+    static QString benchmark(int participants, int seconds);
+    bool open();
+    void run();
+    void stop();
+    QString getStatistics() const;
+
+private:
+    struct Slot {
+        uint32_t sequence = 0;
+        bool filled = false;
+        bool silent = false;
+        DWORD arrivedAt = 0;
+        std::vector<char> audio;
+    };
+
+    struct SourceStatistics {
+        uint64_t framesReceived = 0;
+        uint32_t late = 0;
+        uint32_t concealed = 0;
+        uint32_t underruns = 0;
+        uint32_t moves = 0;
+    };
+
+    struct Participant {
+        uint32_t source;
+        SOCKADDR_IN address;
+        StreamDescriptor format = {};
+        bool mixable = false;
+        AudioCodec *decoder = nullptr;
+        AudioCodec *encoder = nullptr;
+        FormatConverter converter;
+        LossConcealer concealer;
+        Slot jitter[CONFERENCE_JITTER_SLOTS];
+        int buffered = 0;
+        uint32_t playSequence = 0;
+        bool playing = false;
+        std::vector<int16_t> staged;
+        std::vector<int16_t> frame;
+        bool talking = false;
+        uint32_t sendSequence = 0;
+        uint32_t quietTicks = 0;
+        DWORD heardAt = 0;
+        SourceStatistics stats;
+        LatencyMeter latency;
+
+        ~Participant() {
+            delete decoder;
+            delete encoder;
+        }
+    };
+
+    u_short port;
+    uint32_t source;
+    StreamDescriptor mixFormat;
+    int frameSamples;
+    volatile bool running = false;
+    SOCKET sock = INVALID_SOCKET;
+    WSAEVENT readEvent = WSA_INVALID_EVENT;
+    WSAEVENT stopEvent = WSA_INVALID_EVENT;
+    DatagramIO *io = nullptr;
+
+    std::unordered_map<uint32_t, Participant*> participants;
+    std::vector<int32_t> sum;
+    std::vector<int16_t> mixed;
+    char decodeBuffer[AUDIO_DECODE_MAX];
+    char encoded[STREAM_PAYLOAD_SIZE];
+    char packet[DATA_BUFSIZE];
+    Statistics stats;
+
+    void receive(const char *datagram, int bytes, const SOCKADDR_IN &from);
+    void receiveEcho(const StreamPacketHeader &header, const char *payload, const SOCKADDR_IN &from);
+    Participant *find(uint32_t sender, const SOCKADDR_IN &from);
+    void useFormat(Participant *participant, const StreamDescriptor &format);
+    void restart(Participant *participant);
+    void pull(Participant *participant);
+    void mix();
+    void sendMix(Participant *participant, const int16_t *audio);
+    void evict();
+    void sendProbes();
+    QString describe(const Participant *participant) const;
+};
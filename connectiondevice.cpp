@@ -10,10 +10,11 @@
 --                  DWORD connectTCPServer(LPVOID lpParameter)
 --                  bool connectServer()
 --                  bool disconnectClient()
+--                  SOCKET openMulticastReceiver(const char *group, int port)
 --
 -- DATE: 			March 20, 2020
 --
--- REVISIONS:
+-- REVISIONS:       October 19, 2026 - Share the multicast join between the client and the relay - agent
 --
 -- DESIGNER: 		Victor Phan
 --
@@ -57,6 +58,64 @@ void ConnectionDevice::closeSocket(SOCKET &socket) {
     socket = NULL;
 }
 
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	openMulticastReceiver
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: 	Ellaine Chan
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	SOCKET openMulticastReceiver(const char *group, int port)
+--                                           group - multicast group to join
+--                                           port - port the stream is sent to
+--
+-- RETURNS:     Returns the socket, or INVALID_SOCKET if it could not be created
+--
+-- NOTES:
+--              Binds a UDP socket to the port with SO_REUSEADDR, so several receivers on one host can share the
+--              stream, and joins the group on the default interface. A failed bind or join is only reported,
+--              as it was when this was part of joinMulticastStream.
+--
+-------------------------------------------------------------------------------------------------------------------*/
+SOCKET ConnectionDevice::openMulticastReceiver(const char *group, int port) {
+    SOCKADDR_IN stLclAddr;
+    struct ip_mreq stMreq;
+    SOCKET hSocket;
+    bool fFlag;
+    int nRet;
+
+    hSocket = socket(AF_INET, SOCK_DGRAM, 0);
+    if (hSocket == INVALID_SOCKET) {
+        printf("socket() failed, Err: %d\n", WSAGetLastError());
+        return INVALID_SOCKET;
+    }
+    fFlag = TRUE;
+    nRet = setsockopt(hSocket, SOL_SOCKET, SO_REUSEADDR, (char *)&fFlag, sizeof(fFlag));
+    if (nRet == SOCKET_ERROR) {
+        printf("setsockopt() SO_REUSEADDR failed, Err: %d\n", WSAGetLastError());
+    }
+    stLclAddr.sin_family = AF_INET;
+    stLclAddr.sin_addr.s_addr = htonl(INADDR_ANY);
+    stLclAddr.sin_port = htons((u_short)port);
+    nRet = bind(hSocket, (struct sockaddr *)&stLclAddr, sizeof(stLclAddr));
+    if (nRet == SOCKET_ERROR) {
+        printf("bind() port: %d failed, Err: %d\n", port, WSAGetLastError());
+    }
+
+    /* Join the multicast group so we can receive from it */
+    stMreq.imr_multiaddr.s_addr = inet_addr(group);
+    stMreq.imr_interface.s_addr = INADDR_ANY;
+    nRet = setsockopt(hSocket, IPPROTO_IP, IP_ADD_MEMBERSHIP, (char *)&stMreq, sizeof(stMreq));
+    if (nRet == SOCKET_ERROR) {
+        printf("setsockopt() IP_ADD_MEMBERSHIP address %s failed, Err: %d\n", group, WSAGetLastError());
+    }
+    return hSocket;
+}
+
 /*-----------------------------------------------------------------------------------------------------------------
 -- Function:	readTCPPacket
 --
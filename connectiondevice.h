@@ -8,6 +8,7 @@
 #include <ws2tcpip.h>
 #include "filehandler.h"
 #include "audiodevice.h"
+#include "sockettuner.h"
 
 #define DATA_BUFSIZE 4000
 #define PACKET_SIZE 64000
@@ -26,13 +27,13 @@ class ConnectionDevice : public QObject
     Q_OBJECT
 signals:
     void sendMessageToScreen(QString message);
+    void streamTrackChanged(QString title);
 
 public:
     enum protocol
     {
         UDP,
-        TCP,
-        UDP_CALL
+        TCP
     };
     DWORD threadArray[MAX_THREADS] = {};
     int threadIndex = 0;
@@ -43,6 +44,7 @@ public:
     static DWORD WINAPI sendTCPPackets(LPVOID lpParameter);
     bool readTCPPacket(SOCKET *socket);
     static void closeSocket(SOCKET &socket);
+    static SOCKET openMulticastReceiver(const char *group, int port);
     bool startUpWSA()
     {
         WSADATA wsaData;
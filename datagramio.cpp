@@ -0,0 +1,628 @@
+/*------------------------------------------------------------------------------------------------------------------
+-- SOURCE FILE: 	datagramio.cpp - Batched datagram sends and reads on one UDP socket.
+--
+--
+-- PROGRAM: 		Communication Audio Program
+--
+-- FUNCTIONS:
+--                  DatagramIO(SOCKET sock)
+--                  ~DatagramIO()
+--                  static int runFromArguments(int argc, char *argv[])
+--                  static QString benchmark(int seconds, int bytes)
+--                  bool enableSendOffload()
+--                  bool enableReceiveCoalescing()
+--                  void queue(const char *datagram, int bytes, const SOCKADDR_IN &to)
+--                  int flush()
+--                  bool sendOne(const char *datagram, int bytes, const SOCKADDR_IN &to)
+--                  bool sendSegments(int first, int segments, int total)
+--                  int receive(const ReceiveCallback &handle, int limit)
+--                  int receiveCoalesced(const ReceiveCallback &handle)
+--
+-- DATE: 			October 19, 2026
+--
+-- REVISIONS:       October 19, 2026 - Count sends dropped by a full socket buffer - agent
+--                  October 19, 2026 - Add --datagram-bench, loopback packets per second by mode - agent
+--                  October 19, 2026 - Send at once without staging when offload is off, name the bench modes - agent
+--
+-- DESIGNER: 		agent
+--
+-- PROGRAMMER: 		agent
+--
+-- NOTES:
+--      Sending and reading one datagram per call makes the system call the biggest cost once a host carries
+--      many channels or call legs. A DatagramIO collects the datagrams a thread sends in one wake and sends
+--      them together on flush(), and reads every datagram waiting on the socket in one receive().
+--
+--      Where the stack supports UDP segmentation offload, a run of equal sized datagrams to one destination
+--      is handed over in a single WSASendMsg and the stack or the NIC cuts it into datagrams. Where it supports
+--      receive coalescing, datagrams of one sender arrive joined in one buffer and are split again here. Both
+--      need a recent Windows 10 and SDK, so they are compiled only when the SDK defines the options, are off
+--      until enabled, and fall back to one sendto() or recvfrom() per datagram when the stack refuses them.
+--      Without offload nothing is gained by holding datagrams back, so queue() sends each one at once from the
+--      caller's buffer instead of copying it in for flush(). Without coalescing, receive() still reads every
+--      waiting datagram in one wake, but one recvfrom() each. The statistics count datagrams against calls so
+--      the modes can be compared on a running system.
+--
+--      Reads need a non-blocking socket. A DatagramIO is not thread safe and is used by one thread.
+--
+--      --datagram-bench sends datagrams to itself over loopback one per call, in batches, and in batches with
+--      offload and coalescing where the stack has them, and gives packets per second and calls per datagram.
+--      Each mode says which send and read path actually ran.
+--
+--------------------------------------------------------------------------------------------------------------------*/
+#include "datagramio.h"
+#include <cstdlib>
+
+static QString runLoopback(int batch, bool offload, int seconds, int bytes) {
+    SOCKET receiver = socket(AF_INET, SOCK_DGRAM, 0);
+    SOCKET sender = socket(AF_INET, SOCK_DGRAM, 0);
+    if (receiver == INVALID_SOCKET || sender == INVALID_SOCKET) {
+        return QString("could not open sockets, error %1").arg(WSAGetLastError());
+    }
+    SOCKADDR_IN local = {};
+    local.sin_family = AF_INET;
+    local.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    int size = sizeof(local);
+    int bufferSize = DATAGRAM_BENCH_BUFFER;
+    u_long nonBlocking = 1;
+    if (bind(receiver, (struct sockaddr *)&local, sizeof(local)) == SOCKET_ERROR ||
+            getsockname(receiver, (struct sockaddr *)&local, &size) == SOCKET_ERROR ||
+            setsockopt(receiver, SOL_SOCKET, SO_RCVBUF, (const char *)&bufferSize,
+                       sizeof(bufferSize)) == SOCKET_ERROR ||
+            ioctlsocket(receiver, FIONBIO, &nonBlocking) == SOCKET_ERROR) {
+        int error = WSAGetLastError();
+        closesocket(receiver);
+        closesocket(sender);
+        return QString("could not set up the receiver, error %1").arg(error);
+    }
+
+    DatagramIO *out = new DatagramIO(sender);
+    DatagramIO *in = new DatagramIO(receiver);
+    bool offloaded = offload && out->enableSendOffload();
+    bool coalesced = offload && in->enableReceiveCoalescing();
+    QString result;
+    if (offload && !offloaded && !coalesced) {
+        result = QString("not available on this stack");
+    } else {
+        char *datagram = new char[bytes];
+        memset(datagram, 0x55, bytes);
+        LARGE_INTEGER frequency, start, now;
+        QueryPerformanceFrequency(&frequency);
+        QueryPerformanceCounter(&start);
+        do {
+            for (int i = 0; i < batch; i++) {
+                out->queue(datagram, bytes, local);
+            }
+            out->flush();
+            // One read per datagram sent, as the old receivers did, or everything waiting
+            in->receive([](const char *, int, const SOCKADDR_IN &) {}, batch == 1 ? 1 : DATAGRAM_BATCH_SIZE * 4);
+            QueryPerformanceCounter(&now);
+        } while (now.QuadPart - start.QuadPart < seconds * frequency.QuadPart);
+        while (in->receive([](const char *, int, const SOCKADDR_IN &) {}) > 0) {
+        }
+        delete[] datagram;
+
+        double elapsed = (double)(now.QuadPart - start.QuadPart) / frequency.QuadPart;
+        const DatagramIO::Statistics &sent = out->getStatistics();
+        const DatagramIO::Statistics &received = in->getStatistics();
+        result = QString("%1 packets/s, %2 send and %3 receive calls per 100 datagrams, %4% lost (%5, %6)")
+                .arg(received.datagramsReceived / elapsed, 0, 'f', 0)
+                .arg(sent.datagramsSent > 0 ? 100.0 * sent.sendCalls / sent.datagramsSent : 0, 0, 'f', 1)
+                .arg(received.datagramsReceived > 0 ? 100.0 * received.receiveCalls / received.datagramsReceived : 0,
+                     0, 'f', 1)
+                .arg(sent.datagramsSent > 0 ? 100.0 * (sent.datagramsSent - received.datagramsReceived) /
+                     sent.datagramsSent : 0, 0, 'f', 2)
+                .arg(out->isSendOffloaded() ? "segmented sends" : "one sendto per datagram")
+                .arg(in->isReceiveCoalesced() ? "coalesced reads" : "one recvfrom per datagram");
+    }
+    delete in;
+    delete out;
+    closesocket(receiver);
+    closesocket(sender);
+    return result;
+}
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	DatagramIO
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	DatagramIO(SOCKET sock)
+--                         sock - UDP socket to send and read on, still owned by the caller
+--
+-- RETURNS:     NA
+--
+-------------------------------------------------------------------------------------------------------------------*/
+DatagramIO::DatagramIO(SOCKET sock) : sock(sock) {
+    sendBuffer = new char[DATAGRAM_BATCH_SIZE * DATA_BUFSIZE];
+    receiveBuffer = new char[DATAGRAM_COALESCE_MAX];
+}
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	~DatagramIO
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	~DatagramIO()
+--
+-- RETURNS:     NA
+--
+-- NOTES:
+--              Queued datagrams are dropped, the socket may already be closed.
+--
+-------------------------------------------------------------------------------------------------------------------*/
+DatagramIO::~DatagramIO() {
+    delete[] sendBuffer;
+    delete[] receiveBuffer;
+}
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	runFromArguments
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	static int runFromArguments(int argc, char *argv[])
+--                          argc - number of command line arguments
+--                          argv - the command line arguments
+--
+-- RETURNS:     The process exit code
+--
+-- NOTES:
+--              The form is
+--                  --datagram-bench [seconds per mode] [datagram bytes]
+--              The benchmark prints its result and returns.
+--
+-------------------------------------------------------------------------------------------------------------------*/
+int DatagramIO::runFromArguments(int argc, char *argv[]) {
+    if (strcmp(argv[1], "--datagram-bench") != 0) {
+        qDebug() << "Usage: --datagram-bench [seconds per mode] [datagram bytes]\n";
+        return 1;
+    }
+    int seconds = argc >= 3 ? atoi(argv[2]) : DATAGRAM_BENCH_SECONDS;
+    int bytes = argc >= 4 ? atoi(argv[3]) : DATAGRAM_BENCH_BYTES;
+    WSADATA wsaData;
+    if (WSAStartup(0x0202, &wsaData) != 0) {
+        qDebug() << "WSAStartup failed with error \n" << WSAGetLastError();
+        return 1;
+    }
+    qDebug() << benchmark(seconds > 0 ? seconds : DATAGRAM_BENCH_SECONDS,
+                          bytes > 0 && bytes <= DATA_BUFSIZE ? bytes : DATAGRAM_BENCH_BYTES);
+    WSACleanup();
+    return 0;
+}
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	benchmark
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:   October 19, 2026 - Name the path each mode ran - agent
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	static QString benchmark(int seconds, int bytes)
+--                                seconds - how long each mode runs
+--                                bytes - size of every datagram
+--
+-- RETURNS:     A one line summary of the three modes
+--
+-- NOTES:
+--              One thread sends to itself over loopback and reads back what arrived after every flush. The
+--              first mode flushes and reads one datagram at a time, as sendNextChunk and the receivers used
+--              to. The second queues a batch of DATAGRAM_BATCH_SIZE and reads everything waiting, and the
+--              third does the same with segmentation offload and receive coalescing turned on. Without them
+--              the batches still go out one sendto() per datagram, sent as they are queued, so only the third
+--              mode saves calls; the second differs from the first only in draining every waiting datagram
+--              per read. Every mode names the send and read path it ran, so a run without offload is not
+--              taken for a batching gain.
+--
+-------------------------------------------------------------------------------------------------------------------*/
+QString DatagramIO::benchmark(int seconds, int bytes) {
+    return QString("Datagram benchmark, %1 byte datagrams over loopback, %2 s per mode"
+                   " | One per call: %3 | Batches of %4: %5 | Batches with offload: %6")
+            .arg(bytes)
+            .arg(seconds)
+            .arg(runLoopback(1, false, seconds, bytes))
+            .arg(DATAGRAM_BATCH_SIZE)
+            .arg(runLoopback(DATAGRAM_BATCH_SIZE, false, seconds, bytes))
+            .arg(runLoopback(DATAGRAM_BATCH_SIZE, true, seconds, bytes));
+}
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	enableSendOffload
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	bool enableSendOffload()
+--
+-- RETURNS:     Returns true if runs of datagrams will be sent segmented
+--
+-- NOTES:
+--              Only stacks that can segment know the option, so reading it is the test.
+--
+-------------------------------------------------------------------------------------------------------------------*/
+bool DatagramIO::enableSendOffload() {
+#ifdef UDP_SEND_MSG_SIZE
+    DWORD segmentSize = 0;
+    int size = sizeof(segmentSize);
+    sendOffload = getsockopt(sock, IPPROTO_UDP, UDP_SEND_MSG_SIZE, (char *)&segmentSize, &size) != SOCKET_ERROR;
+#endif
+    return sendOffload;
+}
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	enableReceiveCoalescing
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	bool enableReceiveCoalescing()
+--
+-- RETURNS:     Returns true if reads may return several datagrams joined together
+--
+-- NOTES:
+--              Coalesced reads have to go through WSARecvMsg to learn the size of each datagram, so it is
+--              looked up first and coalescing is only turned on if it is there.
+--
+-------------------------------------------------------------------------------------------------------------------*/
+bool DatagramIO::enableReceiveCoalescing() {
+#ifdef UDP_RECV_MAX_COALESCED_SIZE
+    GUID guid = WSAID_WSARECVMSG;
+    DWORD bytes;
+    DWORD maxSize = DATAGRAM_COALESCE_MAX;
+    if (WSAIoctl(sock, SIO_GET_EXTENSION_FUNCTION_POINTER, &guid, sizeof(guid), &recvMsg, sizeof(recvMsg),
+                 &bytes, NULL, NULL) == SOCKET_ERROR) {
+        return false;
+    }
+    receiveCoalescing = setsockopt(sock, IPPROTO_UDP, UDP_RECV_MAX_COALESCED_SIZE, (char *)&maxSize,
+                                   sizeof(maxSize)) != SOCKET_ERROR;
+#endif
+    return receiveCoalescing;
+}
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	queue
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:   October 19, 2026 - Send at once when offload is off - agent
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	void queue(const char *datagram, int bytes, const SOCKADDR_IN &to)
+--                         datagram - packet to send, copied so the caller may reuse it at once
+--                         bytes - size of the packet
+--                         to - destination
+--
+-- RETURNS:     void
+--
+-- NOTES:
+--              With segmentation offload the datagram is copied in and goes out on the next flush(), or now
+--              if the batch is full. Without it the datagram is sent straight from the caller's buffer, after
+--              anything still queued. Datagrams are sent in the order they were queued either way.
+--
+-------------------------------------------------------------------------------------------------------------------*/
+void DatagramIO::queue(const char *datagram, int bytes, const SOCKADDR_IN &to) {
+    if (bytes <= 0 || bytes > DATA_BUFSIZE) {
+        return;
+    }
+    if (!sendOffload) {
+        if (count > 0) {
+            flush();
+        }
+        sendOne(datagram, bytes, to);
+        return;
+    }
+    if (count == DATAGRAM_BATCH_SIZE) {
+        flush();
+    }
+    memcpy(sendBuffer + used, datagram, bytes);
+    entries[count].offset = used;
+    entries[count].bytes = bytes;
+    entries[count].to = to;
+    count++;
+    used += bytes;
+}
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	flush
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:   October 19, 2026 - Drop quietly when the socket buffer is full - agent
+--              October 19, 2026 - Send single datagrams through sendOne - agent
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	int flush()
+--
+-- RETURNS:     Returns the number of datagrams sent
+--
+-- NOTES:
+--              With segmentation offload, queued datagrams to the same destination are grouped while they are
+--              the same size, and only the last of a group may be shorter, which is what the stack cuts a
+--              segmented send into. Anything else is sent one datagram at a time. Without offload nothing is
+--              queued, as queue() has sent it already.
+--
+-------------------------------------------------------------------------------------------------------------------*/
+int DatagramIO::flush() {
+    int sent = 0;
+    int first = 0;
+    while (first < count) {
+        int segments = 1;
+        int total = entries[first].bytes;
+        if (sendOffload) {
+            while (first + segments < count &&
+                   entries[first + segments - 1].bytes == entries[first].bytes &&
+                   entries[first + segments].bytes <= entries[first].bytes &&
+                   sameDestination(entries[first + segments].to, entries[first].to) &&
+                   total + entries[first + segments].bytes <= DATAGRAM_COALESCE_MAX) {
+                total += entries[first + segments].bytes;
+                segments++;
+            }
+        }
+        if (segments > 1 && sendSegments(first, segments, total)) {
+            sent += segments;
+        } else {
+            for (int i = first; i < first + segments; i++) {
+                sent += sendOne(sendBuffer + entries[i].offset, entries[i].bytes, entries[i].to) ? 1 : 0;
+            }
+        }
+        first += segments;
+    }
+    count = 0;
+    used = 0;
+    return sent;
+}
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	sendOne
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	bool sendOne(const char *datagram, int bytes, const SOCKADDR_IN &to)
+--                           datagram - packet to send
+--                           bytes - size of the packet
+--                           to - destination
+--
+-- RETURNS:     Returns false if the datagram was dropped
+--
+-- NOTES:
+--              On a non-blocking socket a full send buffer drops the datagram rather than waiting, and the
+--              drop is only counted.
+--
+-------------------------------------------------------------------------------------------------------------------*/
+bool DatagramIO::sendOne(const char *datagram, int bytes, const SOCKADDR_IN &to) {
+    stats.sendCalls++;
+    if (sendto(sock, datagram, bytes, 0, (struct sockaddr*) &to, sizeof(SOCKADDR_IN)) < 0) {
+        stats.sendsDropped++;
+        if (WSAGetLastError() != WSAEWOULDBLOCK) {
+            qDebug() << "sendto() failed with error \n" << WSAGetLastError();
+        }
+        return false;
+    }
+    stats.datagramsSent++;
+    return true;
+}
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	sendSegments
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	bool sendSegments(int first, int segments, int total)
+--                                first - index of the first queued datagram of the group
+--                                segments - number of datagrams in the group
+--                                total - bytes in the group
+--
+-- RETURNS:     Returns false if the group was not sent and has to be sent one datagram at a time
+--
+-- NOTES:
+--              The segment size travels with the message, so groups of different sizes need no extra calls.
+--              A stack that rejects the option turns offload off for good.
+--
+-------------------------------------------------------------------------------------------------------------------*/
+bool DatagramIO::sendSegments(int first, int segments, int total) {
+#ifdef UDP_SEND_MSG_SIZE
+    char control[WSA_CMSG_SPACE(sizeof(DWORD))] = {};
+    WSABUF data;
+    WSAMSG message = {};
+    DWORD bytes;
+
+    data.buf = sendBuffer + entries[first].offset;
+    data.len = total;
+    message.name = (LPSOCKADDR) &entries[first].to;
+    message.namelen = sizeof(SOCKADDR_IN);
+    message.lpBuffers = &data;
+    message.dwBufferCount = 1;
+    message.Control.buf = control;
+    message.Control.len = sizeof(control);
+    WSACMSGHDR *option = WSA_CMSG_FIRSTHDR(&message);
+    option->cmsg_level = IPPROTO_UDP;
+    option->cmsg_type = UDP_SEND_MSG_SIZE;
+    option->cmsg_len = WSA_CMSG_LEN(sizeof(DWORD));
+    *(DWORD *)WSA_CMSG_DATA(option) = entries[first].bytes;
+
+    stats.sendCalls++;
+    if (WSASendMsg(sock, &message, 0, &bytes, NULL, NULL) == SOCKET_ERROR) {
+        int error = WSAGetLastError();
+        if (error == WSAEINVAL || error == WSAEOPNOTSUPP || error == WSAENOPROTOOPT) {
+            qDebug() << "segmentation offload refused, sending datagrams one at a time \n" << error;
+            sendOffload = false;
+        }
+        return false;
+    }
+    stats.datagramsSent += segments;
+    return true;
+#else
+    return false;
+#endif
+}
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	receive
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	int receive(const ReceiveCallback &handle, int limit)
+--                          handle - called for each datagram with its sender
+--                          limit - stop after this many datagrams so other work is not starved
+--
+-- RETURNS:     Returns the number of datagrams handled
+--
+-- NOTES:
+--              Reads until the socket has nothing left or the limit is reached. The buffer passed to handle is
+--              reused by the next read.
+--
+-------------------------------------------------------------------------------------------------------------------*/
+int DatagramIO::receive(const ReceiveCallback &handle, int limit) {
+    int received = 0;
+    SOCKADDR_IN from;
+    while (received < limit) {
+        int delivered;
+        if (receiveCoalescing) {
+            delivered = receiveCoalesced(handle);
+        } else {
+            int fromSize = sizeof(from);
+            int bytes = recvfrom(sock, receiveBuffer, DATA_BUFSIZE, 0, (struct sockaddr*) &from, &fromSize);
+            stats.receiveCalls++;
+            delivered = bytes;
+            if (bytes > 0) {
+                handle(receiveBuffer, bytes, from);
+                stats.datagramsReceived++;
+                delivered = 1;
+            }
+        }
+        if (delivered == SOCKET_ERROR) {
+            int error = WSAGetLastError();
+            // A peer that left makes the next read report port unreachable, oversized datagrams are dropped
+            if (error == WSAECONNRESET || error == WSAEMSGSIZE) {
+                continue;
+            }
+            if (error != WSAEWOULDBLOCK) {
+                qDebug() << "recvfrom() failed with error \n" << error;
+            }
+            break;
+        }
+        received += delivered;
+    }
+    return received;
+}
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	receiveCoalesced
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	int receiveCoalesced(const ReceiveCallback &handle)
+--                                   handle - called for each datagram with its sender
+--
+-- RETURNS:     Returns the number of datagrams handled, or SOCKET_ERROR if the read failed
+--
+-- NOTES:
+--              Every datagram of a coalesced read is the size the stack reports except the last, which may be
+--              shorter. A read without the size holds a single datagram.
+--
+-------------------------------------------------------------------------------------------------------------------*/
+int DatagramIO::receiveCoalesced(const ReceiveCallback &handle) {
+#ifdef UDP_RECV_MAX_COALESCED_SIZE
+    char control[WSA_CMSG_SPACE(sizeof(DWORD))] = {};
+    SOCKADDR_IN from;
+    WSABUF data;
+    WSAMSG message = {};
+    DWORD bytes;
+
+    data.buf = receiveBuffer;
+    data.len = DATAGRAM_COALESCE_MAX;
+    message.name = (LPSOCKADDR) &from;
+    message.namelen = sizeof(from);
+    message.lpBuffers = &data;
+    message.dwBufferCount = 1;
+    message.Control.buf = control;
+    message.Control.len = sizeof(control);
+    stats.receiveCalls++;
+    if (recvMsg(sock, &message, &bytes, NULL, NULL) == SOCKET_ERROR) {
+        return SOCKET_ERROR;
+    }
+
+    int segmentSize = (int)bytes;
+    for (WSACMSGHDR *option = WSA_CMSG_FIRSTHDR(&message); option != NULL;
+         option = WSA_CMSG_NXTHDR(&message, option)) {
+        if (option->cmsg_level == IPPROTO_UDP && option->cmsg_type == UDP_COALESCED_INFO) {
+            segmentSize = (int)*(DWORD *)WSA_CMSG_DATA(option);
+        }
+    }
+    if (segmentSize <= 0) {
+        segmentSize = (int)bytes;
+    }
+    int delivered = 0;
+    for (int offset = 0; offset < (int)bytes; offset += segmentSize) {
+        int length = (int)bytes - offset < segmentSize ? (int)bytes - offset : segmentSize;
+        handle(receiveBuffer + offset, length, from);
+        delivered++;
+    }
+    stats.datagramsReceived += delivered;
+    return delivered;
+#else
+    return SOCKET_ERROR;
+#endif
+}
@@ -0,0 +1,82 @@
+#pragma once
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#include <mswsock.h>
+#include <windows.h>
+#include <cstring>
+#include <functional>
+#include <QDebug>
+#include <QString>
+#include "streampacket.h"
+
+#define DATAGRAM_BATCH_SIZE 64
+#define DATAGRAM_COALESCE_MAX 65000
+#define DATAGRAM_BENCH_SECONDS 3
+#define DATAGRAM_BENCH_BYTES 1012
+#define DATAGRAM_BENCH_BUFFER (4 * 1024 * 1024)
+
+class DatagramIO {
+public:
+    typedef std::function<void(const char *datagram, int bytes, const SOCKADDR_IN &from)> ReceiveCallback;
+
+    struct Statistics {
+        DWORD datagramsSent;
+        DWORD sendCalls;
+        DWORD sendsDropped;
+        DWORD datagramsReceived;
+        DWORD receiveCalls;
+    };
+
+    DatagramIO(SOCKET sock);
+    ~DatagramIO();
+    DatagramIO(const DatagramIO&) = delete;
+    void operator=(const DatagramIO&) = delete;
+
+    static int runFromArguments(int argc, char *argv[]);
+    static QString benchmark(int seconds, int bytes);
+    bool enableSendOffload();
+    bool enableReceiveCoalescing();
+    void disableSendOffload() {
+        sendOffload = false;
+    }
+    void queue(const char *datagram, int bytes, const SOCKADDR_IN &to);
+    int flush();
+    int receive(const ReceiveCallback &handle, int limit = DATAGRAM_BATCH_SIZE);
+
+    bool isSendOffloaded() const {
+        return sendOffload;
+    }
+    bool isReceiveCoalesced() const {
+        return receiveCoalescing;
+    }
+    const Statistics &getStatistics() const {
+        return stats;
+    }
+
+private:
+    struct Entry {
+        int offset;
+        int bytes;
+        SOCKADDR_IN to;
+    };
+
+    SOCKET sock;
+    bool sendOffload = false;
+    bool receiveCoalescing = false;
+#ifdef UDP_RECV_MAX_COALESCED_SIZE
+    LPFN_WSARECVMSG recvMsg = nullptr;
+#endif
+    Entry entries[DATAGRAM_BATCH_SIZE];
+    int count = 0;
+    int used = 0;
+    char *sendBuffer;
+    char *receiveBuffer;
+    Statistics stats = {};
+
+    static bool sameDestination(const SOCKADDR_IN &a, const SOCKADDR_IN &b) {
+        return a.sin_addr.s_addr == b.sin_addr.s_addr && a.sin_port == b.sin_port;
+    }
+    bool sendOne(const char *datagram, int bytes, const SOCKADDR_IN &to);
+    bool sendSegments(int first, int segments, int total);
+    int receiveCoalesced(const ReceiveCallback &handle);
+};
@@ -0,0 +1,876 @@
+/*------------------------------------------------------------------------------------------------------------------
+-- SOURCE FILE: 	decodeahead.cpp - Decodes a compressed audio file to PCM on its own thread, ahead of playback.
+--
+--
+-- PROGRAM: 		Communication Audio Program
+--
+-- FUNCTIONS:
+--                  DecodeAhead(const std::string &fileName)
+--                  ~DecodeAhead()
+--                  static bool handles(const std::string &fileName)
+--                  static double getSpeed(const Statistics &stats)
+--                  static void addStatistics(Statistics &total, const Statistics &stats)
+--                  static int runFromArguments(int argc, char *argv[])
+--                  static QString benchmark(const std::string &fileName, int decoders)
+--                  bool start(StreamDescriptor &format)
+--                  bool waitForAudio(int bytes, DWORD timeoutMs)
+--                  int read(char *buf, int bytes)
+--                  bool atEnd()
+--                  void seek(uint64_t micros)
+--                  int64_t getDurationMs()
+--                  Statistics getStatistics()
+--                  void drain()
+--                  void applySeek()
+--                  void finish(bool error)
+--                  int convert(const QAudioBuffer &buffer)
+--                  bool push(const QAudioBuffer &buffer)
+--
+-- DATE: 			October 19, 2026
+--
+-- REVISIONS:       October 19, 2026 - Seek by skipping or restarting the decoder - agent
+--                  October 19, 2026 - Add --decode-bench, decoding speed of a file - agent
+--
+-- DESIGNER: 		agent
+--
+-- PROGRAMMER: 		agent
+--
+-- NOTES:
+--      MP3, FLAC and the other compressed formats the platform's decoders handle are turned into 16 bit PCM by a
+--      QAudioDecoder. The decoder lives on a QThread of its own, since it needs an event loop, and fills a ring
+--      that holds DECODE_AHEAD_MS of PCM. The pacing thread only ever copies out of the ring, so decoding never
+--      sits on its path.
+--
+--      When the ring is full the decoder thread stops taking buffers from the decoder, which holds the decoder
+--      back, and keeps the buffer it could not fit. Once the reader has emptied half of the ring it asks the
+--      decoder thread to carry on. Whatever the decoder hands over is converted to 16 bit signed samples, so
+--      the stream codecs and the listeners' concealment work on it like on a WAV track.
+--
+--      Decoding speed is measured while the decoder runs freely: the audio it produced divided by the time it
+--      took, leaving out the time spent waiting for room in the ring. That is how many times faster than
+--      real time one decoder runs, which is roughly how many compressed channels one core can keep fed.
+--      --decode-bench decodes a file with one or more decoders at once, as fast as they go, and gives both.
+--
+--      QAudioDecoder cannot seek, so a seek empties the ring and the decoder thread drops decoded audio until
+--      it reaches the target, using the start time of each buffer. A seek forward of what has been decoded just
+--      lets the decoder run on; a seek back restarts it from the top of the file. Decoding runs many times
+--      faster than real time, so either way the target is reached quickly, and the reader gets silence until
+--      then rather than waiting.
+--
+--      The ring, the flags and the counters are shared with the reader and guarded by a critical section.
+--
+--------------------------------------------------------------------------------------------------------------------*/
+#include "decodeahead.h"
+#include <cstdlib>
+
+static uint64_t readCounter() {
+    LARGE_INTEGER counter;
+    QueryPerformanceCounter(&counter);
+    return (uint64_t)counter.QuadPart;
+}
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	DecodeAhead
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	DecodeAhead(const std::string &fileName)
+--                          fileName - compressed audio file to decode
+--
+-- RETURNS:     NA
+--
+-- NOTES:
+--              Nothing is decoded until start() is called.
+--
+-------------------------------------------------------------------------------------------------------------------*/
+DecodeAhead::DecodeAhead(const std::string &fileName) : fileName(fileName) {
+    InitializeCriticalSection(&lock);
+    audioEvent = CreateEvent(NULL, FALSE, FALSE, NULL);
+}
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	~DecodeAhead
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	~DecodeAhead()
+--
+-- RETURNS:     NA
+--
+-- NOTES:
+--              Stops the decoder on its own thread and waits for the thread to end. The decoder is deleted
+--              when its thread finishes. A track is normally deleted after it has been played to the end, when
+--              the decoder has nothing left to do, so this returns quickly.
+--
+-------------------------------------------------------------------------------------------------------------------*/
+DecodeAhead::~DecodeAhead() {
+    if (thread != nullptr) {
+        if (decoder != nullptr) {
+            QMetaObject::invokeMethod(decoder, "stop", Qt::BlockingQueuedConnection);
+            decoder->deleteLater();
+        }
+        thread->quit();
+        thread->wait();
+        delete thread;
+    }
+    delete[] ring;
+    CloseHandle(audioEvent);
+    DeleteCriticalSection(&lock);
+}
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	handles
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	static bool handles(const std::string &fileName)
+--                          fileName - audio file of a track
+--
+-- RETURNS:     True if the file has the extension of a compressed format
+--
+-------------------------------------------------------------------------------------------------------------------*/
+bool DecodeAhead::handles(const std::string &fileName) {
+    static const char *extensions[] = { "mp3", "flac", "m4a", "aac", "wma", "ogg" };
+    size_t dot = fileName.find_last_of('.');
+    if (dot == std::string::npos) {
+        return false;
+    }
+    std::string extension = fileName.substr(dot + 1);
+    for (char &c : extension) {
+        c = (char)tolower((unsigned char)c);
+    }
+    for (const char *known : extensions) {
+        if (extension == known) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	getSpeed
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	static double getSpeed(const Statistics &stats)
+--                          stats - counters kept by a DecodeAhead
+--
+-- RETURNS:     How many times faster than real time the decoder ran, or 0 before it has run
+--
+-------------------------------------------------------------------------------------------------------------------*/
+double DecodeAhead::getSpeed(const Statistics &stats) {
+    LARGE_INTEGER frequency;
+    QueryPerformanceFrequency(&frequency);
+    if (stats.busyTicks == 0 || frequency.QuadPart == 0) {
+        return 0;
+    }
+    double busyMicros = stats.busyTicks * 1000000.0 / frequency.QuadPart;
+    return stats.audioMicros / busyMicros;
+}
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	addStatistics
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	static void addStatistics(Statistics &total, const Statistics &stats)
+--                          total - counters to add to
+--                          stats - counters of one track
+--
+-- RETURNS:     void
+--
+-------------------------------------------------------------------------------------------------------------------*/
+void DecodeAhead::addStatistics(Statistics &total, const Statistics &stats) {
+    total.audioMicros += stats.audioMicros;
+    total.busyTicks += stats.busyTicks;
+    total.stalls += stats.stalls;
+    total.underruns += stats.underruns;
+}
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	runFromArguments
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	static int runFromArguments(int argc, char *argv[])
+--                          argc - number of command line arguments
+--                          argv - the command line arguments
+--
+-- RETURNS:     The process exit code
+--
+-- NOTES:
+--              The form is
+--                  --decode-bench <file> [decoders]
+--              QAudioDecoder needs an application object, so one is made for the run, without a window or an
+--              event loop of its own. The benchmark prints its result and returns.
+--
+-------------------------------------------------------------------------------------------------------------------*/
+int DecodeAhead::runFromArguments(int argc, char *argv[]) {
+    if (argc < 3 || strcmp(argv[1], "--decode-bench") != 0) {
+        qDebug() << "Usage: --decode-bench <file> [decoders]\n";
+        return 1;
+    }
+    int decoders = argc >= 4 ? atoi(argv[3]) : 1;
+    if (decoders < 1 || decoders > DECODE_BENCH_MAX_DECODERS) {
+        decoders = 1;
+    }
+    QCoreApplication application(argc, argv);
+    qDebug() << benchmark(argv[2], decoders);
+    return 0;
+}
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	benchmark
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	static QString benchmark(const std::string &fileName, int decoders)
+--                                fileName - compressed audio file to decode
+--                                decoders - number of DecodeAheads decoding it at the same time
+--
+-- RETURNS:     A one line summary of the run
+--
+-- NOTES:
+--              Every decoder decodes the whole file while this thread empties their rings as fast as it can,
+--              so none of them waits for room for long. The speed of one decoder comes from the same counters
+--              the stream reports; the speed of all of them together is the audio decoded over the time the
+--              run took, which is what decoders sharing the machine's cores can drive.
+--
+-------------------------------------------------------------------------------------------------------------------*/
+QString DecodeAhead::benchmark(const std::string &fileName, int decoders) {
+    std::vector<DecodeAhead *> tracks;
+    std::vector<char> buffer(STREAM_PAYLOAD_SIZE);
+    LARGE_INTEGER frequency, began, ended;
+    QueryPerformanceFrequency(&frequency);
+    QueryPerformanceCounter(&began);
+    for (int i = 0; i < decoders; i++) {
+        DecodeAhead *track = new DecodeAhead(fileName);
+        StreamDescriptor format;
+        tracks.push_back(track);
+        if (!track->start(format)) {
+            for (DecodeAhead *started : tracks) {
+                delete started;
+            }
+            return QString("Decode benchmark: cannot decode %1").arg(fileName.c_str());
+        }
+    }
+
+    bool decoding = true;
+    while (decoding) {
+        decoding = false;
+        int copied = 0;
+        for (DecodeAhead *track : tracks) {
+            copied += track->read(buffer.data(), (int)buffer.size());
+            decoding = decoding || !track->atEnd();
+        }
+        if (decoding && copied == 0) {
+            Sleep(1);
+        }
+    }
+    QueryPerformanceCounter(&ended);
+
+    Statistics total;
+    for (DecodeAhead *track : tracks) {
+        addStatistics(total, track->getStatistics());
+        delete track;
+    }
+    double seconds = (double)(ended.QuadPart - began.QuadPart) / frequency.QuadPart;
+    return QString("Decode benchmark, %1 | %2 s of audio per decoder | One decoder %3 times real time"
+                   " | %4 decoders together %5 times real time in %6 s, held back by full rings %7 times")
+            .arg(fileName.c_str())
+            .arg(total.audioMicros / 1000000.0 / decoders, 0, 'f', 1)
+            .arg(getSpeed(total), 0, 'f', 0)
+            .arg(decoders)
+            .arg(seconds > 0 ? total.audioMicros / 1000000.0 / seconds : 0, 0, 'f', 0)
+            .arg(seconds, 0, 'f', 2)
+            .arg((qint64)total.stalls);
+}
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	start
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:   October 19, 2026 - Keep the duration the decoder reports - agent
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	bool start(StreamDescriptor &descriptor)
+--                          descriptor - filled in with the PCM format the file decodes to
+--
+-- RETURNS:     True once the first audio is decoded, false if the file cannot be decoded
+--
+-- NOTES:
+--              Starts the decoder thread and waits up to DECODE_OPEN_TIMEOUT_MS for the format, which is only
+--              known from the first decoded buffer. Called on the track's prefetch thread.
+--
+-------------------------------------------------------------------------------------------------------------------*/
+bool DecodeAhead::start(StreamDescriptor &descriptor) {
+    thread = new QThread();
+    // Runs on the new thread, so the decoder and its signals belong to that thread's event loop
+    QObject::connect(thread, &QThread::started, [this]() {
+        decoder = new QAudioDecoder();
+        decoder->setSourceFilename(QString::fromLocal8Bit(fileName.c_str()));
+        QObject::connect(decoder, &QAudioDecoder::bufferReady, [this]() {
+            drain();
+        });
+        QObject::connect(decoder, &QAudioDecoder::finished, [this]() {
+            drain();
+            decoderDone = true;
+            finish(false);
+        });
+        QObject::connect(decoder, &QAudioDecoder::durationChanged, [this](qint64 duration) {
+            EnterCriticalSection(&lock);
+            durationMs = duration;
+            LeaveCriticalSection(&lock);
+        });
+        QObject::connect(decoder, static_cast<void (QAudioDecoder::*)(QAudioDecoder::Error)>(&QAudioDecoder::error),
+                         [this](QAudioDecoder::Error) {
+            qDebug() << "Cannot decode" << fileName.c_str() << decoder->errorString() << "\n";
+            finish(true);
+        });
+        progressAt = readCounter();
+        decoder->start();
+    });
+    thread->start();
+
+    DWORD started = GetTickCount();
+    bool known = false;
+    while (true) {
+        EnterCriticalSection(&lock);
+        bool done = formatKnown || finished;
+        known = formatKnown && !failed;
+        LeaveCriticalSection(&lock);
+        DWORD waited = GetTickCount() - started;
+        if (done || waited >= DECODE_OPEN_TIMEOUT_MS) {
+            break;
+        }
+        WaitForSingleObject(audioEvent, DECODE_OPEN_TIMEOUT_MS - waited);
+    }
+    if (known) {
+        descriptor = format;
+    }
+    return known;
+}
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	waitForAudio
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	bool waitForAudio(int bytes, DWORD timeoutMs)
+--                          bytes - how much PCM to wait for, at most the size of the ring
+--                          timeoutMs - longest to wait
+--
+-- RETURNS:     True if there is any audio to read
+--
+-- NOTES:
+--              Used to prefetch the start of a track before it is marked ready. Returns early if decoding ends.
+--
+-------------------------------------------------------------------------------------------------------------------*/
+bool DecodeAhead::waitForAudio(int bytes, DWORD timeoutMs) {
+    DWORD started = GetTickCount();
+    while (true) {
+        EnterCriticalSection(&lock);
+        bool done = finished || (formatKnown && ringUsed >= (bytes < ringSize ? bytes : ringSize));
+        bool any = ringUsed > 0;
+        LeaveCriticalSection(&lock);
+        DWORD waited = GetTickCount() - started;
+        if (done || waited >= timeoutMs) {
+            return any;
+        }
+        WaitForSingleObject(audioEvent, timeoutMs - waited);
+    }
+}
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	read
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	int read(char *buf, int bytes)
+--                       buf - destination
+--                       bytes - most bytes to read, a multiple of the frame size
+--
+-- RETURNS:     The number of bytes copied, which may be fewer than asked but never waits
+--
+-- NOTES:
+--              A short read before the end of the file is an underrun: the decoder fell behind. If the
+--              decoder was held back by a full ring and half of it is now free, the decoder thread is asked to
+--              carry on.
+--
+-------------------------------------------------------------------------------------------------------------------*/
+int DecodeAhead::read(char *buf, int bytes) {
+    EnterCriticalSection(&lock);
+    int count = bytes < ringUsed ? bytes : ringUsed;
+    int first = ringSize - ringStart < count ? ringSize - ringStart : count;
+    if (count > 0) {
+        memcpy(buf, ring + ringStart, first);
+        memcpy(buf + first, ring, count - first);
+        ringStart = (ringStart + count) % ringSize;
+        ringUsed -= count;
+    }
+    if (count < bytes && !finished) {
+        stats.underruns++;
+    }
+    bool wake = stalled && !drainPending && ringSize - ringUsed >= ringSize / 2;
+    if (wake) {
+        drainPending = true;
+    }
+    LeaveCriticalSection(&lock);
+
+    if (wake) {
+        QMetaObject::invokeMethod(decoder, [this]() {
+            drain();
+        }, Qt::QueuedConnection);
+    }
+    return count;
+}
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	atEnd
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	bool atEnd()
+--
+-- RETURNS:     True once decoding has ended and every decoded byte has been read
+--
+-------------------------------------------------------------------------------------------------------------------*/
+bool DecodeAhead::atEnd() {
+    EnterCriticalSection(&lock);
+    bool end = finished && ringUsed == 0;
+    LeaveCriticalSection(&lock);
+    return end;
+}
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	seek
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	void seek(uint64_t micros)
+--                          micros - position in the file to carry on from, in microseconds
+--
+-- RETURNS:     void
+--
+-- NOTES:
+--              Empties the ring and hands the seek to the decoder thread without waiting for it. Until the
+--              decoder thread picks it up, whatever the decoder gives is from before the seek and is dropped.
+--
+-------------------------------------------------------------------------------------------------------------------*/
+void DecodeAhead::seek(uint64_t micros) {
+    EnterCriticalSection(&lock);
+    if (failed || !formatKnown) {
+        LeaveCriticalSection(&lock);
+        return;
+    }
+    seekTarget = micros;
+    seekPending = true;
+    finished = false;
+    ringStart = 0;
+    ringUsed = 0;
+    LeaveCriticalSection(&lock);
+
+    QMetaObject::invokeMethod(decoder, [this]() {
+        applySeek();
+    }, Qt::QueuedConnection);
+}
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	getDurationMs
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	int64_t getDurationMs()
+--
+-- RETURNS:     The length of the file in milliseconds, or -1 if the decoder has not said yet
+--
+-------------------------------------------------------------------------------------------------------------------*/
+int64_t DecodeAhead::getDurationMs() {
+    EnterCriticalSection(&lock);
+    int64_t duration = durationMs;
+    LeaveCriticalSection(&lock);
+    return duration;
+}
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	getStatistics
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	Statistics getStatistics()
+--
+-- RETURNS:     A copy of the decoding counters
+--
+-------------------------------------------------------------------------------------------------------------------*/
+DecodeAhead::Statistics DecodeAhead::getStatistics() {
+    EnterCriticalSection(&lock);
+    Statistics copy = stats;
+    LeaveCriticalSection(&lock);
+    return copy;
+}
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	drain
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:   October 19, 2026 - Note how far the decoder has got - agent
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	void drain()
+--
+-- RETURNS:     void
+--
+-- NOTES:
+--              Runs on the decoder thread. Moves decoded buffers into the ring until the decoder has none left
+--              or the ring is full. A buffer that does not fit is kept for the next call. Notes how far the
+--              decoder has got, so a seek knows whether it has to start again.
+--
+-------------------------------------------------------------------------------------------------------------------*/
+void DecodeAhead::drain() {
+    EnterCriticalSection(&lock);
+    drainPending = false;
+    LeaveCriticalSection(&lock);
+    while (true) {
+        if (!hasPending) {
+            if (!decoder->bufferAvailable()) {
+                return;
+            }
+            pending = decoder->read();
+            hasPending = true;
+            if (pending.startTime() >= 0) {
+                decodedMicros = (uint64_t)pending.startTime() + (uint64_t)pending.duration();
+            }
+        }
+        if (!push(pending)) {
+            return;
+        }
+        hasPending = false;
+    }
+}
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	applySeek
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	void applySeek()
+--
+-- RETURNS:     void
+--
+-- NOTES:
+--              Runs on the decoder thread. A target the decoder has already passed means starting it again from
+--              the top of the file. A target past the end of a file that has been decoded to the end ends the
+--              track. Otherwise the decoder carries on and push() drops what comes before the target.
+--
+-------------------------------------------------------------------------------------------------------------------*/
+void DecodeAhead::applySeek() {
+    EnterCriticalSection(&lock);
+    if (!seekPending) {
+        LeaveCriticalSection(&lock);
+        return;
+    }
+    skipUntil = seekTarget;
+    seekPending = false;
+    ringStart = 0;
+    ringUsed = 0;
+    LeaveCriticalSection(&lock);
+
+    if (skipUntil < decodedMicros) {
+        hasPending = false;
+        decodedMicros = 0;
+        decoderDone = false;
+        decoder->stop();
+        progressAt = readCounter();
+        decoder->start();
+    } else if (decoderDone) {
+        finish(false);
+    } else {
+        drain();
+    }
+}
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	finish
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:   October 19, 2026 - Ignore the end of decoding while a seek is pending - agent
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	void finish(bool error)
+--                          error - true if decoding failed rather than reaching the end
+--
+-- RETURNS:     void
+--
+-- NOTES:
+--              Audio already in the ring can still be read. When the decoder ends while holding a buffer that
+--              did not fit, that buffer is dropped rather than holding up the end of the track.
+--
+-------------------------------------------------------------------------------------------------------------------*/
+void DecodeAhead::finish(bool error) {
+    EnterCriticalSection(&lock);
+    // The end of the decoding a seek is about to restart is not the end of the track
+    if (!seekPending || error) {
+        finished = true;
+    }
+    failed = failed || error;
+    LeaveCriticalSection(&lock);
+    SetEvent(audioEvent);
+}
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	convert
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	int convert(const QAudioBuffer &buffer)
+--                          buffer - decoded audio in the decoder's format
+--
+-- RETURNS:     Bytes of 16 bit signed samples left in converted
+--
+-- NOTES:
+--              Handles the sample formats decoders give out: 32 bit float, 16 and 32 bit signed and 8 bit
+--              unsigned. push() checks the format before anything is converted.
+--
+-------------------------------------------------------------------------------------------------------------------*/
+int DecodeAhead::convert(const QAudioBuffer &buffer) {
+    int samples = buffer.frameCount() * format.channels;
+    converted.resize(samples * 2);
+    int16_t *out = (int16_t *)converted.data();
+    if (sourceFormat.sampleType() == QAudioFormat::Float) {
+        const float *in = buffer.constData<float>();
+        for (int i = 0; i < samples; i++) {
+            float value = in[i] * 32768.0f;
+            out[i] = (int16_t)(value > 32767.0f ? 32767 : value < -32768.0f ? -32768 : value);
+        }
+    } else if (sourceFormat.sampleSize() == 32) {
+        const int32_t *in = buffer.constData<int32_t>();
+        for (int i = 0; i < samples; i++) {
+            out[i] = (int16_t)(in[i] >> 16);
+        }
+    } else if (sourceFormat.sampleSize() == 8) {
+        const uint8_t *in = buffer.constData<uint8_t>();
+        for (int i = 0; i < samples; i++) {
+            out[i] = (int16_t)((in[i] - 128) << 8);
+        }
+    } else {
+        memcpy(out, buffer.constData(), samples * 2);
+    }
+    return samples * 2;
+}
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	push
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:   October 19, 2026 - Drop the audio before a seek target - agent
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	bool push(const QAudioBuffer &buffer)
+--                          buffer - decoded audio
+--
+-- RETURNS:     False if the ring has no room for the buffer yet, true once the buffer is dealt with or dropped
+--
+-- NOTES:
+--              The first buffer sets the format and the size of the ring. A file whose format changes part
+--              way is ended there, since a track has one format. The time since the last buffer counts as
+--              decoding time unless the decoder was held back in between. After a seek, buffers that end
+--              before the target are dropped and the one holding it is cut, and neither counts for speed.
+--
+-------------------------------------------------------------------------------------------------------------------*/
+bool DecodeAhead::push(const QAudioBuffer &buffer) {
+    if (finished) {
+        return true;
+    }
+    QAudioFormat bufferFormat = buffer.format();
+    if (!formatKnown) {
+        QAudioFormat::SampleType type = bufferFormat.sampleType();
+        int size = bufferFormat.sampleSize();
+        if (bufferFormat.channelCount() <= 0 || bufferFormat.sampleRate() <= 0 ||
+                !((type == QAudioFormat::Float && size == 32) || (type == QAudioFormat::SignedInt && (size == 16 || size == 32)) ||
+                  (type == QAudioFormat::UnSignedInt && size == 8))) {
+            qDebug() << "Decoder gave" << fileName.c_str() << "in a sample format that cannot be streamed \n";
+            finish(true);
+            return true;
+        }
+        sourceFormat = bufferFormat;
+        EnterCriticalSection(&lock);
+        format.sampleRate = (uint32_t)bufferFormat.sampleRate();
+        format.channels = (uint8_t)bufferFormat.channelCount();
+        format.sampleSize = 16;
+        format.sampleType = SAMPLE_SIGNED;
+        format.frameSize = (uint16_t)(format.channels * 2);
+        ringSize = (int)((uint64_t)format.sampleRate * format.frameSize * DECODE_AHEAD_MS / 1000);
+        ring = new char[ringSize];
+        formatKnown = true;
+        LeaveCriticalSection(&lock);
+    } else if (!(bufferFormat == sourceFormat)) {
+        qDebug() << "Format of" << fileName.c_str() << "changed part way, ending the track there \n";
+        finish(false);
+        return true;
+    }
+
+    EnterCriticalSection(&lock);
+    bool stale = seekPending;
+    LeaveCriticalSection(&lock);
+    int skipFrames = 0;
+    if (!stale && skipUntil > 0 && buffer.startTime() >= 0) {
+        uint64_t startMicros = (uint64_t)buffer.startTime();
+        if (startMicros + (uint64_t)buffer.duration() <= skipUntil) {
+            stale = true;
+        } else if (startMicros < skipUntil) {
+            skipFrames = (int)((skipUntil - startMicros) * format.sampleRate / 1000000);
+            stale = skipFrames >= buffer.frameCount();
+        }
+    }
+    if (stale) {
+        progressAt = readCounter();
+        return true;
+    }
+
+    int needed = (buffer.frameCount() - skipFrames) * format.frameSize;
+    EnterCriticalSection(&lock);
+    bool fits = needed <= ringSize - ringUsed;
+    if (!fits && !stalled) {
+        stalled = true;
+        stats.stalls++;
+    }
+    LeaveCriticalSection(&lock);
+    if (needed > ringSize) {
+        return true;
+    }
+    if (!fits) {
+        return false;
+    }
+
+    int skipBytes = skipFrames * format.frameSize;
+    int bytes = convert(buffer) - skipBytes;
+    const char *audio = converted.data() + skipBytes;
+    uint64_t now = readCounter();
+    EnterCriticalSection(&lock);
+    if (seekPending) {
+        LeaveCriticalSection(&lock);
+        return true;
+    }
+    int end = (ringStart + ringUsed) % ringSize;
+    int first = ringSize - end < bytes ? ringSize - end : bytes;
+    memcpy(ring + end, audio, first);
+    memcpy(ring, audio + first, bytes - first);
+    ringUsed += bytes;
+    if (stalled || skipFrames > 0) {
+        // A buffer decoded while the decoder was held back, or cut at a seek, says nothing about speed
+        stalled = false;
+    } else {
+        stats.busyTicks += now - progressAt;
+        stats.audioMicros += (uint64_t)buffer.frameCount() * 1000000 / format.sampleRate;
+    }
+    LeaveCriticalSection(&lock);
+    progressAt = now;
+    skipUntil = 0;
+    SetEvent(audioEvent);
+    return true;
+}
@@ -0,0 +1,80 @@
+#pragma once
+#include <windows.h>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <QAudioDecoder>
+#include <QAudioBuffer>
+#include <QThread>
+#include <QCoreApplication>
+#include <QDebug>
+#include <QString>
+#include "streampacket.h"
+
+#define DECODE_AHEAD_MS 4000
+#define DECODE_OPEN_TIMEOUT_MS 5000
+#define DECODE_BENCH_MAX_DECODERS 64
+
+class DecodeAhead {
+public:
+    struct Statistics {
+        uint64_t audioMicros = 0;
+        uint64_t busyTicks = 0;
+        uint32_t stalls = 0;
+        uint32_t underruns = 0;
+    };
+
+    DecodeAhead(const std::string &fileName);
+    ~DecodeAhead();
+    DecodeAhead(const DecodeAhead&) = delete;
+    void operator=(const DecodeAhead&) = delete;
+
+    static bool handles(const std::string &fileName);
+    static double getSpeed(const Statistics &stats);
+    static void addStatistics(Statistics &total, const Statistics &stats);
+    static int runFromArguments(int argc, char *argv[]);
+    static QString benchmark(const std::string &fileName, int decoders);
+    bool start(StreamDescriptor &format);
+    bool waitForAudio(int bytes, DWORD timeoutMs);
+    int read(char *buf, int bytes);
+    bool atEnd();
+    void seek(uint64_t micros);
+    int64_t getDurationMs();
+    Statistics getStatistics();
+
+private:
+    std::string fileName;
+    QThread *thread = nullptr;
+    QAudioDecoder *decoder = nullptr;
+    CRITICAL_SECTION lock;
+    HANDLE audioEvent;
+    StreamDescriptor format = {};
+    QAudioFormat sourceFormat;
+    bool formatKnown = false;
+    bool finished = false;
+    bool failed = false;
+    bool stalled = false;
+    bool drainPending = false;
+    bool seekPending = false;
+    uint64_t seekTarget = 0;
+    uint64_t skipUntil = 0;
+    uint64_t decodedMicros = 0;
+    bool decoderDone = false;
+    int64_t durationMs = -1;
+    QAudioBuffer pending;
+    bool hasPending = false;
+    char *ring = nullptr;
+    int ringSize = 0;
+    int ringStart = 0;
+    int ringUsed = 0;
+    std::vector<char> converted;
+    uint64_t progressAt = 0;
+    Statistics stats;
+
+    void drain();
+    void applySeek();
+    void finish(bool error);
+    int convert(const QAudioBuffer &buffer);
+    bool push(const QAudioBuffer &buffer);
+};
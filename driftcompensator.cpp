@@ -0,0 +1,271 @@
+/*------------------------------------------------------------------------------------------------------------------
+-- SOURCE FILE: 	driftcompensator.cpp - Keeps the player's buffer at its target depth when the clocks drift.
+--
+--
+-- PROGRAM: 		Communication Audio Program
+--
+-- FUNCTIONS:
+--                  void setFormat(const StreamDescriptor &format, int targetBytes)
+--                  void reset()
+--                  void restart()
+--                  const char *process(const char *pcm, int &bytes, int fillBytes)
+--                  Statistics getStatistics() const
+--                  void track(int fillBytes, int frames)
+--
+-- DATE: 			October 19, 2026
+--
+-- REVISIONS:       October 19, 2026 - Restart the average after a break in the stream - agent
+--
+-- DESIGNER: 		agent
+--
+-- PROGRAMMER: 		agent
+--
+-- NOTES:
+--      The server paces the stream with its own clock and the listener's sound card plays it with another.
+--      The two never quite agree, so over hours the player's buffer slowly fills, adding delay, or empties
+--      and runs dry. The StreamReceiver hands packets over at the rate they arrive, so the difference shows
+--      up only in how full the player's buffer is.
+--
+--      Before each packet is written the buffer fill is averaged over about DRIFT_AVERAGE_MS, which hides the
+--      sawtooth of packets arriving and being played. The difference between the average and the target
+--      depth steers a small change in playback rate: a proportional part that reacts to the buffer being
+--      off target, and an integral part that learns the steady drift between the clocks so the buffer settles
+--      exactly on target. The rate change is limited to DRIFT_MAX_PPM, a pitch change of about 3.5 cents,
+--      well below what anyone can hear, and it only moves as fast as the averaged fill does.
+--
+--      The rate change is applied by resampling each packet with linear interpolation, carrying the
+--      fractional position and the last frame from one packet to the next so the joins are seamless. At
+--      these ratios the interpolation points barely move between packets, which keeps it free of artifacts.
+--      Now and then a packet comes out a frame shorter or longer. Only 16 bit audio is resampled; other
+--      formats pass through unchanged.
+--
+--------------------------------------------------------------------------------------------------------------------*/
+#include "driftcompensator.h"
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	setFormat
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	void setFormat(const StreamDescriptor &format, int targetBytes)
+--                          format - PCM format of the audio that will be played
+--                          targetBytes - how full the player's buffer should be kept
+--
+-- RETURNS:     void
+--
+-- NOTES:
+--              The drift learned so far is kept, since the clocks have not changed with the format.
+--
+-------------------------------------------------------------------------------------------------------------------*/
+void DriftCompensator::setFormat(const StreamDescriptor &newFormat, int targetBytes) {
+    format = newFormat;
+    channels = format.channels;
+    frameSize = channels * 2;
+    active = format.sampleSize == 16 && format.sampleType != SAMPLE_FLOAT && channels > 0 &&
+             channels <= DRIFT_MAX_CHANNELS && format.sampleRate > 0 && targetBytes >= frameSize;
+    if (!active) {
+        return;
+    }
+    signFlip = format.sampleType == SAMPLE_UNSIGNED ? 0x8000 : 0;
+    targetFrames = (double)targetBytes / frameSize;
+    averageKnown = false;
+    position = (uint64_t)1 << 32;
+    memset(last, 0, sizeof(last));
+}
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	reset
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	void reset()
+--
+-- RETURNS:     void
+--
+-- NOTES:
+--              Forgets the learned drift and the counters, for a new stream from what may be another server.
+--
+-------------------------------------------------------------------------------------------------------------------*/
+void DriftCompensator::reset() {
+    averageKnown = false;
+    integral = 0;
+    ppm = 0;
+    position = (uint64_t)1 << 32;
+    memset(last, 0, sizeof(last));
+    framesIn = 0;
+    framesOut = 0;
+}
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	restart
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	void restart()
+--
+-- RETURNS:     void
+--
+-- NOTES:
+--              Starts the buffer average again after the stream paused or jumped, when the buffer was emptied
+--              on purpose. The learned drift is kept, since the clocks have not changed.
+--
+-------------------------------------------------------------------------------------------------------------------*/
+void DriftCompensator::restart() {
+    averageKnown = false;
+    position = (uint64_t)1 << 32;
+    memset(last, 0, sizeof(last));
+}
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	process
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	const char *process(const char *pcm, int &bytes, int fillBytes)
+--                          pcm - audio about to be written to the player
+--                          bytes - size of the audio, set to the size of the audio returned
+--                          fillBytes - how many bytes the player's buffer holds right now
+--
+-- RETURNS:     The audio to write, which stays valid until the next call
+--
+-- NOTES:
+--              The output position steps through the input by 1 + ppm / 1000000 frames at a time, in 32.32
+--              fixed point. Position 0 is the last frame of the previous packet, so each output frame lies
+--              between two input frames that are both known.
+--
+-------------------------------------------------------------------------------------------------------------------*/
+const char *DriftCompensator::process(const char *pcm, int &bytes, int fillBytes) {
+    if (!active) {
+        return pcm;
+    }
+    int frames = bytes / frameSize;
+    if (frames == 0) {
+        return pcm;
+    }
+    track(fillBytes, frames);
+
+    uint64_t step = (uint64_t)((1.0 + ppm / 1000000.0) * 4294967296.0);
+    output.resize((frames + frames / 256 + 2) * frameSize);
+    int count = 0;
+    while ((position >> 32) < (uint64_t)frames) {
+        int index = (int)(position >> 32);
+        int64_t fraction = (int64_t)(uint32_t)position;
+        for (int c = 0; c < channels; c++) {
+            int32_t a = index == 0 ? last[c] : readSample(pcm + ((index - 1) * channels + c) * 2);
+            int32_t b = readSample(pcm + (index * channels + c) * 2);
+            writeSample(&output[(count * channels + c) * 2], (int16_t)(a + (((b - a) * fraction) >> 32)));
+        }
+        count++;
+        position += step;
+    }
+    position -= (uint64_t)frames << 32;
+    for (int c = 0; c < channels; c++) {
+        last[c] = readSample(pcm + ((frames - 1) * channels + c) * 2);
+    }
+
+    framesIn += frames;
+    framesOut += count;
+    bytes = count * frameSize;
+    return output.data();
+}
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	getStatistics
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	Statistics getStatistics() const
+--
+-- RETURNS:     The current rate change, the averaged and target buffer depth, and the frames added overall
+--
+-------------------------------------------------------------------------------------------------------------------*/
+DriftCompensator::Statistics DriftCompensator::getStatistics() const {
+    Statistics stats;
+    if (!active) {
+        return stats;
+    }
+    stats.ppm = ppm;
+    stats.averageFillMs = averageFill * 1000 / format.sampleRate;
+    stats.targetMs = targetFrames * 1000 / format.sampleRate;
+    stats.framesAdded = framesOut - framesIn;
+    return stats;
+}
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	track
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	void track(int fillBytes, int frames)
+--                          fillBytes - how many bytes the player's buffer holds right now
+--                          frames - frames in the packet about to be written
+--
+-- RETURNS:     void
+--
+-- NOTES:
+--              The error is how far the averaged fill is off target, as a fraction of the target. A buffer
+--              that is too full gives a positive rate change, so the audio is played slightly faster. The
+--              integral is limited to DRIFT_MAX_PPM so it cannot wind up while the buffer is out of reach,
+--              such as while the stream is stalled.
+--
+-------------------------------------------------------------------------------------------------------------------*/
+void DriftCompensator::track(int fillBytes, int frames) {
+    double fill = (double)fillBytes / frameSize;
+    double seconds = (double)frames / format.sampleRate;
+    if (!averageKnown) {
+        averageFill = fill;
+        averageKnown = true;
+    }
+    double weight = seconds * 1000 / DRIFT_AVERAGE_MS;
+    averageFill += (weight < 1 ? weight : 1) * (fill - averageFill);
+
+    double error = (averageFill - targetFrames) / targetFrames;
+    integral += error * seconds * DRIFT_INTEGRAL_PPM;
+    if (integral > DRIFT_MAX_PPM) {
+        integral = DRIFT_MAX_PPM;
+    } else if (integral < -DRIFT_MAX_PPM) {
+        integral = -DRIFT_MAX_PPM;
+    }
+    ppm = error * DRIFT_PROPORTIONAL_PPM + integral;
+    if (ppm > DRIFT_MAX_PPM) {
+        ppm = DRIFT_MAX_PPM;
+    } else if (ppm < -DRIFT_MAX_PPM) {
+        ppm = -DRIFT_MAX_PPM;
+    }
+}
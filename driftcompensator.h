@@ -0,0 +1,63 @@
+#pragma once
+#include <cstdint>
+#include <cstring>
+#include <vector>
+#include "streampacket.h"
+
+#define DRIFT_MAX_PPM 2000
+#define DRIFT_AVERAGE_MS 2000
+#define DRIFT_PROPORTIONAL_PPM 500
+#define DRIFT_INTEGRAL_PPM 20
+#define DRIFT_MAX_CHANNELS 8
+
+class DriftCompensator {
+public:
+    struct Statistics {
+        double ppm = 0;
+        double averageFillMs = 0;
+        double targetMs = 0;
+        int64_t framesAdded = 0;
+    };
+
+    DriftCompensator() = default;
+    DriftCompensator(const DriftCompensator&) = delete;
+    void operator=(const DriftCompensator&) = delete;
+
+    void setFormat(const StreamDescriptor &format, int targetBytes);
+    void reset();
+    void restart();
+    const char *process(const char *pcm, int &bytes, int fillBytes);
+
+    bool isActive() const {
+        return active;
+    }
+    Statistics getStatistics() const;
+
+private:
+    bool active = false;
+    StreamDescriptor format = {};
+    int channels = 0;
+    int frameSize = 0;
+    uint16_t signFlip = 0;
+    double targetFrames = 0;
+    double averageFill = 0;
+    bool averageKnown = false;
+    double integral = 0;
+    double ppm = 0;
+    uint64_t position = 0;
+    int16_t last[DRIFT_MAX_CHANNELS] = {};
+    std::vector<char> output;
+    int64_t framesIn = 0;
+    int64_t framesOut = 0;
+
+    int16_t readSample(const char *pcm) const {
+        uint16_t value;
+        memcpy(&value, pcm, 2);
+        return (int16_t)(value ^ signFlip);
+    }
+    void writeSample(char *pcm, int16_t sample) const {
+        uint16_t value = (uint16_t)sample ^ signFlip;
+        memcpy(pcm, &value, 2);
+    }
+    void track(int fillBytes, int frames);
+};
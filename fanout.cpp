@@ -0,0 +1,455 @@
+/*------------------------------------------------------------------------------------------------------------------
+-- SOURCE FILE: 	fanout.cpp - Sends a channel's datagrams to each unicast subscriber from a queue of its own.
+--
+--
+-- PROGRAM: 		Communication Audio Program
+--
+-- FUNCTIONS:
+--                  FanOut(DatagramIO *sender)
+--                  ~FanOut()
+--                  static int runFromArguments(int argc, char *argv[])
+--                  static QString benchmark(int subscribers, int seconds)
+--                  bool subscribe(const SOCKADDR_IN &listener, DWORD now)
+--                  void queue(const char *datagram, int bytes)
+--                  void flush(DWORD now)
+--                  QString describe() const
+--                  void expire(DWORD now)
+--                  bool send(Subscriber &subscriber)
+--
+-- DATE: 			October 19, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: 		agent
+--
+-- PROGRAMMER: 		agent
+--
+-- NOTES:
+--      A channel used to copy every datagram of a pass to every subscriber in the same pass, from one shared
+--      list. When the socket buffer filled part way through, the subscribers after that point lost the pass,
+--      and nothing said which of them was falling behind. Each subscriber now has a queue of its own.
+--
+--      The datagrams are kept once, in a history of the last SUBSCRIBER_QUEUE_MAX, and a subscriber's queue
+--      is how far through that history it has been sent. Queueing a datagram is one copy however many
+--      subscribers there are. A flush serves the subscribers in turn, each one's waiting datagrams in one
+--      segmented send. When the socket buffer fills, the pass stops: the subscribers not reached yet keep
+--      their queues, and the next pass starts with them. A subscriber that falls more than
+--      SUBSCRIBER_QUEUE_MAX datagrams behind loses its oldest, since they would reach it too late to play.
+--      Those drops and the socket's are counted for each subscriber, so one slow listener shows up on its
+--      own rather than as a loss spread over everyone.
+--
+--      --fanout-bench sends a stream to a thousand subscribers over loopback and reports how long each pass
+--      takes against the pacing thread's tick, which says whether one channel can carry that many.
+--
+--      A FanOut is used only from the ChannelManager pacing thread so it does no locking.
+--
+--------------------------------------------------------------------------------------------------------------------*/
+#include "fanout.h"
+#include <cstdlib>
+#include <cstring>
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	FanOut
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	FanOut(DatagramIO *sender)
+--                     sender - sends on the channel's unicast socket, still owned by the caller
+--
+-- RETURNS:     NA
+--
+-------------------------------------------------------------------------------------------------------------------*/
+FanOut::FanOut(DatagramIO *sender) : sender(sender) {
+    history = new Slot[SUBSCRIBER_QUEUE_MAX];
+}
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	~FanOut
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	~FanOut()
+--
+-- RETURNS:     NA
+--
+-------------------------------------------------------------------------------------------------------------------*/
+FanOut::~FanOut() {
+    delete[] history;
+}
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	runFromArguments
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	static int runFromArguments(int argc, char *argv[])
+--                          argc - number of command line arguments
+--                          argv - the command line arguments
+--
+-- RETURNS:     The process exit code
+--
+-- NOTES:
+--              The form is
+--                  --fanout-bench [subscribers] [seconds]
+--              The benchmark prints its result and returns.
+--
+-------------------------------------------------------------------------------------------------------------------*/
+int FanOut::runFromArguments(int argc, char *argv[]) {
+    if (strcmp(argv[1], "--fanout-bench") != 0) {
+        qDebug() << "Usage: --fanout-bench [subscribers] [seconds]\n";
+        return 1;
+    }
+    int subscribers = argc >= 3 ? atoi(argv[2]) : FANOUT_BENCH_SUBSCRIBERS;
+    int seconds = argc >= 4 ? atoi(argv[3]) : FANOUT_BENCH_SECONDS;
+    WSADATA wsaData;
+    if (WSAStartup(0x0202, &wsaData) != 0) {
+        qDebug() << "WSAStartup failed with error \n" << WSAGetLastError();
+        return 1;
+    }
+    qDebug() << benchmark(subscribers > 0 && subscribers <= MAX_SUBSCRIBERS ? subscribers : FANOUT_BENCH_SUBSCRIBERS,
+                          seconds > 0 ? seconds : FANOUT_BENCH_SECONDS);
+    WSACleanup();
+    return 0;
+}
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	benchmark
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	static QString benchmark(int subscribers, int seconds)
+--                                subscribers - listeners to fan out to
+--                                seconds - how long to stream for
+--
+-- RETURNS:     A one line summary of the run
+--
+-- NOTES:
+--              Streams FANOUT_BENCH_PACKETS_PER_SECOND packets of FANOUT_BENCH_PACKET_BYTES, about an ADPCM
+--              stream, and flushes every FANOUT_BENCH_TICK_MS as the pacing thread does. The subscribers are
+--              loopback ports nobody listens on, so the cost is the sending alone. Subscriptions are renewed
+--              every second.
+--
+-------------------------------------------------------------------------------------------------------------------*/
+QString FanOut::benchmark(int subscribers, int seconds) {
+    SOCKET sock = socket(AF_INET, SOCK_DGRAM, 0);
+    if (sock == INVALID_SOCKET) {
+        return QString("could not open a socket, error %1").arg(WSAGetLastError());
+    }
+    u_long nonBlocking = 1;
+    int sendBuffer = FANOUT_SEND_BUFFER;
+    ioctlsocket(sock, FIONBIO, &nonBlocking);
+    setsockopt(sock, SOL_SOCKET, SO_SNDBUF, (char *)&sendBuffer, sizeof(sendBuffer));
+    DatagramIO *io = new DatagramIO(sock);
+    io->enableSendOffload();
+    FanOut *fanOut = new FanOut(io);
+
+    SOCKADDR_IN listener = {};
+    listener.sin_family = AF_INET;
+    listener.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    char packet[FANOUT_BENCH_PACKET_BYTES];
+    memset(packet, 0x55, sizeof(packet));
+    LARGE_INTEGER frequency, begin, passStart, passEnd;
+    QueryPerformanceFrequency(&frequency);
+    QueryPerformanceCounter(&begin);
+    uint64_t queued = 0;
+    int passes = 0;
+    double totalMs = 0;
+    double worstMs = 0;
+    double renewedAt = -1000;
+    while (true) {
+        QueryPerformanceCounter(&passStart);
+        double elapsedMs = (double)(passStart.QuadPart - begin.QuadPart) * 1000 / frequency.QuadPart;
+        if (elapsedMs >= seconds * 1000.0) {
+            break;
+        }
+        if (elapsedMs - renewedAt >= 1000) {
+            for (int i = 0; i < subscribers; i++) {
+                listener.sin_port = htons((u_short)(FANOUT_BENCH_PORT + i));
+                fanOut->subscribe(listener, GetTickCount());
+            }
+            renewedAt = elapsedMs;
+        }
+        uint64_t due = (uint64_t)(elapsedMs * FANOUT_BENCH_PACKETS_PER_SECOND / 1000) + 1;
+        for (; queued < due; queued++) {
+            fanOut->queue(packet, sizeof(packet));
+        }
+        fanOut->flush(GetTickCount());
+        QueryPerformanceCounter(&passEnd);
+        double passMs = (double)(passEnd.QuadPart - passStart.QuadPart) * 1000 / frequency.QuadPart;
+        totalMs += passMs;
+        worstMs = passMs > worstMs ? passMs : worstMs;
+        passes++;
+        Sleep(FANOUT_BENCH_TICK_MS);
+    }
+
+    QString result = QString("Fan-out benchmark, %1 subscribers for %2 s at %3 packets per second: %4 of %5 datagrams"
+                             " sent in %6 send calls, a pass takes %7 ms on average and %8 ms at worst against a"
+                             " %9 ms tick | %10")
+            .arg(subscribers)
+            .arg(seconds)
+            .arg(FANOUT_BENCH_PACKETS_PER_SECOND)
+            .arg((qint64)fanOut->getStatistics().sent)
+            .arg((qint64)(queued * subscribers))
+            .arg((qint64)io->getStatistics().sendCalls)
+            .arg(passes > 0 ? totalMs / passes : 0, 0, 'f', 2)
+            .arg(worstMs, 0, 'f', 2)
+            .arg(FANOUT_BENCH_TICK_MS)
+            .arg(fanOut->describe());
+    delete fanOut;
+    delete io;
+    closesocket(sock);
+    return result;
+}
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	subscribe
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	bool subscribe(const SOCKADDR_IN &listener, DWORD now)
+--                             listener - address the stream is sent to
+--                             now - current tick in milliseconds
+--
+-- RETURNS:     Returns true if the listener is new
+--
+-- NOTES:
+--              Renews the subscription of a known listener, or adds a new one while there is room. A new
+--              subscriber's queue starts empty, with the next datagram queued.
+--
+-------------------------------------------------------------------------------------------------------------------*/
+bool FanOut::subscribe(const SOCKADDR_IN &listener, DWORD now) {
+    for (Subscriber &subscriber : subscribers) {
+        if (subscriber.address.sin_addr.s_addr == listener.sin_addr.s_addr &&
+                subscriber.address.sin_port == listener.sin_port) {
+            subscriber.lastSeen = now;
+            return false;
+        }
+    }
+    if (subscribers.size() >= MAX_SUBSCRIBERS) {
+        stats.refused++;
+        return false;
+    }
+    Subscriber subscriber = {};
+    subscriber.address = listener;
+    subscriber.lastSeen = now;
+    subscriber.next = written;
+    subscribers.push_back(subscriber);
+    stats.subscriptions++;
+    return true;
+}
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	queue
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	void queue(const char *datagram, int bytes)
+--                         datagram - packet every subscriber should get
+--                         bytes - size of the packet
+--
+-- RETURNS:     void
+--
+-- NOTES:
+--              Adds the datagram to the end of every subscriber's queue. It goes out on the next flush().
+--
+-------------------------------------------------------------------------------------------------------------------*/
+void FanOut::queue(const char *datagram, int bytes) {
+    if (subscribers.empty() || bytes <= 0 || bytes > DATA_BUFSIZE) {
+        return;
+    }
+    Slot &slot = history[written % SUBSCRIBER_QUEUE_MAX];
+    memcpy(slot.datagram, datagram, bytes);
+    slot.bytes = bytes;
+    written++;
+}
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	flush
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	void flush(DWORD now)
+--                         now - current tick in milliseconds
+--
+-- RETURNS:     void
+--
+-- NOTES:
+--              Drops subscribers that stopped renewing, then sends each remaining one its queue. The order
+--              rotates every pass. A pass cut short by a full socket buffer carries on next time from the
+--              first subscriber it did not reach.
+--
+-------------------------------------------------------------------------------------------------------------------*/
+void FanOut::flush(DWORD now) {
+    expire(now);
+    size_t count = subscribers.size();
+    if (count == 0) {
+        return;
+    }
+    sender->flush();
+    for (size_t k = 0; k < count; k++) {
+        size_t index = (start + k) % count;
+        if (!send(subscribers[index])) {
+            start = (index + 1) % count;
+            stats.shortPasses++;
+            return;
+        }
+    }
+    start = (start + 1) % count;
+}
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	describe
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	QString describe() const
+--
+-- RETURNS:     The subscribers and what was sent to and dropped for them, as text
+--
+-------------------------------------------------------------------------------------------------------------------*/
+QString FanOut::describe() const {
+    DWORD worst = 0;
+    int behind = 0;
+    for (const Subscriber &subscriber : subscribers) {
+        DWORD dropped = subscriber.queueDrops + subscriber.socketDrops;
+        worst = dropped > worst ? dropped : worst;
+        behind += dropped > 0 ? 1 : 0;
+    }
+    return QString("%1 subscribers (%2 refused, %3 timed out), %4 packets fanned out, %5 dropped from full queues,"
+                   " %6 dropped by the socket, %7 passes cut short, %8 subscribers losing packets, at most %9")
+            .arg((qint64)subscribers.size())
+            .arg((qint64)stats.refused)
+            .arg((qint64)stats.expired)
+            .arg((qint64)stats.sent)
+            .arg((qint64)stats.queueDrops)
+            .arg((qint64)stats.socketDrops)
+            .arg((qint64)stats.shortPasses)
+            .arg(behind)
+            .arg((qint64)worst);
+}
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	expire
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	void expire(DWORD now)
+--                          now - current tick in milliseconds
+--
+-- RETURNS:     void
+--
+-------------------------------------------------------------------------------------------------------------------*/
+void FanOut::expire(DWORD now) {
+    for (size_t i = 0; i < subscribers.size();) {
+        if (now - subscribers[i].lastSeen > SUBSCRIBER_TIMEOUT_MS) {
+            subscribers[i] = subscribers.back();
+            subscribers.pop_back();
+            stats.expired++;
+        } else {
+            i++;
+        }
+    }
+}
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	send
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	bool send(Subscriber &subscriber)
+--                        subscriber - listener to send the queue of
+--
+-- RETURNS:     False if the socket buffer was full and some of the queue was dropped
+--
+-- NOTES:
+--              A queue longer than SUBSCRIBER_QUEUE_MAX first loses its oldest datagrams, which are no longer
+--              in the history anyway.
+--
+-------------------------------------------------------------------------------------------------------------------*/
+bool FanOut::send(Subscriber &subscriber) {
+    uint32_t waiting = written - subscriber.next;
+    if (waiting > SUBSCRIBER_QUEUE_MAX) {
+        subscriber.queueDrops += waiting - SUBSCRIBER_QUEUE_MAX;
+        stats.queueDrops += waiting - SUBSCRIBER_QUEUE_MAX;
+        subscriber.next = written - SUBSCRIBER_QUEUE_MAX;
+        waiting = SUBSCRIBER_QUEUE_MAX;
+    }
+    if (waiting == 0) {
+        return true;
+    }
+    DWORD droppedBefore = sender->getStatistics().sendsDropped;
+    for (; subscriber.next != written; subscriber.next++) {
+        const Slot &slot = history[subscriber.next % SUBSCRIBER_QUEUE_MAX];
+        sender->queue(slot.datagram, slot.bytes, subscriber.address);
+    }
+    sender->flush();
+    DWORD dropped = sender->getStatistics().sendsDropped - droppedBefore;
+    if (dropped > waiting) {
+        dropped = waiting;
+    }
+    subscriber.sent += waiting - dropped;
+    subscriber.socketDrops += dropped;
+    stats.sent += waiting - dropped;
+    stats.socketDrops += dropped;
+    return dropped == 0;
+}
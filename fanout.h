@@ -0,0 +1,76 @@
+#pragma once
+#include <winsock2.h>
+#include <windows.h>
+#include <cstdint>
+#include <vector>
+#include <QDebug>
+#include <QString>
+#include "streampacket.h"
+#include "datagramio.h"
+
+#define MAX_SUBSCRIBERS 1024
+#define SUBSCRIBER_TIMEOUT_MS 6000
+#define SUBSCRIBER_QUEUE_MAX 32
+#define FANOUT_SEND_BUFFER (4 * 1024 * 1024)
+#define FANOUT_BENCH_SUBSCRIBERS 1000
+#define FANOUT_BENCH_SECONDS 10
+#define FANOUT_BENCH_TICK_MS 10
+#define FANOUT_BENCH_PACKET_BYTES 1012
+#define FANOUT_BENCH_PACKETS_PER_SECOND 44
+#define FANOUT_BENCH_PORT 40000
+
+class FanOut {
+public:
+    struct Statistics {
+        DWORD subscriptions = 0;
+        DWORD refused = 0;
+        DWORD expired = 0;
+        DWORD sent = 0;
+        DWORD queueDrops = 0;
+        DWORD socketDrops = 0;
+        DWORD shortPasses = 0;
+    };
+
+    FanOut(DatagramIO *sender);
+    ~FanOut();
+    FanOut(const FanOut&) = delete;
+    void operator=(const FanOut&) = delete;
+
+    static int runFromArguments(int argc, char *argv[]);
+    static QString benchmark(int subscribers, int seconds);
+    bool subscribe(const SOCKADDR_IN &listener, DWORD now);
+    void queue(const char *datagram, int bytes);
+    void flush(DWORD now);
+    QString describe() const;
+
+    int getSubscriberCount() const {
+        return (int)subscribers.size();
+    }
+    const Statistics &getStatistics() const {
+        return stats;
+    }
+
+private:
+    struct Subscriber {
+        SOCKADDR_IN address;
+        DWORD lastSeen;
+        uint32_t next;
+        DWORD sent;
+        DWORD queueDrops;
+        DWORD socketDrops;
+    };
+    struct Slot {
+        int bytes;
+        char datagram[DATA_BUFSIZE];
+    };
+
+    DatagramIO *sender;
+    std::vector<Subscriber> subscribers;
+    Slot *history;
+    uint32_t written = 0;
+    size_t start = 0;
+    Statistics stats;
+
+    void expire(DWORD now);
+    bool send(Subscriber &subscriber);
+};
@@ -0,0 +1,189 @@
+/*------------------------------------------------------------------------------------------------------------------
+-- SOURCE FILE: 	fec.cpp - Forward error correction for the multicast stream.
+--
+--
+-- PROGRAM: 		Communication Audio Program
+--
+-- FUNCTIONS:
+--                  FecEncoder(int groupSize)
+--                  void xorInto(char *dst, const char *src, size_t bytes)
+--                  bool addPacket(uint32_t sequence, const char *payload, int length)
+--                  int buildParityPacket(uint32_t timestamp, char *buf)
+--
+-- DATE: 			October 19, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: 		agent
+--
+-- PROGRAMMER: 		agent
+--
+-- NOTES:
+--      Multicast has no retransmission, so the server can add an XOR parity packet after every groupSize audio
+--      packets. A receiver that is missing exactly one packet of a group rebuilds it by XORing the parity with the
+--      packets it did receive (see StreamReceiver). Groups always start on a sequence number that is a multiple of
+--      the group size so the receiver can work out group boundaries from any packet.
+--
+--      The XOR kernel works 16 bytes at a time with SSE2 when the compiler targets it, and 8 bytes at a time
+--      otherwise, so a single core can encode many streams.
+--
+--------------------------------------------------------------------------------------------------------------------*/
+#include "fec.h"
+#include <cstring>
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define FEC_USE_SSE2
+#endif
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	FecEncoder
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	FecEncoder(int groupSize)
+--                         groupSize - number of audio packets protected by one parity packet
+--
+-- RETURNS:     NA
+--
+-- NOTES:
+--              The group size is clamped to [2, MAX_FEC_GROUP_SIZE].
+--
+-------------------------------------------------------------------------------------------------------------------*/
+FecEncoder::FecEncoder(int groupSize) {
+    if (groupSize < 2) {
+        groupSize = 2;
+    } else if (groupSize > MAX_FEC_GROUP_SIZE) {
+        groupSize = MAX_FEC_GROUP_SIZE;
+    }
+    this->groupSize = groupSize;
+    memset(parity, 0, sizeof(parity));
+}
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	xorInto
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	void xorInto(char *dst, const char *src, size_t bytes)
+--                           dst - buffer that is XORed in place
+--                           src - buffer XORed into dst
+--                           bytes - number of bytes to process
+--
+-- RETURNS:     void
+--
+-- NOTES:
+--              Shared by the encoder and the receiver's recovery path.
+--
+-------------------------------------------------------------------------------------------------------------------*/
+void FecEncoder::xorInto(char *dst, const char *src, size_t bytes) {
+    size_t i = 0;
+#ifdef FEC_USE_SSE2
+    for (; i + 16 <= bytes; i += 16) {
+        __m128i a = _mm_loadu_si128((const __m128i *)(dst + i));
+        __m128i b = _mm_loadu_si128((const __m128i *)(src + i));
+        _mm_storeu_si128((__m128i *)(dst + i), _mm_xor_si128(a, b));
+    }
+#endif
+    for (; i + 8 <= bytes; i += 8) {
+        uint64_t a, b;
+        memcpy(&a, dst + i, 8);
+        memcpy(&b, src + i, 8);
+        a ^= b;
+        memcpy(dst + i, &a, 8);
+    }
+    for (; i < bytes; i++) {
+        dst[i] ^= src[i];
+    }
+}
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	addPacket
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	bool addPacket(uint32_t sequence, const char *payload, int length)
+--                             sequence - sequence number of the audio packet that was sent
+--                             payload - audio payload of the packet
+--                             length - number of payload bytes
+--
+-- RETURNS:     Returns true when the packet completes a group and a parity packet is ready
+--
+-- NOTES:
+--              Folds the payload into the running parity. A packet whose sequence number starts a new group
+--              discards any partially built group.
+--
+-------------------------------------------------------------------------------------------------------------------*/
+bool FecEncoder::addPacket(uint32_t sequence, const char *payload, int length) {
+    uint32_t start = sequence - (sequence % groupSize);
+    if (packetsInGroup == 0 || start != groupStart) {
+        groupStart = start;
+        packetsInGroup = 0;
+        lengthParity = 0;
+        longestPayload = 0;
+        memset(parity, 0, sizeof(parity));
+    }
+    if (length > STREAM_PAYLOAD_SIZE) {
+        length = STREAM_PAYLOAD_SIZE;
+    }
+    xorInto(parity, payload, length);
+    lengthParity ^= (uint16_t)length;
+    if (length > longestPayload) {
+        longestPayload = length;
+    }
+    packetsInGroup++;
+    return sequence == groupStart + groupSize - 1;
+}
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	buildParityPacket
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	int buildParityPacket(uint32_t timestamp, char *buf)
+--                                    timestamp - send time in milliseconds
+--                                    buf - destination, must hold DATA_BUFSIZE bytes
+--
+-- RETURNS:     Returns the size of the parity datagram
+--
+-- NOTES:
+--              The parity packet's sequence number is the first sequence number of the group it protects.
+--              The XOR of the payload lengths travels in the header so a rebuilt packet gets its real length.
+--
+-------------------------------------------------------------------------------------------------------------------*/
+int FecEncoder::buildParityPacket(uint32_t timestamp, char *buf) {
+    StreamPacketHeader header = {};
+    header.type = PACKET_PARITY;
+    header.groupSize = (uint8_t)groupSize;
+    header.sequence = groupStart;
+    header.timestamp = timestamp;
+    header.length = (uint16_t)longestPayload;
+    header.parityLength = lengthParity;
+    StreamPacket::writeHeader(header, buf);
+    memcpy(buf + STREAM_HEADER_SIZE, parity, longestPayload);
+    packetsInGroup = 0;
+    return STREAM_HEADER_SIZE + longestPayload;
+}
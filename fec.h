@@ -0,0 +1,27 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include "streampacket.h"
+
+#define DEFAULT_FEC_GROUP_SIZE 4
+#define MAX_FEC_GROUP_SIZE 16
+
+class FecEncoder {
+private:
+    int groupSize;
+    int packetsInGroup = 0;
+    uint32_t groupStart = 0;
+    uint16_t lengthParity = 0;
+    int longestPayload = 0;
+    char parity[STREAM_PAYLOAD_SIZE];
+
+public:
+    FecEncoder(int groupSize);
+    static void xorInto(char *dst, const char *src, size_t bytes);
+
+    int getGroupSize() const {
+        return groupSize;
+    }
+    bool addPacket(uint32_t sequence, const char *payload, int length);
+    int buildParityPacket(uint32_t timestamp, char *buf);
+};
@@ -9,10 +9,11 @@
 --                  std::string readFile(int bytes)
 --                  int readFile(int bytes, char * buf)
 --                  bool saveDataToFile(std::string filePath, char *buffer, int numBytes)
+--                  void seek(int position)
 --
 -- DATE: 			March 20, 2020
 --
--- REVISIONS:
+-- REVISIONS:       October 19, 2026 - Add seek so reads can start after a file header - agent
 --
 -- DESIGNER: 		Victor Phan
 --
@@ -159,3 +160,27 @@ int FileHandler::readFile(int bytes, char * buf) {
     fclose(file);
     return bytesRead;
 }
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	seek
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	void seek(int position)
+--                  position - byte offset the next read starts from
+--
+-- RETURNS:     void
+--
+-- NOTES:
+--              Moves the read pointer, e.g. past the header of a WAV file to the first sample.
+--
+-------------------------------------------------------------------------------------------------------------------*/
+void FileHandler::seek(int position) {
+    readPointer = position;
+}
@@ -15,5 +15,6 @@ public:
     FileHandler(const std::string& name) : fileName(name), readPointer(0) {}
     std::string readFile(int bytes);
     int readFile(int bytes, char * buf);
+    void seek(int position);
 };
 
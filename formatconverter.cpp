@@ -0,0 +1,445 @@
+/*------------------------------------------------------------------------------------------------------------------
+-- SOURCE FILE: 	formatconverter.cpp - Converts a stream of PCM audio from one format to another.
+--
+--
+-- PROGRAM: 		Communication Audio Program
+--
+-- FUNCTIONS:
+--                  double getSamplesPerSecond(const Statistics &stats)
+--                  StreamDescriptor pcm16(uint32_t sampleRate, uint8_t channels)
+--                  static int runFromArguments(int argc, char *argv[])
+--                  static QString benchmark(int seconds)
+--                  bool setFormats(const StreamDescriptor &input, const StreamDescriptor &output)
+--                  void reset()
+--                  const char *convert(const char *pcm, int &bytes)
+--                  int toInputBytes(int outputBytes) const
+--
+-- DATE: 			October 19, 2026
+--
+-- REVISIONS:       October 19, 2026 - Add --convert-bench, kernel and conversion speed per core - agent
+--
+-- DESIGNER: 		agent
+--
+-- PROGRAMMER: 		agent
+--
+-- NOTES:
+--      Sits wherever audio in one format has to become another: on the server between a track and the
+--      packetizer, so every track of a channel goes out in the channel's format, and on the listener just
+--      before the player, when the sound card cannot play the stream's format. Each chunk goes through the
+--      SampleConvert kernels: to floats, remixed to the output's channels, resampled to the output's rate,
+--      and back to the output's sample format. Steps that are not needed are skipped, and when the two
+--      formats match nothing is done at all.
+--
+--      The resampler keeps a little history, so the audio must be one continuous stream; reset() starts a
+--      new one. The time spent is counted against the samples produced, so the statistics show how many
+--      samples a second one core can convert.
+--
+--      --convert-bench times the SampleConvert kernels on their own, next to plain loops doing the same work,
+--      and whole conversions between the formats the program meets.
+--
+--------------------------------------------------------------------------------------------------------------------*/
+#include "formatconverter.h"
+#include <cmath>
+#include <cstdlib>
+
+static uint64_t readCounter() {
+    LARGE_INTEGER counter;
+    QueryPerformanceCounter(&counter);
+    return (uint64_t)counter.QuadPart;
+}
+
+static double toMillionsPerSecond(uint64_t samples, uint64_t ticks) {
+    LARGE_INTEGER frequency;
+    QueryPerformanceFrequency(&frequency);
+    return ticks > 0 ? samples * (double)frequency.QuadPart / ticks / 1000000 : 0;
+}
+
+static void plainS16ToFloat(const char *in, float *out, int samples) {
+    for (int i = 0; i < samples; i++) {
+        int16_t value;
+        memcpy(&value, in + i * 2, 2);
+        out[i] = value * (1.0f / 32768);
+    }
+}
+
+static void plainFloatToS16(const float *in, char *out, int samples) {
+    for (int i = 0; i < samples; i++) {
+        float scaled = in[i] * 32768;
+        int16_t value = (int16_t)(scaled >= 32767 ? 32767 : scaled <= -32768 ? -32768 : (int)scaled);
+        memcpy(out + i * 2, &value, 2);
+    }
+}
+
+static void plainDownmix(const float *in, float *out, int frames) {
+    for (int i = 0; i < frames; i++) {
+        out[i] = (in[i * 2] + in[i * 2 + 1]) * 0.5f;
+    }
+}
+
+static float plainDot(const float *a, const float *b, int count) {
+    float sum = 0;
+    for (int i = 0; i < count; i++) {
+        sum += a[i] * b[i];
+    }
+    return sum;
+}
+
+static bool samePcm(const StreamDescriptor &a, const StreamDescriptor &b) {
+    return a.sampleRate == b.sampleRate && a.channels == b.channels && a.sampleSize == b.sampleSize &&
+           a.sampleType == b.sampleType;
+}
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	getSamplesPerSecond
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	static double getSamplesPerSecond(const Statistics &stats)
+--                          stats - counters kept by a FormatConverter
+--
+-- RETURNS:     Samples converted per second of busy time on one core, or 0 before anything was converted
+--
+-------------------------------------------------------------------------------------------------------------------*/
+double FormatConverter::getSamplesPerSecond(const Statistics &stats) {
+    LARGE_INTEGER frequency;
+    QueryPerformanceFrequency(&frequency);
+    if (stats.busyTicks == 0 || frequency.QuadPart == 0) {
+        return 0;
+    }
+    return stats.samples * (double)frequency.QuadPart / stats.busyTicks;
+}
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	pcm16
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	static StreamDescriptor pcm16(uint32_t sampleRate, uint8_t channels)
+--                          sampleRate - samples per second
+--                          channels - channels in each frame
+--
+-- RETURNS:     A descriptor for 16 bit signed PCM, the format the codecs and the concealer work on
+--
+-------------------------------------------------------------------------------------------------------------------*/
+StreamDescriptor FormatConverter::pcm16(uint32_t sampleRate, uint8_t channels) {
+    StreamDescriptor format = {};
+    format.sampleRate = sampleRate;
+    format.channels = channels;
+    format.sampleSize = 16;
+    format.sampleType = SAMPLE_SIGNED;
+    format.codec = CODEC_PCM;
+    format.frameSize = (uint16_t)(channels * 2);
+    return format;
+}
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	runFromArguments
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	static int runFromArguments(int argc, char *argv[])
+--                          argc - number of command line arguments
+--                          argv - the command line arguments
+--
+-- RETURNS:     The process exit code
+--
+-- NOTES:
+--              The form is
+--                  --convert-bench [seconds of audio]
+--              The benchmark prints its result and returns.
+--
+-------------------------------------------------------------------------------------------------------------------*/
+int FormatConverter::runFromArguments(int argc, char *argv[]) {
+    if (strcmp(argv[1], "--convert-bench") != 0) {
+        qDebug() << "Usage: --convert-bench [seconds of audio]\n";
+        return 1;
+    }
+    int seconds = argc >= 3 ? atoi(argv[2]) : CONVERT_BENCH_SECONDS;
+    qDebug() << benchmark(seconds > 0 ? seconds : CONVERT_BENCH_SECONDS);
+    return 0;
+}
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	benchmark
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	static QString benchmark(int seconds)
+--                                seconds - length of the 48 kHz stereo audio put through each kernel
+--
+-- RETURNS:     A summary of every kernel and conversion, in millions of samples a second on one core
+--
+-- NOTES:
+--              The kernels work CONVERT_BENCH_CHUNK_MS at a time, as the converter does, so the data stays in
+--              the cache and the time is the kernels' own. Each is followed by a plain loop doing the same
+--              work; the compiler may vectorize those too, so the gap is what the hand written kernels add on
+--              top of it. The dot product runs over rows of RESAMPLE_BASE_TAPS, as the resampler's do. The
+--              conversions are timed by the converter's own statistics, counted in output samples.
+--
+-------------------------------------------------------------------------------------------------------------------*/
+QString FormatConverter::benchmark(int seconds) {
+    const int frames = 48000 * CONVERT_BENCH_CHUNK_MS / 1000;
+    const int samples = frames * 2;
+    const int chunks = seconds * 1000 / CONVERT_BENCH_CHUNK_MS;
+    const uint64_t total = (uint64_t)chunks * samples;
+    std::vector<char> pcm((size_t)samples * 2);
+    std::vector<float> floats(samples);
+    std::vector<float> mono(frames);
+    std::vector<float> coefficients(RESAMPLE_BASE_TAPS, 1.0f / RESAMPLE_BASE_TAPS);
+    for (int i = 0; i < samples; i++) {
+        int16_t value = (int16_t)(12000 * sin(i * 0.05));
+        memcpy(&pcm[i * 2], &value, 2);
+    }
+    volatile float sink = 0;
+    uint64_t ticks[8] = {};
+
+    for (int chunk = 0; chunk < chunks; chunk++) {
+        uint64_t began = readCounter();
+        SampleConvert::s16ToFloat(pcm.data(), floats.data(), samples, 0);
+        uint64_t converted = readCounter();
+        SampleConvert::floatToS16(floats.data(), pcm.data(), samples, 0);
+        uint64_t packed = readCounter();
+        SampleConvert::downmixStereo(floats.data(), mono.data(), frames);
+        uint64_t mixed = readCounter();
+        for (int i = 0; i + RESAMPLE_BASE_TAPS <= samples; i += RESAMPLE_BASE_TAPS) {
+            sink = sink + SampleConvert::dot(floats.data() + i, coefficients.data(), RESAMPLE_BASE_TAPS);
+        }
+        uint64_t dotted = readCounter();
+        ticks[0] += converted - began;
+        ticks[1] += packed - converted;
+        ticks[2] += mixed - packed;
+        ticks[3] += dotted - mixed;
+
+        began = readCounter();
+        plainS16ToFloat(pcm.data(), floats.data(), samples);
+        converted = readCounter();
+        plainFloatToS16(floats.data(), pcm.data(), samples);
+        packed = readCounter();
+        plainDownmix(floats.data(), mono.data(), frames);
+        mixed = readCounter();
+        for (int i = 0; i + RESAMPLE_BASE_TAPS <= samples; i += RESAMPLE_BASE_TAPS) {
+            sink = sink + plainDot(floats.data() + i, coefficients.data(), RESAMPLE_BASE_TAPS);
+        }
+        dotted = readCounter();
+        ticks[4] += converted - began;
+        ticks[5] += packed - converted;
+        ticks[6] += mixed - packed;
+        ticks[7] += dotted - mixed;
+    }
+
+    QString summary = QString("Conversion benchmark, %1 kernels, %2 s of 48 kHz stereo, millions of samples a second"
+                              " per core, kernel against plain loop")
+            .arg(SampleConvert::getKernelName())
+            .arg(seconds);
+    const char *names[4] = { "16 bit to float", "float to 16 bit", "stereo to mono", "dot product" };
+    for (int i = 0; i < 4; i++) {
+        uint64_t counted = i == 2 ? total / 2 : total;
+        summary.append(QString(" | %1: %2 against %3")
+                       .arg(names[i])
+                       .arg(toMillionsPerSecond(counted, ticks[i]), 0, 'f', 0)
+                       .arg(toMillionsPerSecond(counted, ticks[i + 4]), 0, 'f', 0));
+    }
+
+    struct Conversion {
+        const char *name;
+        StreamDescriptor input;
+        StreamDescriptor output;
+    };
+    StreamDescriptor floatStereo = pcm16(48000, 2);
+    floatStereo.sampleSize = 32;
+    floatStereo.sampleType = SAMPLE_FLOAT;
+    floatStereo.frameSize = 8;
+    StreamDescriptor player = pcm16(8000, 2);
+    player.sampleType = SAMPLE_UNSIGNED;
+    Conversion conversions[3] = {
+        { "44.1 kHz to 48 kHz stereo", pcm16(44100, 2), pcm16(48000, 2) },
+        { "48 kHz float stereo to 8 kHz mono", floatStereo, pcm16(8000, 1) },
+        { "8 kHz unsigned stereo to 44.1 kHz", player, pcm16(44100, 2) }
+    };
+    for (const Conversion &conversion : conversions) {
+        FormatConverter converter;
+        converter.setFormats(conversion.input, conversion.output);
+        int bytes = (int)(conversion.input.sampleRate * CONVERT_BENCH_CHUNK_MS / 1000) * conversion.input.frameSize;
+        std::vector<char> input(bytes);
+        for (int i = 0; i + 3 < bytes; i += 4) {
+            if (conversion.input.sampleType == SAMPLE_FLOAT) {
+                float value = (float)(0.4 * sin(i * 0.0125));
+                memcpy(&input[i], &value, 4);
+            } else {
+                int16_t value = (int16_t)(12000 * sin(i * 0.0125));
+                memcpy(&input[i], &value, 2);
+                memcpy(&input[i + 2], &value, 2);
+            }
+        }
+        for (int chunk = 0; chunk < chunks; chunk++) {
+            int length = bytes;
+            converter.convert(input.data(), length);
+        }
+        summary.append(QString(" | %1: %2")
+                       .arg(conversion.name)
+                       .arg(getSamplesPerSecond(converter.getStatistics()) / 1000000, 0, 'f', 0));
+    }
+    return summary;
+}
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	setFormats
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	bool setFormats(const StreamDescriptor &input, const StreamDescriptor &output)
+--                              input - format of the audio given to convert()
+--                              output - format wanted
+--
+-- RETURNS:     True if the audio needs converting
+--
+-- NOTES:
+--              Setting the same formats again keeps the resampler's history, so it can be called on every
+--              track or format announcement. If either format cannot be handled the audio passes through.
+--
+-------------------------------------------------------------------------------------------------------------------*/
+bool FormatConverter::setFormats(const StreamDescriptor &newInput, const StreamDescriptor &newOutput) {
+    if (active && samePcm(input, newInput) && samePcm(output, newOutput)) {
+        return true;
+    }
+    input = newInput;
+    output = newOutput;
+    active = !samePcm(input, output) && SampleConvert::handles(input) && SampleConvert::handles(output);
+    if (active) {
+        resampler.setRates((int)input.sampleRate, (int)output.sampleRate, output.channels);
+    }
+    return active;
+}
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	reset
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	void reset()
+--
+-- RETURNS:     void
+--
+-- NOTES:
+--              Forgets the resampler's history, for audio that does not carry on from what came before.
+--
+-------------------------------------------------------------------------------------------------------------------*/
+void FormatConverter::reset() {
+    if (resampler.isActive()) {
+        resampler.reset();
+    }
+}
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	convert
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	const char *convert(const char *pcm, int &bytes)
+--                          pcm - audio in the input format
+--                          bytes - size of the audio, set to the size of the audio returned
+--
+-- RETURNS:     The audio in the output format, which stays valid until the next call
+--
+-- NOTES:
+--              A partial frame at the end is dropped. When resampling, the number of frames out follows the
+--              rate ratio over time rather than exactly for each call.
+--
+-------------------------------------------------------------------------------------------------------------------*/
+const char *FormatConverter::convert(const char *pcm, int &bytes) {
+    if (!active) {
+        return pcm;
+    }
+    uint64_t began = readCounter();
+    int frames = bytes / input.frameSize;
+    samples.resize((size_t)frames * input.channels);
+    SampleConvert::toFloat(pcm, input, samples.data(), frames * input.channels);
+
+    const float *audio = samples.data();
+    if (input.channels != output.channels) {
+        mixed.resize((size_t)frames * output.channels);
+        SampleConvert::remix(audio, input.channels, mixed.data(), output.channels, frames);
+        audio = mixed.data();
+    }
+    if (resampler.isActive()) {
+        frames = resampler.process(audio, frames, resampled);
+        audio = resampled.data();
+    }
+
+    int outSamples = frames * output.channels;
+    converted.resize((size_t)frames * output.frameSize);
+    SampleConvert::fromFloat(audio, output, converted.data(), outSamples);
+    bytes = frames * output.frameSize;
+
+    stats.samples += outSamples;
+    stats.busyTicks += readCounter() - began;
+    return converted.data();
+}
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	toInputBytes
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	int toInputBytes(int outputBytes) const
+--                               outputBytes - an amount of audio in the output format
+--
+-- RETURNS:     The same length of audio in the input format, rounded up to whole frames
+--
+-------------------------------------------------------------------------------------------------------------------*/
+int FormatConverter::toInputBytes(int outputBytes) const {
+    if (!active) {
+        return outputBytes;
+    }
+    uint64_t frames = (uint64_t)(outputBytes / output.frameSize) * input.sampleRate;
+    frames = (frames + output.sampleRate - 1) / output.sampleRate;
+    return (int)frames * input.frameSize;
+}
@@ -0,0 +1,53 @@
+#pragma once
+#include <windows.h>
+#include <cstdint>
+#include <vector>
+#include <QDebug>
+#include <QString>
+#include "sampleconvert.h"
+#include "streampacket.h"
+
+#define CONVERT_BENCH_SECONDS 60
+#define CONVERT_BENCH_CHUNK_MS 20
+
+class FormatConverter {
+public:
+    struct Statistics {
+        uint64_t samples = 0;
+        uint64_t busyTicks = 0;
+    };
+
+    FormatConverter() = default;
+    FormatConverter(const FormatConverter&) = delete;
+    void operator=(const FormatConverter&) = delete;
+
+    static double getSamplesPerSecond(const Statistics &stats);
+    static StreamDescriptor pcm16(uint32_t sampleRate, uint8_t channels);
+    static int runFromArguments(int argc, char *argv[]);
+    static QString benchmark(int seconds);
+    bool setFormats(const StreamDescriptor &input, const StreamDescriptor &output);
+    void reset();
+    const char *convert(const char *pcm, int &bytes);
+    int toInputBytes(int outputBytes) const;
+
+    bool isActive() const {
+        return active;
+    }
+    const StreamDescriptor &getOutputFormat() const {
+        return output;
+    }
+    const Statistics &getStatistics() const {
+        return stats;
+    }
+
+private:
+    bool active = false;
+    StreamDescriptor input = {};
+    StreamDescriptor output = {};
+    Resampler resampler;
+    std::vector<float> samples;
+    std::vector<float> mixed;
+    std::vector<float> resampled;
+    std::vector<char> converted;
+    Statistics stats;
+};
@@ -0,0 +1,465 @@
+/*------------------------------------------------------------------------------------------------------------------
+-- SOURCE FILE: 	latencymeter.cpp - Breaks the delay of a call or stream down by where it is spent.
+--
+--
+-- PROGRAM: 		Communication Audio Program
+--
+-- FUNCTIONS:
+--                  void LatencyHistogram::record(uint32_t ms)
+--                  uint32_t LatencyHistogram::getPercentile(int percent) const
+--                  QString LatencyHistogram::describe() const
+--                  QString LatencyHistogram::toCsv(const QString &prefix) const
+--                  uint32_t LatencyMeter::now()
+--                  void LatencyMeter::record(Stage stage, uint32_t ms)
+--                  bool LatencyMeter::isProbeDue(uint32_t now)
+--                  void LatencyMeter::receiveReply(uint32_t origin, uint32_t peerTime, uint32_t now)
+--                  bool LatencyMeter::getTransit(uint32_t peerTime, uint32_t now, uint32_t &ms) const
+--                  QString LatencyMeter::describe() const
+--                  bool LatencyMeter::openCsv(const char *fileName)
+--                  void LatencyMeter::writeCsv(const QString &session) const
+--
+-- DATE: 			October 19, 2026
+--
+-- REVISIONS:       October 19, 2026 - Stamp with the performance counter rather than the tick count - agent
+--                  October 19, 2026 - Export the buckets as CSV - agent
+--
+-- DESIGNER: 		agent
+--
+-- PROGRAMMER: 		agent
+--
+-- NOTES:
+--      An average delay hides the one packet in fifty that arrives late enough to be heard, so every delay is
+--      counted into a LatencyHistogram of fixed millisecond buckets instead. Recording is a short search and
+--      an increment, cheap enough for every packet, and the histogram gives the median, the 95th and 99th
+--      percentiles and the worst case. A percentile is the upper edge of the bucket it falls in.
+--
+--      A LatencyMeter keeps one histogram for each stage a packet goes through on its way to the speaker:
+--          transit         from the sender's stamp to arrival, including packetization on a call
+--          jitter buffer   from arrival to leaving the reorder or jitter buffer
+--          output queue    audio already queued in the player ahead of the packet
+--          mouth to ear    the three together
+--          round trip      echo probes to the sender and back
+--
+--      Transit compares a stamp from the sender's clock with ours. The round trip probes give the difference
+--      between the two clocks: the peer stamps its reply when it answers, which is taken to be half way
+--      through the round trip. Of the last LATENCY_OFFSET_SAMPLES replies the one with the shortest round
+--      trip is trusted, since it was delayed least by queues on either path. The estimate is out by half the
+--      difference between the two directions' delays. Until a reply has come back the clocks are only taken
+--      to agree if the stamp is within LATENCY_MAX_MS of ours, as on one machine.
+--
+--      Stamps come from now(), the performance counter in milliseconds. GetTickCount only moves every 10 to
+--      16 ms, which is as long as a voice frame and would put most short delays in the wrong bucket.
+--
+--      The meter does no locking. It is written by the thread that owns the session, and a report read from
+--      another thread may be a packet behind.
+--
+--      Started with --latency-csv <file>, every report of a meter also appends its buckets to that file, one
+--      row per bucket of each stage: time_ms,session,stage,from_ms,to_ms,count. to_ms is empty for the last
+--      bucket, which has no upper edge, and the counts are totals since the session started. Every bucket is
+--      written, empty or not, so a spreadsheet or script can line the rows up from one report to the next.
+--
+--------------------------------------------------------------------------------------------------------------------*/
+#include "latencymeter.h"
+
+const uint32_t LatencyHistogram::bounds[LATENCY_BUCKETS - 1] = {
+    5, 10, 20, 30, 40, 50, 60, 80, 100, 150, 200, 300, 500, 1000, 2000
+};
+
+static const char *stageNames[LatencyMeter::STAGE_COUNT] = {
+    "transit", "jitter buffer", "output queue", "mouth to ear", "round trip"
+};
+
+static FILE *csvFile = nullptr;
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	LatencyHistogram::record
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	void record(uint32_t ms)
+--                          ms - one delay in milliseconds
+--
+-- RETURNS:     void
+--
+-------------------------------------------------------------------------------------------------------------------*/
+void LatencyHistogram::record(uint32_t ms) {
+    int bucket = 0;
+    while (bucket < LATENCY_BUCKETS - 1 && ms > bounds[bucket]) {
+        bucket++;
+    }
+    buckets[bucket]++;
+    count++;
+    totalMs += ms;
+    maxMs = ms > maxMs ? ms : maxMs;
+}
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	LatencyHistogram::getPercentile
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	uint32_t getPercentile(int percent) const
+--                                     percent - share of the delays, 1 to 100
+--
+-- RETURNS:     The delay that many percent of the delays were at or under, in milliseconds
+--
+-- NOTES:
+--              Gives the upper edge of the bucket the percentile falls in, or the worst delay seen if that is
+--              lower or the percentile falls past the last edge.
+--
+-------------------------------------------------------------------------------------------------------------------*/
+uint32_t LatencyHistogram::getPercentile(int percent) const {
+    uint64_t wanted = ((uint64_t)count * percent + 99) / 100;
+    uint64_t seen = 0;
+    for (int bucket = 0; bucket < LATENCY_BUCKETS - 1; bucket++) {
+        seen += buckets[bucket];
+        if (seen >= wanted && seen > 0) {
+            return bounds[bucket] < maxMs ? bounds[bucket] : maxMs;
+        }
+    }
+    return maxMs;
+}
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	LatencyHistogram::describe
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	QString describe() const
+--
+-- RETURNS:     The percentiles and the buckets that have anything in them, as text
+--
+-------------------------------------------------------------------------------------------------------------------*/
+QString LatencyHistogram::describe() const {
+    QString histogram;
+    for (int bucket = 0; bucket < LATENCY_BUCKETS; bucket++) {
+        if (buckets[bucket] == 0) {
+            continue;
+        }
+        QString edge = bucket < LATENCY_BUCKETS - 1 ? QString("<=%1").arg((qint64)bounds[bucket])
+                                                     : QString(">%1").arg((qint64)bounds[bucket - 1]);
+        histogram += QString("%1%2:%3").arg(histogram.isEmpty() ? "" : " ").arg(edge).arg((qint64)buckets[bucket]);
+    }
+    return QString("p50 %1 p95 %2 p99 %3 max %4 ms, mean %5 ms of %6 [%7]")
+            .arg((qint64)getPercentile(50))
+            .arg((qint64)getPercentile(95))
+            .arg((qint64)getPercentile(99))
+            .arg((qint64)maxMs)
+            .arg(count > 0 ? (double)totalMs / count : 0, 0, 'f', 1)
+            .arg((qint64)count)
+            .arg(histogram);
+}
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	LatencyHistogram::toCsv
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	QString toCsv(const QString &prefix) const
+--                           prefix - leading columns of every row, without the trailing comma
+--
+-- RETURNS:     One line per bucket, empty ones included: prefix,from_ms,to_ms,count
+--
+-------------------------------------------------------------------------------------------------------------------*/
+QString LatencyHistogram::toCsv(const QString &prefix) const {
+    QString rows;
+    for (int bucket = 0; bucket < LATENCY_BUCKETS; bucket++) {
+        QString from = bucket > 0 ? QString::number((qint64)bounds[bucket - 1] + 1) : QString("0");
+        QString to = bucket < LATENCY_BUCKETS - 1 ? QString::number((qint64)bounds[bucket]) : QString();
+        rows += QString("%1,%2,%3,%4\n").arg(prefix).arg(from).arg(to).arg((qint64)buckets[bucket]);
+    }
+    return rows;
+}
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	LatencyMeter::now
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	static uint32_t now()
+--
+-- RETURNS:     The performance counter in milliseconds, wrapping like a tick count
+--
+-------------------------------------------------------------------------------------------------------------------*/
+uint32_t LatencyMeter::now() {
+    static uint64_t frequency = 0;
+    if (frequency == 0) {
+        LARGE_INTEGER counterFrequency;
+        QueryPerformanceFrequency(&counterFrequency);
+        frequency = (uint64_t)counterFrequency.QuadPart;
+    }
+    LARGE_INTEGER counter;
+    QueryPerformanceCounter(&counter);
+    return (uint32_t)((uint64_t)counter.QuadPart * 1000 / frequency);
+}
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	LatencyMeter::record
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	void record(Stage stage, uint32_t ms)
+--                          stage - where the time was spent
+--                          ms - how long, in milliseconds
+--
+-- RETURNS:     void
+--
+-------------------------------------------------------------------------------------------------------------------*/
+void LatencyMeter::record(Stage stage, uint32_t ms) {
+    stages[stage].record(ms);
+}
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	LatencyMeter::isProbeDue
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	bool isProbeDue(uint32_t now)
+--                              now - current time from now()
+--
+-- RETURNS:     True if an echo probe should be sent now
+--
+-- NOTES:
+--              Once every LATENCY_PROBE_MS. Returning true counts the probe as sent.
+--
+-------------------------------------------------------------------------------------------------------------------*/
+bool LatencyMeter::isProbeDue(uint32_t now) {
+    if (probed && now - probedAt < LATENCY_PROBE_MS) {
+        return false;
+    }
+    probed = true;
+    probedAt = now;
+    stats.probesSent++;
+    return true;
+}
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	LatencyMeter::receiveReply
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	void receiveReply(uint32_t origin, uint32_t peerTime, uint32_t now)
+--                                origin - when our probe was sent, as echoed back by the peer
+--                                peerTime - the peer's clock when it answered
+--                                now - current time from now()
+--
+-- RETURNS:     void
+--
+-- NOTES:
+--              Records the round trip and keeps the clock offset it gives. A reply claiming to be from the
+--              future or older than LATENCY_MAX_MS is dropped.
+--
+-------------------------------------------------------------------------------------------------------------------*/
+void LatencyMeter::receiveReply(uint32_t origin, uint32_t peerTime, uint32_t now) {
+    uint32_t rtt = now - origin;
+    if (rtt > LATENCY_MAX_MS) {
+        stats.repliesDropped++;
+        return;
+    }
+    stats.repliesReceived++;
+    stages[ROUND_TRIP].record(rtt);
+
+    offsets[offsetNext] = (int32_t)(peerTime - origin - rtt / 2);
+    offsetRtts[offsetNext] = rtt;
+    offsetNext = (offsetNext + 1) % LATENCY_OFFSET_SAMPLES;
+    offsetCount += offsetCount < LATENCY_OFFSET_SAMPLES ? 1 : 0;
+    int best = 0;
+    for (int i = 1; i < offsetCount; i++) {
+        if (offsetRtts[i] < offsetRtts[best]) {
+            best = i;
+        }
+    }
+    offset = offsets[best];
+}
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	LatencyMeter::getTransit
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	bool getTransit(uint32_t peerTime, uint32_t now, uint32_t &ms) const
+--                              peerTime - a stamp from the peer's clock
+--                              now - current time from now()
+--                              ms - set to the time since the stamp
+--
+-- RETURNS:     False if the time cannot be known
+--
+-- NOTES:
+--              With the clock offset known, a stamp that seems to come from slightly in the future is an error
+--              in the estimate and counts as no time at all.
+--
+-------------------------------------------------------------------------------------------------------------------*/
+bool LatencyMeter::getTransit(uint32_t peerTime, uint32_t now, uint32_t &ms) const {
+    if (offsetCount == 0) {
+        ms = now - peerTime;
+        return ms <= LATENCY_MAX_MS;
+    }
+    int32_t transit = (int32_t)(now - (peerTime - (uint32_t)offset));
+    if (transit > LATENCY_MAX_MS) {
+        return false;
+    }
+    ms = transit > 0 ? (uint32_t)transit : 0;
+    return true;
+}
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	LatencyMeter::describe
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	QString describe() const
+--
+-- RETURNS:     Every stage that has been measured, and the probes, as text
+--
+-------------------------------------------------------------------------------------------------------------------*/
+QString LatencyMeter::describe() const {
+    QString text;
+    for (int stage = 0; stage < STAGE_COUNT; stage++) {
+        if (stages[stage].getCount() == 0) {
+            continue;
+        }
+        text += QString("%1%2 %3").arg(text.isEmpty() ? "" : "; ").arg(stageNames[stage])
+                .arg(stages[stage].describe());
+    }
+    if (text.isEmpty()) {
+        text = "not measured yet";
+    }
+    QString clock = offsetCount > 0 ? QString("peer clock %1 ms ahead").arg((qint64)offset)
+                                    : QString("peer clock unknown");
+    return QString("%1; %2 probes, %3 answered, %4 stale; %5")
+            .arg(text)
+            .arg((qint64)stats.probesSent)
+            .arg((qint64)stats.repliesReceived)
+            .arg((qint64)stats.repliesDropped)
+            .arg(clock);
+}
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	LatencyMeter::openCsv
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	static bool openCsv(const char *fileName)
+--                                  fileName - file to append the buckets of every report to
+--
+-- RETURNS:     false if the file could not be opened
+--
+-- NOTES:
+--              Called once from main before any session starts. The column names are written only to a new or
+--              empty file, so several runs can append to the same one.
+--
+-------------------------------------------------------------------------------------------------------------------*/
+bool LatencyMeter::openCsv(const char *fileName) {
+    csvFile = fopen(fileName, "a");
+    if (csvFile == nullptr) {
+        return false;
+    }
+    fseek(csvFile, 0, SEEK_END);
+    if (ftell(csvFile) == 0) {
+        fputs("time_ms,session,stage,from_ms,to_ms,count\n", csvFile);
+        fflush(csvFile);
+    }
+    return true;
+}
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	LatencyMeter::writeCsv
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	void writeCsv(const QString &session) const
+--                            session - name of the call, stream or participant, with no commas in it
+--
+-- RETURNS:     void
+--
+-- NOTES:
+--              Does nothing unless openCsv succeeded. Called wherever the meter's describe() is reported, under
+--              the same lock. The whole report goes out in one fwrite, so reports from two threads never
+--              interleave rows.
+--
+-------------------------------------------------------------------------------------------------------------------*/
+void LatencyMeter::writeCsv(const QString &session) const {
+    if (csvFile == nullptr) {
+        return;
+    }
+    QString time = QString::number((qint64)now());
+    QString rows;
+    for (int stage = 0; stage < STAGE_COUNT; stage++) {
+        rows += stages[stage].toCsv(QString("%1,%2,%3").arg(time).arg(session).arg(stageNames[stage]));
+    }
+    QByteArray bytes = rows.toUtf8();
+    fwrite(bytes.constData(), 1, bytes.size(), csvFile);
+    fflush(csvFile);
+}
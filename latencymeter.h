@@ -0,0 +1,75 @@
+#pragma once
+#include <windows.h>
+#include <cstdint>
+#include <cstdio>
+#include <QString>
+
+#define LATENCY_BUCKETS 16
+#define LATENCY_PROBE_MS 1000
+#define LATENCY_MAX_MS 10000
+#define LATENCY_OFFSET_SAMPLES 8
+#define LATENCY_UNKNOWN UINT32_MAX
+
+class LatencyHistogram {
+public:
+    void record(uint32_t ms);
+    uint32_t getPercentile(int percent) const;
+    QString describe() const;
+    QString toCsv(const QString &prefix) const;
+
+    uint32_t getCount() const {
+        return count;
+    }
+
+private:
+    static const uint32_t bounds[LATENCY_BUCKETS - 1];
+    uint32_t buckets[LATENCY_BUCKETS] = {};
+    uint32_t count = 0;
+    uint64_t totalMs = 0;
+    uint32_t maxMs = 0;
+};
+
+class LatencyMeter {
+public:
+    enum Stage {
+        TRANSIT,
+        JITTER_BUFFER,
+        OUTPUT_QUEUE,
+        MOUTH_TO_EAR,
+        ROUND_TRIP,
+        STAGE_COUNT
+    };
+
+    struct Statistics {
+        uint32_t probesSent = 0;
+        uint32_t repliesReceived = 0;
+        uint32_t repliesDropped = 0;
+    };
+
+    static uint32_t now();
+    void record(Stage stage, uint32_t ms);
+    bool isProbeDue(uint32_t now);
+    void receiveReply(uint32_t origin, uint32_t peerTime, uint32_t now);
+    bool getTransit(uint32_t peerTime, uint32_t now, uint32_t &ms) const;
+    QString describe() const;
+    static bool openCsv(const char *fileName);
+    void writeCsv(const QString &session) const;
+
+    const LatencyHistogram &getHistogram(Stage stage) const {
+        return stages[stage];
+    }
+    const Statistics &getStatistics() const {
+        return stats;
+    }
+
+private:
+    LatencyHistogram stages[STAGE_COUNT];
+    bool probed = false;
+    uint32_t probedAt = 0;
+    int32_t offsets[LATENCY_OFFSET_SAMPLES] = {};
+    uint32_t offsetRtts[LATENCY_OFFSET_SAMPLES] = {};
+    int offsetCount = 0;
+    int offsetNext = 0;
+    int32_t offset = 0;
+    Statistics stats;
+};
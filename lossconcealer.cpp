@@ -0,0 +1,741 @@
+/*------------------------------------------------------------------------------------------------------------------
+-- SOURCE FILE: 	lossconcealer.cpp - Plays something close to the missing audio in place of a lost packet.
+--
+--
+-- PROGRAM: 		Communication Audio Program
+--
+-- FUNCTIONS:
+--                  ~LossConcealer()
+--                  double getMicrosPerSecond(const Statistics &stats)
+--                  static int runFromArguments(int argc, char *argv[])
+--                  static QString benchmark(double lossPercent, int seconds)
+--                  void setFormat(const StreamDescriptor &format)
+--                  void reset()
+--                  const char *play(const char *pcm, int bytes)
+--                  int conceal(char *pcm, int capacity)
+--                  void release()
+--                  void clearHistory()
+--                  void startConcealment()
+--                  int findPeriod() const
+--                  int64_t correlate(int lag, int match, int stride, int64_t &energy) const
+--                  int32_t getGain() const
+--                  void nextFrame(int16_t *frame)
+--                  void remember(const int16_t *frame)
+--
+-- DATE: 			October 19, 2026
+--
+-- REVISIONS:       October 19, 2026 - Add --plc-bench, quality and cost against loss traces - agent
+--
+-- DESIGNER: 		agent
+--
+-- PROGRAMMER: 		agent
+--
+-- NOTES:
+--      A concealer sits just before the player and sees every decoded packet. It keeps the last PLC_HISTORY_MS
+--      of audio in a ring. When a packet is lost it finds the pitch period of the end of that audio and plays
+--      the last period over and over for the length of the lost packet. Music and voice are both mostly
+--      periodic over a few milliseconds, so this sounds much closer to the missing audio than silence and has
+--      no click at either end.
+--
+--      The period is the lag, between PLC_MIN_PERIOD_US and PLC_MAX_PERIOD_US, at which the last PLC_MATCH_MS
+--      of audio best matches the audio one lag earlier. Lags are first tried about every 8 kHz sample, then
+--      around the best one at the full rate, so the search costs the same at any sample rate. The repeated
+--      period starts with a small offset that fades out over its first quarter, so the first made up sample
+--      carries on from the last real one. Repeating one period for long sounds buzzy, so after PLC_FULL_MS
+--      the made up audio fades to silence over PLC_FADE_MS. When real audio returns, its first PLC_MERGE_MS
+--      are cross-faded from the made up audio.
+--
+--      Only the history ring is touched for packets that arrive, so the cost is a copy of each packet plus
+--      the search once per loss. Only 16 bit audio is concealed; in other formats lost packets are skipped
+--      as before. The time spent is kept the same way AudioCodec keeps it, so it can be shown per second of
+--      audio next to the decoding cost.
+--
+--      --plc-bench plays voice-like and music-like audio through random and bursty loss, with silence and with
+--      concealment in place of the lost packets, and compares both with the audio that was sent.
+--
+--------------------------------------------------------------------------------------------------------------------*/
+#include "lossconcealer.h"
+#include <cmath>
+#include <cstdlib>
+
+struct PlcBenchRun {
+    uint32_t packets;
+    uint32_t lost;
+    double silenceSnr;
+    double concealedSnr;
+    double microsPerSecond;
+};
+
+static uint64_t readCounter() {
+    LARGE_INTEGER counter;
+    QueryPerformanceCounter(&counter);
+    return (uint64_t)counter.QuadPart;
+}
+
+static uint32_t nextRandom(uint32_t &state) {
+    state ^= state << 13;
+    state ^= state >> 17;
+    state ^= state << 5;
+    return state;
+}
+
+static int16_t benchSample(bool voice, double t) {
+    const double pi = 3.14159265358979;
+    if (voice) {
+        // Eight harmonics of a pitch gliding between 120 and 180 Hz, in syllables four times a second
+        double phase = 2 * pi * 150 * t - 10 * cos(2 * pi * 3 * t);
+        double value = 0;
+        for (int harmonic = 1; harmonic <= 8; harmonic++) {
+            value += sin(harmonic * phase) / harmonic;
+        }
+        return (int16_t)(6000 * fabs(sin(2 * pi * 2 * t)) * value);
+    }
+    return (int16_t)(5000 * (sin(2 * pi * 440 * t) + sin(2 * pi * 554.37 * t) + sin(2 * pi * 659.26 * t)));
+}
+
+static PlcBenchRun runTrace(bool voice, int burst, double lossPercent, int seconds) {
+    StreamDescriptor format = { 44100, 2, 16, SAMPLE_SIGNED, CODEC_PCM, 4 };
+    int frames = (int)(format.sampleRate * PLC_BENCH_PACKET_MS / 1000);
+    int bytes = frames * format.frameSize;
+    std::vector<int16_t> sent((size_t)frames * format.channels);
+    std::vector<int16_t> concealed(sent.size());
+    LossConcealer *concealer = new LossConcealer();
+    concealer->setFormat(format);
+    PlcBenchRun run = {};
+    run.packets = (uint32_t)(seconds * 1000 / PLC_BENCH_PACKET_MS);
+    // A burst starts at the rate that makes lossPercent of the packets lost on average
+    uint32_t startBelow = (uint32_t)(lossPercent / 100 / (burst - (burst - 1) * lossPercent / 100) * 4294967295.0);
+    uint32_t state = PLC_BENCH_SEED;
+    int burstLeft = 0;
+    double signal = 0;
+    double silenceError = 0;
+    double concealedError = 0;
+
+    for (uint32_t packet = 0; packet < run.packets; packet++) {
+        for (int i = 0; i < frames; i++) {
+            int16_t sample = benchSample(voice, (double)((uint64_t)packet * frames + i) / format.sampleRate);
+            sent[i * 2] = sample;
+            sent[i * 2 + 1] = (int16_t)(sample / 2);
+        }
+        bool lost = burstLeft > 0;
+        if (lost) {
+            burstLeft--;
+        } else if (nextRandom(state) < startBelow) {
+            lost = true;
+            burstLeft = burst - 1;
+        }
+        const int16_t *played;
+        if (lost) {
+            run.lost++;
+            if (concealer->conceal((char *)concealed.data(), bytes) == 0) {
+                memset(concealed.data(), 0, bytes);
+            }
+            played = concealed.data();
+        } else {
+            played = (const int16_t *)concealer->play((const char *)sent.data(), bytes);
+        }
+        for (size_t i = 0; i < sent.size(); i++) {
+            double error = (double)played[i] - sent[i];
+            signal += (double)sent[i] * sent[i];
+            silenceError += lost ? (double)sent[i] * sent[i] : 0;
+            concealedError += error * error;
+        }
+    }
+    run.silenceSnr = silenceError > 0 ? 10 * log10(signal / silenceError) : 0;
+    run.concealedSnr = concealedError > 0 ? 10 * log10(signal / concealedError) : 0;
+    run.microsPerSecond = LossConcealer::getMicrosPerSecond(concealer->getStatistics());
+    delete concealer;
+    return run;
+}
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	~LossConcealer
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	~LossConcealer()
+--
+-- RETURNS:     void
+--
+-------------------------------------------------------------------------------------------------------------------*/
+LossConcealer::~LossConcealer() {
+    release();
+}
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	getMicrosPerSecond
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	static double getMicrosPerSecond(const Statistics &stats)
+--                          stats - counters kept by a concealer
+--
+-- RETURNS:     Microseconds spent per second of audio played, or 0 before any audio
+--
+-------------------------------------------------------------------------------------------------------------------*/
+double LossConcealer::getMicrosPerSecond(const Statistics &stats) {
+    LARGE_INTEGER frequency;
+    QueryPerformanceFrequency(&frequency);
+    if (stats.audioMicros == 0 || frequency.QuadPart == 0) {
+        return 0;
+    }
+    double busyMicros = stats.busyTicks * 1000000.0 / frequency.QuadPart;
+    return busyMicros * 1000000.0 / stats.audioMicros;
+}
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	runFromArguments
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	static int runFromArguments(int argc, char *argv[])
+--                          argc - number of command line arguments
+--                          argv - the command line arguments
+--
+-- RETURNS:     The process exit code
+--
+-- NOTES:
+--              The form is
+--                  --plc-bench [loss percent] [seconds of audio]
+--              The benchmark prints its result and returns.
+--
+-------------------------------------------------------------------------------------------------------------------*/
+int LossConcealer::runFromArguments(int argc, char *argv[]) {
+    if (strcmp(argv[1], "--plc-bench") != 0) {
+        qDebug() << "Usage: --plc-bench [loss percent] [seconds of audio]\n";
+        return 1;
+    }
+    double lossPercent = argc >= 3 ? atof(argv[2]) : PLC_BENCH_LOSS_PERCENT;
+    int seconds = argc >= 4 ? atoi(argv[3]) : PLC_BENCH_SECONDS;
+    if (lossPercent <= 0 || lossPercent >= 50) {
+        lossPercent = PLC_BENCH_LOSS_PERCENT;
+    }
+    qDebug() << benchmark(lossPercent, seconds > 0 ? seconds : PLC_BENCH_SECONDS);
+    return 0;
+}
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	benchmark
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	static QString benchmark(double lossPercent, int seconds)
+--                                lossPercent - share of the packets lost in each trace
+--                                seconds - length of the audio in each trace
+--
+-- RETURNS:     A summary of every trace
+--
+-- NOTES:
+--              Voice-like and music-like 44.1 kHz stereo audio, in PLC_BENCH_PACKET_MS packets, goes through two
+--              loss traces: single packets lost at random, and bursts of PLC_BENCH_BURST packets. The signal to
+--              noise ratio of the whole trace is given for silence in place of each lost packet, which is what
+--              the players did before, and for concealment, cross-fades included. The cost is the concealer's
+--              own, per second of audio played, so it can be set against the decoding cost of --codec-bench.
+--
+-------------------------------------------------------------------------------------------------------------------*/
+QString LossConcealer::benchmark(double lossPercent, int seconds) {
+    QString summary = QString("PLC benchmark, %1 s of 44.1 kHz stereo in %2 ms packets, %3% lost")
+            .arg(seconds)
+            .arg(PLC_BENCH_PACKET_MS)
+            .arg(lossPercent, 0, 'f', 1);
+    for (int trace = 0; trace < 4; trace++) {
+        bool voice = trace < 2;
+        int burst = trace % 2 == 0 ? 1 : PLC_BENCH_BURST;
+        PlcBenchRun run = runTrace(voice, burst, lossPercent, seconds);
+        summary.append(QString(" | %1, %2: %3 lost, silence SNR %4 dB, concealed SNR %5 dB, %6 us/s")
+                       .arg(voice ? "Voice" : "Music")
+                       .arg(burst == 1 ? QString("random loss") : QString("bursts of %1").arg(burst))
+                       .arg((qint64)run.lost)
+                       .arg(run.silenceSnr, 0, 'f', 1)
+                       .arg(run.concealedSnr, 0, 'f', 1)
+                       .arg(run.microsPerSecond, 0, 'f', 1));
+    }
+    return summary;
+}
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	setFormat
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	void setFormat(const StreamDescriptor &format)
+--                          format - PCM format of the audio that will be played
+--
+-- RETURNS:     void
+--
+-- NOTES:
+--              The history is sized for the format and cleared, since audio in the old format is no use for
+--              concealing the new one. The codec in the descriptor is ignored; the concealer sees decoded audio.
+--
+-------------------------------------------------------------------------------------------------------------------*/
+void LossConcealer::setFormat(const StreamDescriptor &newFormat) {
+    if (active && newFormat.sampleRate == format.sampleRate && newFormat.channels == format.channels &&
+            newFormat.sampleSize == format.sampleSize && newFormat.sampleType == format.sampleType) {
+        clearHistory();
+        return;
+    }
+    release();
+    format = newFormat;
+    channels = format.channels;
+    active = format.sampleSize == 16 && format.sampleType != SAMPLE_FLOAT && channels > 0 &&
+             channels <= PLC_MAX_CHANNELS && format.sampleRate >= PLC_SEARCH_RATE;
+    if (!active) {
+        return;
+    }
+    signFlip = format.sampleType == SAMPLE_UNSIGNED ? 0x8000 : 0;
+    historyFrames = (int)(format.sampleRate * PLC_HISTORY_MS / 1000);
+    int maxPeriod = (int)((uint64_t)format.sampleRate * PLC_MAX_PERIOD_US / 1000000);
+    history = new int16_t[historyFrames * channels];
+    linear = new int16_t[historyFrames * channels];
+    mono = new int32_t[historyFrames];
+    cycle = new int16_t[maxPeriod * channels];
+    clearHistory();
+}
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	reset
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	void reset()
+--
+-- RETURNS:     void
+--
+-- NOTES:
+--              Forgets the history and the counters, for a new stream in the same format.
+--
+-------------------------------------------------------------------------------------------------------------------*/
+void LossConcealer::reset() {
+    clearHistory();
+    stats = Statistics();
+}
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	play
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	const char *play(const char *pcm, int bytes)
+--                          pcm - audio of a packet that arrived
+--                          bytes - size of the audio
+--
+-- RETURNS:     The audio to play: pcm itself, or a copy cross-faded from the concealment before it
+--
+-- NOTES:
+--              Adds the audio to the history. The copy stays valid until the next call.
+--
+-------------------------------------------------------------------------------------------------------------------*/
+const char *LossConcealer::play(const char *pcm, int bytes) {
+    if (!active) {
+        return pcm;
+    }
+    uint64_t start = readCounter();
+    int frameSize = channels * 2;
+    int frames = bytes / frameSize;
+    int mergeFrames = 0;
+    lastFrameBytes = frames * frameSize;
+    if (concealing) {
+        merged.assign(pcm, pcm + bytes);
+        pcm = merged.data();
+        mergeFrames = (int)(format.sampleRate * PLC_MERGE_MS / 1000);
+        if (mergeFrames > frames) {
+            mergeFrames = frames;
+        }
+    }
+
+    int16_t values[PLC_MAX_CHANNELS];
+    int16_t synthetic[PLC_MAX_CHANNELS];
+    for (int i = 0; i < frames; i++) {
+        for (int c = 0; c < channels; c++) {
+            values[c] = readSample(pcm + (i * channels + c) * 2);
+        }
+        if (i < mergeFrames) {
+            nextFrame(synthetic);
+            int32_t weight = (i + 1) * 32768 / (mergeFrames + 1);
+            for (int c = 0; c < channels; c++) {
+                values[c] = (int16_t)((values[c] * weight + synthetic[c] * (32768 - weight)) >> 15);
+                writeSample(&merged[(i * channels + c) * 2], values[c]);
+            }
+        }
+        remember(values);
+    }
+    concealing = false;
+
+    stats.busyTicks += readCounter() - start;
+    stats.audioMicros += (uint64_t)frames * 1000000 / format.sampleRate;
+    return pcm;
+}
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	conceal
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	int conceal(char *pcm, int capacity)
+--                          pcm - filled with audio to play in place of a lost packet
+--                          capacity - size of pcm
+--
+-- RETURNS:     Bytes written, the size of the last packet played, or 0 if nothing can be made up
+--
+-- NOTES:
+--              Consecutive calls carry on from each other, so a run of lost packets is one continuous
+--              concealment that fades out. Nothing is made up before the first packet has played.
+--
+-------------------------------------------------------------------------------------------------------------------*/
+int LossConcealer::conceal(char *pcm, int capacity) {
+    if (!active || lastFrameBytes == 0 || lastFrameBytes > capacity) {
+        return 0;
+    }
+    uint64_t start = readCounter();
+    if (!concealing) {
+        startConcealment();
+    }
+    int frames = lastFrameBytes / (channels * 2);
+    int16_t frame[PLC_MAX_CHANNELS];
+    for (int i = 0; i < frames; i++) {
+        nextFrame(frame);
+        for (int c = 0; c < channels; c++) {
+            writeSample(pcm + (i * channels + c) * 2, frame[c]);
+        }
+        remember(frame);
+    }
+    stats.packetsConcealed++;
+    stats.busyTicks += readCounter() - start;
+    stats.audioMicros += (uint64_t)frames * 1000000 / format.sampleRate;
+    return lastFrameBytes;
+}
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	release
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	void release()
+--
+-- RETURNS:     void
+--
+-- NOTES:
+--              Frees the buffers sized for the current format.
+--
+-------------------------------------------------------------------------------------------------------------------*/
+void LossConcealer::release() {
+    delete[] history;
+    delete[] linear;
+    delete[] mono;
+    delete[] cycle;
+    history = nullptr;
+    linear = nullptr;
+    mono = nullptr;
+    cycle = nullptr;
+    active = false;
+}
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	clearHistory
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:   October 19, 2026 - Make public for jumps in the stream - agent
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	void clearHistory()
+--
+-- RETURNS:     void
+--
+-- NOTES:
+--              The history starts as silence, so a loss just after the start conceals with quiet audio. Also
+--              called when the stream jumps, since the audio before the jump is no use for concealing after it.
+--
+-------------------------------------------------------------------------------------------------------------------*/
+void LossConcealer::clearHistory() {
+    if (history != nullptr) {
+        memset(history, 0, historyFrames * channels * sizeof(int16_t));
+    }
+    historyNext = 0;
+    lastFrameBytes = 0;
+    concealing = false;
+}
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	startConcealment
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	void startConcealment()
+--
+-- RETURNS:     void
+--
+-- NOTES:
+--              Finds the pitch period and copies the last period of the history to be repeated. Over the
+--              first quarter of the copy an offset fades out that makes its first sample follow the last
+--              real sample the way the same samples followed each other one period earlier. The last sample
+--              of the copy is the last real sample, so the repeats join the same way.
+--
+-------------------------------------------------------------------------------------------------------------------*/
+void LossConcealer::startConcealment() {
+    // Unroll the ring so the oldest frame comes first
+    int split = historyNext * channels;
+    int total = historyFrames * channels;
+    memcpy(linear, history + split, (total - split) * sizeof(int16_t));
+    memcpy(linear + total - split, history, split * sizeof(int16_t));
+    for (int i = 0; i < historyFrames; i++) {
+        int32_t sum = 0;
+        for (int c = 0; c < channels; c++) {
+            sum += linear[i * channels + c];
+        }
+        mono[i] = sum / channels;
+    }
+
+    period = findPeriod();
+    int overlap = period / 4 > 0 ? period / 4 : 1;
+    const int16_t *last = linear + (historyFrames - 1) * channels;
+    const int16_t *before = linear + (historyFrames - 1 - period) * channels;
+    const int16_t *source = linear + (historyFrames - period) * channels;
+    for (int i = 0; i < period; i++) {
+        for (int c = 0; c < channels; c++) {
+            int32_t value = source[i * channels + c];
+            if (i < overlap) {
+                value += (last[c] - before[c]) * (overlap - i) / overlap;
+            }
+            cycle[i * channels + c] = (int16_t)(value > 32767 ? 32767 : value < -32768 ? -32768 : value);
+        }
+    }
+    position = 0;
+    elapsed = 0;
+    concealing = true;
+    stats.lossEvents++;
+}
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	findPeriod
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	int findPeriod() const
+--
+-- RETURNS:     The pitch period of the end of the history, in frames
+--
+-- NOTES:
+--              Compares normalized correlations, so a lag that lands on a loud part of the history does not
+--              win just for being loud. Audio with no period, like noise or silence, gets the longest period,
+--              which repeats a longer piece and sounds less buzzy.
+--
+-------------------------------------------------------------------------------------------------------------------*/
+int LossConcealer::findPeriod() const {
+    int minPeriod = (int)((uint64_t)format.sampleRate * PLC_MIN_PERIOD_US / 1000000);
+    int maxPeriod = (int)((uint64_t)format.sampleRate * PLC_MAX_PERIOD_US / 1000000);
+    int match = (int)(format.sampleRate * PLC_MATCH_MS / 1000);
+    int step = (int)(format.sampleRate / PLC_SEARCH_RATE);
+    int best = maxPeriod;
+    double bestScore = 0;
+    int64_t energy;
+
+    for (int pass = 0; pass < 2; pass++) {
+        // The first pass tries lags about every 8 kHz sample, the second every sample next to the best one
+        int first = pass == 0 ? minPeriod : best - step + 1;
+        int last = pass == 0 ? maxPeriod : best + step - 1;
+        int stride = pass == 0 ? step : 1;
+        first = first < minPeriod ? minPeriod : first;
+        last = last > maxPeriod ? maxPeriod : last;
+        bestScore = 0;
+        for (int lag = first; lag <= last; lag += stride) {
+            int64_t correlation = correlate(lag, match, stride, energy);
+            if (correlation <= 0 || energy == 0) {
+                continue;
+            }
+            double score = (double)correlation * correlation / energy;
+            if (score > bestScore) {
+                bestScore = score;
+                best = lag;
+            }
+        }
+        if (bestScore == 0) {
+            return maxPeriod;
+        }
+    }
+    return best;
+}
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	correlate
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	int64_t correlate(int lag, int match, int stride, int64_t &energy) const
+--                          lag - how far back to compare
+--                          match - number of frames at the end of the history to compare
+--                          stride - compare every stride-th frame
+--                          energy - set to the energy of the lagged frames
+--
+-- RETURNS:     The correlation of the end of the history with the frames lag before it
+--
+-------------------------------------------------------------------------------------------------------------------*/
+int64_t LossConcealer::correlate(int lag, int match, int stride, int64_t &energy) const {
+    const int32_t *tail = mono + historyFrames - match;
+    int64_t correlation = 0;
+    energy = 0;
+    for (int i = 0; i < match; i += stride) {
+        int64_t lagged = tail[i - lag];
+        correlation += tail[i] * lagged;
+        energy += lagged * lagged;
+    }
+    return correlation;
+}
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	getGain
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	int32_t getGain() const
+--
+-- RETURNS:     Level of the next made up frame, out of 32768
+--
+-------------------------------------------------------------------------------------------------------------------*/
+int32_t LossConcealer::getGain() const {
+    int full = (int)(format.sampleRate * PLC_FULL_MS / 1000);
+    int fade = (int)(format.sampleRate * PLC_FADE_MS / 1000);
+    if (elapsed < full) {
+        return 32768;
+    }
+    if (elapsed >= full + fade) {
+        return 0;
+    }
+    return (int32_t)((int64_t)(full + fade - elapsed) * 32768 / fade);
+}
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	nextFrame
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	void nextFrame(int16_t *frame)
+--                          frame - filled with one made up sample per channel
+--
+-- RETURNS:     void
+--
+-------------------------------------------------------------------------------------------------------------------*/
+void LossConcealer::nextFrame(int16_t *frame) {
+    int32_t gain = getGain();
+    for (int c = 0; c < channels; c++) {
+        frame[c] = (int16_t)((cycle[position * channels + c] * gain) >> 15);
+    }
+    if (++position == period) {
+        position = 0;
+    }
+    // Stop counting once faded out, so a long outage cannot overflow
+    if (gain > 0) {
+        elapsed++;
+    }
+}
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	remember
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	void remember(const int16_t *frame)
+--                          frame - one sample per channel
+--
+-- RETURNS:     void
+--
+-------------------------------------------------------------------------------------------------------------------*/
+void LossConcealer::remember(const int16_t *frame) {
+    memcpy(history + historyNext * channels, frame, channels * sizeof(int16_t));
+    if (++historyNext == historyFrames) {
+        historyNext = 0;
+    }
+}
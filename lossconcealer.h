@@ -0,0 +1,90 @@
+#pragma once
+#include <windows.h>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+#include <QDebug>
+#include <QString>
+#include "streampacket.h"
+
+#define PLC_HISTORY_MS 32
+#define PLC_MATCH_MS 8
+#define PLC_MIN_PERIOD_US 2500
+#define PLC_MAX_PERIOD_US 15000
+#define PLC_SEARCH_RATE 8000
+#define PLC_FULL_MS 20
+#define PLC_FADE_MS 40
+#define PLC_MERGE_MS 4
+#define PLC_MAX_CHANNELS 8
+#define PLC_BENCH_SECONDS 60
+#define PLC_BENCH_LOSS_PERCENT 5.0
+#define PLC_BENCH_PACKET_MS 20
+#define PLC_BENCH_BURST 3
+#define PLC_BENCH_SEED 0x2545F491
+
+class LossConcealer {
+public:
+    struct Statistics {
+        uint32_t packetsConcealed = 0;
+        uint32_t lossEvents = 0;
+        uint64_t audioMicros = 0;
+        uint64_t busyTicks = 0;
+    };
+
+    LossConcealer() = default;
+    ~LossConcealer();
+    LossConcealer(const LossConcealer&) = delete;
+    void operator=(const LossConcealer&) = delete;
+
+    static double getMicrosPerSecond(const Statistics &stats);
+    static int runFromArguments(int argc, char *argv[]);
+    static QString benchmark(double lossPercent, int seconds);
+    void setFormat(const StreamDescriptor &format);
+    void reset();
+    void clearHistory();
+    const char *play(const char *pcm, int bytes);
+    int conceal(char *pcm, int capacity);
+
+    bool isActive() const {
+        return active;
+    }
+    const Statistics &getStatistics() const {
+        return stats;
+    }
+
+private:
+    bool active = false;
+    StreamDescriptor format = {};
+    int channels = 0;
+    uint16_t signFlip = 0;
+    int historyFrames = 0;
+    int historyNext = 0;
+    int16_t *history = nullptr;
+    int16_t *linear = nullptr;
+    int32_t *mono = nullptr;
+    int16_t *cycle = nullptr;
+    std::vector<char> merged;
+    int lastFrameBytes = 0;
+    bool concealing = false;
+    int period = 0;
+    int position = 0;
+    int elapsed = 0;
+    Statistics stats;
+
+    int16_t readSample(const char *pcm) const {
+        uint16_t value;
+        memcpy(&value, pcm, 2);
+        return (int16_t)(value ^ signFlip);
+    }
+    void writeSample(char *pcm, int16_t sample) const {
+        uint16_t value = (uint16_t)sample ^ signFlip;
+        memcpy(pcm, &value, 2);
+    }
+    void release();
+    void startConcealment();
+    int findPeriod() const;
+    int64_t correlate(int lag, int match, int stride, int64_t &energy) const;
+    int32_t getGain() const;
+    void nextFrame(int16_t *frame);
+    void remember(const int16_t *frame);
+};
@@ -1,8 +1,94 @@
+#include "audiocodec.h"
+#include "callsession.h"
+#include "channelmanager.h"
+#include "conferencebridge.h"
+#include "datagramio.h"
+#include "decodeahead.h"
+#include "fanout.h"
+#include "formatconverter.h"
+#include "latencymeter.h"
+#include "lossconcealer.h"
 #include "mainwindow.h"
+#include "receivering.h"
+#include "streamreceiver.h"
+#include "streamrelay.h"
 #include <QApplication>
+#include <cstring>
 
 int main(int argc, char *argv[])
 {
+    // Any mode can write its latency buckets as CSV: --latency-csv <file> first, see LatencyMeter::writeCsv
+    if (argc >= 3 && strcmp(argv[1], "--latency-csv") == 0)
+    {
+        if (!LatencyMeter::openCsv(argv[2]))
+        {
+            qDebug() << "Could not open" << argv[2] << "for the latency buckets";
+            return 1;
+        }
+        argv[2] = argv[0];
+        argv += 2;
+        argc -= 2;
+    }
+    // A relay runs headless: --relay-uplink or --relay-downlink, see StreamRelay::runFromArguments
+    if (argc >= 2 && strncmp(argv[1], "--relay-", 8) == 0)
+    {
+        return StreamRelay::runFromArguments(argc, argv);
+    }
+    // So does a conference bridge: --conference or --conference-bench, see ConferenceBridge::runFromArguments
+    if (argc >= 2 && strncmp(argv[1], "--conference", 12) == 0)
+    {
+        return ConferenceBridge::runFromArguments(argc, argv);
+    }
+    // And the receive ring benchmark: --receive-bench, see ReceiveRing::runFromArguments
+    if (argc >= 2 && strcmp(argv[1], "--receive-bench") == 0)
+    {
+        return ReceiveRing::runFromArguments(argc, argv);
+    }
+    // And the fan-out benchmark: --fanout-bench, see FanOut::runFromArguments
+    if (argc >= 2 && strcmp(argv[1], "--fanout-bench") == 0)
+    {
+        return FanOut::runFromArguments(argc, argv);
+    }
+    // And the codec benchmark: --codec-bench, see AudioCodec::runFromArguments
+    if (argc >= 2 && strcmp(argv[1], "--codec-bench") == 0)
+    {
+        return AudioCodec::runFromArguments(argc, argv);
+    }
+    // And the channel benchmark: --channel-bench, see ChannelManager::runFromArguments
+    if (argc >= 2 && strcmp(argv[1], "--channel-bench") == 0)
+    {
+        return ChannelManager::runFromArguments(argc, argv);
+    }
+    // And the FEC and join benchmarks: --fec-bench or --join-bench, see StreamReceiver::runFromArguments
+    if (argc >= 2 && (strcmp(argv[1], "--fec-bench") == 0 || strcmp(argv[1], "--join-bench") == 0))
+    {
+        return StreamReceiver::runFromArguments(argc, argv);
+    }
+    // And the datagram I/O benchmark: --datagram-bench, see DatagramIO::runFromArguments
+    if (argc >= 2 && strcmp(argv[1], "--datagram-bench") == 0)
+    {
+        return DatagramIO::runFromArguments(argc, argv);
+    }
+    // And the loss concealment benchmark: --plc-bench, see LossConcealer::runFromArguments
+    if (argc >= 2 && strcmp(argv[1], "--plc-bench") == 0)
+    {
+        return LossConcealer::runFromArguments(argc, argv);
+    }
+    // And the decoding benchmark: --decode-bench, see DecodeAhead::runFromArguments
+    if (argc >= 2 && strcmp(argv[1], "--decode-bench") == 0)
+    {
+        return DecodeAhead::runFromArguments(argc, argv);
+    }
+    // And the conversion benchmark: --convert-bench, see FormatConverter::runFromArguments
+    if (argc >= 2 && strcmp(argv[1], "--convert-bench") == 0)
+    {
+        return FormatConverter::runFromArguments(argc, argv);
+    }
+    // And the voice delay benchmark: --voice-bench, see CallSession::runFromArguments
+    if (argc >= 2 && strcmp(argv[1], "--voice-bench") == 0)
+    {
+        return CallSession::runFromArguments(argc, argv);
+    }
     QApplication::setAttribute(Qt::AA_EnableHighDpiScaling);
     QApplication a(argc, argv);
     MainWindow w;
@@ -3,17 +3,28 @@
 
 MainWindow::MainWindow(QWidget *parent) : QMainWindow(parent),
     ui(new Ui::MainWindow),
-    audioDevice(new AudioDevice(this)) {
+    audioDevice(new AudioDevice(this)),
+    callDevice(new AudioDevice(this)) {
     ui->setupUi(this);
     ui->widgets->setCurrentIndex(0);
 
     //Connects the statistical messages signals to the MainWindow
     connect(Server::getInstance(), &Server::sendMessageToScreen, this, &MainWindow::printTCPServerMessage);
     connect(Client::getInstance(), &Client::sendMessageToScreen, this, &MainWindow::printTCPClientMessage);
+    connect(Client::getInstance(), &Client::streamTrackChanged, this, &MainWindow::showStreamTrack);
 
     connect(MediaHandler::getPlayer(), &QMediaPlayer::positionChanged, this, &MainWindow::on_progressChange);
     connect(MediaHandler::getPlayer(), &QMediaPlayer::durationChanged, this, &MainWindow::on_durationChange);
-    connect(audioDevice, &AudioDevice::finishedPlaying, Server::getInstance(), &Server::sendNextChunk);
+
+    //Periodically prints stream reception and repair statistics
+    statsTimer = new QTimer(this);
+    connect(statsTimer, &QTimer::timeout, this, &MainWindow::printStreamStatistics);
+    statsTimer->start(STATS_INTERVAL_MS);
+
+    //Keeps the media controls on the stream page in step with the channel
+    positionTimer = new QTimer(this);
+    connect(positionTimer, &QTimer::timeout, this, &MainWindow::showStreamPosition);
+    positionTimer->start(POSITION_INTERVAL_MS);
 
 }
 
@@ -28,7 +39,7 @@ MainWindow::~MainWindow() {
 --
 -- DATE:		April 8, 2020
 --
--- REVISIONS:   NA
+-- REVISIONS:   October 19, 2026 - Show the media controls for the stream - agent
 --
 -- DESIGNER: 	Nicole Jingco
 --
@@ -40,11 +51,11 @@ MainWindow::~MainWindow() {
 --
 -- NOTES:
 --
---  Changes the UI to the Server Stream UI
+--  Changes the UI to the Server Stream UI. The media controls there pause, seek and skip the stream.
 -------------------------------------------------------------------------------------------------------------------*/
 void MainWindow::on_menu_svr_stream_triggered() {
     ui->widgets->setCurrentIndex(1);
-    ui->frame->setVisible(false);
+    ui->frame->setVisible(true);
 }
 
 /*-----------------------------------------------------------------------------------------------------------------
@@ -240,7 +251,7 @@ void MainWindow::on_media_btn_vol_clicked() {
 --
 -- DATE:		April 8, 2020
 --
--- REVISIONS:   NA
+-- REVISIONS:   October 19, 2026 - Pause and resume the stream on the stream page - agent
 --
 -- DESIGNER: 	Nicole Jingco
 --
@@ -252,9 +263,23 @@ void MainWindow::on_media_btn_vol_clicked() {
 --
 -- NOTES:
 --
--- Plays the file
+-- Plays the file, or on the Server Stream page pauses or resumes the channel for every listener
 -------------------------------------------------------------------------------------------------------------------*/
 void MainWindow::on_media_btn_play_clicked() {
+    if (controlsStream()) {
+        uint32_t position, length;
+        bool paused;
+        int channel = Server::getInstance()->streamChannel;
+        if (ChannelManager::getInstance()->getChannelPosition(channel, position, length, paused)) {
+            if (paused) {
+                ChannelManager::getInstance()->resumeChannel(channel);
+            } else {
+                ChannelManager::getInstance()->pauseChannel(channel);
+            }
+            ui->media_btn_play->setIcon(QIcon(paused ? ":/icons/pause.png" : ":/icons/play.png"));
+        }
+        return;
+    }
     if (audio_file != NULL) {
         if (isPlaying) {
             isPlaying = false;
@@ -275,7 +300,7 @@ void MainWindow::on_media_btn_play_clicked() {
 --
 -- DATE:		April 8, 2020
 --
--- REVISIONS:   NA
+-- REVISIONS:   October 19, 2026 - Pause the stream and go back to the start on the stream page - agent
 --
 -- DESIGNER: 	Nicole Jingco
 --
@@ -287,9 +312,16 @@ void MainWindow::on_media_btn_play_clicked() {
 --
 -- NOTES:
 --
--- Stops the audio player
+-- Stops the audio player. A channel keeps its listeners when stopped, so it is paused at the start of the track.
 -------------------------------------------------------------------------------------------------------------------*/
 void MainWindow::on_media_btn_stop_clicked() {
+    if (controlsStream()) {
+        int channel = Server::getInstance()->streamChannel;
+        ChannelManager::getInstance()->pauseChannel(channel);
+        ChannelManager::getInstance()->seekChannel(channel, 0);
+        ui->media_btn_play->setIcon(QIcon(":/icons/play.png"));
+        return;
+    }
     isPlaying = false;
     MediaHandler::getPlayer()->stop();
     ui->media_btn_play->setIcon(QIcon(":/icons/play.png"));
@@ -300,7 +332,7 @@ void MainWindow::on_media_btn_stop_clicked() {
 --
 -- DATE:		April 8, 2020
 --
--- REVISIONS:   NA
+-- REVISIONS:   October 19, 2026 - Seek the stream on the stream page - agent
 --
 -- DESIGNER: 	Nicole Jingco
 --
@@ -315,15 +347,74 @@ void MainWindow::on_media_btn_stop_clicked() {
 -- change the position by
 -------------------------------------------------------------------------------------------------------------------*/
 void MainWindow::on_media_slider_progress_sliderMoved(int position) {
+    if (controlsStream()) {
+        ChannelManager::getInstance()->seekChannel(Server::getInstance()->streamChannel, (uint32_t)position);
+        return;
+    }
     MediaHandler::getPlayer()->setPosition(position);
 }
 
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:    on_media_btn_rewind_clicked
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:   NA
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:   NA
+--
+-- RETURNS:     void
+--
+-- NOTES:
+--
+-- Jumps SKIP_MS back in the stream, or in the file on the other pages
+-------------------------------------------------------------------------------------------------------------------*/
+void MainWindow::on_media_btn_rewind_clicked() {
+    if (controlsStream()) {
+        ChannelManager::getInstance()->skipChannel(Server::getInstance()->streamChannel, -SKIP_MS);
+        return;
+    }
+    qint64 position = MediaHandler::getPlayer()->position() - SKIP_MS;
+    MediaHandler::getPlayer()->setPosition(position < 0 ? 0 : position);
+}
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:    on_media_btn_forward_clicked
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:   NA
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:   NA
+--
+-- RETURNS:     void
+--
+-- NOTES:
+--
+-- Jumps SKIP_MS forward in the stream, or in the file on the other pages
+-------------------------------------------------------------------------------------------------------------------*/
+void MainWindow::on_media_btn_forward_clicked() {
+    if (controlsStream()) {
+        ChannelManager::getInstance()->skipChannel(Server::getInstance()->streamChannel, SKIP_MS);
+        return;
+    }
+    MediaHandler::getPlayer()->setPosition(MediaHandler::getPlayer()->position() + SKIP_MS);
+}
+
 /*-----------------------------------------------------------------------------------------------------------------
 -- Function:    on_durationChange
 --
 -- DATE:		April 8, 2020
 --
--- REVISIONS:   NA
+-- REVISIONS:   October 19, 2026 - Leave the slider to the stream on the stream page - agent
 --
 -- DESIGNER: 	Nicole Jingco
 --
@@ -338,6 +429,9 @@ void MainWindow::on_media_slider_progress_sliderMoved(int position) {
 --  Audio time
 -------------------------------------------------------------------------------------------------------------------*/
 void MainWindow::on_durationChange(qint64 position) {
+    if (controlsStream()) {
+        return;
+    }
     ui->media_slider_progress->setMaximum(position);
 }
 
@@ -346,7 +440,7 @@ void MainWindow::on_durationChange(qint64 position) {
 --
 -- DATE:		April 8, 2020
 --
--- REVISIONS:   NA
+-- REVISIONS:   October 19, 2026 - Leave the slider to the stream on the stream page - agent
 --
 -- DESIGNER: 	Nicole Jingco
 --
@@ -361,6 +455,9 @@ void MainWindow::on_durationChange(qint64 position) {
 -- Moves player slider to the audio file position
 -------------------------------------------------------------------------------------------------------------------*/
 void MainWindow::on_progressChange(qint64 position) {
+    if (controlsStream()) {
+        return;
+    }
     ui->media_slider_progress->setValue(position);
 }
 
@@ -448,7 +545,7 @@ void MainWindow::on_svr_files_btn_start_clicked() {
 --
 -- DATE:		March 22, 2020
 --
--- REVISIONS:
+-- REVISIONS:   October 19, 2026 - Each click starts another channel - agent
 --
 -- DESIGNER: 	Ellaine Chan
 --
@@ -459,7 +556,8 @@ void MainWindow::on_svr_files_btn_start_clicked() {
 -- RETURNS:     void
 --
 -- NOTES:
---              Starts the server to stream the selected audio file through multicast
+--              Starts the server to stream the selected audio file through multicast. Selecting another file
+--              and port and clicking again starts another channel alongside the running ones.
 --
 -------------------------------------------------------------------------------------------------------------------*/
 void MainWindow::on_svr_stream_btn_start_clicked() {
@@ -468,7 +566,6 @@ void MainWindow::on_svr_stream_btn_start_clicked() {
         qDebug() << "Unable to parse port";
     } else {
         Server::getInstance()->port = port;
-        Server::getInstance()->setAudioPlayer(audioDevice);
         Server::getInstance()->startServer(ConnectionDevice::protocol::UDP);
     }
 }
@@ -544,11 +641,18 @@ void MainWindow::on_clnt_files_input_btn_browse_clicked() {
 //! Streaming ----------------------------------------------------------------------------------------------------------
 
 void MainWindow::on_svr_stream_btn_audio_file_clicked() {
-    audio_file = QFileDialog::getOpenFileName(this, "Open a file", "directoryToOpen",
-                 "Audio Files (*.mp3 *.wav)");
-    ui->svr_stream_input_audio_file->setText(audio_file);
+    QStringList files = QFileDialog::getOpenFileNames(this, "Open files", "directoryToOpen",
+                        "Audio Files (*.mp3 *.flac *.wav)");
+    if (files.isEmpty()) {
+        return;
+    }
+    audio_file = files.first();
+    ui->svr_stream_input_audio_file->setText(files.join("; "));
     ui->media_lab_txt_curr_song->setText(audio_file);
-    Server::getInstance()->streamFileName = audio_file.toLocal8Bit().constData();
+    Server::getInstance()->streamPlaylist.clear();
+    for (const QString &file : files) {
+        Server::getInstance()->streamPlaylist.push_back(file.toLocal8Bit().constData());
+    }
     MediaHandler::getPlayer()->setMedia(QUrl::fromLocalFile(audio_file));
     //audioDevice->playFile(audio_file); //testing - can remove later
 }
@@ -562,6 +666,143 @@ void MainWindow::on_clnt_stream_btn_start_clicked() {
     Client::getInstance()->joinStream();
 }
 
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	printStreamStatistics
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:   October 19, 2026 - Print the pacing and per channel statistics of every station - agent
+--              October 19, 2026 - Print the delay of a call being received - agent
+--              October 19, 2026 - Take the call statistics from the CallSession - agent
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	void printStreamStatistics()
+--
+-- RETURNS:     void
+--
+-- NOTES:
+--              Called every STATS_INTERVAL_MS. Prints the server's channel statistics to the stream page and the
+--              client's reception statistics to the client activity box while a stream is running. The statistics
+--              of a call go to the client activity box too.
+--
+-------------------------------------------------------------------------------------------------------------------*/
+void MainWindow::printStreamStatistics() {
+    if (ChannelManager::getInstance()->getChannelCount() > 0) {
+        ui->svr_stream_box_clnt_info->append(ChannelManager::getInstance()->getStatistics());
+    }
+    if (Client::getInstance()->streamReceiver != nullptr) {
+        printTCPClientMessage(Client::getInstance()->getStreamStatistics());
+    }
+    if (callSession != nullptr) {
+        printTCPClientMessage(callSession->getStatistics());
+    }
+}
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	showStreamTrack
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	void showStreamTrack(QString title)
+--                                   title - title of the track the client is now playing
+--
+-- RETURNS:     void
+--
+-- NOTES:
+--              Called when the stream reaches a new track of the server's playlist.
+--
+-------------------------------------------------------------------------------------------------------------------*/
+void MainWindow::showStreamTrack(QString title) {
+    ui->clnt_stream_txt_song->setText(title);
+}
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	showStreamPosition
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	void showStreamPosition()
+--
+-- RETURNS:     void
+--
+-- NOTES:
+--              Called every POSITION_INTERVAL_MS. On the Server Stream page, moves the slider and the times to
+--              where the channel is in its track, unless the slider is being dragged.
+--
+-------------------------------------------------------------------------------------------------------------------*/
+void MainWindow::showStreamPosition() {
+    uint32_t position, length;
+    bool paused;
+    if (!controlsStream() || !ChannelManager::getInstance()->getChannelPosition(Server::getInstance()->streamChannel,
+                                                                                   position, length, paused)) {
+        return;
+    }
+    ui->media_slider_progress->setMaximum((int)length);
+    if (!ui->media_slider_progress->isSliderDown()) {
+        ui->media_slider_progress->setValue((int)position);
+    }
+    ui->media_lab_txt_curr->setText(formatTime(position));
+    ui->meida_lab_txt_length->setText(formatTime(length));
+    ui->media_btn_play->setIcon(QIcon(paused ? ":/icons/play.png" : ":/icons/pause.png"));
+}
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	controlsStream
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	bool controlsStream() const
+--
+-- RETURNS:     Returns true if the media controls work on the stream rather than the file player
+--
+-------------------------------------------------------------------------------------------------------------------*/
+bool MainWindow::controlsStream() const {
+    return ui->widgets->currentIndex() == 1 && Server::getInstance()->streamChannel >= 0;
+}
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	formatTime
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	static QString formatTime(qint64 ms)
+--                                        ms - a time in milliseconds
+--
+-- RETURNS:     Returns the time as minutes and seconds, the way the media labels show it
+--
+-------------------------------------------------------------------------------------------------------------------*/
+QString MainWindow::formatTime(qint64 ms) {
+    qint64 seconds = ms / 1000;
+    return QString("%1:%2").arg(seconds / 60, 2, 10, QChar('0')).arg(seconds % 60, 2, 10, QChar('0'));
+}
+
 //! Two Way Mic ---------------------------------------------------------------------------------------------------------
 
 /*-----------------------------------------------------------------------------------------------------------------
@@ -569,7 +810,8 @@ void MainWindow::on_clnt_stream_btn_start_clicked() {
 --
 -- DATE:		April 8, 2020
 --
--- REVISIONS:   NA
+-- REVISIONS:   October 19, 2026 - Wait for a caller with a CallSession - agent
+--              October 19, 2026 - Play the call through its own AudioDevice - agent
 --
 -- DESIGNER: 	Nicole Jingco
 --
@@ -581,24 +823,24 @@ void MainWindow::on_clnt_stream_btn_start_clicked() {
 --
 -- NOTES:
 --
--- Allows the user to receive calls with the port specified by the user
+-- Allows the user to receive calls with the port specified by the user. The first caller to reach the port is
+-- answered on the same port, and pressing it again ends the call.
 -------------------------------------------------------------------------------------------------------------------*/
 void MainWindow::on_clnt_voice_btn_accept_call_clicked() {
-    if (!Server::getInstance()->isReceiving)
-    {
-        Server::getInstance()->audioDevice = audioDevice;
-        Server::getInstance()->port = ui->clnt_voice_txt_your_port->text().toInt();
-        Server::getInstance()->isReceiving= true;
-        Server::getInstance()->startServer(ConnectionDevice::protocol::UDP_CALL);
-        ui->clnt_voice_btn_accept_call->setText("Block Calls");
-
+    if (callSession != nullptr) {
+        endCall();
+        return;
     }
-    else
-    {
-        Server::getInstance()->isReceiving= false;
-        ui->clnt_voice_btn_accept_call->setText("Accept Calls");
-
+    callSession = new CallSession(callDevice, (u_short)ui->clnt_voice_txt_your_port->text().toInt());
+    connect(callSession, &CallSession::ended, this, &MainWindow::callEnded);
+    if (!callSession->start(nullptr, 0)) {
+        delete callSession;
+        callSession = nullptr;
+        printTCPClientMessage("Could not wait for calls on that port");
+        return;
     }
+    ui->clnt_voice_btn_accept_call->setText("Block Calls");
+    ui->clnt_voice_btn_call->setText("Hangup");
 }
 
 /*-----------------------------------------------------------------------------------------------------------------
@@ -606,7 +848,8 @@ void MainWindow::on_clnt_voice_btn_accept_call_clicked() {
 --
 -- DATE:		April 8, 2020
 --
--- REVISIONS:
+-- REVISIONS:   October 19, 2026 - Call from the same port calls are accepted on with a CallSession - agent
+--              October 19, 2026 - Play the call through its own AudioDevice - agent
 --
 -- DESIGNER: 	Nicole Jingco
 --
@@ -617,25 +860,80 @@ void MainWindow::on_clnt_voice_btn_accept_call_clicked() {
 -- RETURNS:     void
 --
 -- NOTES:
---  Connects user to the other client using the port and ip the user inputs
+--  Connects user to the other client using the port and ip the user inputs. The call is sent and heard on the
+--  user's own port, so the other client only needs to accept calls.
 -------------------------------------------------------------------------------------------------------------------*/
 void MainWindow::on_clnt_voice_btn_call_clicked() {
-    if (isConnected) {
-        isConnected = false;
-        Client::getInstance()->isConnected = false;
-        ui->clnt_voice_btn_call->setText("Call");
-
-    } else {
-        ui->clnt_voice_btn_call->setText("Hangup");
+    if (callSession != nullptr) {
+        endCall();
+        return;
+    }
+    string ip = ui->clnt_voice_txt_ip->text().toStdString();
+    int port = ui->clnt_voice_txt_port->text().toInt();
+
+    callSession = new CallSession(callDevice, (u_short)ui->clnt_voice_txt_your_port->text().toInt());
+    connect(callSession, &CallSession::ended, this, &MainWindow::callEnded);
+    if (!callSession->start(ip.c_str(), (u_short)port)) {
+        delete callSession;
+        callSession = nullptr;
+        printTCPClientMessage("Could not start the call");
+        return;
+    }
+    ui->clnt_voice_btn_call->setText("Hangup");
+    ui->clnt_voice_btn_accept_call->setText("Block Calls");
+}
 
-        string ip = ui->clnt_voice_txt_ip->text().toStdString();
-        int port = ui->clnt_voice_txt_port->text().toInt();
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:    endCall
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:   October 19, 2026 - Leave the session to callEnded - agent
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:   void endCall()
+--
+-- RETURNS:     void
+--
+-- NOTES:
+--
+-- Hangs up the call or stops waiting for one. The session finishes on its own thread and callEnded cleans up
+-- once it has.
+-------------------------------------------------------------------------------------------------------------------*/
+void MainWindow::endCall() {
+    callSession->hangUp();
+}
 
-        Client::getInstance()->clientMicrophone = audioDevice;
-        Client::getInstance()->ip = ip;
-        Client::getInstance()->port = port;
-        Client::getInstance()->isConnected = true;
-        isConnected = true;
-        Client::getInstance()->connectCall();
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:    callEnded
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:   NA
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:   void callEnded()
+--
+-- RETURNS:     void
+--
+-- NOTES:
+--
+-- Called through a queued connection when the call's thread has finished, because it was hung up or its wait
+-- failed. Prints the call's last statistics and deletes the session.
+-------------------------------------------------------------------------------------------------------------------*/
+void MainWindow::callEnded() {
+    if (callSession == nullptr) {
+        return;
     }
+    printTCPClientMessage(callSession->getStatistics());
+    delete callSession;
+    callSession = nullptr;
+    ui->clnt_voice_btn_call->setText("Call");
+    ui->clnt_voice_btn_accept_call->setText("Accept Calls");
 }
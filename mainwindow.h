@@ -4,10 +4,16 @@
 #include <QDebug>
 #include <QFileDialog>
 #include <QFileInfo>
+#include <QTimer>
 #include "server.h"
 #include "client.h"
 #include "mediahandler.h"
 #include "audiodevice.h"
+#include "callsession.h"
+
+#define STATS_INTERVAL_MS 5000
+#define POSITION_INTERVAL_MS 500
+#define SKIP_MS 10000
 
 namespace Ui {
 class MainWindow;
@@ -36,6 +42,8 @@ private slots:
     //! Media Control
     void on_media_btn_play_clicked();
     void on_media_btn_stop_clicked();
+    void on_media_btn_rewind_clicked();
+    void on_media_btn_forward_clicked();
     void on_media_slider_progress_sliderMoved(int position);
     void on_durationChange(qint64 position);
     void on_progressChange(qint64 position);
@@ -50,10 +58,15 @@ private slots:
     void on_svr_stream_btn_audio_file_clicked();
     void on_svr_stream_btn_start_clicked();
     void on_clnt_stream_btn_start_clicked();
+    void printStreamStatistics();
+    void showStreamTrack(QString title);
+    void showStreamPosition();
 
     //! Mic
     void on_clnt_voice_btn_call_clicked();
     void on_clnt_voice_btn_accept_call_clicked();
+    void endCall();
+    void callEnded();
 
     void on_clnt_files_input_btn_browse_clicked();
 
@@ -62,8 +75,14 @@ private:
     QMediaPlayer *player;
     bool isPlaying = false;
     bool isRecording = false;
-    bool isConnected = false;
+    CallSession *callSession = nullptr;
     QString audio_file;
     AudioDevice *audioDevice;
+    AudioDevice *callDevice;
     QFile sourceFile;
+    QTimer *statsTimer;
+    QTimer *positionTimer;
+
+    bool controlsStream() const;
+    static QString formatTime(qint64 ms);
 };
@@ -0,0 +1,291 @@
+/*------------------------------------------------------------------------------------------------------------------
+-- SOURCE FILE: 	nackscheduler.cpp - Decides when a multicast listener asks the server to repair lost packets.
+--
+--
+-- PROGRAM: 		Communication Audio Program
+--
+-- FUNCTIONS:
+--                  NackScheduler(uint32_t seed)
+--                  void onMissing(uint32_t sequence, uint32_t now)
+--                  void onReceived(uint32_t sequence)
+--                  void onDeadline(uint32_t sequence)
+--                  bool wasRequested(uint32_t sequence)
+--                  int collectDue(uint32_t now, uint32_t *sequences, int max)
+--                  void reset()
+--
+-- DATE: 			October 19, 2026
+--
+-- REVISIONS:       October 19, 2026 - Tell repairs apart from join bursts - agent
+--
+-- DESIGNER: 		agent
+--
+-- PROGRAMMER: 		agent
+--
+-- NOTES:
+--      A gap in the sequence numbers is not NACKed straight away. Each missing packet waits NACK_DELAY_MS plus a
+--      random jitter first, which gives FEC a chance to rebuild it and lets a repair that the server multicast
+--      for another listener cancel ours. When a burst of loss hits every listener at once the NACKs are spread
+--      out instead of arriving at the server together, and every sequence number that is due at the same time
+--      goes out in one NACK datagram.
+--
+--      Times are millisecond ticks supplied by the caller.
+--
+--------------------------------------------------------------------------------------------------------------------*/
+#include "nackscheduler.h"
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	NackScheduler
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	NackScheduler(uint32_t seed)
+--                            seed - seed for the jitter, should differ between listeners
+--
+-- RETURNS:     NA
+--
+-------------------------------------------------------------------------------------------------------------------*/
+NackScheduler::NackScheduler(uint32_t seed) : random(seed | 1) {
+    reset();
+}
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	reset
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	void reset()
+--
+-- RETURNS:     void
+--
+-- NOTES:
+--              Forgets every pending request.
+--
+-------------------------------------------------------------------------------------------------------------------*/
+void NackScheduler::reset() {
+    for (int i = 0; i < NACK_MAX_PENDING; i++) {
+        pending[i].active = false;
+    }
+}
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	nextDelay
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	uint32_t nextDelay(uint32_t base)
+--                                 base - minimum delay in milliseconds
+--
+-- RETURNS:     Returns base plus a random jitter of up to NACK_JITTER_MS
+--
+-------------------------------------------------------------------------------------------------------------------*/
+uint32_t NackScheduler::nextDelay(uint32_t base) {
+    random ^= random << 13;
+    random ^= random >> 17;
+    random ^= random << 5;
+    return base + random % (NACK_JITTER_MS + 1);
+}
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	find
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	Pending *find(uint32_t sequence)
+--                            sequence - sequence number to look up
+--
+-- RETURNS:     Returns the pending request for the sequence number or nullptr
+--
+-------------------------------------------------------------------------------------------------------------------*/
+NackScheduler::Pending *NackScheduler::find(uint32_t sequence) {
+    Pending &entry = pending[sequence % NACK_MAX_PENDING];
+    if (entry.active && entry.sequence == sequence) {
+        return &entry;
+    }
+    return nullptr;
+}
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	onMissing
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	void onMissing(uint32_t sequence, uint32_t now)
+--                             sequence - sequence number found missing
+--                             now - current tick in milliseconds
+--
+-- RETURNS:     void
+--
+-- NOTES:
+--              Schedules a NACK for the packet after the suppression delay.
+--
+-------------------------------------------------------------------------------------------------------------------*/
+void NackScheduler::onMissing(uint32_t sequence, uint32_t now) {
+    Pending &entry = pending[sequence % NACK_MAX_PENDING];
+    if (entry.active && entry.sequence == sequence) {
+        return;
+    }
+    entry.sequence = sequence;
+    entry.due = now + nextDelay(NACK_DELAY_MS);
+    entry.attempts = 0;
+    entry.active = true;
+}
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	onReceived
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	void onReceived(uint32_t sequence)
+--                              sequence - sequence number that arrived or was rebuilt
+--
+-- RETURNS:     void
+--
+-- NOTES:
+--              Cancels the pending NACK. A packet that shows up before its NACK was ever sent counts as suppressed.
+--
+-------------------------------------------------------------------------------------------------------------------*/
+void NackScheduler::onReceived(uint32_t sequence) {
+    Pending *entry = find(sequence);
+    if (entry == nullptr) {
+        return;
+    }
+    if (entry->attempts == 0) {
+        stats.suppressed++;
+    }
+    entry->active = false;
+}
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	onDeadline
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	void onDeadline(uint32_t sequence)
+--                              sequence - sequence number whose playout deadline has passed
+--
+-- RETURNS:     void
+--
+-- NOTES:
+--              A repair can no longer help once the packet's turn to play has gone by, so stop asking for it.
+--
+-------------------------------------------------------------------------------------------------------------------*/
+void NackScheduler::onDeadline(uint32_t sequence) {
+    Pending *entry = find(sequence);
+    if (entry != nullptr) {
+        entry->active = false;
+        stats.expired++;
+    }
+}
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	wasRequested
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	bool wasRequested(uint32_t sequence)
+--                                sequence - sequence number of a packet that arrived on the repair socket
+--
+-- RETURNS:     Returns true if a NACK was sent for the packet and it has not arrived yet
+--
+-------------------------------------------------------------------------------------------------------------------*/
+bool NackScheduler::wasRequested(uint32_t sequence) {
+    Pending *entry = find(sequence);
+    return entry != nullptr && entry->attempts > 0;
+}
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	collectDue
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	int collectDue(uint32_t now, uint32_t *sequences, int max)
+--                             now - current tick in milliseconds
+--                             sequences - filled in with the sequence numbers to NACK
+--                             max - capacity of sequences
+--
+-- RETURNS:     Returns the number of sequence numbers to put in one NACK, 0 if nothing is due
+--
+-- NOTES:
+--              Each returned request is rescheduled NACK_RETRY_MS later in case the NACK or the repair is lost,
+--              up to NACK_MAX_ATTEMPTS times.
+--
+-------------------------------------------------------------------------------------------------------------------*/
+int NackScheduler::collectDue(uint32_t now, uint32_t *sequences, int max) {
+    int count = 0;
+    for (int i = 0; i < NACK_MAX_PENDING && count < max; i++) {
+        Pending &entry = pending[i];
+        if (!entry.active || (int32_t)(now - entry.due) < 0) {
+            continue;
+        }
+        if (entry.attempts >= NACK_MAX_ATTEMPTS) {
+            entry.active = false;
+            stats.expired++;
+            continue;
+        }
+        sequences[count++] = entry.sequence;
+        if (entry.attempts == 0) {
+            stats.packetsRequested++;
+        }
+        entry.attempts++;
+        entry.due = now + nextDelay(NACK_RETRY_MS);
+    }
+    if (count > 0) {
+        stats.nacksSent++;
+        stats.sequencesRequested += count;
+    }
+    return count;
+}
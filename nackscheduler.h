@@ -0,0 +1,47 @@
+#pragma once
+#include <cstdint>
+#include "streampacket.h"
+
+#define NACK_DELAY_MS 20
+#define NACK_JITTER_MS 30
+#define NACK_RETRY_MS 80
+#define NACK_MAX_ATTEMPTS 3
+#define NACK_MAX_PENDING 128
+#define NACK_POLL_MS 10
+
+class NackScheduler {
+public:
+    struct Statistics {
+        uint32_t nacksSent = 0;
+        uint32_t sequencesRequested = 0;
+        uint32_t packetsRequested = 0;
+        uint32_t suppressed = 0;
+        uint32_t expired = 0;
+    };
+
+    NackScheduler(uint32_t seed);
+    void onMissing(uint32_t sequence, uint32_t now);
+    void onReceived(uint32_t sequence);
+    void onDeadline(uint32_t sequence);
+    bool wasRequested(uint32_t sequence);
+    int collectDue(uint32_t now, uint32_t *sequences, int max);
+    void reset();
+    const Statistics &getStatistics() const {
+        return stats;
+    }
+
+private:
+    struct Pending {
+        uint32_t sequence;
+        uint32_t due;
+        int attempts;
+        bool active;
+    };
+
+    Pending pending[NACK_MAX_PENDING];
+    uint32_t random;
+    Statistics stats;
+
+    uint32_t nextDelay(uint32_t base);
+    Pending *find(uint32_t sequence);
+};
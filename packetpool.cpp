@@ -0,0 +1,174 @@
+/*------------------------------------------------------------------------------------------------------------------
+-- SOURCE FILE: 	packetpool.cpp - Datagram buffers shared by every stream channel.
+--
+--
+-- PROGRAM: 		Communication Audio Program
+--
+-- FUNCTIONS:
+--                  PacketPool(int count)
+--                  ~PacketPool()
+--                  void grow(int count)
+--                  PooledPacket *acquire(const void *owner, uint32_t sequence)
+--                  void release(PooledPacket *packet)
+--
+-- DATE: 			October 19, 2026
+--
+-- REVISIONS:       October 19, 2026 - Grow with the channels and take back an unused packet - agent
+--
+-- DESIGNER: 		agent
+--
+-- PROGRAMMER: 		agent
+--
+-- NOTES:
+--      Every stream datagram is built in a packet taken from the pool and stays there so the repair channel can
+--      resend it. The pool hands packets out in a circle, so the packet given out is always the oldest one and
+--      the pool holds the most recent datagrams of all channels together. The pool grows as channels are added
+--      so that it holds a full retransmission ring for each of them, and a channel that sends more than the
+--      others keeps more history. Packets are allocated in blocks that are never moved, since the rings point
+--      into them.
+--
+--      A packet remembers which retransmission buffer and sequence number it was last given to, so a buffer can
+--      tell when one of its packets has been reused by someone else.
+--
+--      The pool is only used from the ChannelManager pacing thread so it does no locking.
+--
+--------------------------------------------------------------------------------------------------------------------*/
+#include "packetpool.h"
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	PacketPool
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:   October 19, 2026 - Allocate the first block - agent
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	PacketPool(int count)
+--                         count - number of datagram buffers to allocate, and the size of each block it grows by
+--
+-- RETURNS:     NA
+--
+-------------------------------------------------------------------------------------------------------------------*/
+PacketPool::PacketPool(int count) : blockSize(count > 0 ? count : 1) {
+    grow(blockSize);
+}
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	~PacketPool
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:   October 19, 2026 - Free every block - agent
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	~PacketPool()
+--
+-- RETURNS:     NA
+--
+-------------------------------------------------------------------------------------------------------------------*/
+PacketPool::~PacketPool() {
+    for (PooledPacket *block : blocks) {
+        delete[] block;
+    }
+}
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	grow
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	void grow(int count)
+--                        count - number of datagram buffers the pool should hold at least
+--
+-- RETURNS:     void
+--
+-- NOTES:
+--              Adds whole blocks. The new packets are handed out once the circle reaches them, so the history
+--              already kept is not disturbed.
+--
+-------------------------------------------------------------------------------------------------------------------*/
+void PacketPool::grow(int count) {
+    while (this->count < count) {
+        PooledPacket *block = new PooledPacket[blockSize];
+        for (int i = 0; i < blockSize; i++) {
+            block[i].owner = nullptr;
+            block[i].sequence = 0;
+            block[i].bytes = 0;
+        }
+        blocks.push_back(block);
+        this->count += blockSize;
+    }
+}
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	acquire
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:   October 19, 2026 - Hand out packets across the blocks - agent
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	PooledPacket *acquire(const void *owner, uint32_t sequence)
+--                                    owner - retransmission buffer the packet is given to
+--                                    sequence - sequence number of the datagram that will be built in it
+--
+-- RETURNS:     Returns the oldest packet in the pool
+--
+-- NOTES:
+--              Whatever the packet held before is gone, which its previous owner notices through holds().
+--
+-------------------------------------------------------------------------------------------------------------------*/
+PooledPacket *PacketPool::acquire(const void *owner, uint32_t sequence) {
+    PooledPacket *packet = &blocks[next / blockSize][next % blockSize];
+    next = (next + 1) % count;
+    packet->owner = owner;
+    packet->sequence = sequence;
+    packet->bytes = 0;
+    return packet;
+}
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	release
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	void release(PooledPacket *packet)
+--                           packet - packet that was acquired but not used
+--
+-- RETURNS:     void
+--
+-- NOTES:
+--              When the packet is the one handed out last it is given back, so the next acquire returns it
+--              again and no other datagram is pushed out of the pool for nothing. Any other packet is only
+--              disowned.
+--
+-------------------------------------------------------------------------------------------------------------------*/
+void PacketPool::release(PooledPacket *packet) {
+    int last = (next + count - 1) % count;
+    packet->owner = nullptr;
+    packet->bytes = 0;
+    if (packet == &blocks[last / blockSize][last % blockSize]) {
+        next = last;
+    }
+}
@@ -0,0 +1,36 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include "streampacket.h"
+
+struct PooledPacket
+{
+    const void *owner;
+    uint32_t sequence;
+    int bytes;
+    char datagram[DATA_BUFSIZE];
+};
+
+class PacketPool {
+public:
+    PacketPool(int count);
+    ~PacketPool();
+    PacketPool(const PacketPool&) = delete;
+    void operator=(const PacketPool&) = delete;
+
+    void grow(int count);
+    PooledPacket *acquire(const void *owner, uint32_t sequence);
+    void release(PooledPacket *packet);
+    bool holds(const PooledPacket *packet, const void *owner, uint32_t sequence) const {
+        return packet != nullptr && packet->owner == owner && packet->sequence == sequence;
+    }
+    int size() const {
+        return count;
+    }
+
+private:
+    std::vector<PooledPacket *> blocks;
+    int blockSize;
+    int count = 0;
+    int next = 0;
+};
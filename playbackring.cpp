@@ -0,0 +1,337 @@
+/*------------------------------------------------------------------------------------------------------------------
+-- SOURCE FILE: 	playbackring.cpp - Hands received audio to the player through memory.
+--
+--
+-- PROGRAM: 		Communication Audio Program
+--
+-- FUNCTIONS:
+--                  PlaybackRing()
+--                  ~PlaybackRing()
+--                  bool push(const char *data, int bytes)
+--                  void setFormat(const StreamDescriptor &format)
+--                  void clear()
+--                  Statistics getStatistics() const
+--                  QString describe() const
+--                  qint64 readData(char *data, qint64 maxSize)
+--                  qint64 writeData(const char *data, qint64 maxSize)
+--                  void fillSilence(char *data, qint64 bytes) const
+--
+-- DATE: 			October 19, 2026
+--
+-- REVISIONS:       October 19, 2026 - Let more than one thread push - agent
+--                  October 19, 2026 - Back to one writer, calls play through an AudioDevice of their own - agent
+--
+-- DESIGNER: 		agent
+--
+-- PROGRAMMER: 		agent
+--
+-- NOTES:
+--      The network threads used to write each packet's audio straight into the QIODevice of a player started in
+--      push mode. That device belongs to the thread that owns the AudioDevice, so the write raced with the
+--      player, and once the player's small buffer was full the rest of the packet was thrown away. The player
+--      is now started in pull mode on a PlaybackRing. The network thread pushes audio into the ring, and the
+--      player reads it back out on its own thread whenever it wants more.
+--
+--      It is the CaptureRing the other way round. There is exactly one writer and one reader, so the ring
+--      needs no lock and neither side ever waits. The stream and a call each play through an AudioDevice of
+--      their own, so each ring is only written by one thread, and the system mixes the two players. Each side
+--      only moves its own running count of bytes, written or taken, and reads the other's. The writer
+--      publishes its count after the audio is copied in, so the reader never sees bytes that are not there yet. Each count sits on a cache line of its own with the counters only its side
+--      touches, so the two threads do not keep taking the line from each other. Pushing copies into memory
+--      allocated once, so nothing is allocated per packet.
+--
+--      A push that does not fit is dropped whole and counted as an overrun, so the samples stay aligned. When
+--      the player asks for more than the ring holds, the rest is filled with silence rather than letting the
+--      player go idle, and if audio had been playing that counts as an underrun. The reader clears the ring
+--      when the player is flushed or changes format.
+--
+--------------------------------------------------------------------------------------------------------------------*/
+#include "playbackring.h"
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	PlaybackRing
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	PlaybackRing()
+--
+-- RETURNS:     NA
+--
+-- NOTES:
+--              The ring is PLAYBACK_RING_BYTES, a power of two so the running counts can wrap around freely.
+--
+-------------------------------------------------------------------------------------------------------------------*/
+PlaybackRing::PlaybackRing() {
+    ring = new char[ringSize];
+}
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	~PlaybackRing
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	~PlaybackRing()
+--
+-- RETURNS:     NA
+--
+-- NOTES:
+--              The player must have been stopped first.
+--
+-------------------------------------------------------------------------------------------------------------------*/
+PlaybackRing::~PlaybackRing() {
+    delete[] ring;
+}
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	push
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:   October 19, 2026 - Serialize writers with writeLock - agent
+--              October 19, 2026 - Drop writeLock again, there is one writer - agent
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	bool push(const char *data, int bytes)
+--                        data - whole frames of audio in the player's format
+--                        bytes - size of the audio
+--
+-- RETURNS:     False if the ring was too full and the audio was dropped
+--
+-- NOTES:
+--              Only called by the one writing thread. Never waits.
+--
+-------------------------------------------------------------------------------------------------------------------*/
+bool PlaybackRing::push(const char *data, int bytes) {
+    if (bytes <= 0) {
+        return true;
+    }
+    uint32_t used = (uint32_t)(written - taken);
+    if ((uint32_t)bytes > ringSize - used) {
+        overruns++;
+        overrunBytes += bytes;
+        return false;
+    }
+    uint32_t at = (uint32_t)written & (ringSize - 1);
+    uint32_t first = ringSize - at < (uint32_t)bytes ? ringSize - at : (uint32_t)bytes;
+    memcpy(ring + at, data, first);
+    memcpy(ring, data + first, bytes - first);
+    InterlockedExchangeAdd(&written, (LONG)bytes);
+    writtenTotal += bytes;
+    return true;
+}
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	setFormat
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	void setFormat(const StreamDescriptor &format)
+--                             format - format the player plays
+--
+-- RETURNS:     void
+--
+-- NOTES:
+--              Tells the ring what silence looks like. Only called while the player is stopped.
+--
+-------------------------------------------------------------------------------------------------------------------*/
+void PlaybackRing::setFormat(const StreamDescriptor &format) {
+    sampleBytes = format.sampleSize > 8 ? format.sampleSize / 8 : 1;
+    unsignedSamples = format.sampleType == SAMPLE_UNSIGNED;
+}
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	clear
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	void clear()
+--
+-- RETURNS:     void
+--
+-- NOTES:
+--              Drops everything waiting, so the next audio pushed is the next heard. Only called by the
+--              reading thread, and the silence until then is not an underrun.
+--
+-------------------------------------------------------------------------------------------------------------------*/
+void PlaybackRing::clear() {
+    InterlockedExchangeAdd(&taken, (LONG)(uint32_t)(written - taken));
+    primed = false;
+    starved = false;
+}
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	getStatistics
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	Statistics getStatistics() const
+--
+-- RETURNS:     Both sides' counters. Read from another thread, they may be a packet behind.
+--
+-------------------------------------------------------------------------------------------------------------------*/
+PlaybackRing::Statistics PlaybackRing::getStatistics() const {
+    Statistics stats;
+    stats.written = writtenTotal;
+    stats.played = played;
+    stats.overruns = overruns;
+    stats.overrunBytes = overrunBytes;
+    stats.underruns = underruns;
+    stats.silenceBytes = silenceBytes;
+    return stats;
+}
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	describe
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	QString describe() const
+--
+-- RETURNS:     The audio waiting and the underruns and overruns, as text
+--
+-------------------------------------------------------------------------------------------------------------------*/
+QString PlaybackRing::describe() const {
+    Statistics stats = getStatistics();
+    return QString("%1 bytes waiting, %2 underruns (%3 bytes of silence), %4 overruns (%5 bytes dropped)")
+            .arg((qint64)getFill())
+            .arg((qint64)stats.underruns)
+            .arg((qint64)stats.silenceBytes)
+            .arg((qint64)stats.overruns)
+            .arg((qint64)stats.overrunBytes);
+}
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	readData
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	qint64 readData(char *data, qint64 maxSize)
+--                              data - the player's buffer
+--                              maxSize - how much the player wants
+--
+-- RETURNS:     maxSize, so the player never goes idle
+--
+-- NOTES:
+--              Called by QAudioOutput on the thread that owns it.
+--
+-------------------------------------------------------------------------------------------------------------------*/
+qint64 PlaybackRing::readData(char *data, qint64 maxSize) {
+    uint32_t available = (uint32_t)(written - taken);
+    MemoryBarrier();
+    uint32_t bytes = maxSize < (qint64)available ? (uint32_t)maxSize : available;
+    uint32_t at = (uint32_t)taken & (ringSize - 1);
+    uint32_t first = ringSize - at < bytes ? ringSize - at : bytes;
+    memcpy(data, ring + at, first);
+    memcpy(data + first, ring, bytes - first);
+    InterlockedExchangeAdd(&taken, (LONG)bytes);
+    played += bytes;
+
+    if (bytes < maxSize) {
+        fillSilence(data + bytes, maxSize - bytes);
+        silenceBytes += primed ? maxSize - bytes : 0;
+        if (primed && !starved) {
+            underruns++;
+        }
+        starved = primed;
+    } else {
+        starved = false;
+    }
+    primed = primed || bytes > 0;
+    return maxSize;
+}
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	writeData
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	qint64 writeData(const char *data, qint64 maxSize)
+--
+-- RETURNS:     -1, the ring is only written with push
+--
+-------------------------------------------------------------------------------------------------------------------*/
+qint64 PlaybackRing::writeData(const char *, qint64) {
+    return -1;
+}
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	fillSilence
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	void fillSilence(char *data, qint64 bytes) const
+--                               data - where the silence goes
+--                               bytes - how much of it
+--
+-- RETURNS:     void
+--
+-- NOTES:
+--              Silence is zero, except in unsigned samples where it is the middle value: the top bit of the
+--              last, most significant byte of each little endian sample.
+--
+-------------------------------------------------------------------------------------------------------------------*/
+void PlaybackRing::fillSilence(char *data, qint64 bytes) const {
+    memset(data, 0, (size_t)bytes);
+    if (unsignedSamples) {
+        for (qint64 i = sampleBytes - 1; i < bytes; i += sampleBytes) {
+            data[i] = (char)0x80;
+        }
+    }
+}
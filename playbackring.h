@@ -0,0 +1,69 @@
+#pragma once
+#include <windows.h>
+#include <cstdint>
+#include <cstring>
+#include <QIODevice>
+#include <QString>
+#include "streampacket.h"
+
+#define PLAYBACK_RING_BYTES (1 << 17)
+#define PLAYBACK_CACHE_LINE 64
+
+class PlaybackRing : public QIODevice {
+public:
+    struct Statistics {
+        uint64_t written = 0;
+        uint64_t played = 0;
+        uint32_t overruns = 0;
+        uint64_t overrunBytes = 0;
+        uint32_t underruns = 0;
+        uint64_t silenceBytes = 0;
+    };
+
+    PlaybackRing();
+    ~PlaybackRing();
+    PlaybackRing(const PlaybackRing&) = delete;
+    void operator=(const PlaybackRing&) = delete;
+
+    bool push(const char *data, int bytes);
+    void setFormat(const StreamDescriptor &format);
+    void clear();
+    Statistics getStatistics() const;
+    QString describe() const;
+    bool isSequential() const override {
+        return true;
+    }
+    qint64 bytesAvailable() const override {
+        return getFill() + QIODevice::bytesAvailable();
+    }
+    uint32_t getFill() const {
+        return (uint32_t)(written - taken);
+    }
+
+protected:
+    qint64 readData(char *data, qint64 maxSize) override;
+    qint64 writeData(const char *data, qint64 maxSize) override;
+
+private:
+    char *ring;
+    uint32_t ringSize = PLAYBACK_RING_BYTES;
+    int sampleBytes = 2;
+    bool unsignedSamples = false;
+
+    char writerLine[PLAYBACK_CACHE_LINE];
+    volatile LONG written = 0;
+    uint64_t writtenTotal = 0;
+    uint32_t overruns = 0;
+    uint64_t overrunBytes = 0;
+
+    char readerLine[PLAYBACK_CACHE_LINE];
+    volatile LONG taken = 0;
+    uint64_t played = 0;
+    uint32_t underruns = 0;
+    uint64_t silenceBytes = 0;
+    bool primed = false;
+    bool starved = false;
+    char endLine[PLAYBACK_CACHE_LINE];
+
+    void fillSilence(char *data, qint64 bytes) const;
+};
@@ -0,0 +1,481 @@
+/*------------------------------------------------------------------------------------------------------------------
+-- SOURCE FILE: 	receivering.cpp - Keeps several overlapped reads posted on one UDP socket.
+--
+--
+-- PROGRAM: 		Communication Audio Program
+--
+-- FUNCTIONS:
+--                  ReceiveRing(SOCKET sock, int depth, ReceiveCallback handle)
+--                  ~ReceiveRing()
+--                  static int runFromArguments(int argc, char *argv[])
+--                  static QString benchmark(int depth, int burst)
+--                  int refill()
+--                  void stop()
+--                  static void completed(DWORD error, DWORD bytes, LPWSAOVERLAPPED overlapped, DWORD flags)
+--                  static QString runBenchmark(int depth, int burst)
+--                  bool post(Slot *slot)
+--                  int countFilled() const
+--
+-- DATE: 			October 19, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: 		agent
+--
+-- PROGRAMMER: 		agent
+--
+-- NOTES:
+--      The stream socket used to have one WSARecvFrom posted at a time, on one buffer. Between that read
+--      completing and the next being posted, a datagram had nowhere to go but the socket's own buffer, and a
+--      burst bigger than that buffer was dropped by the kernel while the thread was still busy with the first
+--      packet. A ReceiveRing posts depth reads at once, each with a buffer of its own, and posts each one again
+--      as soon as its datagram has been handled. A burst fills the posted buffers first, and the thread works
+--      through them in the order they completed.
+--
+--      Completion routines run on the thread that posted the reads, whenever it waits alertably, so the
+--      ring is owned by that thread: it must be refilled, stopped and deleted there. Stopping cancels the
+--      reads and waits for their routines, so no buffer is freed while the kernel may still write to it.
+--
+--      Each completion looks at how many of the other buffers have filled and are waiting too. The most seen
+--      at once says how deep the ring needs to be for the bursts the socket gets, and a count of the times
+--      every buffer was full says the ring was too shallow. --receive-bench measures the loss of a bursty
+--      sender over loopback with one read posted against a whole ring.
+--
+--------------------------------------------------------------------------------------------------------------------*/
+#include "receivering.h"
+#include <cstdlib>
+#include <cstring>
+
+struct BenchSender {
+    SOCKET sock;
+    SOCKADDR_IN to;
+    int burst;
+    volatile bool done;
+};
+
+static DWORD WINAPI sendBursts(LPVOID lpParameter) {
+    BenchSender *sender = (BenchSender *)lpParameter;
+    char datagram[1000];
+    memset(datagram, 0x55, sizeof(datagram));
+    for (int round = 0; round < RECEIVE_BENCH_ROUNDS; round++) {
+        for (int i = 0; i < sender->burst; i++) {
+            sendto(sender->sock, datagram, sizeof(datagram), 0, (struct sockaddr *)&sender->to, sizeof(sender->to));
+        }
+        Sleep(RECEIVE_BENCH_GAP_MS);
+    }
+    sender->done = true;
+    return 0;
+}
+
+static void spin(int micros) {
+    LARGE_INTEGER frequency, start, now;
+    QueryPerformanceFrequency(&frequency);
+    QueryPerformanceCounter(&start);
+    do {
+        QueryPerformanceCounter(&now);
+    } while ((now.QuadPart - start.QuadPart) * 1000000 / frequency.QuadPart < micros);
+}
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	ReceiveRing
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	ReceiveRing(SOCKET sock, int depth, ReceiveCallback handle)
+--                          sock - UDP socket to read, still owned by the caller
+--                          depth - number of reads to keep posted, 1 to RECEIVE_RING_MAX
+--                          handle - called with each datagram read, from the completion routine
+--
+-- RETURNS:     NA
+--
+-- NOTES:
+--              Nothing is posted until refill() is called.
+--
+-------------------------------------------------------------------------------------------------------------------*/
+ReceiveRing::ReceiveRing(SOCKET sock, int depth, ReceiveCallback handle) : sock(sock), handle(handle) {
+    if (depth < 1) {
+        depth = 1;
+    } else if (depth > RECEIVE_RING_MAX) {
+        depth = RECEIVE_RING_MAX;
+    }
+    this->depth = depth;
+    buffers = new Slot[depth];
+    for (int i = 0; i < depth; i++) {
+        buffers[i].ring = this;
+        buffers[i].posted = false;
+    }
+}
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	~ReceiveRing
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	~ReceiveRing()
+--
+-- RETURNS:     NA
+--
+-- NOTES:
+--              Must run on the thread that posted the reads. The buffers are kept rather than freed if a read
+--              is still outstanding after RECEIVE_RING_DRAIN_MS.
+--
+-------------------------------------------------------------------------------------------------------------------*/
+ReceiveRing::~ReceiveRing() {
+    stop();
+    for (int i = 0; i < depth; i++) {
+        if (buffers[i].posted) {
+            qDebug() << "A receive was still posted, leaking the ring's buffers";
+            return;
+        }
+    }
+    delete[] buffers;
+}
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	runFromArguments
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	static int runFromArguments(int argc, char *argv[])
+--                          argc - number of command line arguments
+--                          argv - the command line arguments
+--
+-- RETURNS:     The process exit code
+--
+-- NOTES:
+--              The form is
+--                  --receive-bench [depth] [burst]
+--              The benchmark prints its result and returns.
+--
+-------------------------------------------------------------------------------------------------------------------*/
+int ReceiveRing::runFromArguments(int argc, char *argv[]) {
+    if (strcmp(argv[1], "--receive-bench") != 0) {
+        qDebug() << "Usage: --receive-bench [depth] [burst]\n";
+        return 1;
+    }
+    int depth = argc >= 3 ? atoi(argv[2]) : RECEIVE_RING_DEPTH;
+    int burst = argc >= 4 ? atoi(argv[3]) : RECEIVE_BENCH_BURST;
+    WSADATA wsaData;
+    if (WSAStartup(0x0202, &wsaData) != 0) {
+        qDebug() << "WSAStartup failed with error \n" << WSAGetLastError();
+        return 1;
+    }
+    qDebug() << benchmark(depth > 0 ? depth : RECEIVE_RING_DEPTH, burst > 0 ? burst : RECEIVE_BENCH_BURST);
+    WSACleanup();
+    return 0;
+}
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	benchmark
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	static QString benchmark(int depth, int burst)
+--                                depth - reads to keep posted in the second run
+--                                burst - datagrams sent back to back in each burst
+--
+-- RETURNS:     A one line summary of both runs
+--
+-- NOTES:
+--              Runs the same bursts against one posted read, as the stream socket used to have, and against
+--              a ring of depth reads, so the two losses can be compared.
+--
+-------------------------------------------------------------------------------------------------------------------*/
+QString ReceiveRing::benchmark(int depth, int burst) {
+    return QString("Receive benchmark, %1 bursts of %2 datagrams, %3 us of work each: one read posted %4"
+                   " | %5 reads posted %6")
+            .arg(RECEIVE_BENCH_ROUNDS)
+            .arg(burst)
+            .arg(RECEIVE_BENCH_WORK_US)
+            .arg(runBenchmark(1, burst))
+            .arg(depth)
+            .arg(runBenchmark(depth, burst));
+}
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	refill
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	int refill()
+--
+-- RETURNS:     The number of reads posted afterwards
+--
+-- NOTES:
+--              Posts a read on every buffer that has none. Reads are posted again as they complete, so this
+--              starts the ring and afterwards only has work to do if posting failed.
+--
+-------------------------------------------------------------------------------------------------------------------*/
+int ReceiveRing::refill() {
+    int posted = 0;
+    for (int i = 0; i < depth; i++) {
+        if (!buffers[i].posted && !stopping) {
+            post(&buffers[i]);
+        }
+        posted += buffers[i].posted ? 1 : 0;
+    }
+    return posted;
+}
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	stop
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	void stop()
+--
+-- RETURNS:     void
+--
+-- NOTES:
+--              Cancels the reads and waits alertably, up to RECEIVE_RING_DRAIN_MS, for their completion
+--              routines. Datagrams that completed but were not handled yet are dropped.
+--
+-------------------------------------------------------------------------------------------------------------------*/
+void ReceiveRing::stop() {
+    stopping = true;
+    CancelIo((HANDLE)sock);
+    DWORD startedAt = GetTickCount();
+    while (GetTickCount() - startedAt < RECEIVE_RING_DRAIN_MS) {
+        bool outstanding = false;
+        for (int i = 0; i < depth; i++) {
+            outstanding = outstanding || buffers[i].posted;
+        }
+        if (!outstanding) {
+            return;
+        }
+        SleepEx(10, TRUE);
+    }
+}
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	completed
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	static void CALLBACK completed(DWORD error, DWORD bytes, LPWSAOVERLAPPED overlapped, DWORD flags)
+--                                             error - result of the read
+--                                             bytes - size of the datagram read
+--                                             overlapped - the read's slot
+--                                             flags - unused
+--
+-- RETURNS:     void
+--
+-- NOTES:
+--              Hands the datagram on and posts the buffer again. A port unreachable report from an earlier
+--              send is not a reason to stop reading, so only a cancelled read is not posted again.
+--
+-------------------------------------------------------------------------------------------------------------------*/
+void CALLBACK ReceiveRing::completed(DWORD error, DWORD bytes, LPWSAOVERLAPPED overlapped, DWORD) {
+    Slot *slot = (Slot *)overlapped;
+    ReceiveRing *ring = slot->ring;
+    slot->posted = false;
+    if (error == WSA_OPERATION_ABORTED || ring->stopping) {
+        return;
+    }
+
+    DWORD filled = (DWORD)ring->countFilled() + 1;
+    if (filled > ring->stats.mostFilled) {
+        ring->stats.mostFilled = filled;
+    }
+    if ((int)filled >= ring->depth) {
+        ring->stats.allFilled++;
+    }
+    if (error == 0) {
+        ring->stats.datagramsReceived++;
+        ring->handle(slot->data, (int)bytes, slot->from);
+    } else if (error != WSAECONNRESET) {
+        ring->stats.errors++;
+        qDebug() << "Overlapped receive failed with error" << error;
+    }
+    if (!ring->stopping) {
+        ring->post(slot);
+    }
+}
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	runBenchmark
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	static QString runBenchmark(int depth, int burst)
+--                                   depth - reads to keep posted
+--                                   burst - datagrams sent back to back in each burst
+--
+-- RETURNS:     The loss and the ring's counters for one run
+--
+-- NOTES:
+--              The receiving socket's own buffer is turned off, so a datagram is kept only if a read is posted
+--              for it, and every datagram costs RECEIVE_BENCH_WORK_US of work as a decode would. Another
+--              thread sends RECEIVE_BENCH_ROUNDS bursts over loopback, RECEIVE_BENCH_GAP_MS apart.
+--
+-------------------------------------------------------------------------------------------------------------------*/
+QString ReceiveRing::runBenchmark(int depth, int burst) {
+    SOCKET receiver = socket(AF_INET, SOCK_DGRAM, 0);
+    SOCKET sender = socket(AF_INET, SOCK_DGRAM, 0);
+    if (receiver == INVALID_SOCKET || sender == INVALID_SOCKET) {
+        return QString("could not open sockets, error %1").arg(WSAGetLastError());
+    }
+    SOCKADDR_IN local = {};
+    local.sin_family = AF_INET;
+    local.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    int size = sizeof(local);
+    int noBuffer = 0;
+    if (bind(receiver, (struct sockaddr *)&local, sizeof(local)) == SOCKET_ERROR ||
+            getsockname(receiver, (struct sockaddr *)&local, &size) == SOCKET_ERROR ||
+            setsockopt(receiver, SOL_SOCKET, SO_RCVBUF, (const char *)&noBuffer, sizeof(noBuffer)) == SOCKET_ERROR) {
+        int error = WSAGetLastError();
+        closesocket(receiver);
+        closesocket(sender);
+        return QString("could not set up the receiver, error %1").arg(error);
+    }
+
+    ReceiveRing *ring = new ReceiveRing(receiver, depth, [](const char *, int, const SOCKADDR_IN &) {
+        spin(RECEIVE_BENCH_WORK_US);
+    });
+    ring->refill();
+    BenchSender bench = { sender, local, burst, false };
+    HANDLE thread = CreateThread(NULL, 0, sendBursts, &bench, 0, NULL);
+    if (thread == NULL) {
+        bench.done = true;
+    }
+    DWORD received = 0;
+    DWORD quietSince = GetTickCount();
+    while (!bench.done || GetTickCount() - quietSince < 200) {
+        SleepEx(RECEIVE_BENCH_GAP_MS, TRUE);
+        ring->refill();
+        if (ring->getStatistics().datagramsReceived != received) {
+            received = ring->getStatistics().datagramsReceived;
+            quietSince = GetTickCount();
+        }
+    }
+    if (thread != NULL) {
+        WaitForSingleObject(thread, INFINITE);
+        CloseHandle(thread);
+    }
+    Statistics result = ring->getStatistics();
+    delete ring;
+    closesocket(receiver);
+    closesocket(sender);
+
+    DWORD sent = thread != NULL ? (DWORD)(RECEIVE_BENCH_ROUNDS * burst) : 0;
+    return QString("%1 of %2 received (%3% lost), at most %4 buffers filled at once, all full %5 times")
+            .arg((qint64)result.datagramsReceived)
+            .arg((qint64)sent)
+            .arg(sent > 0 ? 100.0 * (sent - result.datagramsReceived) / sent : 0, 0, 'f', 1)
+            .arg((qint64)result.mostFilled)
+            .arg((qint64)result.allFilled);
+}
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	post
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	bool post(Slot *slot)
+--                        slot - buffer to read into
+--
+-- RETURNS:     False if the read could not be posted
+--
+-- NOTES:
+--              A read that completes at once still reports through the completion routine.
+--
+-------------------------------------------------------------------------------------------------------------------*/
+bool ReceiveRing::post(Slot *slot) {
+    ZeroMemory(&slot->overlapped, sizeof(WSAOVERLAPPED));
+    slot->buffer.buf = slot->data;
+    slot->buffer.len = DATA_BUFSIZE;
+    slot->fromSize = sizeof(slot->from);
+    slot->flags = 0;
+    slot->posted = true;
+    DWORD bytes;
+    if (WSARecvFrom(sock, &slot->buffer, 1, &bytes, &slot->flags, (struct sockaddr *)&slot->from, &slot->fromSize,
+                    &slot->overlapped, completed) == SOCKET_ERROR && WSAGetLastError() != WSA_IO_PENDING) {
+        slot->posted = false;
+        if (stats.postFailures++ == 0) {
+            qDebug() << "WSARecvFrom() failed with error" << WSAGetLastError();
+        }
+        return false;
+    }
+    stats.receivesPosted++;
+    return true;
+}
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	countFilled
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	int countFilled() const
+--
+-- RETURNS:     The number of posted reads that have completed and wait for their routine
+--
+-------------------------------------------------------------------------------------------------------------------*/
+int ReceiveRing::countFilled() const {
+    int filled = 0;
+    for (int i = 0; i < depth; i++) {
+        if (buffers[i].posted && HasOverlappedIoCompleted(&buffers[i].overlapped)) {
+            filled++;
+        }
+    }
+    return filled;
+}
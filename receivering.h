@@ -0,0 +1,70 @@
+#pragma once
+#include <winsock2.h>
+#include <windows.h>
+#include <functional>
+#include <QDebug>
+#include <QString>
+#include "streampacket.h"
+
+#define RECEIVE_RING_DEPTH 16
+#define RECEIVE_RING_MAX 64
+#define RECEIVE_RING_DRAIN_MS 1000
+#define RECEIVE_BENCH_BURST 256
+#define RECEIVE_BENCH_ROUNDS 50
+#define RECEIVE_BENCH_GAP_MS 20
+#define RECEIVE_BENCH_WORK_US 20
+
+class ReceiveRing {
+public:
+    typedef std::function<void(const char *datagram, int bytes, const SOCKADDR_IN &from)> ReceiveCallback;
+
+    struct Statistics {
+        DWORD datagramsReceived = 0;
+        DWORD receivesPosted = 0;
+        DWORD postFailures = 0;
+        DWORD errors = 0;
+        DWORD mostFilled = 0;
+        DWORD allFilled = 0;
+    };
+
+    ReceiveRing(SOCKET sock, int depth, ReceiveCallback handle);
+    ~ReceiveRing();
+    ReceiveRing(const ReceiveRing&) = delete;
+    void operator=(const ReceiveRing&) = delete;
+
+    static int runFromArguments(int argc, char *argv[]);
+    static QString benchmark(int depth, int burst);
+    int refill();
+    void stop();
+
+    int getDepth() const {
+        return depth;
+    }
+    const Statistics &getStatistics() const {
+        return stats;
+    }
+
+private:
+    struct Slot {
+        WSAOVERLAPPED overlapped;
+        ReceiveRing *ring;
+        bool posted;
+        WSABUF buffer;
+        SOCKADDR_IN from;
+        INT fromSize;
+        DWORD flags;
+        char data[DATA_BUFSIZE];
+    };
+
+    SOCKET sock;
+    int depth;
+    ReceiveCallback handle;
+    Slot *buffers;
+    bool stopping = false;
+    Statistics stats;
+
+    static void CALLBACK completed(DWORD error, DWORD bytes, LPWSAOVERLAPPED overlapped, DWORD flags);
+    static QString runBenchmark(int depth, int burst);
+    bool post(Slot *slot);
+    int countFilled() const;
+};
@@ -0,0 +1,247 @@
+/*------------------------------------------------------------------------------------------------------------------
+-- SOURCE FILE: 	retransmitbuffer.cpp - Keeps the most recently sent stream packets for the repair channel.
+--
+--
+-- PROGRAM: 		Communication Audio Program
+--
+-- FUNCTIONS:
+--                  RetransmitBuffer(PacketPool *pool)
+--                  PooledPacket *acquire(uint32_t sequence)
+--                  void release(uint32_t sequence)
+--                  void keep(uint32_t sequence, PooledPacket *packet)
+--                  RepairAction requestRepair(uint32_t sequence, DWORD now, const PooledPacket *&packet)
+--                  const PooledPacket *find(uint32_t sequence) const
+--                  void clear()
+--
+-- DATE: 			October 19, 2026
+--
+-- REVISIONS:       October 19, 2026 - Keep datagrams in the PacketPool shared by all channels - agent
+--                  October 19, 2026 - Look up recent packets for join bursts - agent
+--                  October 19, 2026 - Keep packets that were received rather than built - agent
+--
+-- DESIGNER: 		agent
+--
+-- PROGRAMMER: 		agent
+--
+-- NOTES:
+--      The server builds every audio datagram of a channel in a packet acquired here, which indexes it by
+--      sequence number in a ring of the last RETRANSMIT_RING_SIZE packets. The datagram itself lives in the
+--      shared PacketPool, so a packet can be dropped from the history early when the pool reuses it for another
+--      channel. The repair path looks packets up here when a listener sends a NACK, and the join path when a new
+--      listener asks for the most recent audio to fill its playout buffer.
+--
+--      To stop a burst of loss across many listeners from turning into a flood of repairs, each packet is
+--      repaired at most twice per REPAIR_SUPPRESS_MS window: the first NACK is answered by unicast to that
+--      listener, a second NACK from anyone else means the loss is shared so the packet is multicast once for
+--      everybody, and every further NACK in the window is ignored.
+--
+--      Sending and repairs both run on the ChannelManager pacing thread so the ring does no locking.
+--
+--------------------------------------------------------------------------------------------------------------------*/
+#include "retransmitbuffer.h"
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	RetransmitBuffer
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:   October 19, 2026 - Take the packet pool datagrams are kept in - agent
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	RetransmitBuffer(PacketPool *pool)
+--                               pool - pool the datagrams are built in
+--
+-- RETURNS:     NA
+--
+-------------------------------------------------------------------------------------------------------------------*/
+RetransmitBuffer::RetransmitBuffer(PacketPool *pool) : pool(pool) {
+    clear();
+}
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	clear
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	void clear()
+--
+-- RETURNS:     void
+--
+-- NOTES:
+--              Forgets every stored packet, used when a new stream starts.
+--
+-------------------------------------------------------------------------------------------------------------------*/
+void RetransmitBuffer::clear() {
+    for (int i = 0; i < RETRANSMIT_RING_SIZE; i++) {
+        ring[i].packet = nullptr;
+    }
+}
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	acquire
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	PooledPacket *acquire(uint32_t sequence)
+--                                    sequence - sequence number of the datagram about to be sent
+--
+-- RETURNS:     Returns the packet to build the datagram in
+--
+-- NOTES:
+--              The packet is recorded as the copy of sequence straight away. The caller builds the datagram in
+--              it, sets its size and sends it, so the datagram is never copied.
+--
+-------------------------------------------------------------------------------------------------------------------*/
+PooledPacket *RetransmitBuffer::acquire(uint32_t sequence) {
+    Entry &entry = ring[sequence % RETRANSMIT_RING_SIZE];
+    entry.sequence = sequence;
+    entry.packet = pool->acquire(this, sequence);
+    entry.repaired = false;
+    entry.multicast = false;
+    return entry.packet;
+}
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	release
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	void release(uint32_t sequence)
+--                           sequence - sequence number acquired for a datagram that was not sent after all
+--
+-- RETURNS:     void
+--
+-- NOTES:
+--              Gives the packet back to the pool, so acquiring the sequence again does not use up another one.
+--
+-------------------------------------------------------------------------------------------------------------------*/
+void RetransmitBuffer::release(uint32_t sequence) {
+    Entry &entry = ring[sequence % RETRANSMIT_RING_SIZE];
+    if (entry.sequence == sequence && pool->holds(entry.packet, this, sequence)) {
+        pool->release(entry.packet);
+    }
+    entry.packet = nullptr;
+}
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	keep
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	void keep(uint32_t sequence, PooledPacket *packet)
+--                        sequence - sequence number of the datagram in the packet
+--                        packet - pool packet the datagram was received into
+--
+-- RETURNS:     void
+--
+-- NOTES:
+--              Used by the relay, which only learns the sequence number once the datagram is already in the
+--              packet. The packet is taken over as if it had been acquired for that sequence number.
+--
+-------------------------------------------------------------------------------------------------------------------*/
+void RetransmitBuffer::keep(uint32_t sequence, PooledPacket *packet) {
+    Entry &entry = ring[sequence % RETRANSMIT_RING_SIZE];
+    packet->owner = this;
+    packet->sequence = sequence;
+    entry.sequence = sequence;
+    entry.packet = packet;
+    entry.repaired = false;
+    entry.multicast = false;
+}
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	requestRepair
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:   October 19, 2026 - Hand back the pooled packet instead of copying it - agent
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	RepairAction requestRepair(uint32_t sequence, DWORD now, const PooledPacket *&packet)
+--                                         sequence - sequence number a listener asked for
+--                                         now - current time in milliseconds
+--                                         packet - set to the stored datagram when it should be resent
+--
+-- RETURNS:     Returns how the packet should be repaired
+--
+-- NOTES:
+--              Applies the per packet suppression window described at the top of the file.
+--
+-------------------------------------------------------------------------------------------------------------------*/
+RetransmitBuffer::RepairAction RetransmitBuffer::requestRepair(uint32_t sequence, DWORD now,
+                                                               const PooledPacket *&packet) {
+    Entry &entry = ring[sequence % RETRANSMIT_RING_SIZE];
+    if (entry.sequence != sequence || !pool->holds(entry.packet, this, sequence) || entry.packet->bytes == 0) {
+        return REPAIR_UNAVAILABLE;
+    }
+    packet = entry.packet;
+    if (!entry.repaired || now - entry.lastRepair > REPAIR_SUPPRESS_MS) {
+        entry.repaired = true;
+        entry.multicast = false;
+        entry.lastRepair = now;
+        return REPAIR_UNICAST;
+    }
+    if (!entry.multicast) {
+        entry.multicast = true;
+        return REPAIR_MULTICAST;
+    }
+    return REPAIR_SUPPRESSED;
+}
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	find
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	const PooledPacket *find(uint32_t sequence) const
+--                                       sequence - sequence number of a sent datagram
+--
+-- RETURNS:     Returns the stored datagram, or nullptr if it is no longer held
+--
+-- NOTES:
+--              Unlike requestRepair this does not count as a repair, so join bursts never suppress NACKs.
+--
+-------------------------------------------------------------------------------------------------------------------*/
+const PooledPacket *RetransmitBuffer::find(uint32_t sequence) const {
+    const Entry &entry = ring[sequence % RETRANSMIT_RING_SIZE];
+    if (entry.sequence != sequence || !pool->holds(entry.packet, this, sequence) || entry.packet->bytes == 0) {
+        return nullptr;
+    }
+    return entry.packet;
+}
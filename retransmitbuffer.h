@@ -0,0 +1,53 @@
+#pragma once
+#include <winsock2.h>
+#include <windows.h>
+#include "streampacket.h"
+#include "packetpool.h"
+
+#define RETRANSMIT_RING_SIZE 256
+#define REPAIR_SUPPRESS_MS 100
+
+struct RepairStatistics
+{
+    DWORD nacksReceived;
+    DWORD sequencesRequested;
+    DWORD repairsUnicast;
+    DWORD repairsMulticast;
+    DWORD repairsSuppressed;
+    DWORD repairsUnavailable;
+    DWORD repairBytes;
+};
+
+class RetransmitBuffer {
+public:
+    enum RepairAction
+    {
+        REPAIR_UNAVAILABLE,
+        REPAIR_UNICAST,
+        REPAIR_MULTICAST,
+        REPAIR_SUPPRESSED
+    };
+
+    RetransmitBuffer(PacketPool *pool);
+    RetransmitBuffer(const RetransmitBuffer&) = delete;
+    void operator=(const RetransmitBuffer&) = delete;
+
+    PooledPacket *acquire(uint32_t sequence);
+    void release(uint32_t sequence);
+    void keep(uint32_t sequence, PooledPacket *packet);
+    RepairAction requestRepair(uint32_t sequence, DWORD now, const PooledPacket *&packet);
+    const PooledPacket *find(uint32_t sequence) const;
+    void clear();
+
+private:
+    struct Entry {
+        uint32_t sequence;
+        PooledPacket *packet;
+        DWORD lastRepair;
+        bool repaired;
+        bool multicast;
+    };
+
+    PacketPool *pool;
+    Entry ring[RETRANSMIT_RING_SIZE];
+};
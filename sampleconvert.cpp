@@ -0,0 +1,940 @@
+/*------------------------------------------------------------------------------------------------------------------
+-- SOURCE FILE: 	sampleconvert.cpp - Sample format, channel and rate conversion kernels.
+--
+--
+-- PROGRAM: 		Communication Audio Program
+--
+-- FUNCTIONS:
+--                  bool handles(const StreamDescriptor &format)
+--                  const char *getKernelName()
+--                  void toFloat(const char *in, const StreamDescriptor &format, float *out, int samples)
+--                  void fromFloat(const float *in, const StreamDescriptor &format, char *out, int samples)
+--                  void s16ToFloat(const char *in, float *out, int samples, uint16_t signFlip)
+--                  void floatToS16(const float *in, char *out, int samples, uint16_t signFlip)
+--                  void deinterleave(const float *in, int channels, int frames, float *const *planes)
+--                  void interleave(const float *const *planes, int channels, int frames, float *out)
+--                  void downmixStereo(const float *in, float *out, int frames)
+--                  void remix(const float *in, int inChannels, float *out, int outChannels, int frames)
+--                  float dot(const float *a, const float *b, int count)
+--                  void accumulateS16(const int16_t *in, int32_t *sum, int samples)
+--                  void mixMinusS16(const int32_t *sum, const int16_t *own, int16_t *out, int samples)
+--                  bool setRates(int inputRate, int outputRate, int channels)
+--                  void reset()
+--                  int process(const float *in, int frames, std::vector<float> &out)
+--
+-- DATE: 			October 19, 2026
+--
+-- REVISIONS:       October 19, 2026 - Add the conference mixing kernels - agent
+--                  October 19, 2026 - Name the kernels compiled in, for --convert-bench - agent
+--
+-- DESIGNER: 		agent
+--
+-- PROGRAMMER: 		agent
+--
+-- NOTES:
+--      Audio moves between formats as interleaved floats in [-1, 1). Samples are turned into floats, remixed
+--      to the wanted channel count, resampled, and turned back into the wanted sample format. FormatConverter
+--      strings these steps together.
+--
+--      The kernels that see every sample work 8 at a time with AVX2 and 4 or 8 at a time with SSE2 or NEON,
+--      whichever the compiler targets, like the FEC XOR kernel. Each has a scalar loop that finishes the
+--      remainder and does all the work on other targets. These are 16 bit conversion, stereo splitting and
+--      joining, stereo downmix and the resampler's dot product. The rarer 8, 24 and 32 bit formats are
+--      scalar only.
+--
+--      The conference bridge mixes with two more kernels of the same kind. Every talker is added into 32 bit
+--      sums, which cannot overflow, and each participant's mix is the sum less their own voice, packed back
+--      to 16 bits with saturation. Clipping only once, at the end, keeps the sum exact, so taking one voice
+--      back out of it leaves precisely the others.
+--
+--      The Resampler is a polyphase FIR filter. For rates with a ratio of up / down in lowest terms, every
+--      output frame lies at one of up fixed offsets between two input frames, so there is one row of
+--      coefficients per offset, worked out once when the rates are set. Each row is a Blackman windowed sinc
+--      with its cutoff just under the lower of the two Nyquist rates. Downsampling lowers the cutoff and so
+--      needs longer rows, up to RESAMPLE_MAX_TAPS. Between 44.1 and 48 kHz there are 160 rows of 32 taps.
+--      Unusual ratios with more than RESAMPLE_MAX_PHASES offsets use the nearest row, but the output still
+--      comes out at exactly the right rate.
+--
+--------------------------------------------------------------------------------------------------------------------*/
+#include "sampleconvert.h"
+#include <cmath>
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define CONVERT_USE_AVX2
+#endif
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define CONVERT_USE_SSE2
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define CONVERT_USE_NEON
+#endif
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	handles
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	bool handles(const StreamDescriptor &format)
+--                           format - PCM format to check
+--
+-- RETURNS:     True if samples in this format can be converted
+--
+-- NOTES:
+--              8 bit signed or unsigned, 16 bit signed or unsigned, 24 bit signed, and 32 bit signed or float.
+--
+-------------------------------------------------------------------------------------------------------------------*/
+bool SampleConvert::handles(const StreamDescriptor &format) {
+    if (format.channels == 0 || format.channels > CONVERT_MAX_CHANNELS || format.sampleRate == 0 ||
+            format.frameSize != format.channels * format.sampleSize / 8) {
+        return false;
+    }
+    switch (format.sampleSize) {
+    case 8:
+    case 16:
+        return format.sampleType != SAMPLE_FLOAT;
+    case 24:
+        return format.sampleType == SAMPLE_SIGNED;
+    case 32:
+        return format.sampleType != SAMPLE_UNSIGNED;
+    default:
+        return false;
+    }
+}
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	getKernelName
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	static const char *getKernelName()
+--
+-- RETURNS:     The widest instruction set the kernels were compiled for, or "scalar"
+--
+-------------------------------------------------------------------------------------------------------------------*/
+const char *SampleConvert::getKernelName() {
+#if defined(CONVERT_USE_AVX2)
+    return "AVX2";
+#elif defined(CONVERT_USE_SSE2)
+    return "SSE2";
+#elif defined(CONVERT_USE_NEON)
+    return "NEON";
+#else
+    return "scalar";
+#endif
+}
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	toFloat
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	void toFloat(const char *in, const StreamDescriptor &format, float *out, int samples)
+--                           in - samples in the given format
+--                           format - format of the samples, one handles() accepts
+--                           out - destination for the floats
+--                           samples - number of samples, not frames
+--
+-- RETURNS:     void
+--
+-------------------------------------------------------------------------------------------------------------------*/
+void SampleConvert::toFloat(const char *in, const StreamDescriptor &format, float *out, int samples) {
+    switch (format.sampleSize) {
+    case 8:
+        if (format.sampleType == SAMPLE_UNSIGNED) {
+            for (int i = 0; i < samples; i++) {
+                out[i] = ((uint8_t)in[i] - 128) * (1.0f / 128);
+            }
+        } else {
+            for (int i = 0; i < samples; i++) {
+                out[i] = (int8_t)in[i] * (1.0f / 128);
+            }
+        }
+        break;
+    case 16:
+        s16ToFloat(in, out, samples, format.sampleType == SAMPLE_UNSIGNED ? 0x8000 : 0);
+        break;
+    case 24:
+        for (int i = 0; i < samples; i++) {
+            const uint8_t *sample = (const uint8_t *)in + i * 3;
+            int32_t value = (int32_t)((uint32_t)sample[0] << 8 | (uint32_t)sample[1] << 16 | (uint32_t)sample[2] << 24);
+            out[i] = (value >> 8) * (1.0f / 8388608);
+        }
+        break;
+    case 32:
+        if (format.sampleType == SAMPLE_FLOAT) {
+            memcpy(out, in, samples * sizeof(float));
+        } else {
+            for (int i = 0; i < samples; i++) {
+                int32_t value;
+                memcpy(&value, in + i * 4, 4);
+                out[i] = value * (1.0f / 2147483648.0f);
+            }
+        }
+        break;
+    }
+}
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	fromFloat
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	void fromFloat(const float *in, const StreamDescriptor &format, char *out, int samples)
+--                             in - floats to convert
+--                             format - format wanted, one handles() accepts
+--                             out - destination for the samples
+--                             samples - number of samples, not frames
+--
+-- RETURNS:     void
+--
+-- NOTES:
+--              Integer samples are rounded and clipped to their range. Floats are copied as they are.
+--
+-------------------------------------------------------------------------------------------------------------------*/
+void SampleConvert::fromFloat(const float *in, const StreamDescriptor &format, char *out, int samples) {
+    switch (format.sampleSize) {
+    case 8:
+        for (int i = 0; i < samples; i++) {
+            float value = in[i] * 128;
+            int32_t sample = (int32_t)(value > 127 ? 127 : value < -128 ? -128 : value + (value < 0 ? -0.5f : 0.5f));
+            out[i] = (char)(format.sampleType == SAMPLE_UNSIGNED ? sample + 128 : sample);
+        }
+        break;
+    case 16:
+        floatToS16(in, out, samples, format.sampleType == SAMPLE_UNSIGNED ? 0x8000 : 0);
+        break;
+    case 24:
+        for (int i = 0; i < samples; i++) {
+            double value = in[i] * 8388608.0;
+            int32_t sample = (int32_t)(value > 8388607 ? 8388607 : value < -8388608 ? -8388608
+                                       : value + (value < 0 ? -0.5 : 0.5));
+            out[i * 3] = (char)sample;
+            out[i * 3 + 1] = (char)(sample >> 8);
+            out[i * 3 + 2] = (char)(sample >> 16);
+        }
+        break;
+    case 32:
+        if (format.sampleType == SAMPLE_FLOAT) {
+            memcpy(out, in, samples * sizeof(float));
+        } else {
+            for (int i = 0; i < samples; i++) {
+                double value = in[i] * 2147483648.0;
+                int32_t sample = (int32_t)(value > 2147483647.0 ? 2147483647.0 : value < -2147483648.0 ? -2147483648.0
+                                           : value + (value < 0 ? -0.5 : 0.5));
+                memcpy(out + i * 4, &sample, 4);
+            }
+        }
+        break;
+    }
+}
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	s16ToFloat
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	void s16ToFloat(const char *in, float *out, int samples, uint16_t signFlip)
+--                              in - 16 bit samples, need not be aligned
+--                              out - destination for the floats
+--                              samples - number of samples
+--                              signFlip - 0x8000 for unsigned samples, 0 for signed
+--
+-- RETURNS:     void
+--
+-------------------------------------------------------------------------------------------------------------------*/
+void SampleConvert::s16ToFloat(const char *in, float *out, int samples, uint16_t signFlip) {
+    int i = 0;
+#ifdef CONVERT_USE_AVX2
+    const __m256 wideScale = _mm256_set1_ps(1.0f / 32768);
+    const __m128i wideFlip = _mm_set1_epi16((short)signFlip);
+    for (; i + 8 <= samples; i += 8) {
+        __m128i value = _mm_xor_si128(_mm_loadu_si128((const __m128i *)(in + i * 2)), wideFlip);
+        _mm256_storeu_ps(out + i, _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_cvtepi16_epi32(value)), wideScale));
+    }
+#endif
+#ifdef CONVERT_USE_SSE2
+    const __m128 scale = _mm_set1_ps(1.0f / 32768);
+    const __m128i flip = _mm_set1_epi16((short)signFlip);
+    for (; i + 8 <= samples; i += 8) {
+        __m128i value = _mm_xor_si128(_mm_loadu_si128((const __m128i *)(in + i * 2)), flip);
+        // Each sample is put in the top half of a 32 bit lane and shifted down to sign extend it
+        __m128i low = _mm_srai_epi32(_mm_unpacklo_epi16(value, value), 16);
+        __m128i high = _mm_srai_epi32(_mm_unpackhi_epi16(value, value), 16);
+        _mm_storeu_ps(out + i, _mm_mul_ps(_mm_cvtepi32_ps(low), scale));
+        _mm_storeu_ps(out + i + 4, _mm_mul_ps(_mm_cvtepi32_ps(high), scale));
+    }
+#endif
+#ifdef CONVERT_USE_NEON
+    const float32x4_t scale = vdupq_n_f32(1.0f / 32768);
+    const int16x8_t flip = vdupq_n_s16((int16_t)signFlip);
+    for (; i + 8 <= samples; i += 8) {
+        int16x8_t value = veorq_s16(vreinterpretq_s16_u8(vld1q_u8((const uint8_t *)(in + i * 2))), flip);
+        vst1q_f32(out + i, vmulq_f32(vcvtq_f32_s32(vmovl_s16(vget_low_s16(value))), scale));
+        vst1q_f32(out + i + 4, vmulq_f32(vcvtq_f32_s32(vmovl_s16(vget_high_s16(value))), scale));
+    }
+#endif
+    for (; i < samples; i++) {
+        uint16_t value;
+        memcpy(&value, in + i * 2, 2);
+        out[i] = (int16_t)(value ^ signFlip) * (1.0f / 32768);
+    }
+}
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	floatToS16
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	void floatToS16(const float *in, char *out, int samples, uint16_t signFlip)
+--                              in - floats to convert
+--                              out - destination for the 16 bit samples, need not be aligned
+--                              samples - number of samples
+--                              signFlip - 0x8000 for unsigned samples, 0 for signed
+--
+-- RETURNS:     void
+--
+-- NOTES:
+--              Rounds to the nearest sample and clips. SSE2 and AVX2 round halves to even where the other paths
+--              round them away from zero, a difference of at most one step on exact halves.
+--
+-------------------------------------------------------------------------------------------------------------------*/
+void SampleConvert::floatToS16(const float *in, char *out, int samples, uint16_t signFlip) {
+    int i = 0;
+#ifdef CONVERT_USE_AVX2
+    const __m256 wideScale = _mm256_set1_ps(32768.0f);
+    const __m256 wideHigh = _mm256_set1_ps(32767.0f);
+    const __m256 wideLow = _mm256_set1_ps(-32768.0f);
+    const __m256i wideFlip = _mm256_set1_epi16((short)signFlip);
+    for (; i + 16 <= samples; i += 16) {
+        __m256 a = _mm256_min_ps(_mm256_max_ps(_mm256_mul_ps(_mm256_loadu_ps(in + i), wideScale), wideLow), wideHigh);
+        __m256 b = _mm256_min_ps(_mm256_max_ps(_mm256_mul_ps(_mm256_loadu_ps(in + i + 8), wideScale), wideLow),
+                                 wideHigh);
+        // The pack works within each 128 bit lane, so the middle quarters come out swapped
+        __m256i packed = _mm256_packs_epi32(_mm256_cvtps_epi32(a), _mm256_cvtps_epi32(b));
+        packed = _mm256_permute4x64_epi64(packed, 0xD8);
+        _mm256_storeu_si256((__m256i *)(out + i * 2), _mm256_xor_si256(packed, wideFlip));
+    }
+#endif
+#ifdef CONVERT_USE_SSE2
+    const __m128 scale = _mm_set1_ps(32768.0f);
+    const __m128 high = _mm_set1_ps(32767.0f);
+    const __m128 low = _mm_set1_ps(-32768.0f);
+    const __m128i flip = _mm_set1_epi16((short)signFlip);
+    for (; i + 8 <= samples; i += 8) {
+        __m128 a = _mm_min_ps(_mm_max_ps(_mm_mul_ps(_mm_loadu_ps(in + i), scale), low), high);
+        __m128 b = _mm_min_ps(_mm_max_ps(_mm_mul_ps(_mm_loadu_ps(in + i + 4), scale), low), high);
+        __m128i packed = _mm_packs_epi32(_mm_cvtps_epi32(a), _mm_cvtps_epi32(b));
+        _mm_storeu_si128((__m128i *)(out + i * 2), _mm_xor_si128(packed, flip));
+    }
+#endif
+#ifdef CONVERT_USE_NEON
+    const float32x4_t scale = vdupq_n_f32(32768.0f);
+    const float32x4_t half = vdupq_n_f32(0.5f);
+    const float32x4_t zero = vdupq_n_f32(0.0f);
+    const int16x8_t flip = vdupq_n_s16((int16_t)signFlip);
+    for (; i + 8 <= samples; i += 8) {
+        float32x4_t a = vmulq_f32(vld1q_f32(in + i), scale);
+        float32x4_t b = vmulq_f32(vld1q_f32(in + i + 4), scale);
+        // The conversion truncates, so add a half away from zero first; it and the narrowing both saturate
+        a = vaddq_f32(a, vbslq_f32(vcltq_f32(a, zero), vnegq_f32(half), half));
+        b = vaddq_f32(b, vbslq_f32(vcltq_f32(b, zero), vnegq_f32(half), half));
+        int16x8_t packed = vcombine_s16(vqmovn_s32(vcvtq_s32_f32(a)), vqmovn_s32(vcvtq_s32_f32(b)));
+        vst1q_u8((uint8_t *)(out + i * 2), vreinterpretq_u8_s16(veorq_s16(packed, flip)));
+    }
+#endif
+    for (; i < samples; i++) {
+        float value = in[i] * 32768.0f;
+        int32_t sample = (int32_t)(value > 32767 ? 32767 : value < -32768 ? -32768 : value + (value < 0 ? -0.5f : 0.5f));
+        uint16_t bits = (uint16_t)sample ^ signFlip;
+        memcpy(out + i * 2, &bits, 2);
+    }
+}
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	deinterleave
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	void deinterleave(const float *in, int channels, int frames, float *const *planes)
+--                                in - interleaved frames
+--                                channels - samples per frame
+--                                frames - number of frames
+--                                planes - one destination per channel
+--
+-- RETURNS:     void
+--
+-- NOTES:
+--              Stereo, by far the most common, is split 4 frames at a time.
+--
+-------------------------------------------------------------------------------------------------------------------*/
+void SampleConvert::deinterleave(const float *in, int channels, int frames, float *const *planes) {
+    int i = 0;
+    if (channels == 2) {
+        float *left = planes[0];
+        float *right = planes[1];
+#ifdef CONVERT_USE_SSE2
+        for (; i + 4 <= frames; i += 4) {
+            __m128 a = _mm_loadu_ps(in + i * 2);
+            __m128 b = _mm_loadu_ps(in + i * 2 + 4);
+            _mm_storeu_ps(left + i, _mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0)));
+            _mm_storeu_ps(right + i, _mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1)));
+        }
+#endif
+#ifdef CONVERT_USE_NEON
+        for (; i + 4 <= frames; i += 4) {
+            float32x4x2_t pair = vld2q_f32(in + i * 2);
+            vst1q_f32(left + i, pair.val[0]);
+            vst1q_f32(right + i, pair.val[1]);
+        }
+#endif
+        for (; i < frames; i++) {
+            left[i] = in[i * 2];
+            right[i] = in[i * 2 + 1];
+        }
+        return;
+    }
+    for (; i < frames; i++) {
+        for (int c = 0; c < channels; c++) {
+            planes[c][i] = in[i * channels + c];
+        }
+    }
+}
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	interleave
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	void interleave(const float *const *planes, int channels, int frames, float *out)
+--                              planes - one source per channel
+--                              channels - samples per frame
+--                              frames - number of frames
+--                              out - destination for the interleaved frames
+--
+-- RETURNS:     void
+--
+-------------------------------------------------------------------------------------------------------------------*/
+void SampleConvert::interleave(const float *const *planes, int channels, int frames, float *out) {
+    int i = 0;
+    if (channels == 2) {
+        const float *left = planes[0];
+        const float *right = planes[1];
+#ifdef CONVERT_USE_SSE2
+        for (; i + 4 <= frames; i += 4) {
+            __m128 l = _mm_loadu_ps(left + i);
+            __m128 r = _mm_loadu_ps(right + i);
+            _mm_storeu_ps(out + i * 2, _mm_unpacklo_ps(l, r));
+            _mm_storeu_ps(out + i * 2 + 4, _mm_unpackhi_ps(l, r));
+        }
+#endif
+#ifdef CONVERT_USE_NEON
+        for (; i + 4 <= frames; i += 4) {
+            float32x4x2_t pair;
+            pair.val[0] = vld1q_f32(left + i);
+            pair.val[1] = vld1q_f32(right + i);
+            vst2q_f32(out + i * 2, pair);
+        }
+#endif
+        for (; i < frames; i++) {
+            out[i * 2] = left[i];
+            out[i * 2 + 1] = right[i];
+        }
+        return;
+    }
+    for (; i < frames; i++) {
+        for (int c = 0; c < channels; c++) {
+            out[i * channels + c] = planes[c][i];
+        }
+    }
+}
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	downmixStereo
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	void downmixStereo(const float *in, float *out, int frames)
+--                                 in - interleaved stereo frames
+--                                 out - destination for the mono samples
+--                                 frames - number of frames
+--
+-- RETURNS:     void
+--
+-- NOTES:
+--              Each mono sample is the average of the two sides, so a full scale stereo signal cannot clip.
+--
+-------------------------------------------------------------------------------------------------------------------*/
+void SampleConvert::downmixStereo(const float *in, float *out, int frames) {
+    int i = 0;
+#ifdef CONVERT_USE_AVX2
+    const __m256 wideHalf = _mm256_set1_ps(0.5f);
+    for (; i + 8 <= frames; i += 8) {
+        __m256 a = _mm256_loadu_ps(in + i * 2);
+        __m256 b = _mm256_loadu_ps(in + i * 2 + 8);
+        // hadd sums neighbouring pairs within each lane, leaving frames 0-1, 4-5, 2-3, 6-7
+        __m256 sums = _mm256_hadd_ps(a, b);
+        sums = _mm256_castpd_ps(_mm256_permute4x64_pd(_mm256_castps_pd(sums), 0xD8));
+        _mm256_storeu_ps(out + i, _mm256_mul_ps(sums, wideHalf));
+    }
+#endif
+#ifdef CONVERT_USE_SSE2
+    const __m128 half = _mm_set1_ps(0.5f);
+    for (; i + 4 <= frames; i += 4) {
+        __m128 a = _mm_loadu_ps(in + i * 2);
+        __m128 b = _mm_loadu_ps(in + i * 2 + 4);
+        __m128 left = _mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0));
+        __m128 right = _mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1));
+        _mm_storeu_ps(out + i, _mm_mul_ps(_mm_add_ps(left, right), half));
+    }
+#endif
+#ifdef CONVERT_USE_NEON
+    const float32x4_t half = vdupq_n_f32(0.5f);
+    for (; i + 4 <= frames; i += 4) {
+        float32x4x2_t pair = vld2q_f32(in + i * 2);
+        vst1q_f32(out + i, vmulq_f32(vaddq_f32(pair.val[0], pair.val[1]), half));
+    }
+#endif
+    for (; i < frames; i++) {
+        out[i] = (in[i * 2] + in[i * 2 + 1]) * 0.5f;
+    }
+}
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	remix
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	void remix(const float *in, int inChannels, float *out, int outChannels, int frames)
+--                         in - interleaved frames
+--                         inChannels - channels in each input frame
+--                         out - destination for the interleaved frames
+--                         outChannels - channels wanted in each output frame
+--                         frames - number of frames
+--
+-- RETURNS:     void
+--
+-- NOTES:
+--              Mono is copied to every output channel. When there are fewer output channels, each one is the
+--              average of the input channels that fold onto it, input channel i going to output i % outChannels;
+--              for stereo to mono that is the usual average of the two sides. When there are more, the input
+--              channels repeat across them.
+--
+-------------------------------------------------------------------------------------------------------------------*/
+void SampleConvert::remix(const float *in, int inChannels, float *out, int outChannels, int frames) {
+    if (inChannels == outChannels) {
+        memcpy(out, in, (size_t)frames * inChannels * sizeof(float));
+        return;
+    }
+    if (inChannels == 2 && outChannels == 1) {
+        downmixStereo(in, out, frames);
+        return;
+    }
+    if (inChannels < outChannels) {
+        for (int i = 0; i < frames; i++) {
+            for (int c = 0; c < outChannels; c++) {
+                out[i * outChannels + c] = in[i * inChannels + c % inChannels];
+            }
+        }
+        return;
+    }
+    for (int i = 0; i < frames; i++) {
+        for (int c = 0; c < outChannels; c++) {
+            float sum = 0;
+            int count = 0;
+            for (int source = c; source < inChannels; source += outChannels) {
+                sum += in[i * inChannels + source];
+                count++;
+            }
+            out[i * outChannels + c] = sum / count;
+        }
+    }
+}
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	dot
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	float dot(const float *a, const float *b, int count)
+--                        a, b - vectors to multiply
+--                        count - number of elements
+--
+-- RETURNS:     The sum of the products
+--
+-- NOTES:
+--              The resampler's inner loop, one filter row against one channel's input.
+--
+-------------------------------------------------------------------------------------------------------------------*/
+float SampleConvert::dot(const float *a, const float *b, int count) {
+    int i = 0;
+    float sum = 0;
+#ifdef CONVERT_USE_AVX2
+    __m256 wideTotal = _mm256_setzero_ps();
+    for (; i + 8 <= count; i += 8) {
+        wideTotal = _mm256_add_ps(wideTotal, _mm256_mul_ps(_mm256_loadu_ps(a + i), _mm256_loadu_ps(b + i)));
+    }
+    __m128 folded = _mm_add_ps(_mm256_castps256_ps128(wideTotal), _mm256_extractf128_ps(wideTotal, 1));
+    float wideLanes[4];
+    _mm_storeu_ps(wideLanes, folded);
+    sum += wideLanes[0] + wideLanes[1] + wideLanes[2] + wideLanes[3];
+#endif
+#ifdef CONVERT_USE_SSE2
+    __m128 total = _mm_setzero_ps();
+    for (; i + 4 <= count; i += 4) {
+        total = _mm_add_ps(total, _mm_mul_ps(_mm_loadu_ps(a + i), _mm_loadu_ps(b + i)));
+    }
+    float lanes[4];
+    _mm_storeu_ps(lanes, total);
+    sum += lanes[0] + lanes[1] + lanes[2] + lanes[3];
+#endif
+#ifdef CONVERT_USE_NEON
+    float32x4_t total = vdupq_n_f32(0.0f);
+    for (; i + 4 <= count; i += 4) {
+        total = vmlaq_f32(total, vld1q_f32(a + i), vld1q_f32(b + i));
+    }
+    float lanes[4];
+    vst1q_f32(lanes, total);
+    sum += lanes[0] + lanes[1] + lanes[2] + lanes[3];
+#endif
+    for (; i < count; i++) {
+        sum += a[i] * b[i];
+    }
+    return sum;
+}
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	accumulateS16
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	void accumulateS16(const int16_t *in, int32_t *sum, int samples)
+--                                 in - 16 bit signed samples to add
+--                                 sum - running sums, one per sample
+--                                 samples - number of samples
+--
+-- RETURNS:     void
+--
+-------------------------------------------------------------------------------------------------------------------*/
+void SampleConvert::accumulateS16(const int16_t *in, int32_t *sum, int samples) {
+    int i = 0;
+#ifdef CONVERT_USE_AVX2
+    for (; i + 8 <= samples; i += 8) {
+        __m256i value = _mm256_cvtepi16_epi32(_mm_loadu_si128((const __m128i *)(in + i)));
+        __m256i total = _mm256_loadu_si256((const __m256i *)(sum + i));
+        _mm256_storeu_si256((__m256i *)(sum + i), _mm256_add_epi32(total, value));
+    }
+#endif
+#ifdef CONVERT_USE_SSE2
+    for (; i + 8 <= samples; i += 8) {
+        __m128i value = _mm_loadu_si128((const __m128i *)(in + i));
+        __m128i low = _mm_srai_epi32(_mm_unpacklo_epi16(value, value), 16);
+        __m128i high = _mm_srai_epi32(_mm_unpackhi_epi16(value, value), 16);
+        _mm_storeu_si128((__m128i *)(sum + i), _mm_add_epi32(_mm_loadu_si128((const __m128i *)(sum + i)), low));
+        _mm_storeu_si128((__m128i *)(sum + i + 4),
+                         _mm_add_epi32(_mm_loadu_si128((const __m128i *)(sum + i + 4)), high));
+    }
+#endif
+#ifdef CONVERT_USE_NEON
+    for (; i + 8 <= samples; i += 8) {
+        int16x8_t value = vld1q_s16(in + i);
+        vst1q_s32(sum + i, vaddw_s16(vld1q_s32(sum + i), vget_low_s16(value)));
+        vst1q_s32(sum + i + 4, vaddw_s16(vld1q_s32(sum + i + 4), vget_high_s16(value)));
+    }
+#endif
+    for (; i < samples; i++) {
+        sum[i] += in[i];
+    }
+}
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	mixMinusS16
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	void mixMinusS16(const int32_t *sum, const int16_t *own, int16_t *out, int samples)
+--                               sum - sums made by accumulateS16
+--                               own - the listener's own samples to take out, nullptr if they were not added
+--                               out - destination for the mix, clipped to 16 bits
+--                               samples - number of samples
+--
+-- RETURNS:     void
+--
+-------------------------------------------------------------------------------------------------------------------*/
+void SampleConvert::mixMinusS16(const int32_t *sum, const int16_t *own, int16_t *out, int samples) {
+    int i = 0;
+#ifdef CONVERT_USE_AVX2
+    for (; own != nullptr && i + 16 <= samples; i += 16) {
+        __m256i low = _mm256_sub_epi32(_mm256_loadu_si256((const __m256i *)(sum + i)),
+                                       _mm256_cvtepi16_epi32(_mm_loadu_si128((const __m128i *)(own + i))));
+        __m256i high = _mm256_sub_epi32(_mm256_loadu_si256((const __m256i *)(sum + i + 8)),
+                                        _mm256_cvtepi16_epi32(_mm_loadu_si128((const __m128i *)(own + i + 8))));
+        // The pack works within each 128 bit half, so the middle quarters come out swapped
+        __m256i packed = _mm256_permute4x64_epi64(_mm256_packs_epi32(low, high), 0xD8);
+        _mm256_storeu_si256((__m256i *)(out + i), packed);
+    }
+#endif
+#ifdef CONVERT_USE_SSE2
+    for (; i + 8 <= samples; i += 8) {
+        __m128i low = _mm_loadu_si128((const __m128i *)(sum + i));
+        __m128i high = _mm_loadu_si128((const __m128i *)(sum + i + 4));
+        if (own != nullptr) {
+            __m128i value = _mm_loadu_si128((const __m128i *)(own + i));
+            low = _mm_sub_epi32(low, _mm_srai_epi32(_mm_unpacklo_epi16(value, value), 16));
+            high = _mm_sub_epi32(high, _mm_srai_epi32(_mm_unpackhi_epi16(value, value), 16));
+        }
+        _mm_storeu_si128((__m128i *)(out + i), _mm_packs_epi32(low, high));
+    }
+#endif
+#ifdef CONVERT_USE_NEON
+    for (; i + 8 <= samples; i += 8) {
+        int32x4_t low = vld1q_s32(sum + i);
+        int32x4_t high = vld1q_s32(sum + i + 4);
+        if (own != nullptr) {
+            int16x8_t value = vld1q_s16(own + i);
+            low = vsubw_s16(low, vget_low_s16(value));
+            high = vsubw_s16(high, vget_high_s16(value));
+        }
+        vst1q_s16(out + i, vcombine_s16(vqmovn_s32(low), vqmovn_s32(high)));
+    }
+#endif
+    for (; i < samples; i++) {
+        int32_t value = own != nullptr ? sum[i] - own[i] : sum[i];
+        out[i] = (int16_t)(value > 32767 ? 32767 : value < -32768 ? -32768 : value);
+    }
+}
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	setRates
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	bool setRates(int inputRate, int outputRate, int channels)
+--                            inputRate - sample rate of the audio given to process()
+--                            outputRate - sample rate wanted
+--                            channels - channels in each frame
+--
+-- RETURNS:     True if the audio needs resampling, false if the rates match or cannot be handled
+--
+-- NOTES:
+--              Builds the filter rows. Row p is the filter for output frames that lie p / phases of the way
+--              from one input frame to the next, centred between taps taps / 2 - 1 and taps / 2. Every row is
+--              scaled to a gain of exactly one so a constant signal stays constant.
+--
+-------------------------------------------------------------------------------------------------------------------*/
+bool Resampler::setRates(int inputRate, int outputRate, int channels) {
+    active = false;
+    if (inputRate <= 0 || outputRate <= 0 || inputRate == outputRate || channels <= 0 ||
+            channels > CONVERT_MAX_CHANNELS) {
+        return false;
+    }
+    uint32_t a = (uint32_t)inputRate;
+    uint32_t b = (uint32_t)outputRate;
+    while (b != 0) {
+        uint32_t r = a % b;
+        a = b;
+        b = r;
+    }
+    up = (uint32_t)outputRate / a;
+    down = (uint32_t)inputRate / a;
+    phases = up < RESAMPLE_MAX_PHASES ? (int)up : RESAMPLE_MAX_PHASES;
+
+    double cutoff = RESAMPLE_CUTOFF * (up < down ? (double)up / down : 1.0);
+    taps = (int)ceil(RESAMPLE_BASE_TAPS * RESAMPLE_CUTOFF / cutoff);
+    taps = (taps + 7) & ~7;
+    if (taps > RESAMPLE_MAX_TAPS) {
+        taps = RESAMPLE_MAX_TAPS;
+    }
+
+    const double pi = 3.14159265358979323846;
+    int centre = taps / 2 - 1;
+    coefficients.resize((size_t)phases * taps);
+    for (int p = 0; p < phases; p++) {
+        float *row = coefficients.data() + (size_t)p * taps;
+        double offset = (double)p / phases;
+        double sum = 0;
+        for (int i = 0; i < taps; i++) {
+            double distance = i - centre - offset;
+            double x = distance / (taps / 2.0);
+            double window = x <= -1 || x >= 1 ? 0 : 0.42 + 0.5 * cos(pi * x) + 0.08 * cos(2 * pi * x);
+            double sinc = distance == 0 ? 1 : sin(pi * cutoff * distance) / (pi * cutoff * distance);
+            row[i] = (float)(sinc * window);
+            sum += row[i];
+        }
+        for (int i = 0; i < taps; i++) {
+            row[i] = (float)(row[i] / sum);
+        }
+    }
+
+    this->channels = channels;
+    active = true;
+    reset();
+    return true;
+}
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	reset
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	void reset()
+--
+-- RETURNS:     void
+--
+-- NOTES:
+--              Starts again from silence. The history is primed so the first output frame lines up with the
+--              first input frame; the audio comes out taps / 2 input frames late.
+--
+-------------------------------------------------------------------------------------------------------------------*/
+void Resampler::reset() {
+    for (int c = 0; c < CONVERT_MAX_CHANNELS; c++) {
+        planes[c].assign(c < channels ? taps / 2 - 1 : 0, 0.0f);
+    }
+    start = 0;
+    phase = 0;
+}
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	process
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	int process(const float *in, int frames, std::vector<float> &out)
+--                          in - interleaved input frames
+--                          frames - number of input frames
+--                          out - resized to hold the interleaved output frames
+--
+-- RETURNS:     The number of output frames
+--
+-- NOTES:
+--              The input is split into one history per channel so every tap run is contiguous for dot().
+--              Output frames are made for as long as a whole row of input is there, stepping down / up input
+--              frames each time in whole frames plus a phase, and the frames no longer needed are dropped.
+--
+-------------------------------------------------------------------------------------------------------------------*/
+int Resampler::process(const float *in, int frames, std::vector<float> &out) {
+    float *tails[CONVERT_MAX_CHANNELS];
+    int held = (int)planes[0].size();
+    for (int c = 0; c < channels; c++) {
+        planes[c].resize(held + frames);
+        tails[c] = planes[c].data() + held;
+    }
+    SampleConvert::deinterleave(in, channels, frames, tails);
+
+    int available = held + frames;
+    out.resize(((size_t)(available - start) * up / down + 2) * channels);
+    int count = 0;
+    while (start + taps <= available) {
+        const float *row = coefficients.data() + (size_t)((uint64_t)phase * phases / up) * taps;
+        for (int c = 0; c < channels; c++) {
+            out[count * channels + c] = SampleConvert::dot(row, planes[c].data() + start, taps);
+        }
+        count++;
+        phase += down;
+        start += phase / up;
+        phase %= up;
+    }
+
+    int consumed = start < available ? start : available;
+    for (int c = 0; c < channels; c++) {
+        planes[c].erase(planes[c].begin(), planes[c].begin() + consumed);
+    }
+    start -= consumed;
+    return count;
+}
@@ -0,0 +1,55 @@
+#pragma once
+#include <cstdint>
+#include <cstring>
+#include <vector>
+#include "streampacket.h"
+
+#define CONVERT_MAX_CHANNELS 8
+#define RESAMPLE_BASE_TAPS 32
+#define RESAMPLE_MAX_TAPS 256
+#define RESAMPLE_MAX_PHASES 1024
+#define RESAMPLE_CUTOFF 0.92
+
+class SampleConvert {
+public:
+    static bool handles(const StreamDescriptor &format);
+    static const char *getKernelName();
+    static void toFloat(const char *in, const StreamDescriptor &format, float *out, int samples);
+    static void fromFloat(const float *in, const StreamDescriptor &format, char *out, int samples);
+    static void s16ToFloat(const char *in, float *out, int samples, uint16_t signFlip);
+    static void floatToS16(const float *in, char *out, int samples, uint16_t signFlip);
+    static void deinterleave(const float *in, int channels, int frames, float *const *planes);
+    static void interleave(const float *const *planes, int channels, int frames, float *out);
+    static void downmixStereo(const float *in, float *out, int frames);
+    static void remix(const float *in, int inChannels, float *out, int outChannels, int frames);
+    static float dot(const float *a, const float *b, int count);
+    static void accumulateS16(const int16_t *in, int32_t *sum, int samples);
+    static void mixMinusS16(const int32_t *sum, const int16_t *own, int16_t *out, int samples);
+};
+
+class Resampler {
+public:
+    Resampler() = default;
+    Resampler(const Resampler&) = delete;
+    void operator=(const Resampler&) = delete;
+
+    bool setRates(int inputRate, int outputRate, int channels);
+    void reset();
+    int process(const float *in, int frames, std::vector<float> &out);
+
+    bool isActive() const {
+        return active;
+    }
+
+private:
+    bool active = false;
+    int channels = 0;
+    uint32_t up = 1;
+    uint32_t down = 1;
+    int phases = 0;
+    int taps = 0;
+    std::vector<float> coefficients;
+    std::vector<float> planes[CONVERT_MAX_CHANNELS];
+    int start = 0;
+    uint32_t phase = 0;
+};
@@ -92,7 +92,12 @@ DWORD Server::createTCPServer(LPVOID lpParameter) {
 --
 -- DATE:		March 23, 2020
 --
--- REVISIONS:
+-- REVISIONS:   October 19, 2026 - Reset the stream sequence and FEC encoder for each stream - agent
+--              October 19, 2026 - Open the NACK repair channel - agent
+--              October 19, 2026 - Stream the WAV data chunk in its own format - agent
+--              October 19, 2026 - Add a channel to the ChannelManager instead of streaming here - agent
+--              October 19, 2026 - Stream the selected playlist - agent
+--              October 19, 2026 - Remember the channel for the transport controls - agent
 --
 -- DESIGNER: 	Ellaine Chan
 --
@@ -104,12 +109,21 @@ DWORD Server::createTCPServer(LPVOID lpParameter) {
 -- RETURNS:     Returns true when reading is complete
 --
 -- NOTES:
---              Creates a udp socket to multicast datagrams to all clients that are joined.
---              The audio file must already be selected or else this function will return false.
+--              Starts a multicast channel streaming the selected files to the multicast group on the selected
+--              port. Each call adds another channel, so one server can run several stations at once as long as
+--              their ports are at least two apart (the port above each one carries its repairs).
+--              Files that no longer exist are left out of the playlist. At least one audio file must already be
+--              selected or else this function will return false. The media controls on the stream page work on
+--              the channel started last.
 -------------------------------------------------------------------------------------------------------------------*/
 DWORD Server::createMulticastServer(LPVOID lpParameter) {
-    if(Server::getInstance()->streamFileName.size() < 1 ||
-            !FileHandler::fileExists(Server::getInstance()->streamFileName)) {
+    std::vector<std::string> playlist;
+    for (const std::string &fileName : Server::getInstance()->streamPlaylist) {
+        if (fileName.size() > 0 && FileHandler::fileExists(fileName)) {
+            playlist.push_back(fileName);
+        }
+    }
+    if (playlist.empty()) {
         qDebug() << "file not selected \n";
         return FALSE;
     }
@@ -118,98 +132,25 @@ DWORD Server::createMulticastServer(LPVOID lpParameter) {
         return FALSE;
     }
 
-    if ((Server::getInstance()->serverSocket = socket(AF_INET, SOCK_DGRAM, 0)) == INVALID_SOCKET) {
-        qDebug() << "Failed to get a socket \n" << WSAGetLastError();
-        WSACleanup();
-        return FALSE;
-    }
-    memset(&Server::getInstance()->sockAddress, 0, sizeof(Server::getInstance()->sockAddress));
-    Server::getInstance()->sockAddress.sin_family = AF_INET;
-    Server::getInstance()->sockAddress.sin_addr.s_addr = htonl(INADDR_ANY);
-    Server::getInstance()->sockAddress.sin_port = 0;
-
-    if (bind(Server::getInstance()->serverSocket, (PSOCKADDR) &Server::getInstance()->sockAddress,
-             sizeof(sockAddress)) == SOCKET_ERROR) {
-        qDebug() << "bind() failed with error \n" << WSAGetLastError();
+    int channel = ChannelManager::getInstance()->addChannel(playlist,
+                                                            Server::getInstance()->multicast_addr,
+                                                            Server::getInstance()->port,
+                                                            Server::getInstance()->multicast_ttl);
+    if (channel < 0) {
+        qDebug() << "Failed to start a channel on port" << Server::getInstance()->port << "\n";
         return FALSE;
     }
-
-    Server::getInstance()->stMreq.imr_multiaddr.s_addr = inet_addr(Server::getInstance()->multicast_addr);
-    Server::getInstance()->stMreq.imr_interface.s_addr = INADDR_ANY;
-    if (setsockopt(Server::getInstance()->serverSocket, IPPROTO_IP, IP_ADD_MEMBERSHIP,
-                   (char *)&Server::getInstance()->stMreq, sizeof(stMreq)) == SOCKET_ERROR) {
-        qDebug() << "Failed to setsockopt to add membership \n" << WSAGetLastError();
-    }
-
-    if (setsockopt(Server::getInstance()->serverSocket, IPPROTO_IP, IP_MULTICAST_TTL,
-                   (char *)&Server::getInstance()->multicast_ttl, sizeof(Server::getInstance()->multicast_ttl)) == SOCKET_ERROR) {
-        qDebug() << "Failed to setsockopt to set ttl \n" << WSAGetLastError();
-    };
-
-    bool fFlag = FALSE;
-    if (setsockopt(Server::getInstance()->serverSocket, IPPROTO_IP, IP_MULTICAST_LOOP, (char *)&fFlag, sizeof(fFlag)) == SOCKET_ERROR) {
-        qDebug() << "Failed to setsockopt to disable loopback \n" << WSAGetLastError();
-    }
-
-    Server::getInstance()->multicastDestination.sin_family = AF_INET;
-    Server::getInstance()->multicastDestination.sin_addr.s_addr = inet_addr(Server::getInstance()->multicast_addr);
-    Server::getInstance()->multicastDestination.sin_port = htons((u_short)Server::getInstance()->port);
-
-    Server::getInstance()->fileHandler = new FileHandler(Server::getInstance()->streamFileName);
-
-    char streamBuffer[DATA_BUFSIZE];
-    int read = Server::getInstance()->fileHandler->readFile(DATA_BUFSIZE,streamBuffer);
-    int sent;
-    if (read > 0) {
-        Server::getInstance()->audioPlayer->playFromBufferSilent();
-        Server::getInstance()->audioPlayer->addToPlayBuffer(QByteArray::fromRawData(streamBuffer, DATA_BUFSIZE));
-        if((sent = sendto(Server::getInstance()->serverSocket, (char*)streamBuffer, sizeof(streamBuffer), 0, (struct sockaddr*) &Server::getInstance()->multicastDestination, sizeof(multicastDestination))) < 0) {
-            perror("send to \n");
-        }
-    }
+    Server::getInstance()->streamChannel = channel;
+    qDebug() << "Started channel" << channel << "on port" << Server::getInstance()->port;
     return TRUE;
 }
 
-/*-----------------------------------------------------------------------------------------------------------------
--- Function:	sendNextChunk
---
--- DATE:		March 23, 2020
---
--- REVISIONS:
---
--- DESIGNER: 	Ellaine Chan
---
--- PROGRAMMER: 	Ellaine Chan
---
--- INTERFACE:	void sendNextChunk()
---
--- RETURNS:     void
---
--- NOTES:
---              This is the method that is called when the audio device has no more data to play.
---              This method will read the next chunk of data that the audio device should play, and write it to
---              the audio device to play.
--------------------------------------------------------------------------------------------------------------------*/
-void Server::sendNextChunk(){
-    qDebug() << "sending next chunk";
-    int sent;
-    char streamBuffer[DATA_BUFSIZE];
-    if (Server::getInstance()->fileHandler->readFile(DATA_BUFSIZE,streamBuffer) > 0) {
-        Server::getInstance()->audioPlayer->addToPlayBuffer(QByteArray::fromRawData(streamBuffer, DATA_BUFSIZE));
-        if((sent = sendto(Server::getInstance()->serverSocket, (char*)streamBuffer, sizeof(streamBuffer), 0, (struct sockaddr*) &Server::getInstance()->multicastDestination, sizeof(multicastDestination))) < 0) {
-            perror("send to \n");
-        }
-    } else {
-        Server::getInstance()->audioPlayer->player->stop();
-    }
-};
-
 /*-----------------------------------------------------------------------------------------------------------------
 -- Function:	accpetTCPConnectionThread
 --
 -- DATE:		March 20, 2020
 --
--- REVISIONS:
+-- REVISIONS:   October 19, 2026 - Size each accepted socket's send buffer for file transfers - agent
 --
 -- DESIGNER: 	Victor Phan
 --
@@ -254,6 +195,8 @@ DWORD WINAPI Server::acceptTCPConnectionThread(LPVOID lpParameter) {
         }
         //Intentionally setting index to the CURRENT socket
         int index = Server::getInstance()->clientConnectionIndex++;
+        SocketTuner fileTuner(Server::getInstance()->clientSocket[index], SocketTuner::SEND, SOCKET_FILE_RATE);
+        qDebug() << "File socket buffers:" << fileTuner.describe();
         QString currentTime = QDateTime::currentDateTime().toString("yyyy-MM-dd HH:mm:ss,zzz").append("");
         QString acceptMessage = QString("Client Connected on Socket: ")
                 .append(QString::number(Server::getInstance()->clientSocket[index]))
@@ -310,7 +253,7 @@ void Server::resetServerObj() {
 --
 -- DATE:		March 20, 2020
 --
--- REVISIONS:
+-- REVISIONS:   October 19, 2026 - Calls moved to CallSession, which needs no server thread - agent
 --
 -- DESIGNER: 	Victor Phan
 --
@@ -337,11 +280,6 @@ void Server::startServer(protocol pSelection) {
             qDebug() << "CreateThread failed with error \n" << GetLastError();
             return;
         }
-    } else {
-        if ((threadHandle = CreateThread(NULL, 0, createCallReceiver, NULL, 0, &threadArray[threadIndex++])) == NULL) {
-            qDebug() << "CreateThread failed with error \n" << GetLastError();
-            return;
-        }
     }
 }
 
@@ -391,7 +329,8 @@ bool Server::acceptTCPConnections() {
 --
 -- DATE:		March 20, 2020
 --
--- REVISIONS:
+-- REVISIONS:   October 19, 2026 - Close the stream repair socket - agent
+--              October 19, 2026 - Stop every multicast channel - agent
 --
 -- DESIGNER: 	Victor Phan
 --
@@ -411,6 +350,7 @@ bool Server::shutDownServer() {
     if(serverSocket != 0) {
         closesocket(serverSocket);
     }
+    ChannelManager::getInstance()->stop();
     for(int j = 0; j < MAX_CLIENT_CONNECTIONS; j++) {
         if(clientSocket[j] != 0) {
             closesocket(clientSocket[j]);
@@ -428,170 +368,3 @@ bool Server::shutDownServer() {
     return true;
 }
 
-
-//! Mic --------------------------------------------------------------
-
-/*-----------------------------------------------------------------------------------------------------------------
--- Function:    createCallReceiver
---
--- DATE:		March  30, 2020
---
--- REVISIONS:   NA
---
--- DESIGNER: 	Nicole Jingco
---
--- PROGRAMMER: 	Nicole Jingco
---
--- INTERFACE:
---
--- RETURNS:     NA
---
--- NOTES:
---
---  Creates users socket and binds for two way audio
--------------------------------------------------------------------------------------------------------------------*/
-DWORD Server::createCallReceiver(LPVOID lpParameter)
-{
-    int err;
-    char recvBuff = MIC_BUFF;
-
-    if (!Server::getInstance()->startUpWSA()) {
-        qDebug() << "WSAStartup failed with error \n" << Server::getInstance()->ret;
-        return FALSE;
-    }
-
-    if ((Server::getInstance()->serverSocket =  WSASocket(PF_INET, SOCK_DGRAM, 0, NULL,0,WSA_FLAG_OVERLAPPED)) == INVALID_SOCKET)
-    {
-        qDebug() << "Failed to get a socket \n" << WSAGetLastError();
-        WSACleanup();
-        return FALSE;
-    }
-
-    Server::getInstance()->sockAddress.sin_family = PF_INET;
-    Server::getInstance()->sockAddress.sin_addr.s_addr = htonl(INADDR_ANY);
-    Server::getInstance()->sockAddress.sin_port = htons((u_short)getInstance()->port);
-
-    err = setsockopt(Server::getInstance()->serverSocket, SOL_SOCKET, SO_RCVBUF, (const char*)&recvBuff, sizeof(recvBuff));
-
-    if (bind(Server::getInstance()->serverSocket, (PSOCKADDR) &Server::getInstance()->sockAddress,
-             sizeof(sockAddress)) == SOCKET_ERROR) {
-        qDebug() << "bind() failed with error \n" << WSAGetLastError();
-        return FALSE;
-    }
-
-    getInstance()->getVoice();
-
-
-    return TRUE;
-}
-
-/*-----------------------------------------------------------------------------------------------------------------
--- Function:    getVoice
---
--- DATE:		March  30, 2020
---
--- REVISIONS:   NA
---
--- DESIGNER: 	Nicole Jingco
---
--- PROGRAMMER: 	Nicole Jingco
---
--- INTERFACE:
---
--- RETURNS:     NA
---
--- NOTES:
---
--- This function receives udp datagram from the client
--------------------------------------------------------------------------------------------------------------------*/
-DWORD Server::getVoice()
-{
-    LPSOCKET_INFORMATION SocketInfo;
-    AudioDevice *audioPlayer = getInstance()->audioDevice;
-    DWORD Flags, Index, RecvBytes;
-    WSAEVENT readEvent;
-    struct sockaddr_in SenderAddr;
-    int SenderAddrSize = sizeof (SenderAddr);
-
-    Flags = 0;
-
-    if ((SocketInfo = (LPSOCKET_INFORMATION)GlobalAlloc(GPTR,
-                                                        sizeof(SOCKET_INFORMATION))) == NULL)
-    {
-        qDebug() << "GlobalAlloc() failed with error \n"
-                 << GetLastError();
-    }
-
-    SocketInfo->Socket = Server::getInstance()->serverSocket;
-    ZeroMemory(&(SocketInfo->Overlapped), sizeof(WSAOVERLAPPED));
-    SocketInfo->DataBuf.len = MIC_BUFF;
-    SocketInfo->DataBuf.buf = SocketInfo->Buffer;
-    SocketInfo->audioPlayer = audioPlayer;
-    SocketInfo->audioPlayer->playFromBuffer();
-
-    if ((readEvent = WSACreateEvent()) == WSA_INVALID_EVENT)
-    {
-        qDebug() << "WSACreateEvent() failed with error \n"
-                 << WSAGetLastError();
-        return 1;
-    }
-
-    if (WSAEventSelect(getInstance()->serverSocket, readEvent, FD_READ))
-    {
-        qDebug() << "Faled to tie event to socket";
-        return 1;
-    }
-
-    SocketInfo->audioPlayer->playFromBuffer();
-
-    while (Server::getInstance()->isReceiving)
-    {
-        Index = WSAWaitForMultipleEvents(1, &readEvent, FALSE, WSA_INFINITE, TRUE);
-
-        if (WSARecvFrom(SocketInfo->Socket, &(SocketInfo->DataBuf), 1, &RecvBytes, &Flags,
-                        (SOCKADDR *) &SenderAddr, &SenderAddrSize, &(SocketInfo->Overlapped), PlayVoiceWorkerRoutine) < 0)
-        {
-
-        }
-    }
-}
-
-/*-----------------------------------------------------------------------------------------------------------------
--- Function:    PlayVoiceWorkerRoutine
---
--- DATE:		March  30, 2020
---
--- REVISIONS:   NA
---
--- DESIGNER: 	Nicole Jingco
---
--- PROGRAMMER: 	Nicole Jingco
---
--- INTERFACE:
---
--- RETURNS:     NA
---
--- NOTES:
---
--- Worker function used to play audio received from getVoice
--------------------------------------------------------------------------------------------------------------------*/
-void CALLBACK Server::PlayVoiceWorkerRoutine(DWORD error, DWORD bytesTransferred, LPWSAOVERLAPPED overlapped, DWORD InFlags)
-{
-    LPSOCKET_INFORMATION SI = (LPSOCKET_INFORMATION)overlapped;
-    if (error != 0)
-    {
-        qDebug() << "I/O operation failed with error: " << error;
-    }
-
-    if (error != 0 || bytesTransferred == 0)
-    {
-        //Close the socket
-        QString message = QString("Read Complete on socket: ").append(QString::number(SI->Socket));
-        emit SI->device->sendMessageToScreen(message);
-        closeSocket(SI->Socket);
-        GlobalFree(SI);
-        return;
-    }
-    qDebug() << "received! Playing!";
-    SI->audioPlayer->addToPlayBuffer(QByteArray::fromRawData(SI->Buffer, bytesTransferred));
-}
@@ -1,6 +1,7 @@
 #pragma once
 #include "connectiondevice.h"
 #include "filehandler.h"
+#include "channelmanager.h"
 
 #define MAX_CLIENT_CONNECTIONS 100
 #define MAX_SERVER_THREADS 100
@@ -11,11 +12,9 @@ private:
     Server() = default;
     static DWORD WINAPI createTCPServer(LPVOID lpParameter);
     static DWORD WINAPI createMulticastServer(LPVOID lpParameter);
-    static DWORD WINAPI createCallReceiver(LPVOID lpParameter);
 
     static DWORD WINAPI acceptTCPConnectionThread(LPVOID lpParameter);
 
-    DWORD getVoice();
     void resetServerObj();
     bool acceptTCPConnections();
 
@@ -25,20 +24,14 @@ public:
     WSADATA wsaData;
     SOCKET serverSocket;
     SOCKADDR_IN sockAddress;
-    SOCKADDR_IN multicastDestination;
     INT ret;
     HANDLE threadHandle;
     WSAEVENT acceptEvent;
-    ip_mreq stMreq;
     int port;
-    std::string streamFileName;
-
-    AudioDevice *audioPlayer;
-    AudioDevice *audioDevice;
-    FileHandler *fileHandler;
+    std::vector<std::string> streamPlaylist;
+    volatile int streamChannel = -1;
 
     void startServer(protocol pSelection);
-    bool isReceiving = false;
 
     static Server* getInstance() {
         static Server* server = new Server();
@@ -47,14 +40,7 @@ public:
     void operator=(Server const&) = delete;
     ~Server() = default;
 
-    void setAudioPlayer(AudioDevice * player) {
-        audioPlayer = player;
-    }
     static QString createPacketMessage(QString bytesReceived);
 
     bool shutDownServer();
-    static void CALLBACK PlayVoiceWorkerRoutine(DWORD error, DWORD bytesTransferred, LPWSAOVERLAPPED overlapped, DWORD InFlags);
-
-public slots:
-    void sendNextChunk();
 };
@@ -0,0 +1,330 @@
+/*------------------------------------------------------------------------------------------------------------------
+-- SOURCE FILE: 	sockettuner.cpp - Sizes a socket's kernel buffers for the traffic it carries.
+--
+--
+-- PROGRAM: 		Communication Audio Program
+--
+-- FUNCTIONS:
+--                  SocketTuner(SOCKET sock, int directions, uint32_t bytesPerSecond)
+--                  static int getBufferSize(uint32_t bytesPerSecond, uint32_t holdMs, uint32_t burstBytes)
+--                  void setRate(uint32_t bytesPerSecond)
+--                  void update(uint32_t rttMs, uint32_t burstBytes, uint32_t now)
+--                  QString describe() const
+--                  static bool readKernelDrops(DWORD &drops)
+--                  void apply()
+--                  void resize(int option, int bytes, int &requested, int &granted)
+--
+-- DATE: 			October 19, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: 		agent
+--
+-- PROGRAMMER: 		agent
+--
+-- NOTES:
+--      Every socket used to run on the stack's default buffers, whatever it carried. A SocketTuner sizes
+--      SO_RCVBUF and SO_SNDBUF from what is known about the traffic: the rate it runs at, the round trip and
+--      the largest burst seen. A buffer is made SOCKET_TUNE_HEADROOM times what can be in it at once, which is
+--      the rate for the longer of the round trip and SOCKET_TUNE_MIN_HOLD_MS, plus the largest burst on the
+--      receive side. That covers a round trip's worth of repairs arriving together as well as a join burst.
+--      Sizes stay between SOCKET_BUFFER_MIN and SOCKET_BUFFER_MAX.
+--
+--      The owner calls update() as it runs, and every SOCKET_TUNE_INTERVAL_MS the sizes are worked out again.
+--      A buffer is only resized when it would change by more than SOCKET_TUNE_CHANGE_PERCENT, and after each
+--      change the size the stack actually granted is read back, since it may round, double or cap what was
+--      asked for.
+--
+--      Windows keeps no drop count per socket. For a UDP receive socket the tuner follows the stack's count of
+--      UDP datagrams that could not be delivered, which includes those dropped for a full receive buffer.
+--      That count covers every UDP socket on the machine, so it says a buffer may still be too small rather
+--      than which one. Each time it rises the receive buffer is doubled, up to SOCKET_TUNE_MAX_GROWTH times
+--      the computed size.
+--
+--      A TCP socket is only tuned for sending. Setting its receive buffer would turn off the stack's own
+--      receive window tuning, which already follows the round trip.
+--
+--------------------------------------------------------------------------------------------------------------------*/
+#include "sockettuner.h"
+#include <cstdlib>
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	SocketTuner
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	SocketTuner(SOCKET sock, int directions, uint32_t bytesPerSecond)
+--                          sock - socket to tune, still owned by the caller
+--                          directions - RECEIVE, SEND or BOTH
+--                          bytesPerSecond - rate the socket is expected to carry, 0 if not known yet
+--
+-- RETURNS:     NA
+--
+-- NOTES:
+--              Sizes the buffers straight away, assuming SOCKET_TUNE_DEFAULT_RTT_MS until a round trip is
+--              known and SOCKET_TUNE_DEFAULT_RATE until a rate is.
+--
+-------------------------------------------------------------------------------------------------------------------*/
+SocketTuner::SocketTuner(SOCKET sock, int directions, uint32_t bytesPerSecond)
+    : sock(sock), directions(directions),
+      bytesPerSecond(bytesPerSecond > 0 ? bytesPerSecond : SOCKET_TUNE_DEFAULT_RATE) {
+    int type = 0;
+    int size = sizeof(type);
+    datagram = getsockopt(sock, SOL_SOCKET, SO_TYPE, (char *)&type, &size) != SOCKET_ERROR && type == SOCK_DGRAM;
+    if (!datagram) {
+        this->directions &= SEND;
+    }
+    size = sizeof(stats.grantedReceive);
+    getsockopt(sock, SOL_SOCKET, SO_RCVBUF, (char *)&stats.grantedReceive, &size);
+    size = sizeof(stats.grantedSend);
+    getsockopt(sock, SOL_SOCKET, SO_SNDBUF, (char *)&stats.grantedSend, &size);
+    countingDrops = datagram && (this->directions & RECEIVE) && readKernelDrops(dropsAtStart);
+    tunedAt = GetTickCount();
+    apply();
+}
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	getBufferSize
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	static int getBufferSize(uint32_t bytesPerSecond, uint32_t holdMs, uint32_t burstBytes)
+--                                       bytesPerSecond - rate the socket carries
+--                                       holdMs - how long the buffer may have to hold that rate
+--                                       burstBytes - largest burst that may arrive on top of it
+--
+-- RETURNS:     The buffer size in bytes, between SOCKET_BUFFER_MIN and SOCKET_BUFFER_MAX
+--
+-------------------------------------------------------------------------------------------------------------------*/
+int SocketTuner::getBufferSize(uint32_t bytesPerSecond, uint32_t holdMs, uint32_t burstBytes) {
+    uint64_t bytes = ((uint64_t)bytesPerSecond * holdMs / 1000 + burstBytes) * SOCKET_TUNE_HEADROOM;
+    if (bytes < SOCKET_BUFFER_MIN) {
+        return SOCKET_BUFFER_MIN;
+    }
+    return bytes > SOCKET_BUFFER_MAX ? SOCKET_BUFFER_MAX : (int)bytes;
+}
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	setRate
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	void setRate(uint32_t bytesPerSecond)
+--                           bytesPerSecond - rate the socket now carries
+--
+-- RETURNS:     void
+--
+-- NOTES:
+--              Resizes at once, for a stream or call that has just announced its format.
+--
+-------------------------------------------------------------------------------------------------------------------*/
+void SocketTuner::setRate(uint32_t bytesPerSecond) {
+    if (bytesPerSecond == 0 || bytesPerSecond == this->bytesPerSecond) {
+        return;
+    }
+    this->bytesPerSecond = bytesPerSecond;
+    apply();
+}
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	update
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	void update(uint32_t rttMs, uint32_t burstBytes, uint32_t now)
+--                          rttMs - round trip measured to the peer, 0 if none yet
+--                          burstBytes - bytes that arrived together since the last call
+--                          now - current tick in milliseconds
+--
+-- RETURNS:     void
+--
+-- NOTES:
+--              Cheap enough to call on every wake. The largest burst is remembered, and the kernel's drops
+--              and the sizes are only looked at every SOCKET_TUNE_INTERVAL_MS.
+--
+-------------------------------------------------------------------------------------------------------------------*/
+void SocketTuner::update(uint32_t rttMs, uint32_t burstBytes, uint32_t now) {
+    if (rttMs > 0) {
+        this->rttMs = rttMs;
+    }
+    if (burstBytes > this->burstBytes) {
+        this->burstBytes = burstBytes;
+    }
+    if (now - tunedAt < SOCKET_TUNE_INTERVAL_MS) {
+        return;
+    }
+    tunedAt = now;
+
+    DWORD drops;
+    if (countingDrops && readKernelDrops(drops)) {
+        uint32_t dropped = drops - dropsAtStart;
+        if (dropped > stats.kernelDrops) {
+            stats.dropRises++;
+            growth = growth * 2 > SOCKET_TUNE_MAX_GROWTH ? SOCKET_TUNE_MAX_GROWTH : growth * 2;
+        }
+        stats.kernelDrops = dropped;
+    }
+    apply();
+}
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	describe
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	QString describe() const
+--
+-- RETURNS:     The sizes asked for and granted, the resizes and the kernel's drops, as text
+--
+-------------------------------------------------------------------------------------------------------------------*/
+QString SocketTuner::describe() const {
+    QString receive = stats.requestedReceive > 0 ? QString("receive %1 of %2 bytes granted")
+                                                   .arg(stats.grantedReceive).arg(stats.requestedReceive)
+                                                 : QString("receive %1 bytes by default").arg(stats.grantedReceive);
+    QString send = stats.requestedSend > 0 ? QString("send %1 of %2 bytes granted")
+                                             .arg(stats.grantedSend).arg(stats.requestedSend)
+                                           : QString("send %1 bytes by default").arg(stats.grantedSend);
+    QString drops = !countingDrops ? QString("")
+        : QString(", %1 UDP datagrams dropped by the kernel while tuned, receive buffer grown %2 times")
+          .arg((qint64)stats.kernelDrops).arg((qint64)stats.dropRises);
+    return QString("%1, %2, %3 resizes, %4 failed%5")
+            .arg(receive)
+            .arg(send)
+            .arg((qint64)stats.resizes)
+            .arg((qint64)stats.failures)
+            .arg(drops);
+}
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	readKernelDrops
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	static bool readKernelDrops(DWORD &drops)
+--                                          drops - set to the stack's count of undeliverable UDP datagrams
+--
+-- RETURNS:     False if the stack's UDP statistics could not be read
+--
+-------------------------------------------------------------------------------------------------------------------*/
+bool SocketTuner::readKernelDrops(DWORD &drops) {
+    MIB_UDPSTATS udp;
+    if (GetUdpStatistics(&udp) != NO_ERROR) {
+        return false;
+    }
+    drops = udp.dwInErrors;
+    return true;
+}
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	apply
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	void apply()
+--
+-- RETURNS:     void
+--
+-- NOTES:
+--              Works the sizes out again and resizes each buffer that is off by more than
+--              SOCKET_TUNE_CHANGE_PERCENT. The send side holds no bursts, since the socket sends them itself.
+--
+-------------------------------------------------------------------------------------------------------------------*/
+void SocketTuner::apply() {
+    uint32_t holdMs = rttMs > SOCKET_TUNE_MIN_HOLD_MS ? rttMs : SOCKET_TUNE_MIN_HOLD_MS;
+    if (directions & RECEIVE) {
+        int64_t bytes = (int64_t)getBufferSize(bytesPerSecond, holdMs, burstBytes) * growth;
+        bytes = bytes > SOCKET_BUFFER_MAX ? SOCKET_BUFFER_MAX : bytes;
+        int64_t change = llabs(bytes - stats.requestedReceive) * 100;
+        if (change > (int64_t)stats.requestedReceive * SOCKET_TUNE_CHANGE_PERCENT) {
+            resize(SO_RCVBUF, (int)bytes, stats.requestedReceive, stats.grantedReceive);
+        }
+    }
+    if (directions & SEND) {
+        int64_t bytes = getBufferSize(bytesPerSecond, holdMs, 0);
+        int64_t change = llabs(bytes - stats.requestedSend) * 100;
+        if (change > (int64_t)stats.requestedSend * SOCKET_TUNE_CHANGE_PERCENT) {
+            resize(SO_SNDBUF, (int)bytes, stats.requestedSend, stats.grantedSend);
+        }
+    }
+}
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	resize
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	void resize(int option, int bytes, int &requested, int &granted)
+--                          option - SO_RCVBUF or SO_SNDBUF
+--                          bytes - size to ask for
+--                          requested - set to bytes
+--                          granted - set to the size the stack reports afterwards
+--
+-- RETURNS:     void
+--
+-- NOTES:
+--              A size that was refused is still remembered as asked for, so it is not asked for again until
+--              the traffic changes.
+--
+-------------------------------------------------------------------------------------------------------------------*/
+void SocketTuner::resize(int option, int bytes, int &requested, int &granted) {
+    requested = bytes;
+    if (setsockopt(sock, SOL_SOCKET, option, (const char *)&bytes, sizeof(bytes)) == SOCKET_ERROR) {
+        if (stats.failures++ == 0) {
+            qDebug() << "Failed to resize a socket buffer to" << bytes << "bytes, error" << WSAGetLastError();
+        }
+        return;
+    }
+    stats.resizes++;
+    int size = sizeof(granted);
+    if (getsockopt(sock, SOL_SOCKET, option, (char *)&granted, &size) == SOCKET_ERROR) {
+        granted = bytes;
+    }
+}
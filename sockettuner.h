@@ -0,0 +1,66 @@
+#pragma once
+#include <winsock2.h>
+#include <windows.h>
+#include <iphlpapi.h>
+#include <cstdint>
+#include <QDebug>
+#include <QString>
+
+#define SOCKET_BUFFER_MIN 8192
+#define SOCKET_BUFFER_MAX (4 * 1024 * 1024)
+#define SOCKET_TUNE_DEFAULT_RATE 176400
+#define SOCKET_TUNE_DEFAULT_RTT_MS 100
+#define SOCKET_TUNE_MIN_HOLD_MS 50
+#define SOCKET_TUNE_HEADROOM 2
+#define SOCKET_TUNE_MAX_GROWTH 8
+#define SOCKET_TUNE_INTERVAL_MS 2000
+#define SOCKET_TUNE_CHANGE_PERCENT 25
+#define SOCKET_FILE_RATE 12500000
+
+class SocketTuner {
+public:
+    enum Direction {
+        RECEIVE = 1,
+        SEND = 2,
+        BOTH = 3
+    };
+
+    struct Statistics {
+        int requestedReceive = 0;
+        int grantedReceive = 0;
+        int requestedSend = 0;
+        int grantedSend = 0;
+        uint32_t resizes = 0;
+        uint32_t failures = 0;
+        uint32_t kernelDrops = 0;
+        uint32_t dropRises = 0;
+    };
+
+    SocketTuner(SOCKET sock, int directions, uint32_t bytesPerSecond);
+
+    static int getBufferSize(uint32_t bytesPerSecond, uint32_t holdMs, uint32_t burstBytes);
+    void setRate(uint32_t bytesPerSecond);
+    void update(uint32_t rttMs, uint32_t burstBytes, uint32_t now);
+    QString describe() const;
+
+    const Statistics &getStatistics() const {
+        return stats;
+    }
+
+private:
+    SOCKET sock;
+    int directions;
+    bool datagram = false;
+    uint32_t bytesPerSecond;
+    uint32_t rttMs = SOCKET_TUNE_DEFAULT_RTT_MS;
+    uint32_t burstBytes = 0;
+    int growth = 1;
+    bool countingDrops = false;
+    DWORD dropsAtStart = 0;
+    uint32_t tunedAt = 0;
+    Statistics stats;
+
+    static bool readKernelDrops(DWORD &drops);
+    void apply();
+    void resize(int option, int bytes, int &requested, int &granted);
+};
@@ -0,0 +1,1120 @@
+/*------------------------------------------------------------------------------------------------------------------
+-- SOURCE FILE: 	streamchannel.cpp - One multicast station: a source file sent to its own group and port.
+--
+--
+-- PROGRAM: 		Communication Audio Program
+--
+-- FUNCTIONS:
+--                  StreamChannel(int id, const std::vector<std::string> &playlist, const std::string &group,
+--                                int port, int fecGroupSize, uint8_t codec, DatagramIO *sender, PacketPool *pool)
+--                  ~StreamChannel()
+--                  bool open()
+--                  bool openRepairSocket()
+--                  void useFormat(const StreamDescriptor &format)
+--                  void startPrefetch(int index)
+--                  bool nextTrackReady()
+--                  bool advanceTrack()
+--                  int pump(uint64_t now)
+--                  uint64_t getNextDeadline() const
+--                  void pause()
+--                  void resume()
+--                  bool seek(uint32_t positionMs)
+--                  bool skip(int32_t deltaMs)
+--                  int readChunk(char *buf)
+--                  bool sendNext()
+--                  void sendDescriptor()
+--                  void sendTrackChange()
+--                  void sendDiscontinuity()
+--                  void sendDatagram(const char *datagram, int bytes)
+--                  void serviceRepairs()
+--                  void sendBurst(const SOCKADDR_IN &listener, uint16_t burstMs)
+--                  void subscribe(const SOCKADDR_IN &listener)
+--                  void fanOut()
+--                  QString getStatistics() const
+--
+-- DATE: 			October 19, 2026
+--
+-- REVISIONS:       October 19, 2026 - Stream a looping playlist with the next track prefetched - agent
+--                  October 19, 2026 - Compress the audio with the channel's codec - agent
+--                  October 19, 2026 - Send new listeners a burst of recent audio - agent
+--                  October 19, 2026 - Queue datagrams for batched sends - agent
+--                  October 19, 2026 - Fan the stream out to unicast subscribers - agent
+--                  October 19, 2026 - Report how fast compressed tracks decode - agent
+--                  October 19, 2026 - Convert every track to the channel's format - agent
+--                  October 19, 2026 - Pause, resume and seek the stream - agent
+--                  October 19, 2026 - Answer echo probes from listeners - agent
+--                  October 19, 2026 - Give each subscriber its own queue through a FanOut - agent
+--
+-- DESIGNER: 		agent
+--
+-- PROGRAMMER: 		agent
+--
+-- NOTES:
+--      A channel holds everything that used to be the Server's single stream: the source and its format,
+--      the sequence counter, the FEC encoder, the retransmission history and the unicast repair socket on
+--      port + STREAM_REPAIR_PORT_OFFSET. Channels do not own a thread or a multicast socket. The ChannelManager
+--      pacing thread calls pump() and serviceRepairs() on every channel, and all channels send through the
+--      manager's DatagramIO, which sends everything queued in one wake together.
+--
+--      Packets are paced against the wall clock. Packet n is due when the audio sent before it would have
+--      finished playing, counted from when the channel started, so rounding never adds up to drift. Packets
+--      are sent up to CHANNEL_SEND_AHEAD_US early so the pacing thread can send a batch for all channels
+--      each time it wakes.
+--
+--      The source is a playlist that loops forever. While a track plays the next one is opened and prefetched
+--      on its own thread (see TrackSource). When a track ends part way through a packet and the next track has
+--      the same format, the rest of the packet is filled from the next track, so the packets keep the same size
+--      and cadence across the boundary. A track change marker names the packet the new track starts in, and
+--      is repeated with the format descriptor for listeners that join later.
+--
+--      Tracks with 16 bit samples are compressed with the channel's codec (see AudioCodec) before they are
+--      packetized. Packets hold the same amount of audio as uncompressed ones, so pacing, FEC and repairs work
+--      the same and only the bandwidth changes. Other tracks are sent as PCM, and the descriptor says which.
+--
+--      A listener that joins sends a join request to the repair port. It gets back, by unicast, the format, the
+--      current track and the last few hundred milliseconds of audio from the retransmission history, which
+--      fills its playout buffer at once. The burst ends just before the next live packet, so the listener
+--      carries on from the multicast without a gap or a duplicate.
+--
+--      Where multicast is blocked, listeners subscribe on the repair port instead and renew the subscription
+--      every few seconds. Every datagram a pass multicasts is also handed to the channel's FanOut, which keeps
+--      it once and sends it from the repair socket to each subscriber from a queue of its own, so chunks are
+--      still read and encoded once however many subscribers there are. The channel can also run with
+--      multicast turned off and serve subscribers only.
+--
+--      The server can pause the stream, seek in the current track or jump forward or back from where it is.
+--      Either way listeners get a discontinuity marker naming the first packet after the break: after a seek
+--      they drop the audio from the old position they are still holding, and at a pause they play out what
+--      they hold instead of waiting. Seek markers are repeated with the next DISCONTINUITY_REPEATS packets.
+--      A paused channel sends no audio but still answers repairs, and on resuming its pacing schedule starts
+--      again from that moment.
+--
+--------------------------------------------------------------------------------------------------------------------*/
+#include "streamchannel.h"
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	StreamChannel
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:   October 19, 2026 - Take the codec - agent
+--              October 19, 2026 - Send through the manager's DatagramIO - agent
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	StreamChannel(int id, const std::vector<std::string> &playlist, const std::string &group,
+--                            int port, int fecGroupSize, uint8_t codec, DatagramIO *sender, PacketPool *pool)
+--                  id - number shown in the statistics
+--                  playlist - audio files to stream in order, at least one
+--                  group - multicast group address
+--                  port - multicast port, the repair channel uses port + STREAM_REPAIR_PORT_OFFSET
+--                  fecGroupSize - audio packets per parity packet, 0 or 1 disables FEC
+--                  codec - AudioCodecId used for tracks it supports
+--                  sender - batches the multicast datagrams of every channel
+--                  pool - packet pool shared by every channel
+--
+-- RETURNS:     NA
+--
+-------------------------------------------------------------------------------------------------------------------*/
+StreamChannel::StreamChannel(int id, const std::vector<std::string> &playlist, const std::string &group, int port,
+                             int fecGroupSize, uint8_t codec, DatagramIO *sender, PacketPool *pool)
+    : id(id), playlist(playlist), group(group), port(port), fecGroupSize(fecGroupSize), codec(codec),
+      sender(sender), retransmitBuffer(pool) {
+    memset(&destination, 0, sizeof(destination));
+}
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	~StreamChannel
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	~StreamChannel()
+--
+-- RETURNS:     NA
+--
+-- NOTES:
+--              Closes the repair socket. The multicast socket belongs to the ChannelManager. Waits for a
+--              prefetch that is still running so the track is not freed under it.
+--
+-------------------------------------------------------------------------------------------------------------------*/
+StreamChannel::~StreamChannel() {
+    delete unicast;
+    delete repairSender;
+    if (repairSocket != INVALID_SOCKET) {
+        closesocket(repairSocket);
+    }
+    if (repairEvent != WSA_INVALID_EVENT) {
+        WSACloseEvent(repairEvent);
+    }
+    if (prefetchHandle != NULL) {
+        WaitForSingleObject(prefetchHandle, INFINITE);
+        CloseHandle(prefetchHandle);
+    }
+    delete fecEncoder;
+    delete encoder;
+    delete nextTrack;
+    delete track;
+}
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	open
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:   October 19, 2026 - Open the first usable track and prefetch the one after it - agent
+--              October 19, 2026 - Take the channel's format from the first track - agent
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	bool open()
+--
+-- RETURNS:     Returns false if no track in the playlist can be streamed
+--
+-- NOTES:
+--              A channel without a repair socket still streams, listeners then rely on FEC only. The channel
+--              streams 16 bit signed audio at the first track's rate and channel count for as long as it runs.
+--
+-------------------------------------------------------------------------------------------------------------------*/
+bool StreamChannel::open() {
+    for (size_t i = 0; i < playlist.size() && track == nullptr; i++) {
+        track = new TrackSource(playlist[i], (int)i);
+        if (!track->open()) {
+            delete track;
+            track = nullptr;
+        }
+    }
+    if (track == nullptr) {
+        return false;
+    }
+    channelFormat = FormatConverter::pcm16(track->getDescriptor().sampleRate, track->getDescriptor().channels);
+    track->setOutputFormat(channelFormat);
+    useFormat(track->getDescriptor());
+    startPrefetch((track->getIndex() + 1) % (int)playlist.size());
+
+    destination.sin_family = AF_INET;
+    destination.sin_addr.s_addr = inet_addr(group.c_str());
+    destination.sin_port = htons((u_short)port);
+
+    if (!openRepairSocket()) {
+        qDebug() << "Repair channel unavailable, listeners will rely on FEC only \n";
+    }
+    if (fecGroupSize > 1) {
+        fecEncoder = new FecEncoder(fecGroupSize);
+    }
+    return true;
+}
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	useFormat
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:   October 19, 2026 - Pick the codec for the track - agent
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	void useFormat(const StreamDescriptor &format)
+--                             format - format of the track being streamed
+--
+-- RETURNS:     void
+--
+-- NOTES:
+--              The chunk size is rounded down to whole frames so every packet can be played, or concealed, on
+--              its own. Compressed chunks are a whole number of frame pairs so a mono IMA-ADPCM block never
+--              ends in a padding nibble.
+--
+-------------------------------------------------------------------------------------------------------------------*/
+void StreamChannel::useFormat(const StreamDescriptor &format) {
+    trackFormat = format;
+    formatSequence = sequence;
+    descriptor = format;
+    delete encoder;
+    encoder = AudioCodec::create(codec, format);
+    descriptor.codec = encoder ? codec : CODEC_PCM;
+    int align = encoder ? 2 * descriptor.frameSize : descriptor.frameSize;
+    chunkSize = STREAM_PAYLOAD_SIZE - STREAM_PAYLOAD_SIZE % align;
+    byteRate = descriptor.sampleRate * descriptor.frameSize;
+}
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	startPrefetch
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	void startPrefetch(int index)
+--                                 index - playlist position of the track to open
+--
+-- RETURNS:     void
+--
+-- NOTES:
+--              Starts opening the track on its own thread. If the thread cannot be created the track is opened
+--              here instead.
+--
+-------------------------------------------------------------------------------------------------------------------*/
+void StreamChannel::startPrefetch(int index) {
+    nextTrack = new TrackSource(playlist[index], index);
+    if ((prefetchHandle = CreateThread(NULL, 0, TrackSource::prefetchThread, nextTrack, 0, NULL)) == NULL) {
+        qDebug() << "CreateThread failed with error \n" << GetLastError();
+        nextTrack->open();
+    }
+}
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	nextTrackReady
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:   October 19, 2026 - Convert the next track to the channel's format - agent
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	bool nextTrackReady()
+--
+-- RETURNS:     Returns true once the next track has been opened and can be streamed
+--
+-- NOTES:
+--              A next track that failed to open is dropped and the one after it is prefetched instead. A ready
+--              track is set to give out the channel's format, so tracks follow each other without a format
+--              change and the listeners' players are never restarted between them.
+--
+-------------------------------------------------------------------------------------------------------------------*/
+bool StreamChannel::nextTrackReady() {
+    if (nextTrack == nullptr || !nextTrack->isReady()) {
+        return false;
+    }
+    if (prefetchHandle != NULL) {
+        CloseHandle(prefetchHandle);
+        prefetchHandle = NULL;
+    }
+    if (!nextTrack->isUsable()) {
+        int index = nextTrack->getIndex();
+        delete nextTrack;
+        nextTrack = nullptr;
+        startPrefetch((index + 1) % (int)playlist.size());
+        return false;
+    }
+    nextTrack->setOutputFormat(channelFormat);
+    return true;
+}
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	advanceTrack
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:   October 19, 2026 - Keep the finished track's decoding counters - agent
+--              October 19, 2026 - Keep its conversion counters too - agent
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	bool advanceTrack()
+--
+-- RETURNS:     Returns false if the next track is not ready yet
+--
+-- NOTES:
+--              Makes the prefetched track current and starts prefetching the one after it. If the format
+--              changes the pacing schedule is restarted from the current deadline at the new byte rate and a
+--              descriptor is sent before the next packet.
+--
+-------------------------------------------------------------------------------------------------------------------*/
+bool StreamChannel::advanceTrack() {
+    if (!nextTrackReady()) {
+        return false;
+    }
+    DecodeAhead::addStatistics(stats.decode, track->getDecodeStatistics());
+    stats.convert.samples += track->getConvertStatistics().samples;
+    stats.convert.busyTicks += track->getConvertStatistics().busyTicks;
+    delete track;
+    track = nextTrack;
+    nextTrack = nullptr;
+    if (!StreamPacket::sameFormat(trackFormat, track->getDescriptor())) {
+        startTime = getNextDeadline();
+        bytesScheduled = 0;
+        useFormat(track->getDescriptor());
+        descriptorDue = true;
+    }
+    trackSequence = sequence;
+    trackChangeDue = true;
+    stats.tracks++;
+    startPrefetch((track->getIndex() + 1) % (int)playlist.size());
+    return true;
+}
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	openRepairSocket
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:   October 19, 2026 - Batch the repairs sent from it - agent
+--              October 19, 2026 - Enlarge the send buffer for the unicast fan out - agent
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	bool openRepairSocket()
+--
+-- RETURNS:     Returns false if the repair socket could not be set up
+--
+-- NOTES:
+--              Binds the unicast repair socket to port + STREAM_REPAIR_PORT_OFFSET and ties it to an event so
+--              the pacing thread wakes up when a NACK arrives. This also makes the socket non-blocking.
+--              Repairs and join bursts to one listener are runs of same sized packets, so the socket sends
+--              segmented where the stack allows it.
+--
+-------------------------------------------------------------------------------------------------------------------*/
+bool StreamChannel::openRepairSocket() {
+    SOCKADDR_IN repairAddress;
+    if ((repairSocket = socket(AF_INET, SOCK_DGRAM, 0)) == INVALID_SOCKET) {
+        qDebug() << "Failed to get a repair socket \n" << WSAGetLastError();
+        return false;
+    }
+    memset(&repairAddress, 0, sizeof(repairAddress));
+    repairAddress.sin_family = AF_INET;
+    repairAddress.sin_addr.s_addr = htonl(INADDR_ANY);
+    repairAddress.sin_port = htons((u_short)(port + STREAM_REPAIR_PORT_OFFSET));
+    if (bind(repairSocket, (PSOCKADDR) &repairAddress, sizeof(repairAddress)) == SOCKET_ERROR) {
+        qDebug() << "repair bind() failed with error \n" << WSAGetLastError();
+        closesocket(repairSocket);
+        repairSocket = INVALID_SOCKET;
+        return false;
+    }
+    int sendBuffer = FANOUT_SEND_BUFFER;
+    if (setsockopt(repairSocket, SOL_SOCKET, SO_SNDBUF, (char *)&sendBuffer, sizeof(sendBuffer)) == SOCKET_ERROR) {
+        qDebug() << "Failed to enlarge the repair send buffer \n" << WSAGetLastError();
+    }
+    repairSender = new DatagramIO(repairSocket);
+    repairSender->enableSendOffload();
+    unicast = new FanOut(repairSender);
+    if ((repairEvent = WSACreateEvent()) == WSA_INVALID_EVENT) {
+        qDebug() << "WSACreateEvent() failed with error \n" << WSAGetLastError();
+        return false;
+    }
+    if (WSAEventSelect(repairSocket, repairEvent, FD_READ) == SOCKET_ERROR) {
+        qDebug() << "WSAEventSelect for repairs failed: " << WSAGetLastError();
+        WSACloseEvent(repairEvent);
+        repairEvent = WSA_INVALID_EVENT;
+        return false;
+    }
+    return true;
+}
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	getNextDeadline
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:   October 19, 2026 - Nothing is due while paused - agent
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	uint64_t getNextDeadline() const
+--
+-- RETURNS:     Returns when the next audio packet is due in microseconds on the ChannelManager clock, or
+--              UINT64_MAX while the channel is paused
+--
+-------------------------------------------------------------------------------------------------------------------*/
+uint64_t StreamChannel::getNextDeadline() const {
+    if (paused) {
+        return UINT64_MAX;
+    }
+    return startTime + bytesScheduled * 1000000 / byteRate;
+}
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	pump
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:   October 19, 2026 - Fan out to subscribers - agent
+--              October 19, 2026 - Send no audio while paused - agent
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	int pump(uint64_t now)
+--                       now - current time in microseconds on the ChannelManager clock
+--
+-- RETURNS:     Returns the number of audio packets sent
+--
+-- NOTES:
+--              Sends every packet due before now + CHANNEL_SEND_AHEAD_US. If the pacing thread was held up for
+--              more than CHANNEL_MAX_LAG_US the schedule is moved forward instead of sending the backlog in one
+--              burst that listeners could not buffer. Stops early if the next track is not ready yet, and
+--              tries again on the next wake. What was sent is then fanned out to the unicast subscribers.
+--              A paused channel only fans out the markers sent when it paused.
+--
+-------------------------------------------------------------------------------------------------------------------*/
+int StreamChannel::pump(uint64_t now) {
+    int sent = 0;
+    if (paused) {
+        fanOut();
+        return 0;
+    }
+    if (!started) {
+        started = true;
+        startTime = now;
+    }
+    while (true) {
+        uint64_t deadline = getNextDeadline();
+        if (deadline > now + CHANNEL_SEND_AHEAD_US) {
+            break;
+        }
+        if (now > deadline + CHANNEL_MAX_LAG_US) {
+            startTime += now - deadline;
+            stats.stalls++;
+        }
+        if (!sendNext()) {
+            break;
+        }
+        sent++;
+    }
+    fanOut();
+    return sent;
+}
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	pause
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	void pause()
+--
+-- RETURNS:     void
+--
+-- NOTES:
+--              Stops sending audio and sends the pause marker DISCONTINUITY_REPEATS times straight away, since
+--              no packets follow it to carry repeats. The markers go out with the next flush of the pacing
+--              thread.
+--
+-------------------------------------------------------------------------------------------------------------------*/
+void StreamChannel::pause() {
+    if (paused) {
+        return;
+    }
+    paused = true;
+    stats.pauses++;
+    discontinuitySequence = sequence;
+    discontinuityReason = DISCONTINUITY_PAUSE;
+    discontinuityPositionMs = track->getPositionMs();
+    for (int i = 0; i < DISCONTINUITY_REPEATS; i++) {
+        sendDiscontinuity();
+    }
+    discontinuitiesDue = 0;
+}
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	resume
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	void resume()
+--
+-- RETURNS:     void
+--
+-- NOTES:
+--              The pacing schedule starts again on the next pump, so the time spent paused is not sent as a
+--              backlog.
+--
+-------------------------------------------------------------------------------------------------------------------*/
+void StreamChannel::resume() {
+    if (!paused) {
+        return;
+    }
+    paused = false;
+    started = false;
+    bytesScheduled = 0;
+}
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	seek
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	bool seek(uint32_t positionMs)
+--                        positionMs - time in the current track to carry on from
+--
+-- RETURNS:     Returns false if the track cannot seek there
+--
+-- NOTES:
+--              The next audio packet is read from the new position and a seek marker goes out before it and
+--              the packets after it. Join bursts no longer reach back past the seek. A seek while paused takes
+--              effect when the channel resumes.
+--
+-------------------------------------------------------------------------------------------------------------------*/
+bool StreamChannel::seek(uint32_t positionMs) {
+    if (!track->seek(positionMs)) {
+        return false;
+    }
+    stats.seeks++;
+    seekSequence = sequence;
+    discontinuitySequence = sequence;
+    discontinuityReason = DISCONTINUITY_SEEK;
+    discontinuityPositionMs = track->getPositionMs();
+    discontinuitiesDue = DISCONTINUITY_REPEATS;
+    return true;
+}
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	skip
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	bool skip(int32_t deltaMs)
+--                        deltaMs - how far to jump from the current position, negative to go back
+--
+-- RETURNS:     Returns false if the track cannot seek there
+--
+-- NOTES:
+--              A jump back past the start goes to the start, and one past the end ends the track.
+--
+-------------------------------------------------------------------------------------------------------------------*/
+bool StreamChannel::skip(int32_t deltaMs) {
+    int64_t target = (int64_t)track->getPositionMs() + deltaMs;
+    return seek(target < 0 ? 0 : (uint32_t)target);
+}
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	readChunk
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	int readChunk(char *buf)
+--                            buf - destination, must hold chunkSize bytes
+--
+-- RETURNS:     Returns the number of PCM bytes read
+--
+-- NOTES:
+--              When the track ends part way through the chunk and the next track has the same format, the rest
+--              of the chunk is read from the next track.
+--
+-------------------------------------------------------------------------------------------------------------------*/
+int StreamChannel::readChunk(char *buf) {
+    int length = track->read(buf, chunkSize);
+    if (length < chunkSize && nextTrackReady() &&
+            StreamPacket::sameFormat(trackFormat, nextTrack->getDescriptor()) && advanceTrack()) {
+        // The new track starts inside this packet
+        length += track->read(buf + length, chunkSize - length);
+    }
+    return length;
+}
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	sendNext
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:   October 19, 2026 - Read from the playlist and cross track boundaries inside a packet - agent
+--              October 19, 2026 - Encode the chunk with the channel's codec - agent
+--              October 19, 2026 - Repeat the seek marker - agent
+--              October 19, 2026 - Give the packet back when there was nothing to send - agent
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	bool sendNext()
+--
+-- RETURNS:     Returns false if nothing could be sent because the next track is not ready
+--
+-- NOTES:
+--              The chunk is read, or encoded, straight into a pooled packet after the header, sent, and left
+--              there for the repair channel. When FEC is enabled the chunk is also folded into the current parity
+--              group, and the parity packet is multicast right after the last packet of its group. The format
+--              descriptor and the current track marker go out whenever they change and every DESCRIPTOR_INTERVAL
+--              packets so listeners that join late learn them quickly. A seek marker goes out with each of the
+--              first few packets after a seek.
+--
+-------------------------------------------------------------------------------------------------------------------*/
+bool StreamChannel::sendNext() {
+    if (track->atEnd() && !advanceTrack()) {
+        stats.trackWaits++;
+        return false;
+    }
+    PooledPacket *packet = retransmitBuffer.acquire(sequence);
+    char *chunk = packet->datagram + STREAM_HEADER_SIZE;
+    int pcmLength = readChunk(encoder ? pcm : chunk);
+    if (pcmLength <= 0) {
+        retransmitBuffer.release(sequence);
+        return track->atEnd() ? sendNext() : false;
+    }
+    int length = encoder ? encoder->encode(pcm, pcmLength, chunk, &stats.codec) : pcmLength;
+    if (descriptorDue || sequence % DESCRIPTOR_INTERVAL == 0) {
+        sendDescriptor();
+    }
+    if (trackChangeDue || sequence % DESCRIPTOR_INTERVAL == 0) {
+        sendTrackChange();
+    }
+    if (discontinuitiesDue > 0) {
+        sendDiscontinuity();
+        discontinuitiesDue--;
+    }
+
+    StreamPacketHeader header = {};
+    header.type = PACKET_AUDIO;
+    header.groupSize = fecEncoder ? (uint8_t)fecEncoder->getGroupSize() : 0;
+    header.sequence = sequence++;
+    header.timestamp = GetTickCount();
+    header.length = (uint16_t)length;
+    StreamPacket::writeHeader(header, packet->datagram);
+    packet->bytes = STREAM_HEADER_SIZE + length;
+    sendDatagram(packet->datagram, packet->bytes);
+    bytesScheduled += pcmLength;
+    stats.packetsSent++;
+
+    if (fecEncoder && fecEncoder->addPacket(header.sequence, chunk, length)) {
+        char parity[DATA_BUFSIZE];
+        sendDatagram(parity, fecEncoder->buildParityPacket(header.timestamp, parity));
+        stats.parityPackets++;
+    }
+    return true;
+}
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	sendDescriptor
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	void sendDescriptor()
+--
+-- RETURNS:     void
+--
+-- NOTES:
+--              The descriptor carries the sequence number of the next audio packet, which is the first packet
+--              the format applies to.
+--
+-------------------------------------------------------------------------------------------------------------------*/
+void StreamChannel::sendDescriptor() {
+    char packet[DATA_BUFSIZE];
+    sendDatagram(packet, StreamPacket::buildDescriptor(descriptor, sequence, packet));
+    stats.descriptors++;
+    descriptorDue = false;
+}
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	sendTrackChange
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	void sendTrackChange()
+--
+-- RETURNS:     void
+--
+-- NOTES:
+--              The marker carries the sequence number of the packet the current track started in, so repeats
+--              of it are recognised by listeners that already switched.
+--
+-------------------------------------------------------------------------------------------------------------------*/
+void StreamChannel::sendTrackChange() {
+    char packet[DATA_BUFSIZE];
+    sendDatagram(packet, StreamPacket::buildTrackChange(trackSequence, (uint16_t)track->getIndex(),
+                                                        track->getTitle(), packet));
+    trackChangeDue = false;
+}
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	sendDiscontinuity
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	void sendDiscontinuity()
+--
+-- RETURNS:     void
+--
+-- NOTES:
+--              Every repeat carries the same sequence number, the first packet after the break, so listeners
+--              act on the first copy that arrives and ignore the rest.
+--
+-------------------------------------------------------------------------------------------------------------------*/
+void StreamChannel::sendDiscontinuity() {
+    char packet[DATA_BUFSIZE];
+    sendDatagram(packet, StreamPacket::buildDiscontinuity(discontinuitySequence, discontinuityReason,
+                                                          discontinuityPositionMs, packet));
+}
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	sendDatagram
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:   October 19, 2026 - Queue the datagram instead of sending it - agent
+--              October 19, 2026 - Keep it for the subscribers, multicast only if enabled - agent
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	void sendDatagram(const char *datagram, int bytes)
+--                                datagram - packet to multicast
+--                                bytes - size of the packet
+--
+-- RETURNS:     void
+--
+-- NOTES:
+--              The datagram goes out when the pacing thread flushes the sender at the end of its pass.
+--
+-------------------------------------------------------------------------------------------------------------------*/
+void StreamChannel::sendDatagram(const char *datagram, int bytes) {
+    if (multicast) {
+        sender->queue(datagram, bytes, destination);
+    }
+    if (unicast) {
+        unicast->queue(datagram, bytes);
+    }
+    stats.bytesSent += bytes;
+}
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	serviceRepairs
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:   October 19, 2026 - Answer join requests - agent
+--              October 19, 2026 - Send the repairs as one batch - agent
+--              October 19, 2026 - Take subscriptions and fan out multicast repairs - agent
+--              October 19, 2026 - Answer echo probes - agent
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	void serviceRepairs()
+--
+-- RETURNS:     void
+--
+-- NOTES:
+--              Reads every NACK waiting on the repair socket. Each requested packet still in the history is sent
+--              back by unicast to the listener that asked, multicast once if several listeners lost it, or
+--              dropped if it was already repaired in the current suppression window. Join requests are
+--              answered with a burst of recent audio. Unicast repairs are queued and sent together once the
+--              socket has been drained, multicast repairs go out with the next flush of the pacing thread and
+--              to every subscriber. Subscriptions are added or renewed. Echo probes are answered with the
+--              clock the audio packets are stamped with, so listeners can time the stream's transit.
+--
+-------------------------------------------------------------------------------------------------------------------*/
+void StreamChannel::serviceRepairs() {
+    char request[DATA_BUFSIZE];
+    uint32_t sequences[NACK_MAX_SEQUENCES];
+    SOCKADDR_IN listener;
+    StreamPacketHeader header;
+
+    if (repairSocket == INVALID_SOCKET) {
+        return;
+    }
+    WSAResetEvent(repairEvent);
+    while (true) {
+        int listenerSize = sizeof(listener);
+        int bytes = recvfrom(repairSocket, request, sizeof(request), 0, (struct sockaddr*) &listener, &listenerSize);
+        if (bytes == SOCKET_ERROR) {
+            // A listener that left makes the next read report port unreachable
+            if (WSAGetLastError() == WSAECONNRESET) {
+                continue;
+            }
+            if (WSAGetLastError() != WSAEWOULDBLOCK) {
+                qDebug() << "repair recvfrom() failed with error \n" << WSAGetLastError();
+            }
+            break;
+        }
+        if (!StreamPacket::readHeader(request, bytes, header)) {
+            continue;
+        }
+        if (header.type == PACKET_SUBSCRIBE) {
+            subscribe(listener);
+            continue;
+        }
+        uint32_t prober, origin;
+        bool reply;
+        if (header.type == PACKET_ECHO) {
+            if (StreamPacket::readEcho(request + STREAM_HEADER_SIZE, header.length, prober, reply, origin) && !reply) {
+                char echo[DATA_BUFSIZE];
+                int echoBytes = StreamPacket::buildEcho(0, true, header.timestamp, GetTickCount(), echo);
+                repairSender->queue(echo, echoBytes, listener);
+            }
+            continue;
+        }
+        uint16_t burstMs;
+        if (header.type == PACKET_JOIN &&
+                StreamPacket::readJoin(request + STREAM_HEADER_SIZE, header.length, burstMs)) {
+            sendBurst(listener, burstMs);
+            continue;
+        }
+        if (header.type != PACKET_NACK) {
+            continue;
+        }
+
+        int count = StreamPacket::readNack(request + STREAM_HEADER_SIZE, header.length, sequences, NACK_MAX_SEQUENCES);
+        DWORD now = GetTickCount();
+        repairStats.nacksReceived++;
+        repairStats.sequencesRequested += count;
+        for (int i = 0; i < count; i++) {
+            const PooledPacket *repair = nullptr;
+            switch (retransmitBuffer.requestRepair(sequences[i], now, repair)) {
+            case RetransmitBuffer::REPAIR_UNICAST:
+                repairSender->queue(repair->datagram, repair->bytes, listener);
+                repairStats.repairsUnicast++;
+                repairStats.repairBytes += repair->bytes;
+                break;
+            case RetransmitBuffer::REPAIR_MULTICAST:
+                if (multicast) {
+                    sender->queue(repair->datagram, repair->bytes, destination);
+                }
+                unicast->queue(repair->datagram, repair->bytes);
+                repairStats.repairsMulticast++;
+                repairStats.repairBytes += repair->bytes;
+                break;
+            case RetransmitBuffer::REPAIR_SUPPRESSED:
+                repairStats.repairsSuppressed++;
+                break;
+            default:
+                repairStats.repairsUnavailable++;
+                break;
+            }
+        }
+    }
+    repairSender->flush();
+    fanOut();
+}
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	sendBurst
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:   October 19, 2026 - Queue the burst on the repair sender - agent
+--              October 19, 2026 - Stop at the last seek - agent
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	void sendBurst(const SOCKADDR_IN &listener, uint16_t burstMs)
+--                             listener - address the join request came from
+--                             burstMs - how much recent audio the listener asked for
+--
+-- RETURNS:     void
+--
+-- NOTES:
+--              The descriptor goes first so the listener can play the burst, and names the first packet of the
+--              burst. The burst never reaches back past the last format change, so all of it is in that format,
+--              or past the last seek, so none of it is from the old position.
+--              Packets the pool has already reused are skipped and left to the listener's NACKs.
+--
+-------------------------------------------------------------------------------------------------------------------*/
+void StreamChannel::sendBurst(const SOCKADDR_IN &listener, uint16_t burstMs) {
+    char packet[DATA_BUFSIZE];
+    uint32_t count = (uint32_t)((uint64_t)burstMs * byteRate / 1000 / chunkSize) + 1;
+    if (count > RETRANSMIT_RING_SIZE) {
+        count = RETRANSMIT_RING_SIZE;
+    }
+    uint32_t first = sequence - count;
+    if ((int32_t)(first - formatSequence) < 0) {
+        first = formatSequence;
+    }
+    if ((int32_t)(first - seekSequence) < 0) {
+        first = seekSequence;
+    }
+    stats.joins++;
+
+    repairSender->queue(packet, StreamPacket::buildDescriptor(descriptor, first, packet), listener);
+    repairSender->queue(packet, StreamPacket::buildTrackChange(trackSequence, (uint16_t)track->getIndex(),
+                                                               track->getTitle(), packet), listener);
+    for (uint32_t next = first; next != sequence; next++) {
+        const PooledPacket *audio = retransmitBuffer.find(next);
+        if (audio != nullptr) {
+            repairSender->queue(audio->datagram, audio->bytes, listener);
+            stats.burstPackets++;
+        }
+    }
+}
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	subscribe
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:   October 19, 2026 - Keep the subscribers in the FanOut - agent
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	void subscribe(const SOCKADDR_IN &listener)
+--                             listener - address the stream is sent to
+--
+-- RETURNS:     void
+--
+-- NOTES:
+--              Renews the subscription of a known listener, or adds a new one while there is room. A new
+--              subscriber gets the descriptor and track marker with the next packet.
+--
+-------------------------------------------------------------------------------------------------------------------*/
+void StreamChannel::subscribe(const SOCKADDR_IN &listener) {
+    if (unicast->subscribe(listener, GetTickCount())) {
+        descriptorDue = true;
+        trackChangeDue = true;
+    }
+}
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	fanOut
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:   October 19, 2026 - Send from each subscriber's own queue through the FanOut - agent
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	void fanOut()
+--
+-- RETURNS:     void
+--
+-- NOTES:
+--              Sends the unicast subscribers what was queued for them since the last call. See FanOut.
+--
+-------------------------------------------------------------------------------------------------------------------*/
+void StreamChannel::fanOut() {
+    if (unicast) {
+        unicast->flush(GetTickCount());
+    }
+}
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	getStatistics
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:   October 19, 2026 - Add the codec's compression and cost - agent
+--              October 19, 2026 - Add join bursts - agent
+--              October 19, 2026 - Add the unicast fan out - agent
+--              October 19, 2026 - Add the decoding speed of compressed tracks - agent
+--              October 19, 2026 - Add the format conversion speed - agent
+--              October 19, 2026 - Add the position, seeks and pauses - agent
+--              October 19, 2026 - Take the unicast fan out from the FanOut - agent
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	QString getStatistics() const
+--
+-- RETURNS:     Returns a one line summary of the channel's traffic and repairs
+--
+-------------------------------------------------------------------------------------------------------------------*/
+QString StreamChannel::getStatistics() const {
+    double ratio = stats.codec.codedBytes == 0 ? 1 : (double)stats.codec.pcmBytes / stats.codec.codedBytes;
+    DecodeAhead::Statistics decode = stats.decode;
+    DecodeAhead::addStatistics(decode, track->getDecodeStatistics());
+    FormatConverter::Statistics convert = stats.convert;
+    convert.samples += track->getConvertStatistics().samples;
+    convert.busyTicks += track->getConvertStatistics().busyTicks;
+    return QString("Channel %1 %2:%3 playing %4: %5 packets, %6 parity, %7 stalls, %8 tracks, %9 waits for a track"
+                   " | Repair: %10 NACKs for %11 packets, %12 unicast, %13 multicast, %14 suppressed, %15 too old"
+                   " | Codec: %16, %17x smaller, encoding takes %18 us per second of audio"
+                   " | Joins: %19 with %20 packets of recent audio"
+                   " | Unicast: %21"
+                   " | Decode: %22x realtime, held back %23 times by a full buffer, %24 underruns"
+                   " | Conversion: %25 million samples per second"
+                   " | Transport: %26 at %27 of %28 s, %29 seeks, %30 pauses")
+            .arg(id)
+            .arg(QString::fromStdString(group))
+            .arg(port)
+            .arg(QString::fromStdString(track->getTitle()))
+            .arg((qint64)stats.packetsSent)
+            .arg((qint64)stats.parityPackets)
+            .arg((qint64)stats.stalls)
+            .arg((qint64)stats.tracks)
+            .arg((qint64)stats.trackWaits)
+            .arg((qint64)repairStats.nacksReceived)
+            .arg((qint64)repairStats.sequencesRequested)
+            .arg((qint64)repairStats.repairsUnicast)
+            .arg((qint64)repairStats.repairsMulticast)
+            .arg((qint64)repairStats.repairsSuppressed)
+            .arg((qint64)repairStats.repairsUnavailable)
+            .arg(AudioCodec::getName(descriptor.codec))
+            .arg(ratio, 0, 'f', 1)
+            .arg(AudioCodec::getMicrosPerSecond(stats.codec), 0, 'f', 1)
+            .arg((qint64)stats.joins)
+            .arg((qint64)stats.burstPackets)
+            .arg(unicast ? unicast->describe() : QString("no repair socket"))
+            .arg(DecodeAhead::getSpeed(decode), 0, 'f', 1)
+            .arg((qint64)decode.stalls)
+            .arg((qint64)decode.underruns)
+            .arg(FormatConverter::getSamplesPerSecond(convert) / 1000000, 0, 'f', 1)
+            .arg(paused ? "paused" : "playing")
+            .arg(track->getPositionMs() / 1000.0, 0, 'f', 1)
+            .arg(track->getLengthMs() / 1000.0, 0, 'f', 1)
+            .arg((qint64)stats.seeks)
+            .arg((qint64)stats.pauses);
+}
@@ -0,0 +1,135 @@
+#pragma once
+#include <winsock2.h>
+#include <windows.h>
+#include <string>
+#include <vector>
+#include <QString>
+#include <QDebug>
+#include "tracksource.h"
+#include "audiocodec.h"
+#include "fec.h"
+#include "packetpool.h"
+#include "retransmitbuffer.h"
+#include "datagramio.h"
+#include "fanout.h"
+
+#define CHANNEL_SEND_AHEAD_US 100000
+#define CHANNEL_MAX_LAG_US 500000
+
+class StreamChannel {
+public:
+    struct Statistics {
+        DWORD packetsSent;
+        DWORD parityPackets;
+        DWORD descriptors;
+        DWORD bytesSent;
+        DWORD stalls;
+        DWORD tracks;
+        DWORD trackWaits;
+        DWORD joins;
+        DWORD burstPackets;
+        AudioCodec::Statistics codec;
+        DecodeAhead::Statistics decode;
+        FormatConverter::Statistics convert;
+        DWORD seeks;
+        DWORD pauses;
+    };
+
+    StreamChannel(int id, const std::vector<std::string> &playlist, const std::string &group, int port,
+                  int fecGroupSize, uint8_t codec, DatagramIO *sender, PacketPool *pool);
+    ~StreamChannel();
+    StreamChannel(const StreamChannel&) = delete;
+    void operator=(const StreamChannel&) = delete;
+
+    bool open();
+    int pump(uint64_t now);
+    void serviceRepairs();
+    uint64_t getNextDeadline() const;
+    void pause();
+    void resume();
+    bool seek(uint32_t positionMs);
+    bool skip(int32_t deltaMs);
+    QString getStatistics() const;
+
+    int getId() const {
+        return id;
+    }
+    int getPort() const {
+        return port;
+    }
+    WSAEVENT getRepairEvent() const {
+        return repairEvent;
+    }
+    void setMulticast(bool enabled) {
+        multicast = enabled;
+    }
+    bool isPaused() const {
+        return paused;
+    }
+    uint32_t getPositionMs() const {
+        return track->getPositionMs();
+    }
+    uint32_t getLengthMs() const {
+        return track->getLengthMs();
+    }
+
+private:
+    int id;
+    std::vector<std::string> playlist;
+    std::string group;
+    int port;
+    int fecGroupSize;
+    uint8_t codec;
+    DatagramIO *sender;
+    SOCKET repairSocket = INVALID_SOCKET;
+    DatagramIO *repairSender = nullptr;
+    FanOut *unicast = nullptr;
+    WSAEVENT repairEvent = WSA_INVALID_EVENT;
+    SOCKADDR_IN destination;
+    bool multicast = true;
+
+    TrackSource *track = nullptr;
+    TrackSource *nextTrack = nullptr;
+    HANDLE prefetchHandle = NULL;
+    StreamDescriptor descriptor = {};
+    StreamDescriptor trackFormat = {};
+    StreamDescriptor channelFormat = {};
+    int chunkSize = STREAM_PAYLOAD_SIZE;
+    AudioCodec *encoder = nullptr;
+    char pcm[STREAM_PAYLOAD_SIZE];
+    uint32_t sequence = 0;
+    uint32_t trackSequence = 0;
+    uint32_t formatSequence = 0;
+    bool descriptorDue = true;
+    bool trackChangeDue = true;
+    bool paused = false;
+    uint32_t seekSequence = 0;
+    uint32_t discontinuitySequence = 0;
+    DiscontinuityReason discontinuityReason = DISCONTINUITY_SEEK;
+    uint32_t discontinuityPositionMs = 0;
+    int discontinuitiesDue = 0;
+    FecEncoder *fecEncoder = nullptr;
+    RetransmitBuffer retransmitBuffer;
+
+    bool started = false;
+    uint64_t startTime = 0;
+    uint64_t bytesScheduled = 0;
+    uint32_t byteRate = 0;
+    Statistics stats = {};
+    RepairStatistics repairStats = {};
+
+    bool openRepairSocket();
+    void useFormat(const StreamDescriptor &format);
+    void startPrefetch(int index);
+    bool nextTrackReady();
+    bool advanceTrack();
+    int readChunk(char *buf);
+    bool sendNext();
+    void sendDescriptor();
+    void sendTrackChange();
+    void sendDiscontinuity();
+    void sendDatagram(const char *datagram, int bytes);
+    void sendBurst(const SOCKADDR_IN &listener, uint16_t burstMs);
+    void subscribe(const SOCKADDR_IN &listener);
+    void fanOut();
+};
@@ -0,0 +1,867 @@
+/*------------------------------------------------------------------------------------------------------------------
+-- SOURCE FILE: 	streampacket.cpp - Contains the wire format used for multicast stream datagrams.
+--
+--
+-- PROGRAM: 		Communication Audio Program
+--
+-- FUNCTIONS:
+--                  int writeHeader(const StreamPacketHeader &header, char *buf)
+--                  bool readHeader(const char *buf, int bytes, StreamPacketHeader &header)
+--                  int build(StreamPacketType type, uint32_t sequence, uint32_t timestamp,
+--                            const char *payload, int length, char *buf)
+--                  int buildNack(const uint32_t *sequences, int count, char *buf)
+--                  int readNack(const char *payload, int length, uint32_t *sequences, int max)
+--                  int buildDescriptor(const StreamDescriptor &descriptor, uint32_t sequence, char *buf)
+--                  bool readDescriptor(const char *payload, int length, StreamDescriptor &descriptor)
+--                  bool sameFormat(const StreamDescriptor &a, const StreamDescriptor &b)
+--                  int buildTrackChange(uint32_t sequence, uint16_t index, const std::string &title, char *buf)
+--                  bool readTrackChange(const char *payload, int length, uint16_t &index, std::string &title)
+--                  int buildDiscontinuity(uint32_t sequence, DiscontinuityReason reason, uint32_t positionMs, char *buf)
+--                  bool readDiscontinuity(const char *payload, int length, DiscontinuityReason &reason,
+--                                         uint32_t &positionMs)
+--                  int buildJoin(uint16_t burstMs, char *buf)
+--                  bool readJoin(const char *payload, int length, uint16_t &burstMs)
+--                  int buildSubscribe(char *buf)
+--                  uint32_t newSource()
+--                  bool readSource(const char *buf, int bytes, uint32_t &source)
+--                  int buildVoice(uint32_t source, const StreamDescriptor &format, uint32_t sequence,
+--                                 uint32_t timestamp, const char *audio, int length, char *buf)
+--                  bool readVoice(const char *payload, int length, uint32_t &source, StreamDescriptor &format,
+--                                 const char *&audio, int &audioLength)
+--                  int buildComfortNoise(uint32_t source, const StreamDescriptor &format, uint32_t sequence,
+--                                        uint32_t timestamp, uint8_t level, char *buf)
+--                  bool readComfortNoise(const char *payload, int length, uint32_t &source,
+--                                        StreamDescriptor &format, uint8_t &level)
+--                  int buildEcho(uint32_t source, bool reply, uint32_t origin, uint32_t timestamp, char *buf)
+--                  bool readEcho(const char *payload, int length, uint32_t &source, bool &reply, uint32_t &origin)
+--
+-- DATE: 			October 19, 2026
+--
+-- REVISIONS:       October 19, 2026 - Add NACK packets for the repair channel - agent
+--                  October 19, 2026 - Add stream format descriptor packets - agent
+--                  October 19, 2026 - Add track change markers - agent
+--                  October 19, 2026 - Carry the codec in the descriptor and add voice packets - agent
+--                  October 19, 2026 - Add join requests for late joiners - agent
+--                  October 19, 2026 - Add unicast subscriptions - agent
+--                  October 19, 2026 - Add discontinuity markers for seeks and pauses - agent
+--                  October 19, 2026 - Add comfort noise markers for silent callers - agent
+--                  October 19, 2026 - Name the source of every call packet - agent
+--                  October 19, 2026 - Add echo probes for measuring the round trip - agent
+--
+-- DESIGNER: 		agent
+--
+-- PROGRAMMER: 		agent
+--
+-- NOTES:
+--      Every stream datagram starts with a fixed 16 byte header written in network byte order followed by the
+--      payload. The header carries a sequence number so that receivers can detect loss and reorder packets.
+--
+--      Layout:
+--          magic(2) type(1) groupSize(1) sequence(4) timestamp(4) length(2) parityLength(2)
+--
+--------------------------------------------------------------------------------------------------------------------*/
+#include "streampacket.h"
+#include <chrono>
+#include <random>
+
+static void writeU16(char *buf, uint16_t value) {
+    buf[0] = (char)(value >> 8);
+    buf[1] = (char)(value & 0xFF);
+}
+
+static void writeU32(char *buf, uint32_t value) {
+    buf[0] = (char)(value >> 24);
+    buf[1] = (char)((value >> 16) & 0xFF);
+    buf[2] = (char)((value >> 8) & 0xFF);
+    buf[3] = (char)(value & 0xFF);
+}
+
+static uint16_t readU16(const char *buf) {
+    const unsigned char *b = (const unsigned char *)buf;
+    return (uint16_t)((b[0] << 8) | b[1]);
+}
+
+static uint32_t readU32(const char *buf) {
+    const unsigned char *b = (const unsigned char *)buf;
+    return ((uint32_t)b[0] << 24) | ((uint32_t)b[1] << 16) | ((uint32_t)b[2] << 8) | (uint32_t)b[3];
+}
+
+static void writeFormat(char *buf, const StreamDescriptor &descriptor) {
+    writeU32(buf, descriptor.sampleRate);
+    buf[4] = (char)descriptor.channels;
+    buf[5] = (char)descriptor.sampleSize;
+    buf[6] = (char)descriptor.sampleType;
+    buf[7] = (char)descriptor.codec;
+    writeU16(buf + 8, descriptor.frameSize);
+}
+
+static bool readFormat(const char *buf, StreamDescriptor &descriptor) {
+    descriptor.sampleRate = readU32(buf);
+    descriptor.channels = (uint8_t)buf[4];
+    descriptor.sampleSize = (uint8_t)buf[5];
+    descriptor.sampleType = (uint8_t)buf[6];
+    descriptor.codec = (uint8_t)buf[7];
+    descriptor.frameSize = readU16(buf + 8);
+    if (descriptor.codec >= CODEC_COUNT || (descriptor.codec != CODEC_PCM && descriptor.sampleSize != 16)) {
+        return false;
+    }
+    // The receiver and the converters step through the audio by frameSize and read samples by sampleSize
+    if (descriptor.sampleSize % 8 != 0 || descriptor.frameSize != descriptor.channels * descriptor.sampleSize / 8) {
+        return false;
+    }
+    return descriptor.sampleRate > 0 && descriptor.channels > 0 && descriptor.sampleSize > 0;
+}
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	writeHeader
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	int writeHeader(const StreamPacketHeader &header, char *buf)
+--                              header - header fields to serialize
+--                              buf - destination, must hold at least STREAM_HEADER_SIZE bytes
+--
+-- RETURNS:     Returns the number of bytes written
+--
+-- NOTES:
+--              Serializes the header in network byte order.
+--
+-------------------------------------------------------------------------------------------------------------------*/
+int StreamPacket::writeHeader(const StreamPacketHeader &header, char *buf) {
+    writeU16(buf, STREAM_PACKET_MAGIC);
+    buf[2] = (char)header.type;
+    buf[3] = (char)header.groupSize;
+    writeU32(buf + 4, header.sequence);
+    writeU32(buf + 8, header.timestamp);
+    writeU16(buf + 12, header.length);
+    writeU16(buf + 14, header.parityLength);
+    return STREAM_HEADER_SIZE;
+}
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	readHeader
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	bool readHeader(const char *buf, int bytes, StreamPacketHeader &header)
+--                              buf - received datagram
+--                              bytes - size of the received datagram
+--                              header - filled in with the parsed fields
+--
+-- RETURNS:     Returns false if the datagram is not a valid stream packet
+--
+-- NOTES:
+--              Rejects datagrams that are too short, have the wrong magic or claim more payload than was received.
+--
+-------------------------------------------------------------------------------------------------------------------*/
+bool StreamPacket::readHeader(const char *buf, int bytes, StreamPacketHeader &header) {
+    if (bytes < STREAM_HEADER_SIZE || readU16(buf) != STREAM_PACKET_MAGIC) {
+        return false;
+    }
+    header.magic = STREAM_PACKET_MAGIC;
+    header.type = (uint8_t)buf[2];
+    header.groupSize = (uint8_t)buf[3];
+    header.sequence = readU32(buf + 4);
+    header.timestamp = readU32(buf + 8);
+    header.length = readU16(buf + 12);
+    header.parityLength = readU16(buf + 14);
+    return header.length <= bytes - STREAM_HEADER_SIZE;
+}
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	build
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	int build(StreamPacketType type, uint32_t sequence, uint32_t timestamp,
+--                        const char *payload, int length, char *buf)
+--                  type - packet type
+--                  sequence - sequence number of the packet
+--                  timestamp - send time in milliseconds
+--                  payload - payload bytes, copied after the header
+--                  length - number of payload bytes
+--                  buf - destination, must hold STREAM_HEADER_SIZE + length bytes
+--
+-- RETURNS:     Returns the size of the datagram
+--
+-- NOTES:
+--              Convenience function for packets that do not belong to an FEC group.
+--
+-------------------------------------------------------------------------------------------------------------------*/
+int StreamPacket::build(StreamPacketType type, uint32_t sequence, uint32_t timestamp,
+                        const char *payload, int length, char *buf) {
+    StreamPacketHeader header = {};
+    header.type = type;
+    header.sequence = sequence;
+    header.timestamp = timestamp;
+    header.length = (uint16_t)length;
+    writeHeader(header, buf);
+    memcpy(buf + STREAM_HEADER_SIZE, payload, length);
+    return STREAM_HEADER_SIZE + length;
+}
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	buildNack
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	int buildNack(const uint32_t *sequences, int count, char *buf)
+--                            sequences - sequence numbers the listener is missing
+--                            count - number of sequence numbers, at most NACK_MAX_SEQUENCES
+--                            buf - destination, must hold DATA_BUFSIZE bytes
+--
+-- RETURNS:     Returns the size of the NACK datagram
+--
+-- NOTES:
+--              A NACK lists every missing sequence number as a 4 byte value so one datagram can ask for a
+--              whole burst of loss.
+--
+-------------------------------------------------------------------------------------------------------------------*/
+int StreamPacket::buildNack(const uint32_t *sequences, int count, char *buf) {
+    if (count > NACK_MAX_SEQUENCES) {
+        count = NACK_MAX_SEQUENCES;
+    }
+    StreamPacketHeader header = {};
+    header.type = PACKET_NACK;
+    header.length = (uint16_t)(count * 4);
+    writeHeader(header, buf);
+    for (int i = 0; i < count; i++) {
+        writeU32(buf + STREAM_HEADER_SIZE + i * 4, sequences[i]);
+    }
+    return STREAM_HEADER_SIZE + count * 4;
+}
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	readNack
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	int readNack(const char *payload, int length, uint32_t *sequences, int max)
+--                           payload - payload of a NACK packet
+--                           length - payload length from the header
+--                           sequences - filled in with the requested sequence numbers
+--                           max - capacity of sequences
+--
+-- RETURNS:     Returns the number of sequence numbers read
+--
+-------------------------------------------------------------------------------------------------------------------*/
+int StreamPacket::readNack(const char *payload, int length, uint32_t *sequences, int max) {
+    int count = length / 4;
+    if (count > max) {
+        count = max;
+    }
+    for (int i = 0; i < count; i++) {
+        sequences[i] = readU32(payload + i * 4);
+    }
+    return count;
+}
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	buildDescriptor
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:   October 19, 2026 - The reserved byte carries the codec - agent
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	int buildDescriptor(const StreamDescriptor &descriptor, uint32_t sequence, char *buf)
+--                                  descriptor - format of the audio in the stream
+--                                  sequence - first audio sequence number the format applies to
+--                                  buf - destination, must hold DATA_BUFSIZE bytes
+--
+-- RETURNS:     Returns the size of the descriptor datagram
+--
+-- NOTES:
+--              Payload layout: sampleRate(4) channels(1) sampleSize(1) sampleType(1) codec(1) frameSize(2)
+--              For a compressed stream the sample fields describe the PCM the codec decodes to.
+--
+-------------------------------------------------------------------------------------------------------------------*/
+int StreamPacket::buildDescriptor(const StreamDescriptor &descriptor, uint32_t sequence, char *buf) {
+    StreamPacketHeader header = {};
+    char *payload = buf + STREAM_HEADER_SIZE;
+    header.type = PACKET_DESCRIPTOR;
+    header.sequence = sequence;
+    header.length = STREAM_DESCRIPTOR_SIZE;
+    writeHeader(header, buf);
+    writeFormat(payload, descriptor);
+    return STREAM_HEADER_SIZE + STREAM_DESCRIPTOR_SIZE;
+}
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	readDescriptor
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:   October 19, 2026 - Read the codec - agent
+--              October 19, 2026 - Reject a frame size that does not match the samples - agent
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	bool readDescriptor(const char *payload, int length, StreamDescriptor &descriptor)
+--                                  payload - payload of a descriptor packet
+--                                  length - payload length from the header
+--                                  descriptor - filled in with the stream format
+--
+-- RETURNS:     Returns false if the payload is too short or describes an unusable format, including a frame
+--              size that is not the channels' samples
+--
+-------------------------------------------------------------------------------------------------------------------*/
+bool StreamPacket::readDescriptor(const char *payload, int length, StreamDescriptor &descriptor) {
+    if (length < STREAM_DESCRIPTOR_SIZE) {
+        return false;
+    }
+    return readFormat(payload, descriptor);
+}
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	sameFormat
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:   October 19, 2026 - Compare the codec - agent
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	bool sameFormat(const StreamDescriptor &a, const StreamDescriptor &b)
+--
+-- RETURNS:     Returns true if both descriptors describe the same audio format
+--
+-------------------------------------------------------------------------------------------------------------------*/
+bool StreamPacket::sameFormat(const StreamDescriptor &a, const StreamDescriptor &b) {
+    return a.sampleRate == b.sampleRate && a.channels == b.channels && a.sampleSize == b.sampleSize &&
+            a.sampleType == b.sampleType && a.codec == b.codec && a.frameSize == b.frameSize;
+}
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	buildTrackChange
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	int buildTrackChange(uint32_t sequence, uint16_t index, const std::string &title, char *buf)
+--                                   sequence - audio packet the track starts in
+--                                   index - position of the track in the playlist
+--                                   title - track title, cut to TRACK_TITLE_MAX bytes
+--                                   buf - destination, must hold DATA_BUFSIZE bytes
+--
+-- RETURNS:     Returns the size of the marker datagram
+--
+-- NOTES:
+--              Payload layout: index(2) title(rest, UTF-8, not terminated)
+--
+-------------------------------------------------------------------------------------------------------------------*/
+int StreamPacket::buildTrackChange(uint32_t sequence, uint16_t index, const std::string &title, char *buf) {
+    StreamPacketHeader header = {};
+    int titleLength = title.size() < TRACK_TITLE_MAX ? (int)title.size() : TRACK_TITLE_MAX;
+    header.type = PACKET_TRACK_CHANGE;
+    header.sequence = sequence;
+    header.length = (uint16_t)(2 + titleLength);
+    writeHeader(header, buf);
+    writeU16(buf + STREAM_HEADER_SIZE, index);
+    memcpy(buf + STREAM_HEADER_SIZE + 2, title.data(), titleLength);
+    return STREAM_HEADER_SIZE + 2 + titleLength;
+}
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	readTrackChange
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	bool readTrackChange(const char *payload, int length, uint16_t &index, std::string &title)
+--                                   payload - payload of a track change packet
+--                                   length - payload length from the header
+--                                   index - set to the playlist position of the track
+--                                   title - set to the track title
+--
+-- RETURNS:     Returns false if the payload is too short
+--
+-------------------------------------------------------------------------------------------------------------------*/
+bool StreamPacket::readTrackChange(const char *payload, int length, uint16_t &index, std::string &title) {
+    if (length < 2) {
+        return false;
+    }
+    index = readU16(payload);
+    title.assign(payload + 2, length - 2);
+    return true;
+}
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	buildDiscontinuity
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	int buildDiscontinuity(uint32_t sequence, DiscontinuityReason reason, uint32_t positionMs, char *buf)
+--                                     sequence - first audio packet after the break
+--                                     reason - DISCONTINUITY_SEEK or DISCONTINUITY_PAUSE
+--                                     positionMs - position in the track the audio carries on from
+--                                     buf - destination, must hold DATA_BUFSIZE bytes
+--
+-- RETURNS:     Returns the size of the marker datagram
+--
+-- NOTES:
+--              Payload layout: reason(1) positionMs(4)
+--
+-------------------------------------------------------------------------------------------------------------------*/
+int StreamPacket::buildDiscontinuity(uint32_t sequence, DiscontinuityReason reason, uint32_t positionMs, char *buf) {
+    StreamPacketHeader header = {};
+    header.type = PACKET_DISCONTINUITY;
+    header.sequence = sequence;
+    header.length = 5;
+    writeHeader(header, buf);
+    buf[STREAM_HEADER_SIZE] = (char)reason;
+    writeU32(buf + STREAM_HEADER_SIZE + 1, positionMs);
+    return STREAM_HEADER_SIZE + 5;
+}
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	readDiscontinuity
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	bool readDiscontinuity(const char *payload, int length, DiscontinuityReason &reason,
+--                                     uint32_t &positionMs)
+--                                     payload - payload of a discontinuity packet
+--                                     length - payload length from the header
+--                                     reason - set to why the audio breaks
+--                                     positionMs - set to the position in the track after the break
+--
+-- RETURNS:     Returns false if the payload is too short or the reason is unknown
+--
+-------------------------------------------------------------------------------------------------------------------*/
+bool StreamPacket::readDiscontinuity(const char *payload, int length, DiscontinuityReason &reason,
+                                     uint32_t &positionMs) {
+    if (length < 5 || (uint8_t)payload[0] > DISCONTINUITY_PAUSE) {
+        return false;
+    }
+    reason = (DiscontinuityReason)(uint8_t)payload[0];
+    positionMs = readU32(payload + 1);
+    return true;
+}
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	buildJoin
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	int buildJoin(uint16_t burstMs, char *buf)
+--                            burstMs - how much recent audio the listener wants, in milliseconds
+--                            buf - destination, must hold DATA_BUFSIZE bytes
+--
+-- RETURNS:     Returns the size of the join datagram
+--
+-- NOTES:
+--              Sent by a new listener to the repair port. Payload layout: burstMs(2)
+--
+-------------------------------------------------------------------------------------------------------------------*/
+int StreamPacket::buildJoin(uint16_t burstMs, char *buf) {
+    StreamPacketHeader header = {};
+    header.type = PACKET_JOIN;
+    header.length = 2;
+    writeHeader(header, buf);
+    writeU16(buf + STREAM_HEADER_SIZE, burstMs);
+    return STREAM_HEADER_SIZE + 2;
+}
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	readJoin
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	bool readJoin(const char *payload, int length, uint16_t &burstMs)
+--                            payload - payload of a join packet
+--                            length - payload length from the header
+--                            burstMs - set to the requested amount of audio, at most JOIN_BURST_MAX_MS
+--
+-- RETURNS:     Returns false if the payload is too short
+--
+-------------------------------------------------------------------------------------------------------------------*/
+bool StreamPacket::readJoin(const char *payload, int length, uint16_t &burstMs) {
+    if (length < 2) {
+        return false;
+    }
+    burstMs = readU16(payload);
+    if (burstMs > JOIN_BURST_MAX_MS) {
+        burstMs = JOIN_BURST_MAX_MS;
+    }
+    return true;
+}
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	buildSubscribe
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	int buildSubscribe(char *buf)
+--                                 buf - destination, must hold DATA_BUFSIZE bytes
+--
+-- RETURNS:     Returns the size of the subscribe datagram
+--
+-- NOTES:
+--              A subscription has no payload. The server sends the stream back to the address it came from.
+--
+-------------------------------------------------------------------------------------------------------------------*/
+int StreamPacket::buildSubscribe(char *buf) {
+    StreamPacketHeader header = {};
+    header.type = PACKET_SUBSCRIBE;
+    return writeHeader(header, buf);
+}
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	newSource
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	uint32_t newSource()
+--
+-- RETURNS:     A random source id for a new call, never 0
+--
+-- NOTES:
+--              Some runtimes give the same random_device sequence in every process, so the clock is mixed in.
+--
+-------------------------------------------------------------------------------------------------------------------*/
+uint32_t StreamPacket::newSource() {
+    static std::random_device device;
+    uint32_t source = device() ^ (uint32_t)std::chrono::high_resolution_clock::now().time_since_epoch().count();
+    return source != 0 ? source : 1;
+}
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	readSource
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:   October 19, 2026 - Read the source of echo probes - agent
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	bool readSource(const char *buf, int bytes, uint32_t &source)
+--                              buf - a whole datagram
+--                              bytes - size of the datagram
+--                              source - set to the sender's source id
+--
+-- RETURNS:     Returns false if the datagram is not a voice, comfort noise or echo packet
+--
+-- NOTES:
+--              Lets a receiver find the call a packet belongs to before reading the rest of it.
+--
+-------------------------------------------------------------------------------------------------------------------*/
+bool StreamPacket::readSource(const char *buf, int bytes, uint32_t &source) {
+    StreamPacketHeader header;
+    if (!readHeader(buf, bytes, header) || (header.type != PACKET_VOICE && header.type != PACKET_COMFORT_NOISE &&
+                                            header.type != PACKET_ECHO) || header.length < STREAM_SOURCE_SIZE) {
+        return false;
+    }
+    source = readU32(buf + STREAM_HEADER_SIZE);
+    return true;
+}
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	buildVoice
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:   October 19, 2026 - Stamp voice frames with their capture time - agent
+--              October 19, 2026 - Carry the sender's source id - agent
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	int buildVoice(uint32_t source, const StreamDescriptor &format, uint32_t sequence,
+--                             uint32_t timestamp, const char *audio, int length, char *buf)
+--                             source - id the sender picked for this call
+--                             format - format and codec of the audio
+--                             sequence - number of the frame in the capture
+--                             timestamp - capture time of the frame's first sample in milliseconds
+--                             audio - encoded audio
+--                             length - number of audio bytes, at most STREAM_PAYLOAD_SIZE - VOICE_PREFIX_SIZE
+--                             buf - destination, must hold DATA_BUFSIZE bytes
+--
+-- RETURNS:     Returns the size of the voice datagram
+--
+-- NOTES:
+--              Calls have no setup exchange, so every voice packet describes its own format and says which
+--              call it belongs to. The source id tells callers apart where the address cannot, such as two
+--              behind one NAT or one whose port changes mid call. Payload layout:
+--              source(4) format(STREAM_DESCRIPTOR_SIZE, as in a descriptor) audio(rest)
+--
+-------------------------------------------------------------------------------------------------------------------*/
+int StreamPacket::buildVoice(uint32_t source, const StreamDescriptor &format, uint32_t sequence, uint32_t timestamp,
+                             const char *audio, int length, char *buf) {
+    StreamPacketHeader header = {};
+    header.type = PACKET_VOICE;
+    header.sequence = sequence;
+    header.timestamp = timestamp;
+    header.length = (uint16_t)(VOICE_PREFIX_SIZE + length);
+    writeHeader(header, buf);
+    writeU32(buf + STREAM_HEADER_SIZE, source);
+    writeFormat(buf + STREAM_HEADER_SIZE + STREAM_SOURCE_SIZE, format);
+    memcpy(buf + STREAM_HEADER_SIZE + VOICE_PREFIX_SIZE, audio, length);
+    return STREAM_HEADER_SIZE + VOICE_PREFIX_SIZE + length;
+}
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	readVoice
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:   October 19, 2026 - Read the sender's source id - agent
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	bool readVoice(const char *payload, int length, uint32_t &source, StreamDescriptor &format,
+--                             const char *&audio, int &audioLength)
+--                             payload - payload of a voice packet
+--                             length - payload length from the header
+--                             source - set to the sender's source id
+--                             format - set to the format and codec of the audio
+--                             audio - set to point at the audio inside the payload
+--                             audioLength - set to the number of audio bytes
+--
+-- RETURNS:     Returns false if the payload is too short or describes an unusable format, including a frame
+--              size that is not the channels' samples
+--
+-------------------------------------------------------------------------------------------------------------------*/
+bool StreamPacket::readVoice(const char *payload, int length, uint32_t &source, StreamDescriptor &format,
+                             const char *&audio, int &audioLength) {
+    if (length < VOICE_PREFIX_SIZE || !readFormat(payload + STREAM_SOURCE_SIZE, format)) {
+        return false;
+    }
+    source = readU32(payload);
+    audio = payload + VOICE_PREFIX_SIZE;
+    audioLength = length - VOICE_PREFIX_SIZE;
+    return true;
+}
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	buildComfortNoise
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:   October 19, 2026 - Carry the sender's source id - agent
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	int buildComfortNoise(uint32_t source, const StreamDescriptor &format, uint32_t sequence,
+--                                    uint32_t timestamp, uint8_t level, char *buf)
+--                                    source - id the sender picked for this call
+--                                    format - format of the caller's voice packets
+--                                    sequence - number of the silent frame it stands for
+--                                    timestamp - capture time of that frame in milliseconds
+--                                    level - background noise level in -dBov, 0 to 127
+--                                    buf - destination, must hold DATA_BUFSIZE bytes
+--
+-- RETURNS:     Returns the size of the marker datagram
+--
+-- NOTES:
+--              Sent instead of voice while the caller is silent, so the listener can play noise like the
+--              caller's background rather than nothing. Payload layout:
+--              source(4) format(STREAM_DESCRIPTOR_SIZE, as in a descriptor) level(1)
+--
+-------------------------------------------------------------------------------------------------------------------*/
+int StreamPacket::buildComfortNoise(uint32_t source, const StreamDescriptor &format, uint32_t sequence,
+                                    uint32_t timestamp, uint8_t level, char *buf) {
+    StreamPacketHeader header = {};
+    header.type = PACKET_COMFORT_NOISE;
+    header.sequence = sequence;
+    header.timestamp = timestamp;
+    header.length = (uint16_t)(VOICE_PREFIX_SIZE + 1);
+    writeHeader(header, buf);
+    writeU32(buf + STREAM_HEADER_SIZE, source);
+    writeFormat(buf + STREAM_HEADER_SIZE + STREAM_SOURCE_SIZE, format);
+    buf[STREAM_HEADER_SIZE + VOICE_PREFIX_SIZE] = (char)(level & 0x7F);
+    return STREAM_HEADER_SIZE + VOICE_PREFIX_SIZE + 1;
+}
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	readComfortNoise
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:   October 19, 2026 - Read the sender's source id - agent
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	bool readComfortNoise(const char *payload, int length, uint32_t &source,
+--                                    StreamDescriptor &format, uint8_t &level)
+--                                    payload - payload of a comfort noise packet
+--                                    length - payload length from the header
+--                                    source - set to the sender's source id
+--                                    format - set to the format of the caller's voice packets
+--                                    level - set to the background noise level in -dBov
+--
+-- RETURNS:     Returns false if the payload is too short or describes an unusable format, including a frame
+--              size that is not the channels' samples
+--
+-------------------------------------------------------------------------------------------------------------------*/
+bool StreamPacket::readComfortNoise(const char *payload, int length, uint32_t &source, StreamDescriptor &format,
+                                    uint8_t &level) {
+    if (length < VOICE_PREFIX_SIZE + 1 || !readFormat(payload + STREAM_SOURCE_SIZE, format)) {
+        return false;
+    }
+    source = readU32(payload);
+    level = (uint8_t)payload[VOICE_PREFIX_SIZE] & 0x7F;
+    return true;
+}
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	buildEcho
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	int buildEcho(uint32_t source, bool reply, uint32_t origin, uint32_t timestamp, char *buf)
+--                            source - id of the session sending it, 0 for a stream server or listener
+--                            reply - false for a probe, true for the answer to one
+--                            origin - for a reply, the timestamp of the probe it answers
+--                            timestamp - the sender's clock as it sends, in milliseconds
+--                            buf - destination, must hold DATA_BUFSIZE bytes
+--
+-- RETURNS:     Returns the size of the echo datagram
+--
+-- NOTES:
+--              A probe is answered straight away with a reply that carries the probe's timestamp back as its
+--              origin, and the answering side's clock as its own timestamp. The prober gets the round trip
+--              from the origin and how far the two clocks are apart from the timestamp. Payload layout:
+--              source(4) reply(1) origin(4)
+--
+-------------------------------------------------------------------------------------------------------------------*/
+int StreamPacket::buildEcho(uint32_t source, bool reply, uint32_t origin, uint32_t timestamp, char *buf) {
+    StreamPacketHeader header = {};
+    header.type = PACKET_ECHO;
+    header.timestamp = timestamp;
+    header.length = ECHO_PAYLOAD_SIZE;
+    writeHeader(header, buf);
+    writeU32(buf + STREAM_HEADER_SIZE, source);
+    buf[STREAM_HEADER_SIZE + STREAM_SOURCE_SIZE] = reply ? 1 : 0;
+    writeU32(buf + STREAM_HEADER_SIZE + STREAM_SOURCE_SIZE + 1, origin);
+    return STREAM_HEADER_SIZE + ECHO_PAYLOAD_SIZE;
+}
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	readEcho
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	bool readEcho(const char *payload, int length, uint32_t &source, bool &reply, uint32_t &origin)
+--                            payload - payload of an echo packet
+--                            length - payload length from the header
+--                            source - set to the sender's source id
+--                            reply - set to whether it answers a probe
+--                            origin - set to the timestamp of the probe it answers
+--
+-- RETURNS:     Returns false if the payload is too short
+--
+-------------------------------------------------------------------------------------------------------------------*/
+bool StreamPacket::readEcho(const char *payload, int length, uint32_t &source, bool &reply, uint32_t &origin) {
+    if (length < ECHO_PAYLOAD_SIZE) {
+        return false;
+    }
+    source = readU32(payload);
+    reply = payload[STREAM_SOURCE_SIZE] != 0;
+    origin = readU32(payload + STREAM_SOURCE_SIZE + 1);
+    return true;
+}
@@ -0,0 +1,109 @@
+#pragma once
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+#define DATA_BUFSIZE 4000
+#define STREAM_PACKET_MAGIC 0x4341
+#define STREAM_HEADER_SIZE 16
+#define STREAM_PAYLOAD_SIZE (DATA_BUFSIZE - STREAM_HEADER_SIZE)
+#define STREAM_REPAIR_PORT_OFFSET 1
+#define NACK_MAX_SEQUENCES 64
+#define STREAM_DESCRIPTOR_SIZE 10
+#define STREAM_SOURCE_SIZE 4
+#define VOICE_PREFIX_SIZE (STREAM_SOURCE_SIZE + STREAM_DESCRIPTOR_SIZE)
+#define ECHO_PAYLOAD_SIZE (STREAM_SOURCE_SIZE + 5)
+#define DESCRIPTOR_INTERVAL 16
+#define TRACK_TITLE_MAX 200
+#define JOIN_BURST_MAX_MS 2000
+#define DISCONTINUITY_REPEATS 3
+
+enum StreamPacketType : uint8_t
+{
+    PACKET_AUDIO = 1,
+    PACKET_PARITY = 2,
+    PACKET_NACK = 3,
+    PACKET_DESCRIPTOR = 4,
+    PACKET_TRACK_CHANGE = 5,
+    PACKET_VOICE = 6,
+    PACKET_JOIN = 7,
+    PACKET_SUBSCRIBE = 8,
+    PACKET_DISCONTINUITY = 9,
+    PACKET_COMFORT_NOISE = 10,
+    PACKET_ECHO = 11
+};
+
+enum DiscontinuityReason : uint8_t
+{
+    DISCONTINUITY_SEEK = 0,
+    DISCONTINUITY_PAUSE = 1
+};
+
+enum StreamSampleType : uint8_t
+{
+    SAMPLE_SIGNED = 0,
+    SAMPLE_UNSIGNED = 1,
+    SAMPLE_FLOAT = 2
+};
+
+enum AudioCodecId : uint8_t
+{
+    CODEC_PCM = 0,
+    CODEC_ULAW = 1,
+    CODEC_ALAW = 2,
+    CODEC_IMA_ADPCM = 3,
+    CODEC_COUNT
+};
+
+struct StreamPacketHeader
+{
+    uint16_t magic;
+    uint8_t type;
+    uint8_t groupSize;
+    uint32_t sequence;
+    uint32_t timestamp;
+    uint16_t length;
+    uint16_t parityLength;
+};
+
+struct StreamDescriptor
+{
+    uint32_t sampleRate;
+    uint8_t channels;
+    uint8_t sampleSize;
+    uint8_t sampleType;
+    uint8_t codec;
+    uint16_t frameSize;
+};
+
+class StreamPacket {
+public:
+    static int writeHeader(const StreamPacketHeader &header, char *buf);
+    static bool readHeader(const char *buf, int bytes, StreamPacketHeader &header);
+    static int build(StreamPacketType type, uint32_t sequence, uint32_t timestamp,
+                     const char *payload, int length, char *buf);
+    static int buildNack(const uint32_t *sequences, int count, char *buf);
+    static int readNack(const char *payload, int length, uint32_t *sequences, int max);
+    static int buildDescriptor(const StreamDescriptor &descriptor, uint32_t sequence, char *buf);
+    static bool readDescriptor(const char *payload, int length, StreamDescriptor &descriptor);
+    static bool sameFormat(const StreamDescriptor &a, const StreamDescriptor &b);
+    static int buildTrackChange(uint32_t sequence, uint16_t index, const std::string &title, char *buf);
+    static bool readTrackChange(const char *payload, int length, uint16_t &index, std::string &title);
+    static int buildDiscontinuity(uint32_t sequence, DiscontinuityReason reason, uint32_t positionMs, char *buf);
+    static bool readDiscontinuity(const char *payload, int length, DiscontinuityReason &reason, uint32_t &positionMs);
+    static int buildJoin(uint16_t burstMs, char *buf);
+    static bool readJoin(const char *payload, int length, uint16_t &burstMs);
+    static int buildSubscribe(char *buf);
+    static uint32_t newSource();
+    static bool readSource(const char *buf, int bytes, uint32_t &source);
+    static int buildVoice(uint32_t source, const StreamDescriptor &format, uint32_t sequence, uint32_t timestamp,
+                          const char *audio, int length, char *buf);
+    static bool readVoice(const char *payload, int length, uint32_t &source, StreamDescriptor &format,
+                          const char *&audio, int &audioLength);
+    static int buildComfortNoise(uint32_t source, const StreamDescriptor &format, uint32_t sequence,
+                                 uint32_t timestamp, uint8_t level, char *buf);
+    static bool readComfortNoise(const char *payload, int length, uint32_t &source, StreamDescriptor &format,
+                                 uint8_t &level);
+    static int buildEcho(uint32_t source, bool reply, uint32_t origin, uint32_t timestamp, char *buf);
+    static bool readEcho(const char *payload, int length, uint32_t &source, bool &reply, uint32_t &origin);
+};
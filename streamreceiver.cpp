@@ -0,0 +1,1102 @@
+/*------------------------------------------------------------------------------------------------------------------
+-- SOURCE FILE: 	streamreceiver.cpp - Reorders received stream packets and rebuilds lost ones before playback.
+--
+--
+-- PROGRAM: 		Communication Audio Program
+--
+-- FUNCTIONS:
+--                  StreamReceiver(int playoutDepth, PlayCallback play, FormatCallback applyFormat)
+--                  static int runFromArguments(int argc, char *argv[])
+--                  static QString benchmark(double lossPercent, int groupSize)
+--                  static QString joinBenchmark(int joins, int burstMs, int oneWayMs)
+--                  bool receive(const char *datagram, int bytes, uint32_t now)
+--                  void reset()
+--                  bool hasPacket(uint32_t sequence)
+--                  void storePacket(uint32_t sequence, const char *payload, int length, uint32_t transitMs)
+--                  void storeParity(const StreamPacketHeader &header, const char *payload)
+--                  void receiveDescriptor(const StreamPacketHeader &header, const char *payload)
+--                  void receiveTrackChange(const StreamPacketHeader &header, const char *payload)
+--                  void changeTrack(uint32_t sequence, const std::string &title)
+--                  void receiveDiscontinuity(const StreamPacketHeader &header, const char *payload)
+--                  void skipTo(uint32_t sequence)
+--                  bool confirmJump(uint32_t sequence)
+--                  void resync(uint32_t sequence)
+--                  void applyPending()
+--                  void tryRecover(uint32_t groupStart)
+--                  void releaseNext()
+--                  void releaseReady()
+--
+-- DATE: 			October 19, 2026
+--
+-- REVISIONS:       October 19, 2026 - Report gaps to a NackScheduler for the repair channel - agent
+--                  October 19, 2026 - Apply stream format descriptors in sequence order - agent
+--                  October 19, 2026 - Report track changes when the new track starts playing - agent
+--                  October 19, 2026 - Report lost packets at their turn so they can be concealed - agent
+--                  October 19, 2026 - Drop stale audio at seek markers and play out the tail at pauses - agent
+--                  October 19, 2026 - Time each packet's transit and its wait in the window - agent
+--                  October 19, 2026 - Resync after a restart instead of releasing every packet in between - agent
+--                  October 19, 2026 - Add --fec-bench, FEC through a simulated lossy channel - agent
+--                  October 19, 2026 - Add --join-bench, time to first audio with and without a join burst - agent
+--
+-- DESIGNER: 		agent
+--
+-- PROGRAMMER: 		agent
+--
+-- NOTES:
+--      Packets are held in a window indexed by sequence number and handed to the play callback in order once
+--      they are playoutDepth packets behind the newest packet received. That delay is the playout deadline:
+--      a packet that is still missing when its turn comes is counted as lost. While a packet is waiting, the
+--      parity packet of its FEC group can rebuild it if it is the only packet of the group that went missing.
+--
+--      When a loss callback is set it is called at the turn of every lost packet, so something can be played
+--      in its place (see LossConcealer) and the audio after it keeps its timing.
+--
+--      When a NackScheduler is attached, every gap in the sequence numbers is reported to it, and packets
+--      that arrive, are rebuilt or pass their deadline cancel the pending request.
+--
+--      Audio is only accepted once a format descriptor has been received, since playing samples in the wrong
+--      format is worse than silence. A descriptor announcing a new format takes effect when the audio packet
+--      with its sequence number is played, so packets still in the window play in the old format. Track change
+--      markers are held back the same way so the title changes when the new track is heard.
+--
+--      When the server seeks, it sends a discontinuity marker with the first packet from the new position. The
+--      packets before it that are still waiting are dropped instead of played, so listeners hear the jump at
+--      once rather than a playout depth of stale audio. When the server pauses, the marker carries the packet
+--      the stream will carry on from, and the packets still held back are played out straight away instead of
+--      waiting for the stream to resume.
+--
+--      When a LatencyMeter is attached, every audio packet's transit is recorded from the server's send stamp
+--      as it arrives, repairs included, and its wait in the window as it is played. While the play callback
+--      runs, getPlayingDelay() gives the two together for the packet being played.
+--
+--      A StreamReceiver is only used from the thread that reads the socket so it does no locking.
+--
+--      --fec-bench sends a stream through a simulated lossy channel twice, without parity and with it, and
+--      times the parity encoding on the way and the receiver, recovery included, at the other end.
+--      --join-bench measures how long listeners joining at random times wait for their first audio, from live
+--      packets alone and with a join burst.
+--
+--------------------------------------------------------------------------------------------------------------------*/
+#include "streamreceiver.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <vector>
+
+struct FecBenchRun {
+    StreamReceiver::Statistics stats;
+    uint32_t played;
+    uint32_t datagramsSent;
+    uint64_t encodeTicks;
+    uint64_t receiveTicks;
+};
+
+static uint64_t readCounter() {
+    LARGE_INTEGER counter;
+    QueryPerformanceCounter(&counter);
+    return (uint64_t)counter.QuadPart;
+}
+
+static uint32_t nextRandom(uint32_t &state) {
+    state ^= state << 13;
+    state ^= state >> 17;
+    state ^= state << 5;
+    return state;
+}
+
+static FecBenchRun runLossyChannel(double lossPercent, int groupSize) {
+    StreamDescriptor format = { 44100, 2, 16, SAMPLE_SIGNED, CODEC_PCM, 4 };
+    FecBenchRun run = {};
+    StreamReceiver *receiver = new StreamReceiver(DEFAULT_PLAYOUT_DEPTH,
+        [&run](const char *, int) {
+            run.played++;
+        },
+        [](const StreamDescriptor &) {});
+    FecEncoder *encoder = groupSize > 1 ? new FecEncoder(groupSize) : nullptr;
+    char *datagram = new char[DATA_BUFSIZE];
+    char *parity = new char[DATA_BUFSIZE];
+    char *payload = datagram + STREAM_HEADER_SIZE;
+    memset(payload, 0x55, STREAM_PAYLOAD_SIZE);
+    uint32_t dropBelow = (uint32_t)(lossPercent / 100 * 4294967295.0);
+    uint32_t audioState = FEC_BENCH_SEED;
+    uint32_t parityState = ~FEC_BENCH_SEED;
+
+    for (uint32_t sequence = 0; sequence < FEC_BENCH_PACKETS; sequence++) {
+        uint32_t now = sequence * FEC_BENCH_PACKET_MS;
+        if (sequence % DESCRIPTOR_INTERVAL == 0) {
+            char descriptor[DATA_BUFSIZE];
+            receiver->receive(descriptor, StreamPacket::buildDescriptor(format, sequence, descriptor), now);
+        }
+        StreamPacketHeader header = {};
+        header.type = PACKET_AUDIO;
+        header.groupSize = (uint8_t)(encoder ? encoder->getGroupSize() : 0);
+        header.sequence = sequence;
+        header.timestamp = now;
+        header.length = STREAM_PAYLOAD_SIZE;
+        StreamPacket::writeHeader(header, datagram);
+        memcpy(payload, &sequence, sizeof(sequence));
+        int parityBytes = 0;
+        if (encoder) {
+            uint64_t began = readCounter();
+            if (encoder->addPacket(sequence, payload, STREAM_PAYLOAD_SIZE)) {
+                parityBytes = encoder->buildParityPacket(now, parity);
+            }
+            run.encodeTicks += readCounter() - began;
+        }
+
+        uint64_t began = readCounter();
+        if (nextRandom(audioState) >= dropBelow) {
+            receiver->receive(datagram, STREAM_HEADER_SIZE + STREAM_PAYLOAD_SIZE, now);
+        }
+        if (parityBytes > 0 && nextRandom(parityState) >= dropBelow) {
+            receiver->receive(parity, parityBytes, now);
+        }
+        run.receiveTicks += readCounter() - began;
+        run.datagramsSent += parityBytes > 0 ? 2 : 1;
+    }
+    run.stats = receiver->getStatistics();
+    delete[] parity;
+    delete[] datagram;
+    delete encoder;
+    delete receiver;
+    return run;
+}
+
+static int buildBenchAudio(uint32_t sequence, double sentAt, int length, char *datagram) {
+    StreamPacketHeader header = {};
+    header.type = PACKET_AUDIO;
+    header.sequence = sequence;
+    header.timestamp = (uint32_t)sentAt;
+    header.length = (uint16_t)length;
+    StreamPacket::writeHeader(header, datagram);
+    memset(datagram + STREAM_HEADER_SIZE, 0x55, length);
+    return STREAM_HEADER_SIZE + length;
+}
+
+static double timeToFirstAudio(double joinAt, int burstMs, double oneWayMs) {
+    StreamDescriptor format = { 44100, 2, 16, SAMPLE_SIGNED, CODEC_PCM, 4 };
+    uint32_t byteRate = format.sampleRate * format.frameSize;
+    int chunk = STREAM_PAYLOAD_SIZE - STREAM_PAYLOAD_SIZE % format.frameSize;
+    double packetMs = 1000.0 * chunk / byteRate;
+    double now = joinAt;
+    bool heard = false;
+    StreamReceiver *receiver = new StreamReceiver(DEFAULT_PLAYOUT_DEPTH,
+        [&heard](const char *, int) {
+            heard = true;
+        },
+        [](const StreamDescriptor &) {});
+    char *datagram = new char[DATA_BUFSIZE];
+    uint32_t first = (uint32_t)ceil((joinAt - oneWayMs) / packetMs);
+    double burstAt = burstMs > 0 ? joinAt + 2 * oneWayMs : -1;
+
+    for (uint32_t sequence = first; !heard && sequence != first + JOIN_BENCH_MAX_PACKETS; sequence++) {
+        double arrivesAt = sequence * packetMs + oneWayMs;
+        if (burstAt >= 0 && burstAt <= arrivesAt) {
+            // What StreamChannel::sendBurst queues when the join request reaches it
+            uint32_t sent = (uint32_t)((joinAt + oneWayMs) / packetMs) + 1;
+            uint32_t count = (uint32_t)((uint64_t)burstMs * byteRate / 1000 / chunk) + 1;
+            now = burstAt;
+            burstAt = -1;
+            receiver->receive(datagram, StreamPacket::buildDescriptor(format, sent - count, datagram), (uint32_t)now);
+            for (uint32_t burst = sent - count; burst != sent; burst++) {
+                receiver->receive(datagram, buildBenchAudio(burst, burst * packetMs, chunk, datagram), (uint32_t)now);
+            }
+            if (heard) {
+                break;
+            }
+        }
+        now = arrivesAt;
+        if (sequence % DESCRIPTOR_INTERVAL == 0) {
+            receiver->receive(datagram, StreamPacket::buildDescriptor(format, sequence, datagram), (uint32_t)now);
+        }
+        receiver->receive(datagram, buildBenchAudio(sequence, sequence * packetMs, chunk, datagram), (uint32_t)now);
+    }
+    delete[] datagram;
+    delete receiver;
+    return heard ? now - joinAt : -1;
+}
+
+static QString describeJoins(std::vector<double> &delays) {
+    std::sort(delays.begin(), delays.end());
+    double total = 0;
+    for (double delay : delays) {
+        total += delay;
+    }
+    return QString("%1 ms on average, %2 ms at the 95th percentile, %3 ms at worst")
+            .arg(total / delays.size(), 0, 'f', 0)
+            .arg(delays[delays.size() * 95 / 100], 0, 'f', 0)
+            .arg(delays.back(), 0, 'f', 0);
+}
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	StreamReceiver
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	StreamReceiver(int playoutDepth, PlayCallback play, FormatCallback applyFormat)
+--                             playoutDepth - number of packets held back before playing
+--                             play - called with each payload in sequence order
+--                             applyFormat - called when the audio format of the stream changes
+--
+-- RETURNS:     NA
+--
+-- NOTES:
+--              The depth must be larger than the FEC group size for parity to arrive before the deadline.
+--
+-------------------------------------------------------------------------------------------------------------------*/
+StreamReceiver::StreamReceiver(int playoutDepth, PlayCallback play, FormatCallback applyFormat)
+    : play(play), applyFormat(applyFormat) {
+    if (playoutDepth < 1) {
+        playoutDepth = 1;
+    } else if (playoutDepth > RECEIVER_WINDOW / 2) {
+        playoutDepth = RECEIVER_WINDOW / 2;
+    }
+    this->playoutDepth = playoutDepth;
+    reset();
+}
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	runFromArguments
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:   October 19, 2026 - Add --join-bench - agent
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	static int runFromArguments(int argc, char *argv[])
+--                          argc - number of command line arguments
+--                          argv - the command line arguments
+--
+-- RETURNS:     The process exit code
+--
+-- NOTES:
+--              The forms are
+--                  --fec-bench [loss percent] [group size]
+--                  --join-bench [burst ms] [one way ms]
+--              The benchmark prints its result and returns.
+--
+-------------------------------------------------------------------------------------------------------------------*/
+int StreamReceiver::runFromArguments(int argc, char *argv[]) {
+    if (strcmp(argv[1], "--join-bench") == 0) {
+        int burstMs = argc >= 3 ? atoi(argv[2]) : JOIN_BENCH_BURST_MS;
+        int oneWayMs = argc >= 4 ? atoi(argv[3]) : JOIN_BENCH_ONE_WAY_MS;
+        if (burstMs <= 0 || burstMs > JOIN_BURST_MAX_MS) {
+            burstMs = JOIN_BENCH_BURST_MS;
+        }
+        qDebug() << joinBenchmark(JOIN_BENCH_JOINS, burstMs, oneWayMs >= 0 ? oneWayMs : JOIN_BENCH_ONE_WAY_MS);
+        return 0;
+    }
+    if (strcmp(argv[1], "--fec-bench") != 0) {
+        qDebug() << "Usage: --fec-bench [loss percent] [group size]\n"
+                 << "       --join-bench [burst ms] [one way ms]\n";
+        return 1;
+    }
+    double lossPercent = argc >= 3 ? atof(argv[2]) : FEC_BENCH_LOSS_PERCENT;
+    int groupSize = argc >= 4 ? atoi(argv[3]) : DEFAULT_FEC_GROUP_SIZE;
+    if (lossPercent < 0 || lossPercent >= 100) {
+        lossPercent = FEC_BENCH_LOSS_PERCENT;
+    }
+    qDebug() << benchmark(lossPercent, groupSize > 1 ? groupSize : DEFAULT_FEC_GROUP_SIZE);
+    return 0;
+}
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	benchmark
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	static QString benchmark(double lossPercent, int groupSize)
+--                                lossPercent - chance of each datagram being dropped
+--                                groupSize - audio packets per parity packet in the second run
+--
+-- RETURNS:     A one line summary of both runs
+--
+-- NOTES:
+--              FEC_BENCH_PACKETS full packets, one every FEC_BENCH_PACKET_MS of stream time, go through a
+--              receiver with the default playout depth. Each audio and parity datagram is dropped independently
+--              and at random, the audio the same way in both runs, as on Wi-Fi; descriptors always arrive, as they are
+--              repeated anyway. Encoding is the time spent in the FecEncoder, receiving the time spent in
+--              receive(), rebuilding included, and both are given as a share of what one core could carry of
+--              44.1 kHz stereo streams.
+--
+-------------------------------------------------------------------------------------------------------------------*/
+QString StreamReceiver::benchmark(double lossPercent, int groupSize) {
+    LARGE_INTEGER frequency;
+    QueryPerformanceFrequency(&frequency);
+    double bytes = (double)FEC_BENCH_PACKETS * STREAM_PAYLOAD_SIZE;
+    double streamRate = 44100.0 * 4;
+    FecBenchRun plain = runLossyChannel(lossPercent, 0);
+    FecBenchRun fec = runLossyChannel(lossPercent, groupSize);
+    double encodeSeconds = (double)fec.encodeTicks / frequency.QuadPart;
+    double receiveSeconds = (double)fec.receiveTicks / frequency.QuadPart;
+    double encodeRate = encodeSeconds > 0 ? bytes / encodeSeconds : 0;
+    double receiveRate = receiveSeconds > 0 ? bytes / receiveSeconds : 0;
+    return QString("FEC benchmark, %1 packets of %2 bytes, %3% of datagrams dropped"
+                   " | No parity: %4 lost (%5%)"
+                   " | Groups of %6: %7 rebuilt, %8 lost (%9%), %10% more datagrams"
+                   " | Encoding %11 MB/s (%12 streams per core), receiving %13 MB/s (%14 streams per core)")
+            .arg(FEC_BENCH_PACKETS)
+            .arg(STREAM_PAYLOAD_SIZE)
+            .arg(lossPercent, 0, 'f', 1)
+            .arg((qint64)plain.stats.lost)
+            .arg(100.0 * plain.stats.lost / FEC_BENCH_PACKETS, 0, 'f', 2)
+            .arg(groupSize)
+            .arg((qint64)fec.stats.recovered)
+            .arg((qint64)fec.stats.lost)
+            .arg(100.0 * fec.stats.lost / FEC_BENCH_PACKETS, 0, 'f', 2)
+            .arg(100.0 * (fec.datagramsSent - plain.datagramsSent) / plain.datagramsSent, 0, 'f', 1)
+            .arg(encodeRate / 1000000, 0, 'f', 0)
+            .arg(encodeRate / streamRate, 0, 'f', 0)
+            .arg(receiveRate / 1000000, 0, 'f', 0)
+            .arg(receiveRate / streamRate, 0, 'f', 0);
+}
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	joinBenchmark
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	static QString joinBenchmark(int joins, int burstMs, int oneWayMs)
+--                                    joins - number of listeners joining, one after the other
+--                                    burstMs - how much recent audio each asks for in the second run
+--                                    oneWayMs - network delay from the server to the listener and back
+--
+-- RETURNS:     A one line summary of both runs
+--
+-- NOTES:
+--              Each listener joins a 44.1 kHz stereo stream at a random time and feeds what it would receive
+--              to a receiver with the default playout depth, until the receiver plays its first packet. That
+--              is the time to first audio that Client::getStreamStatistics reports. Without a burst the
+--              listener waits for the next repeated descriptor and then for a playout depth of live packets.
+--              With one, the descriptor and the burst StreamChannel::sendBurst would send come back a round
+--              trip after the join. Both runs use the same join times.
+--
+-------------------------------------------------------------------------------------------------------------------*/
+QString StreamReceiver::joinBenchmark(int joins, int burstMs, int oneWayMs) {
+    std::vector<double> live, burst;
+    uint32_t state = FEC_BENCH_SEED;
+    for (int join = 0; join < joins; join++) {
+        // A minute into the stream, anywhere within a second
+        double joinAt = 60000 + (double)nextRandom(state) / 4294967296.0 * 1000;
+        double withoutBurst = timeToFirstAudio(joinAt, 0, oneWayMs);
+        double withBurst = timeToFirstAudio(joinAt, burstMs, oneWayMs);
+        if (withoutBurst >= 0 && withBurst >= 0) {
+            live.push_back(withoutBurst);
+            burst.push_back(withBurst);
+        }
+    }
+    if (live.empty()) {
+        return QString("Join benchmark: no listener heard any audio");
+    }
+    return QString("Join benchmark, %1 joins, %2 ms each way"
+                   " | Live packets only: first audio after %3"
+                   " | With a %4 ms burst: first audio after %5")
+            .arg((qint64)live.size())
+            .arg(oneWayMs)
+            .arg(describeJoins(live))
+            .arg(burstMs)
+            .arg(describeJoins(burst));
+}
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	reset
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	void reset()
+--
+-- RETURNS:     void
+--
+-- NOTES:
+--              Drops every buffered packet. The next packet received starts a new sequence. The current format
+--              is kept.
+--
+-------------------------------------------------------------------------------------------------------------------*/
+void StreamReceiver::reset() {
+    started = false;
+    playing = false;
+    formatPending = false;
+    trackPending = false;
+    discontinuityKnown = false;
+    jumpPending = false;
+    for (int i = 0; i < RECEIVER_WINDOW; i++) {
+        window[i].present = false;
+    }
+    for (int i = 0; i < RECEIVER_PARITY_SLOTS; i++) {
+        parity[i].present = false;
+    }
+}
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	receive
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:   October 19, 2026 - Report gaps to the NackScheduler - agent
+--              October 19, 2026 - Handle discontinuity markers - agent
+--              October 19, 2026 - Record the transit of audio packets - agent
+--              October 19, 2026 - Resync on jumps too far for the window instead of releasing every packet
+--                                 in between - agent
+--              October 19, 2026 - Take older audio until the first packet plays - agent
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	bool receive(const char *datagram, int bytes, uint32_t now)
+--                           datagram - datagram read from the stream or repair socket
+--                           bytes - size of the datagram
+--                           now - current tick in milliseconds
+--
+-- RETURNS:     Returns true if the datagram was a new audio packet that made its deadline
+--
+-- NOTES:
+--              Stores audio and parity packets, attempts recovery for the packet's group, then plays every
+--              packet that has reached its deadline.
+--
+--              An audio packet RECEIVER_RESYNC_DISTANCE or more from the head of the window, either way, is not
+--              a loss or a late packet but a stray datagram or a server that restarted. It is dropped unless
+--              the packet before it was such a jump too and lands just behind it, in which case the receiver
+--              resyncs to it. So one stray cannot move the window, and a restart costs one packet.
+--
+--              Until the first packet is played an older packet moves the head of the window back to it instead
+--              of counting as late. A live descriptor can start the receiver a moment before the join burst
+--              arrives, and the burst should still fill the playout buffer.
+--
+-------------------------------------------------------------------------------------------------------------------*/
+bool StreamReceiver::receive(const char *datagram, int bytes, uint32_t now) {
+    StreamPacketHeader header;
+    bool stored = false;
+    if (!StreamPacket::readHeader(datagram, bytes, header)) {
+        return false;
+    }
+    const char *payload = datagram + STREAM_HEADER_SIZE;
+    receivedAt = now;
+
+    if (header.type == PACKET_AUDIO) {
+        if (!formatKnown) {
+            stats.unformatted++;
+            return false;
+        }
+        if (!started) {
+            started = true;
+            nextSequence = header.sequence;
+            highestSequence = header.sequence;
+        }
+        int32_t ahead = distance(nextSequence, header.sequence);
+        if (ahead <= -RECEIVER_RESYNC_DISTANCE || ahead >= RECEIVER_RESYNC_DISTANCE) {
+            if (!confirmJump(header.sequence)) {
+                return false;
+            }
+            resync(header.sequence);
+        } else if (ahead < 0 && !playing && distance(header.sequence, highestSequence) < RECEIVER_WINDOW) {
+            // Nothing has played yet, so older audio, such as a join burst behind the live stream, goes first
+            nextSequence = header.sequence;
+        } else if (ahead < 0) {
+            stats.late++;
+            return false;
+        }
+        jumpPending = false;
+        if (hasPacket(header.sequence)) {
+            stats.duplicates++;
+            return false;
+        }
+        // Too far ahead for the window: everything older has missed its deadline
+        while (distance(nextSequence, header.sequence) >= RECEIVER_WINDOW) {
+            releaseNext();
+        }
+        stats.received++;
+        stored = true;
+        uint32_t transit = LATENCY_UNKNOWN;
+        if (latency && latency->getTransit(header.timestamp, now, transit)) {
+            latency->record(LatencyMeter::TRANSIT, transit);
+        }
+        storePacket(header.sequence, payload, header.length, transit);
+        if (distance(highestSequence, header.sequence) > 0) {
+            uint32_t gap = highestSequence + 1;
+            if (distance(gap, nextSequence) > 0) {
+                gap = nextSequence;
+            }
+            for (; gap != header.sequence; gap++) {
+                if (nackScheduler && !hasPacket(gap)) {
+                    nackScheduler->onMissing(gap, now);
+                }
+            }
+            highestSequence = header.sequence;
+        }
+        if (header.groupSize > 1) {
+            tryRecover(header.sequence - (header.sequence % header.groupSize));
+        }
+    } else if (header.type == PACKET_PARITY) {
+        if (!started || header.groupSize < 2 || header.groupSize > MAX_FEC_GROUP_SIZE) {
+            return false;
+        }
+        if (distance(nextSequence, header.sequence + header.groupSize) <= 0
+                || distance(nextSequence, header.sequence) >= RECEIVER_WINDOW) {
+            return false;
+        }
+        storeParity(header, payload);
+        tryRecover(header.sequence);
+    } else if (header.type == PACKET_DESCRIPTOR) {
+        receiveDescriptor(header, payload);
+    } else if (header.type == PACKET_TRACK_CHANGE) {
+        receiveTrackChange(header, payload);
+    } else if (header.type == PACKET_DISCONTINUITY) {
+        receiveDiscontinuity(header, payload);
+    }
+    releaseReady();
+    return stored;
+}
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	receiveDescriptor
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	void receiveDescriptor(const StreamPacketHeader &header, const char *payload)
+--                                     header - header of the descriptor packet
+--                                     payload - serialized StreamDescriptor
+--
+-- RETURNS:     void
+--
+-- NOTES:
+--              The first descriptor is applied straight away. Later ones only matter if the format changed, and
+--              are held until the packet they apply to is played.
+--
+-------------------------------------------------------------------------------------------------------------------*/
+void StreamReceiver::receiveDescriptor(const StreamPacketHeader &header, const char *payload) {
+    StreamDescriptor descriptor;
+    if (!StreamPacket::readDescriptor(payload, header.length, descriptor)) {
+        return;
+    }
+    if (!formatKnown) {
+        format = descriptor;
+        formatKnown = true;
+        applyFormat(format);
+    } else if (!StreamPacket::sameFormat(format, descriptor)) {
+        if (!started || distance(nextSequence, header.sequence) <= 0) {
+            format = descriptor;
+            formatPending = false;
+            applyFormat(format);
+        } else if (!formatPending || !StreamPacket::sameFormat(pendingFormat, descriptor)) {
+            pendingFormat = descriptor;
+            pendingSequence = header.sequence;
+            formatPending = true;
+        }
+    }
+}
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	receiveTrackChange
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	void receiveTrackChange(const StreamPacketHeader &header, const char *payload)
+--                                      header - header of the track change packet
+--                                      payload - playlist index and title
+--
+-- RETURNS:     void
+--
+-- NOTES:
+--              Markers are repeated by the server, so one for the track that is already playing is ignored.
+--              A marker for a track that has already started (or for the first track heard) takes effect at
+--              once, one for a packet still to come waits until that packet is played.
+--
+-------------------------------------------------------------------------------------------------------------------*/
+void StreamReceiver::receiveTrackChange(const StreamPacketHeader &header, const char *payload) {
+    uint16_t index;
+    std::string title;
+    if (!StreamPacket::readTrackChange(payload, header.length, index, title)) {
+        return;
+    }
+    if (trackKnown && distance(trackSequence, header.sequence) <= 0) {
+        return;
+    }
+    if (!started || distance(nextSequence, header.sequence) <= 0) {
+        changeTrack(header.sequence, title);
+    } else if (!trackPending || pendingTrackSequence != header.sequence) {
+        pendingTrackSequence = header.sequence;
+        pendingTitle = title;
+        trackPending = true;
+    }
+}
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	changeTrack
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	void changeTrack(uint32_t sequence, const std::string &title)
+--                               sequence - packet the track started in
+--                               title - title of the track
+--
+-- RETURNS:     void
+--
+-------------------------------------------------------------------------------------------------------------------*/
+void StreamReceiver::changeTrack(uint32_t sequence, const std::string &title) {
+    trackKnown = true;
+    trackPending = false;
+    trackSequence = sequence;
+    if (onTrack) {
+        onTrack(title);
+    }
+}
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	receiveDiscontinuity
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	void receiveDiscontinuity(const StreamPacketHeader &header, const char *payload)
+--                                        header - header of the discontinuity packet
+--                                        payload - reason and position in the track
+--
+-- RETURNS:     void
+--
+-- NOTES:
+--              Markers are repeated by the server, so one that has already been handled is ignored. A seek
+--              made while paused gives a second marker at the same packet, which is handled. A marker that
+--              arrives after its packet was played is too late to help and is ignored as well. Otherwise
+--              the packets before the marker are dropped for a seek, or played out for a pause, and the
+--              discontinuity callback is called so the audio after the marker starts cleanly.
+--
+-------------------------------------------------------------------------------------------------------------------*/
+void StreamReceiver::receiveDiscontinuity(const StreamPacketHeader &header, const char *payload) {
+    DiscontinuityReason reason;
+    uint32_t positionMs;
+    if (!StreamPacket::readDiscontinuity(payload, header.length, reason, positionMs)) {
+        return;
+    }
+    int32_t ahead = distance(discontinuitySequence, header.sequence);
+    if (discontinuityKnown && (ahead < 0 || (ahead == 0 && discontinuityReason == reason))) {
+        return;
+    }
+    discontinuityKnown = true;
+    discontinuitySequence = header.sequence;
+    discontinuityReason = reason;
+    if (!started || distance(nextSequence, header.sequence) < 0) {
+        return;
+    }
+    stats.discontinuities++;
+    if (reason == DISCONTINUITY_SEEK || distance(nextSequence, header.sequence) > RECEIVER_WINDOW) {
+        skipTo(header.sequence);
+    } else {
+        while (nextSequence != header.sequence) {
+            releaseNext();
+        }
+    }
+    if (onDiscontinuity) {
+        onDiscontinuity(reason, positionMs);
+    }
+}
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	skipTo
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	void skipTo(uint32_t sequence)
+--                          sequence - packet to carry on from
+--
+-- RETURNS:     void
+--
+-- NOTES:
+--              Moves the head of the window to the sequence without playing anything in between or counting
+--              it as lost. Repairs still pending for the skipped packets are cancelled, and format and track
+--              changes that have been passed are applied, since the audio after the jump depends on them.
+--
+-------------------------------------------------------------------------------------------------------------------*/
+void StreamReceiver::skipTo(uint32_t sequence) {
+    for (int i = 0; i < RECEIVER_WINDOW && nextSequence != sequence; i++, nextSequence++) {
+        if (hasPacket(nextSequence)) {
+            stats.skipped++;
+        } else if (nackScheduler) {
+            nackScheduler->onDeadline(nextSequence);
+        }
+    }
+    nextSequence = sequence;
+    if (distance(highestSequence, nextSequence) > 0) {
+        highestSequence = nextSequence - 1;
+    }
+    applyPending();
+}
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	confirmJump
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	bool confirmJump(uint32_t sequence)
+--                               sequence - sequence number too far from the window
+--
+-- RETURNS:     Returns true if the last packet received was a jump that this one follows on from
+--
+-------------------------------------------------------------------------------------------------------------------*/
+bool StreamReceiver::confirmJump(uint32_t sequence) {
+    int32_t after = distance(jumpSequence, sequence);
+    if (jumpPending && after > 0 && after < RECEIVER_WINDOW) {
+        jumpPending = false;
+        return true;
+    }
+    jumpPending = true;
+    jumpSequence = sequence;
+    stats.strays++;
+    return false;
+}
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	resync
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	void resync(uint32_t sequence)
+--                          sequence - packet the stream carries on from
+--
+-- RETURNS:     void
+--
+-- NOTES:
+--              Drops what the window holds and every repair still pending, and restarts the window at the
+--              sequence in one step. Nothing in between is counted as lost. The format is kept.
+--
+-------------------------------------------------------------------------------------------------------------------*/
+void StreamReceiver::resync(uint32_t sequence) {
+    for (int i = 0; i < RECEIVER_WINDOW; i++) {
+        if (window[i].present && distance(nextSequence, window[i].sequence) >= 0) {
+            stats.skipped++;
+        }
+    }
+    if (nackScheduler) {
+        nackScheduler->reset();
+    }
+    reset();
+    started = true;
+    nextSequence = sequence;
+    highestSequence = sequence;
+    stats.resyncs++;
+}
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	hasPacket
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	bool hasPacket(uint32_t sequence)
+--                             sequence - sequence number to look up
+--
+-- RETURNS:     Returns true if the packet is held in the window, played or not
+--
+-------------------------------------------------------------------------------------------------------------------*/
+bool StreamReceiver::hasPacket(uint32_t sequence) const {
+    const Slot &slot = window[sequence % RECEIVER_WINDOW];
+    return slot.present && slot.sequence == sequence;
+}
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	storePacket
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:   October 19, 2026 - Remember when the packet arrived and how long it took - agent
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	void storePacket(uint32_t sequence, const char *payload, int length, uint32_t transitMs)
+--                               sequence - sequence number of the packet
+--                               payload - audio payload
+--                               length - number of payload bytes
+--                               transitMs - how long it took to arrive, or LATENCY_UNKNOWN
+--
+-- RETURNS:     void
+--
+-------------------------------------------------------------------------------------------------------------------*/
+void StreamReceiver::storePacket(uint32_t sequence, const char *payload, int length, uint32_t transitMs) {
+    Slot &slot = window[sequence % RECEIVER_WINDOW];
+    if (length > STREAM_PAYLOAD_SIZE) {
+        length = STREAM_PAYLOAD_SIZE;
+    }
+    slot.sequence = sequence;
+    slot.present = true;
+    slot.length = length;
+    slot.arrivedAt = receivedAt;
+    slot.transitMs = transitMs;
+    memcpy(slot.payload, payload, length);
+    if (nackScheduler) {
+        nackScheduler->onReceived(sequence);
+    }
+}
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	storeParity
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	void storeParity(const StreamPacketHeader &header, const char *payload)
+--                               header - header of the parity packet
+--                               payload - XOR of the group's payloads
+--
+-- RETURNS:     void
+--
+-------------------------------------------------------------------------------------------------------------------*/
+void StreamReceiver::storeParity(const StreamPacketHeader &header, const char *payload) {
+    ParitySlot &slot = parity[(header.sequence / header.groupSize) % RECEIVER_PARITY_SLOTS];
+    int length = header.length > STREAM_PAYLOAD_SIZE ? STREAM_PAYLOAD_SIZE : header.length;
+    slot.groupStart = header.sequence;
+    slot.present = true;
+    slot.groupSize = header.groupSize;
+    slot.length = length;
+    slot.parityLength = header.parityLength;
+    memcpy(slot.payload, payload, length);
+}
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	tryRecover
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:   October 19, 2026 - Time the wait of rebuilt packets from their rebuilding - agent
+--              October 19, 2026 - Only rebuild packets that fit in the window - agent
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	void tryRecover(uint32_t groupStart)
+--                              groupStart - first sequence number of the FEC group
+--
+-- RETURNS:     void
+--
+-- NOTES:
+--              Rebuilds the group's missing packet when the parity is present, exactly one packet is missing and
+--              that packet has not passed its deadline yet. A packet a window or more ahead of the head would
+--              land on a slot still in use, so it is left for its own arrival or a repair.
+--
+-------------------------------------------------------------------------------------------------------------------*/
+void StreamReceiver::tryRecover(uint32_t groupStart) {
+    for (int i = 0; i < RECEIVER_PARITY_SLOTS; i++) {
+        ParitySlot &group = parity[i];
+        if (!group.present || group.groupStart != groupStart) {
+            continue;
+        }
+        int missingCount = 0;
+        uint32_t missing = 0;
+        for (int j = 0; j < group.groupSize; j++) {
+            if (!hasPacket(groupStart + j)) {
+                missing = groupStart + j;
+                missingCount++;
+            }
+        }
+        int32_t ahead = distance(nextSequence, missing);
+        if (missingCount == 1 && ahead >= 0 && ahead < RECEIVER_WINDOW) {
+            Slot &slot = window[missing % RECEIVER_WINDOW];
+            uint16_t length = group.parityLength;
+            memcpy(slot.payload, group.payload, group.length);
+            for (int j = 0; j < group.groupSize; j++) {
+                uint32_t sequence = groupStart + j;
+                if (sequence != missing) {
+                    const Slot &other = window[sequence % RECEIVER_WINDOW];
+                    FecEncoder::xorInto(slot.payload, other.payload, other.length);
+                    length ^= (uint16_t)other.length;
+                }
+            }
+            slot.sequence = missing;
+            slot.present = true;
+            slot.arrivedAt = receivedAt;
+            slot.transitMs = LATENCY_UNKNOWN;
+            slot.length = length > group.length ? group.length : length;
+            stats.recovered++;
+            if (nackScheduler) {
+                nackScheduler->onReceived(missing);
+            }
+        }
+        if (missingCount <= 1) {
+            group.present = false;
+        }
+        return;
+    }
+}
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	releaseNext
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:   October 19, 2026 - Apply pending track changes - agent
+--              October 19, 2026 - Call the loss callback for lost packets - agent
+--              October 19, 2026 - Apply pending changes through applyPending - agent
+--              October 19, 2026 - Record the packet's wait in the window - agent
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	void releaseNext()
+--
+-- RETURNS:     void
+--
+-- NOTES:
+--              Plays the packet at the head of the window, or counts it as lost and calls the loss callback if
+--              it never arrived. A pending format or track change that starts at this packet is applied first.
+--              A packet rebuilt from parity has no transit of its own, so only its wait is known.
+--
+-------------------------------------------------------------------------------------------------------------------*/
+void StreamReceiver::releaseNext() {
+    applyPending();
+    playing = true;
+    if (hasPacket(nextSequence)) {
+        const Slot &slot = window[nextSequence % RECEIVER_WINDOW];
+        uint32_t waited = receivedAt - slot.arrivedAt;
+        if (latency) {
+            latency->record(LatencyMeter::JITTER_BUFFER, waited);
+        }
+        playingDelayMs = slot.transitMs == LATENCY_UNKNOWN ? LATENCY_UNKNOWN : slot.transitMs + waited;
+        play(slot.payload, slot.length);
+        playingDelayMs = LATENCY_UNKNOWN;
+    } else {
+        stats.lost++;
+        if (nackScheduler) {
+            nackScheduler->onDeadline(nextSequence);
+        }
+        if (onLoss && formatKnown) {
+            onLoss();
+        }
+    }
+    nextSequence++;
+}
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	applyPending
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	void applyPending()
+--
+-- RETURNS:     void
+--
+-- NOTES:
+--              Applies a pending format or track change that starts at or before the head of the window.
+--
+-------------------------------------------------------------------------------------------------------------------*/
+void StreamReceiver::applyPending() {
+    if (formatPending && distance(pendingSequence, nextSequence) >= 0) {
+        format = pendingFormat;
+        formatPending = false;
+        applyFormat(format);
+    }
+    if (trackPending && distance(pendingTrackSequence, nextSequence) >= 0) {
+        changeTrack(pendingTrackSequence, pendingTitle);
+    }
+}
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	releaseReady
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	void releaseReady()
+--
+-- RETURNS:     void
+--
+-- NOTES:
+--              Releases every packet that is at least playoutDepth packets behind the newest one.
+--
+-------------------------------------------------------------------------------------------------------------------*/
+void StreamReceiver::releaseReady() {
+    while (distance(nextSequence, highestSequence) >= playoutDepth) {
+        releaseNext();
+    }
+}
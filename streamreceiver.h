@@ -0,0 +1,143 @@
+#pragma once
+#include <windows.h>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <QDebug>
+#include <QString>
+#include "streampacket.h"
+#include "fec.h"
+#include "nackscheduler.h"
+#include "latencymeter.h"
+
+#define RECEIVER_WINDOW 64
+#define RECEIVER_PARITY_SLOTS 16
+#define DEFAULT_PLAYOUT_DEPTH 6
+#define RECEIVER_RESYNC_DISTANCE (2 * RECEIVER_WINDOW)
+#define FEC_BENCH_PACKETS 100000
+#define FEC_BENCH_LOSS_PERCENT 2.0
+#define FEC_BENCH_PACKET_MS 20
+#define FEC_BENCH_SEED 0x2545F491
+#define JOIN_BENCH_JOINS 1000
+#define JOIN_BENCH_BURST_MS 300
+#define JOIN_BENCH_ONE_WAY_MS 5
+#define JOIN_BENCH_MAX_PACKETS 200
+
+class StreamReceiver {
+public:
+    typedef std::function<void(const char *data, int length)> PlayCallback;
+    typedef std::function<void(const StreamDescriptor &format)> FormatCallback;
+    typedef std::function<void(const std::string &title)> TrackCallback;
+    typedef std::function<void()> LossCallback;
+    typedef std::function<void(DiscontinuityReason reason, uint32_t positionMs)> DiscontinuityCallback;
+
+    struct Statistics {
+        uint32_t received = 0;
+        uint32_t recovered = 0;
+        uint32_t lost = 0;
+        uint32_t late = 0;
+        uint32_t duplicates = 0;
+        uint32_t unformatted = 0;
+        uint32_t discontinuities = 0;
+        uint32_t skipped = 0;
+        uint32_t strays = 0;
+        uint32_t resyncs = 0;
+    };
+
+    StreamReceiver(int playoutDepth, PlayCallback play, FormatCallback applyFormat);
+    static int runFromArguments(int argc, char *argv[]);
+    static QString benchmark(double lossPercent, int groupSize);
+    static QString joinBenchmark(int joins, int burstMs, int oneWayMs);
+    bool receive(const char *datagram, int bytes, uint32_t now);
+    void reset();
+    void setNackScheduler(NackScheduler *scheduler) {
+        nackScheduler = scheduler;
+    }
+    void setLatencyMeter(LatencyMeter *meter) {
+        latency = meter;
+    }
+    void setTrackCallback(TrackCallback callback) {
+        onTrack = callback;
+    }
+    void setLossCallback(LossCallback callback) {
+        onLoss = callback;
+    }
+    void setDiscontinuityCallback(DiscontinuityCallback callback) {
+        onDiscontinuity = callback;
+    }
+    const Statistics &getStatistics() const {
+        return stats;
+    }
+    uint32_t getPlayingDelay() const {
+        return playingDelayMs;
+    }
+
+private:
+    struct Slot {
+        uint32_t sequence;
+        bool present;
+        int length;
+        uint32_t arrivedAt;
+        uint32_t transitMs;
+        char payload[STREAM_PAYLOAD_SIZE];
+    };
+    struct ParitySlot {
+        uint32_t groupStart;
+        bool present;
+        int groupSize;
+        int length;
+        uint16_t parityLength;
+        char payload[STREAM_PAYLOAD_SIZE];
+    };
+
+    int playoutDepth;
+    PlayCallback play;
+    FormatCallback applyFormat;
+    TrackCallback onTrack;
+    LossCallback onLoss;
+    DiscontinuityCallback onDiscontinuity;
+    NackScheduler *nackScheduler = nullptr;
+    LatencyMeter *latency = nullptr;
+    uint32_t receivedAt = 0;
+    uint32_t playingDelayMs = LATENCY_UNKNOWN;
+    bool started = false;
+    bool playing = false;
+    bool formatKnown = false;
+    bool formatPending = false;
+    uint32_t pendingSequence = 0;
+    StreamDescriptor format;
+    StreamDescriptor pendingFormat;
+    bool trackKnown = false;
+    bool trackPending = false;
+    uint32_t trackSequence = 0;
+    uint32_t pendingTrackSequence = 0;
+    std::string pendingTitle;
+    bool discontinuityKnown = false;
+    uint32_t discontinuitySequence = 0;
+    DiscontinuityReason discontinuityReason = DISCONTINUITY_SEEK;
+    uint32_t nextSequence = 0;
+    uint32_t highestSequence = 0;
+    bool jumpPending = false;
+    uint32_t jumpSequence = 0;
+    Statistics stats;
+    Slot window[RECEIVER_WINDOW];
+    ParitySlot parity[RECEIVER_PARITY_SLOTS];
+
+    static int32_t distance(uint32_t from, uint32_t to) {
+        return (int32_t)(to - from);
+    }
+    bool hasPacket(uint32_t sequence) const;
+    void storePacket(uint32_t sequence, const char *payload, int length, uint32_t transitMs);
+    void storeParity(const StreamPacketHeader &header, const char *payload);
+    void receiveDescriptor(const StreamPacketHeader &header, const char *payload);
+    void receiveTrackChange(const StreamPacketHeader &header, const char *payload);
+    void changeTrack(uint32_t sequence, const std::string &title);
+    void receiveDiscontinuity(const StreamPacketHeader &header, const char *payload);
+    void skipTo(uint32_t sequence);
+    bool confirmJump(uint32_t sequence);
+    void resync(uint32_t sequence);
+    void applyPending();
+    void tryRecover(uint32_t groupStart);
+    void releaseNext();
+    void releaseReady();
+};
@@ -0,0 +1,969 @@
+/*------------------------------------------------------------------------------------------------------------------
+-- SOURCE FILE: 	streamrelay.cpp - Carries a multicast stream to a remote site over one unicast link.
+--
+--
+-- PROGRAM: 		Communication Audio Program
+--
+-- FUNCTIONS:
+--                  StreamRelay(Link link)
+--                  ~StreamRelay()
+--                  static int runFromArguments(int argc, char *argv[])
+--                  bool openUplink(const std::string &group, int port, const std::string &remoteHost, int remotePort)
+--                  bool openDownlink(int listenPort, const std::string &group, int port, int ttl)
+--                  void run()
+--                  void stop()
+--                  QString getStatistics() const
+--                  static bool resolve(const std::string &host, int port, SOCKADDR_IN &address)
+--                  bool openEvent(SOCKET sock, WSAEVENT &event, long events)
+--                  bool connectLink()
+--                  void closeLink()
+--                  void forwardStream()
+--                  bool sendLink(const char *datagram, int bytes)
+--                  void acceptLink()
+--                  void readLink()
+--                  void relayDatagram(int bytes)
+--                  void serviceRepairs()
+--                  void sendBurst(const SOCKADDR_IN &listener, uint16_t burstMs)
+--
+-- DATE: 			October 19, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: 		agent
+--
+-- PROGRAMMER: 		agent
+--
+-- NOTES:
+--      A relay runs as a pair. The uplink sits on the server's network, joins the multicast group like any
+--      listener and forwards every stream datagram, unchanged, over one UDP or TCP link to the downlink at the
+--      remote site. The downlink multicasts what it receives to the local group, so listeners there see the
+--      same packets, sequence numbers and FEC they would see next to the server.
+--
+--      Nothing is held back for batching. Each datagram is forwarded as soon as it is read, straight out of
+--      the buffer it was read into. Over TCP each datagram gets a two byte length prefix, and the prefix and
+--      the datagram go out in one gathered send. The downlink reads each datagram into a packet from its own
+--      pool, multicasts it from there and keeps that same packet as its retransmission history.
+--
+--      Listeners at the remote site send their NACKs and join requests to the downlink's repair port, the
+--      same port offset the server uses, and are served from the downlink's history. Loss on the link itself
+--      is not asked for again upstream; the FEC parity carried with the stream covers it.
+--
+--      The relay has no window. It is started from the command line with --relay-uplink or --relay-downlink
+--      and reports its counters to the debug output every few seconds.
+--------------------------------------------------------------------------------------------------------------------*/
+#include "streamrelay.h"
+#include <cstring>
+#include <cstdlib>
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	StreamRelay
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	StreamRelay(Link link)
+--                          link - whether datagrams cross to the other site over UDP or TCP
+--
+-- RETURNS:     void
+--
+-- NOTES:
+--              Nothing is opened until openUplink or openDownlink is called.
+--
+-------------------------------------------------------------------------------------------------------------------*/
+StreamRelay::StreamRelay(Link link)
+    : link(link) {
+    memset(&linkAddress, 0, sizeof(linkAddress));
+    memset(&destination, 0, sizeof(destination));
+}
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	~StreamRelay
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	~StreamRelay()
+--
+-- RETURNS:     void
+--
+-- NOTES:
+--              Closes every socket and event the relay opened and frees its packet history.
+--
+-------------------------------------------------------------------------------------------------------------------*/
+StreamRelay::~StreamRelay() {
+    SOCKET sockets[] = { streamSocket, linkSocket, listenSocket, repairSocket };
+    for (SOCKET sock : sockets) {
+        if (sock != INVALID_SOCKET) {
+            closesocket(sock);
+        }
+    }
+    WSAEVENT events[] = { streamEvent, linkEvent, repairEvent, stopEvent };
+    for (WSAEVENT event : events) {
+        if (event != WSA_INVALID_EVENT) {
+            WSACloseEvent(event);
+        }
+    }
+    delete retransmitBuffer;
+    delete pool;
+}
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	runFromArguments
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	static int runFromArguments(int argc, char *argv[])
+--                          argc - number of command line arguments
+--                          argv - the command line arguments
+--
+-- RETURNS:     The process exit code
+--
+-- NOTES:
+--              The two forms are
+--                  --relay-uplink <group> <port> <remote host> <remote port> [tcp]
+--                  --relay-downlink <listen port> <group> <port> [ttl] [tcp]
+--              The relay then runs on the calling thread until the process is ended.
+--
+-------------------------------------------------------------------------------------------------------------------*/
+int StreamRelay::runFromArguments(int argc, char *argv[]) {
+    WSADATA wsaData;
+    bool uplink = argc >= 6 && strcmp(argv[1], "--relay-uplink") == 0;
+    bool downlink = argc >= 5 && strcmp(argv[1], "--relay-downlink") == 0;
+    if (!uplink && !downlink) {
+        qDebug() << "Usage: --relay-uplink <group> <port> <remote host> <remote port> [tcp]\n"
+                 << "       --relay-downlink <listen port> <group> <port> [ttl] [tcp]\n";
+        return 1;
+    }
+    Link link = strcmp(argv[argc - 1], "tcp") == 0 ? LINK_TCP : LINK_UDP;
+    if (WSAStartup(0x0202, &wsaData) != 0) {
+        qDebug() << "WSAStartup failed with error \n" << WSAGetLastError();
+        return 1;
+    }
+
+    StreamRelay relay(link);
+    bool opened;
+    if (uplink) {
+        opened = relay.openUplink(argv[2], atoi(argv[3]), argv[4], atoi(argv[5]));
+    } else {
+        int ttl = argc >= 6 && strcmp(argv[5], "tcp") != 0 ? atoi(argv[5]) : RELAY_DEFAULT_TTL;
+        opened = relay.openDownlink(atoi(argv[2]), argv[3], atoi(argv[4]), ttl);
+    }
+    if (opened) {
+        relay.run();
+    }
+    WSACleanup();
+    return opened ? 0 : 1;
+}
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	openUplink
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	bool openUplink(const std::string &group, int port, const std::string &remoteHost, int remotePort)
+--                          group - multicast group the server streams to
+--                          port - port the server streams to
+--                          remoteHost - address of the downlink relay
+--                          remotePort - port the downlink relay listens on
+--
+-- RETURNS:     True if the group was joined
+--
+-- NOTES:
+--              A TCP link that cannot be connected yet is retried while the stream is running, so the two
+--              ends can be started in either order.
+--
+-------------------------------------------------------------------------------------------------------------------*/
+bool StreamRelay::openUplink(const std::string &group, int port, const std::string &remoteHost, int remotePort) {
+    uplink = true;
+    if (!resolve(remoteHost, remotePort, linkAddress)) {
+        return false;
+    }
+    if ((streamSocket = ConnectionDevice::openMulticastReceiver(group.c_str(), port)) == INVALID_SOCKET) {
+        return false;
+    }
+    if (!openEvent(streamSocket, streamEvent, FD_READ) || (stopEvent = WSACreateEvent()) == WSA_INVALID_EVENT) {
+        return false;
+    }
+    connectLink();
+    return true;
+}
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	openDownlink
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	bool openDownlink(int listenPort, const std::string &group, int port, int ttl)
+--                          listenPort - port the uplink relay sends to
+--                          group - multicast group to stream to at this site
+--                          port - port to stream to at this site
+--                          ttl - multicast time to live at this site
+--
+-- RETURNS:     True if every socket was opened
+--
+-- NOTES:
+--              The repair port is port + STREAM_REPAIR_PORT_OFFSET, as it is on the server, so listeners at
+--              this site need no other settings.
+--
+-------------------------------------------------------------------------------------------------------------------*/
+bool StreamRelay::openDownlink(int listenPort, const std::string &group, int port, int ttl) {
+    SOCKADDR_IN address;
+    uplink = false;
+    if (!resolve(group, port, destination)) {
+        return false;
+    }
+    if ((streamSocket = socket(AF_INET, SOCK_DGRAM, 0)) == INVALID_SOCKET ||
+            (repairSocket = socket(AF_INET, SOCK_DGRAM, 0)) == INVALID_SOCKET) {
+        qDebug() << "Failed to get a socket \n" << WSAGetLastError();
+        return false;
+    }
+    if (setsockopt(streamSocket, IPPROTO_IP, IP_MULTICAST_TTL, (char *)&ttl, sizeof(ttl)) == SOCKET_ERROR) {
+        qDebug() << "Failed to setsockopt to set ttl \n" << WSAGetLastError();
+    }
+    bool fFlag = FALSE;
+    if (setsockopt(streamSocket, IPPROTO_IP, IP_MULTICAST_LOOP, (char *)&fFlag, sizeof(fFlag)) == SOCKET_ERROR) {
+        qDebug() << "Failed to setsockopt to disable loopback \n" << WSAGetLastError();
+    }
+
+    memset(&address, 0, sizeof(address));
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_ANY);
+    address.sin_port = htons((u_short)(port + STREAM_REPAIR_PORT_OFFSET));
+    if (bind(repairSocket, (PSOCKADDR) &address, sizeof(address)) == SOCKET_ERROR) {
+        qDebug() << "repair bind() failed with error \n" << WSAGetLastError();
+        return false;
+    }
+
+    SOCKET linkListener = socket(AF_INET, link == LINK_TCP ? SOCK_STREAM : SOCK_DGRAM, 0);
+    if (linkListener == INVALID_SOCKET) {
+        qDebug() << "Failed to get a link socket \n" << WSAGetLastError();
+        return false;
+    }
+    address.sin_port = htons((u_short)listenPort);
+    if (bind(linkListener, (PSOCKADDR) &address, sizeof(address)) == SOCKET_ERROR) {
+        qDebug() << "link bind() failed with error \n" << WSAGetLastError();
+        closesocket(linkListener);
+        return false;
+    }
+    if (link == LINK_TCP) {
+        listenSocket = linkListener;
+        if (listen(listenSocket, 1) == SOCKET_ERROR) {
+            qDebug() << "listen() failed with error \n" << WSAGetLastError();
+            return false;
+        }
+        if (!openEvent(listenSocket, linkEvent, FD_ACCEPT)) {
+            return false;
+        }
+    } else {
+        linkSocket = linkListener;
+        if (!openEvent(linkSocket, linkEvent, FD_READ)) {
+            return false;
+        }
+    }
+    if (!openEvent(repairSocket, repairEvent, FD_READ) || (stopEvent = WSACreateEvent()) == WSA_INVALID_EVENT) {
+        return false;
+    }
+
+    pool = new PacketPool(RELAY_POOL_PACKETS);
+    retransmitBuffer = new RetransmitBuffer(pool);
+    spare = pool->acquire(nullptr, 0);
+    return true;
+}
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	run
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	void run()
+--
+-- RETURNS:     void
+--
+-- NOTES:
+--              Waits on the relay's sockets and drains whichever are readable until stop() is called. All of
+--              the sockets are drained on every wake, each until it would block, so one busy socket cannot keep
+--              another waiting behind it.
+--
+-------------------------------------------------------------------------------------------------------------------*/
+void StreamRelay::run() {
+    WSAEVENT events[3];
+    DWORD reportedAt = GetTickCount();
+    running = true;
+    while (running) {
+        DWORD count = 0;
+        events[count++] = stopEvent;
+        if (uplink) {
+            events[count++] = streamEvent;
+        } else {
+            events[count++] = linkEvent;
+            events[count++] = repairEvent;
+        }
+        if (WSAWaitForMultipleEvents(count, events, FALSE, RELAY_REPORT_MS, FALSE) == WSA_WAIT_FAILED) {
+            qDebug() << "WSAWaitForMultipleEvents failed with error \n" << WSAGetLastError();
+            break;
+        }
+
+        if (uplink) {
+            WSAResetEvent(streamEvent);
+            forwardStream();
+        } else {
+            WSAResetEvent(linkEvent);
+            if (listenSocket != INVALID_SOCKET && linkSocket == INVALID_SOCKET) {
+                acceptLink();
+            }
+            readLink();
+            serviceRepairs();
+        }
+
+        if (GetTickCount() - reportedAt >= RELAY_REPORT_MS) {
+            qDebug() << getStatistics();
+            reportedAt = GetTickCount();
+        }
+    }
+}
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	stop
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	void stop()
+--
+-- RETURNS:     void
+--
+-- NOTES:
+--              May be called from another thread. run() returns once it wakes.
+--
+-------------------------------------------------------------------------------------------------------------------*/
+void StreamRelay::stop() {
+    running = false;
+    if (stopEvent != WSA_INVALID_EVENT) {
+        WSASetEvent(stopEvent);
+    }
+}
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	getStatistics
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	QString getStatistics() const
+--
+-- RETURNS:     One line describing the relay's counters
+--
+-- NOTES:
+--              The repair and join counters only move on the downlink.
+--
+-------------------------------------------------------------------------------------------------------------------*/
+QString StreamRelay::getStatistics() const {
+    return QString("Relay %1 over %2: %3 received, %4 forwarded (%5 KB), %6 malformed, %7 lost on the link"
+                   " | Repair: %8 NACKs for %9 packets, %10 unicast, %11 multicast, %12 suppressed, %13 too old"
+                   " | Joins: %14 with %15 packets")
+            .arg(uplink ? "uplink" : "downlink")
+            .arg(link == LINK_TCP ? "TCP" : "UDP")
+            .arg(stats.received)
+            .arg(stats.forwarded)
+            .arg((qulonglong)(stats.bytes / 1024))
+            .arg(stats.malformed)
+            .arg(stats.linkDrops)
+            .arg(repairStats.nacksReceived)
+            .arg(repairStats.sequencesRequested)
+            .arg(repairStats.repairsUnicast)
+            .arg(repairStats.repairsMulticast)
+            .arg(repairStats.repairsSuppressed)
+            .arg(repairStats.repairsUnavailable)
+            .arg(stats.joins)
+            .arg(stats.burstPackets);
+}
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	resolve
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	static bool resolve(const std::string &host, int port, SOCKADDR_IN &address)
+--                          host - dotted address or host name
+--                          port - port to fill in
+--                          address - filled in with the host and port
+--
+-- RETURNS:     True if the host was found
+--
+-------------------------------------------------------------------------------------------------------------------*/
+bool StreamRelay::resolve(const std::string &host, int port, SOCKADDR_IN &address) {
+    struct hostent *hp;
+    if ((hp = gethostbyname(host.c_str())) == NULL) {
+        qDebug() << "Unknown relay address\n" << host.c_str();
+        return false;
+    }
+    memset(&address, 0, sizeof(address));
+    address.sin_family = AF_INET;
+    address.sin_port = htons((u_short)port);
+    memcpy((char *)&address.sin_addr, hp->h_addr, hp->h_length);
+    return true;
+}
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	openEvent
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	bool openEvent(SOCKET sock, WSAEVENT &event, long events)
+--                          sock - socket to watch
+--                          event - created if it does not exist yet, then signalled for the socket
+--                          events - network events to signal on
+--
+-- RETURNS:     True if the event was attached to the socket
+--
+-- NOTES:
+--              Attaching an event also makes the socket nonblocking, which the drain loops rely on.
+--
+-------------------------------------------------------------------------------------------------------------------*/
+bool StreamRelay::openEvent(SOCKET sock, WSAEVENT &event, long events) {
+    if (event == WSA_INVALID_EVENT && (event = WSACreateEvent()) == WSA_INVALID_EVENT) {
+        qDebug() << "WSACreateEvent() failed with error \n" << WSAGetLastError();
+        return false;
+    }
+    if (WSAEventSelect(sock, event, events) == SOCKET_ERROR) {
+        qDebug() << "WSAEventSelect for the relay failed: " << WSAGetLastError();
+        return false;
+    }
+    return true;
+}
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	connectLink
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	bool connectLink()
+--
+-- RETURNS:     True if the uplink can send to the downlink
+--
+-- NOTES:
+--              A UDP link is a connected datagram socket, so each forward is a plain send with no address.
+--              A TCP link turns off Nagle's algorithm so a datagram is never held back waiting for the next.
+--
+-------------------------------------------------------------------------------------------------------------------*/
+bool StreamRelay::connectLink() {
+    if ((linkSocket = socket(AF_INET, link == LINK_TCP ? SOCK_STREAM : SOCK_DGRAM, 0)) == INVALID_SOCKET) {
+        qDebug() << "Failed to get a link socket \n" << WSAGetLastError();
+        linkLostAt = GetTickCount();
+        return false;
+    }
+    if (link == LINK_TCP) {
+        BOOL noDelay = TRUE;
+        if (setsockopt(linkSocket, IPPROTO_TCP, TCP_NODELAY, (char *)&noDelay, sizeof(noDelay)) == SOCKET_ERROR) {
+            qDebug() << "Failed to setsockopt to disable Nagle \n" << WSAGetLastError();
+        }
+    }
+    if (connect(linkSocket, (struct sockaddr *)&linkAddress, sizeof(linkAddress)) == SOCKET_ERROR) {
+        qDebug() << "Relay connect() failed with error \n" << WSAGetLastError();
+        closeLink();
+        return false;
+    }
+    return true;
+}
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	closeLink
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	void closeLink()
+--
+-- RETURNS:     void
+--
+-- NOTES:
+--              The uplink reconnects after RELAY_RECONNECT_MS. The downlink goes back to waiting for the
+--              uplink to connect, and drops any datagram it was part way through reading.
+--
+-------------------------------------------------------------------------------------------------------------------*/
+void StreamRelay::closeLink() {
+    if (linkSocket != INVALID_SOCKET) {
+        closesocket(linkSocket);
+        linkSocket = INVALID_SOCKET;
+    }
+    linkLostAt = GetTickCount();
+    frameRead = 0;
+    frameLength = 0;
+}
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	forwardStream
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	void forwardStream()
+--
+-- RETURNS:     void
+--
+-- NOTES:
+--              Reads every datagram waiting on the group and forwards each one as soon as it is read, from the
+--              buffer it was read into. Datagrams without a stream header are not forwarded.
+--
+-------------------------------------------------------------------------------------------------------------------*/
+void StreamRelay::forwardStream() {
+    StreamPacketHeader header;
+    while (true) {
+        int bytes = recvfrom(streamSocket, buffer, sizeof(buffer), 0, NULL, NULL);
+        if (bytes == SOCKET_ERROR) {
+            if (WSAGetLastError() == WSAECONNRESET || WSAGetLastError() == WSAEMSGSIZE) {
+                continue;
+            }
+            if (WSAGetLastError() != WSAEWOULDBLOCK) {
+                qDebug() << "relay recvfrom() failed with error \n" << WSAGetLastError();
+            }
+            return;
+        }
+        if (!StreamPacket::readHeader(buffer, bytes, header)) {
+            stats.malformed++;
+            continue;
+        }
+        stats.received++;
+        if (sendLink(buffer, bytes)) {
+            stats.forwarded++;
+            stats.bytes += bytes;
+        } else {
+            stats.linkDrops++;
+        }
+    }
+}
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	sendLink
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	bool sendLink(const char *datagram, int bytes)
+--                          datagram - stream datagram to forward
+--                          bytes - size of the datagram
+--
+-- RETURNS:     True if the datagram was handed to the link
+--
+-- NOTES:
+--              Over TCP the length prefix and the datagram are two buffers of one WSASend, so the datagram is
+--              not copied to put the prefix in front of it. While the link is down datagrams are dropped.
+--
+-------------------------------------------------------------------------------------------------------------------*/
+bool StreamRelay::sendLink(const char *datagram, int bytes) {
+    if (linkSocket == INVALID_SOCKET &&
+            (GetTickCount() - linkLostAt < RELAY_RECONNECT_MS || !connectLink())) {
+        return false;
+    }
+    if (link == LINK_UDP) {
+        // The downlink not running yet shows up as a refused send, which is only a drop
+        return send(linkSocket, datagram, bytes, 0) == bytes;
+    }
+
+    char length[RELAY_FRAME_HEADER] = { (char)(bytes >> 8), (char)(bytes & 0xFF) };
+    WSABUF buffers[2];
+    DWORD sent;
+    buffers[0].buf = length;
+    buffers[0].len = RELAY_FRAME_HEADER;
+    buffers[1].buf = (CHAR *)datagram;
+    buffers[1].len = bytes;
+    if (WSASend(linkSocket, buffers, 2, &sent, 0, NULL, NULL) == SOCKET_ERROR) {
+        qDebug() << "Relay WSASend() failed with error \n" << WSAGetLastError();
+        closeLink();
+        return false;
+    }
+    return true;
+}
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	acceptLink
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	void acceptLink()
+--
+-- RETURNS:     void
+--
+-- NOTES:
+--              Takes the uplink's TCP connection. Only one uplink is served at a time; another one is
+--              accepted after the current one closes.
+--
+-------------------------------------------------------------------------------------------------------------------*/
+void StreamRelay::acceptLink() {
+    SOCKET accepted = accept(listenSocket, NULL, NULL);
+    if (accepted == INVALID_SOCKET) {
+        if (WSAGetLastError() != WSAEWOULDBLOCK) {
+            qDebug() << "Relay accept() failed with error \n" << WSAGetLastError();
+        }
+        return;
+    }
+    // The accepted socket shares the link event, now for reads and the uplink closing
+    if (WSAEventSelect(accepted, linkEvent, FD_READ | FD_CLOSE) == SOCKET_ERROR) {
+        qDebug() << "WSAEventSelect for the relay failed: " << WSAGetLastError();
+        closesocket(accepted);
+        return;
+    }
+    linkSocket = accepted;
+    frameRead = 0;
+}
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	readLink
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	void readLink()
+--
+-- RETURNS:     void
+--
+-- NOTES:
+--              Reads every datagram the uplink has sent straight into the spare pool packet. Over TCP the
+--              length prefix is read first and then exactly that many bytes, so a datagram split across reads
+--              is put back together in place.
+--
+-------------------------------------------------------------------------------------------------------------------*/
+void StreamRelay::readLink() {
+    while (linkSocket != INVALID_SOCKET) {
+        int bytes;
+        if (link == LINK_UDP) {
+            if ((bytes = recvfrom(linkSocket, spare->datagram, DATA_BUFSIZE, 0, NULL, NULL)) != SOCKET_ERROR) {
+                relayDatagram(bytes);
+                continue;
+            }
+        } else if (frameRead < RELAY_FRAME_HEADER) {
+            bytes = recv(linkSocket, frameHeader + frameRead, RELAY_FRAME_HEADER - frameRead, 0);
+        } else {
+            int read = frameRead - RELAY_FRAME_HEADER;
+            bytes = recv(linkSocket, spare->datagram + read, frameLength - read, 0);
+        }
+
+        if (bytes == SOCKET_ERROR) {
+            if (link == LINK_UDP && (WSAGetLastError() == WSAECONNRESET || WSAGetLastError() == WSAEMSGSIZE)) {
+                continue;
+            }
+            if (WSAGetLastError() != WSAEWOULDBLOCK) {
+                qDebug() << "Relay link read failed with error \n" << WSAGetLastError();
+                closeLink();
+            }
+            return;
+        }
+        if (bytes == 0) {
+            qDebug() << "Relay uplink closed the connection\n";
+            closeLink();
+            return;
+        }
+
+        frameRead += bytes;
+        if (frameRead == RELAY_FRAME_HEADER) {
+            frameLength = ((uint8_t)frameHeader[0] << 8) | (uint8_t)frameHeader[1];
+            if (frameLength == 0 || frameLength > DATA_BUFSIZE) {
+                qDebug() << "Relay link sent a bad frame length \n" << frameLength;
+                closeLink();
+                return;
+            }
+        } else if (frameRead == RELAY_FRAME_HEADER + frameLength) {
+            relayDatagram(frameLength);
+            frameRead = 0;
+        }
+    }
+}
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	relayDatagram
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	void relayDatagram(int bytes)
+--                          bytes - size of the datagram read into the spare packet
+--
+-- RETURNS:     void
+--
+-- NOTES:
+--              Multicasts the spare packet to the local group. Audio packets are then kept as they are in the
+--              retransmission history and a new spare is taken from the pool. The latest descriptor and track
+--              change marker are kept aside for join bursts, as they only arrive every few packets.
+--
+-------------------------------------------------------------------------------------------------------------------*/
+void StreamRelay::relayDatagram(int bytes) {
+    StreamPacketHeader header;
+    if (!StreamPacket::readHeader(spare->datagram, bytes, header)) {
+        stats.malformed++;
+        return;
+    }
+    stats.received++;
+    spare->bytes = bytes;
+    if (sendto(streamSocket, spare->datagram, bytes, 0, (struct sockaddr *)&destination, sizeof(destination)) == bytes) {
+        stats.forwarded++;
+        stats.bytes += bytes;
+    } else {
+        stats.linkDrops++;
+    }
+
+    StreamDescriptor received;
+    switch (header.type) {
+    case PACKET_AUDIO:
+        retransmitBuffer->keep(header.sequence, spare);
+        if (!sequenceKnown || (int32_t)(header.sequence + 1 - nextSequence) > 0) {
+            nextSequence = header.sequence + 1;
+            sequenceKnown = true;
+        }
+        spare = pool->acquire(nullptr, 0);
+        break;
+    case PACKET_DESCRIPTOR:
+        if (!StreamPacket::readDescriptor(spare->datagram + STREAM_HEADER_SIZE, header.length, received)) {
+            break;
+        }
+        // Descriptors repeat with the current sequence, so only a new format moves where it starts
+        if (!formatKnown || memcmp(&received, &format, sizeof(format)) != 0) {
+            format = received;
+            formatSequence = header.sequence;
+            formatKnown = true;
+        }
+        break;
+    case PACKET_TRACK_CHANGE:
+        memcpy(trackPacket, spare->datagram, bytes);
+        trackBytes = bytes;
+        break;
+    default:
+        break;
+    }
+}
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	serviceRepairs
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	void serviceRepairs()
+--
+-- RETURNS:     void
+--
+-- NOTES:
+--              Answers NACKs and join requests from listeners at this site the way a StreamChannel does,
+--              from the downlink's own history. Repairs asked for by several listeners are multicast to the
+--              local group once.
+--
+-------------------------------------------------------------------------------------------------------------------*/
+void StreamRelay::serviceRepairs() {
+    char request[DATA_BUFSIZE];
+    uint32_t sequences[NACK_MAX_SEQUENCES];
+    SOCKADDR_IN listener;
+    StreamPacketHeader header;
+
+    WSAResetEvent(repairEvent);
+    while (true) {
+        int listenerSize = sizeof(listener);
+        int bytes = recvfrom(repairSocket, request, sizeof(request), 0, (struct sockaddr*) &listener, &listenerSize);
+        if (bytes == SOCKET_ERROR) {
+            if (WSAGetLastError() == WSAECONNRESET) {
+                continue;
+            }
+            if (WSAGetLastError() != WSAEWOULDBLOCK) {
+                qDebug() << "relay repair recvfrom() failed with error \n" << WSAGetLastError();
+            }
+            return;
+        }
+        if (!StreamPacket::readHeader(request, bytes, header)) {
+            continue;
+        }
+        uint16_t burstMs;
+        if (header.type == PACKET_JOIN &&
+                StreamPacket::readJoin(request + STREAM_HEADER_SIZE, header.length, burstMs)) {
+            sendBurst(listener, burstMs);
+            continue;
+        }
+        if (header.type != PACKET_NACK) {
+            continue;
+        }
+
+        int count = StreamPacket::readNack(request + STREAM_HEADER_SIZE, header.length, sequences, NACK_MAX_SEQUENCES);
+        DWORD now = GetTickCount();
+        repairStats.nacksReceived++;
+        repairStats.sequencesRequested += count;
+        for (int i = 0; i < count; i++) {
+            const PooledPacket *repair = nullptr;
+            switch (retransmitBuffer->requestRepair(sequences[i], now, repair)) {
+            case RetransmitBuffer::REPAIR_UNICAST:
+                sendto(repairSocket, repair->datagram, repair->bytes, 0, (struct sockaddr *)&listener, sizeof(listener));
+                repairStats.repairsUnicast++;
+                repairStats.repairBytes += repair->bytes;
+                break;
+            case RetransmitBuffer::REPAIR_MULTICAST:
+                sendto(streamSocket, repair->datagram, repair->bytes, 0, (struct sockaddr *)&destination, sizeof(destination));
+                repairStats.repairsMulticast++;
+                repairStats.repairBytes += repair->bytes;
+                break;
+            case RetransmitBuffer::REPAIR_SUPPRESSED:
+                repairStats.repairsSuppressed++;
+                break;
+            default:
+                repairStats.repairsUnavailable++;
+                break;
+            }
+        }
+    }
+}
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	sendBurst
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	void sendBurst(const SOCKADDR_IN &listener, uint16_t burstMs)
+--                             listener - address the join request came from
+--                             burstMs - how much recent audio the listener asked for
+--
+-- RETURNS:     void
+--
+-- NOTES:
+--              The relay does not know the stream's byte rate, so the burst is measured with the timestamps
+--              the server put in the packets: it reaches back from the newest packet while the packets are
+--              no more than burstMs older. Otherwise it is sent like the server's burst, descriptor first and
+--              never reaching back past the last format change. Nothing is sent before a descriptor arrives.
+--
+-------------------------------------------------------------------------------------------------------------------*/
+void StreamRelay::sendBurst(const SOCKADDR_IN &listener, uint16_t burstMs) {
+    char packet[DATA_BUFSIZE];
+    StreamPacketHeader header;
+    if (!sequenceKnown || !formatKnown) {
+        return;
+    }
+    const PooledPacket *latest = retransmitBuffer->find(nextSequence - 1);
+    if (latest == nullptr || !StreamPacket::readHeader(latest->datagram, latest->bytes, header)) {
+        return;
+    }
+    uint32_t newest = header.timestamp;
+    uint32_t first = nextSequence - 1;
+    for (uint32_t back = 1; back < RETRANSMIT_RING_SIZE; back++) {
+        const PooledPacket *audio = retransmitBuffer->find(nextSequence - 1 - back);
+        if (audio == nullptr || !StreamPacket::readHeader(audio->datagram, audio->bytes, header) ||
+                newest - header.timestamp > burstMs) {
+            break;
+        }
+        first = nextSequence - 1 - back;
+    }
+    if ((int32_t)(first - formatSequence) < 0) {
+        first = formatSequence;
+    }
+    stats.joins++;
+
+    int bytes = StreamPacket::buildDescriptor(format, first, packet);
+    sendto(repairSocket, packet, bytes, 0, (struct sockaddr *)&listener, sizeof(listener));
+    if (trackBytes > 0) {
+        sendto(repairSocket, trackPacket, trackBytes, 0, (struct sockaddr *)&listener, sizeof(listener));
+    }
+    for (uint32_t next = first; next != nextSequence; next++) {
+        const PooledPacket *audio = retransmitBuffer->find(next);
+        if (audio != nullptr) {
+            sendto(repairSocket, audio->datagram, audio->bytes, 0, (struct sockaddr *)&listener, sizeof(listener));
+            stats.burstPackets++;
+        }
+    }
+}
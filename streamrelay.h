@@ -0,0 +1,92 @@
+#pragma once
+#include <winsock2.h>
+#include <windows.h>
+#include <string>
+#include <QString>
+#include <QDebug>
+#include "connectiondevice.h"
+#include "streampacket.h"
+#include "packetpool.h"
+#include "retransmitbuffer.h"
+
+#define RELAY_POOL_PACKETS 512
+#define RELAY_REPORT_MS 5000
+#define RELAY_RECONNECT_MS 2000
+#define RELAY_FRAME_HEADER 2
+#define RELAY_DEFAULT_TTL 2
+
+class StreamRelay {
+public:
+    enum Link
+    {
+        LINK_UDP,
+        LINK_TCP
+    };
+
+    struct Statistics {
+        DWORD received;
+        DWORD forwarded;
+        DWORD malformed;
+        DWORD linkDrops;
+        DWORD joins;
+        DWORD burstPackets;
+        uint64_t bytes;
+    };
+
+    StreamRelay(Link link);
+    ~StreamRelay();
+    StreamRelay(const StreamRelay&) = delete;
+    void operator=(const StreamRelay&) = delete;
+
+    static int runFromArguments(int argc, char *argv[]);
+    bool openUplink(const std::string &group, int port, const std::string &remoteHost, int remotePort);
+    bool openDownlink(int listenPort, const std::string &group, int port, int ttl);
+    void run();
+    void stop();
+    QString getStatistics() const;
+
+private:
+    Link link;
+    bool uplink = false;
+    volatile bool running = false;
+    SOCKET streamSocket = INVALID_SOCKET;
+    SOCKET linkSocket = INVALID_SOCKET;
+    SOCKET listenSocket = INVALID_SOCKET;
+    SOCKET repairSocket = INVALID_SOCKET;
+    WSAEVENT streamEvent = WSA_INVALID_EVENT;
+    WSAEVENT linkEvent = WSA_INVALID_EVENT;
+    WSAEVENT repairEvent = WSA_INVALID_EVENT;
+    WSAEVENT stopEvent = WSA_INVALID_EVENT;
+    SOCKADDR_IN linkAddress;
+    SOCKADDR_IN destination;
+    DWORD linkLostAt = 0;
+
+    PacketPool *pool = nullptr;
+    RetransmitBuffer *retransmitBuffer = nullptr;
+    PooledPacket *spare = nullptr;
+    char buffer[DATA_BUFSIZE];
+    char frameHeader[RELAY_FRAME_HEADER];
+    int frameRead = 0;
+    int frameLength = 0;
+    bool formatKnown = false;
+    StreamDescriptor format = {};
+    uint32_t formatSequence = 0;
+    char trackPacket[DATA_BUFSIZE];
+    int trackBytes = 0;
+    uint32_t nextSequence = 0;
+    bool sequenceKnown = false;
+    Statistics stats = {};
+    RepairStatistics repairStats = {};
+
+    static bool resolve(const std::string &host, int port, SOCKADDR_IN &address);
+    bool openEvent(SOCKET sock, WSAEVENT &event, long events);
+    bool connectLink();
+    void closeLink();
+    void forwardStream();
+    bool sendLink(const char *datagram, int bytes);
+    void acceptLink();
+    void readLink();
+    void relayDatagram(int bytes);
+    void serviceRepairs();
+    void sendBurst(const SOCKADDR_IN &listener, uint16_t burstMs);
+};
@@ -0,0 +1,526 @@
+/*------------------------------------------------------------------------------------------------------------------
+-- SOURCE FILE: 	tracksource.cpp - One playlist entry of a stream channel, opened ahead of time.
+--
+--
+-- PROGRAM: 		Communication Audio Program
+--
+-- FUNCTIONS:
+--                  TrackSource(const std::string &fileName, int index)
+--                  ~TrackSource()
+--                  DWORD prefetchThread(LPVOID lpParameter)
+--                  bool open()
+--                  int read(char *buf, int bytes)
+--                  void setOutputFormat(const StreamDescriptor &format)
+--                  bool seek(uint32_t positionMs)
+--                  uint32_t getPositionMs() const
+--                  uint32_t getLengthMs() const
+--                  int readFile(char *buf, int bytes)
+--                  int readSource(char *buf, int bytes)
+--                  bool openDecoded()
+--
+-- DATE: 			October 19, 2026
+--
+-- REVISIONS:       October 19, 2026 - Decode compressed tracks on a decode-ahead thread - agent
+--                  October 19, 2026 - Convert the audio to the channel's format - agent
+--                  October 19, 2026 - Seek to a time and report the position and length - agent
+--                  October 19, 2026 - Count the data left in 64 bits - agent
+--
+-- DESIGNER: 		agent
+--
+-- PROGRAMMER: 		agent
+--
+-- NOTES:
+--      A channel plays its playlist one TrackSource at a time. While one track plays the next one is opened on
+--      its own thread: the file is opened, the WAV header parsed and the first TRACK_PREFETCH_MS of audio read
+--      into memory. When the current track runs out the channel switches to the next one without touching the
+--      disk, so slow opens of large files never hold up the pacing thread.
+--
+--      Unlike FileHandler the file stays open for the life of the track, with a large stdio buffer, so reading
+--      a chunk is a copy out of the buffer most of the time.
+--
+--      Compressed tracks such as MP3 and FLAC are handed to a DecodeAhead instead, which decodes them to PCM on
+--      its own thread and keeps a few seconds ahead of the pacing thread.
+--
+--      Whatever the file holds, the channel can ask for its audio in another format with setOutputFormat(),
+--      and read() then passes it through a FormatConverter on the way out.
+--
+--      PCM has a fixed number of bytes per frame, so a time maps straight to an offset in the data chunk and
+--      a seek is one fseek however large the file is. A seek into the first TRACK_PREFETCH_MS is served from
+--      the prefetch buffer without touching the disk. Decoded tracks are sought through their DecodeAhead.
+--
+--      open() runs on the prefetch thread and everything else on the pacing thread. The pacing thread only
+--      touches a track after isReady() reports that open() has finished.
+--
+--------------------------------------------------------------------------------------------------------------------*/
+#include "tracksource.h"
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	TrackSource
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	TrackSource(const std::string &fileName, int index)
+--                          fileName - audio file of the track
+--                          index - position of the track in the playlist
+--
+-- RETURNS:     NA
+--
+-- NOTES:
+--              The title is the file name without its folder and extension.
+--
+-------------------------------------------------------------------------------------------------------------------*/
+TrackSource::TrackSource(const std::string &fileName, int index) : fileName(fileName), index(index) {
+    size_t start = fileName.find_last_of("/\\");
+    title = start == std::string::npos ? fileName : fileName.substr(start + 1);
+    size_t extension = title.find_last_of('.');
+    if (extension != std::string::npos && extension > 0) {
+        title = title.substr(0, extension);
+    }
+}
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	~TrackSource
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	~TrackSource()
+--
+-- RETURNS:     NA
+--
+-------------------------------------------------------------------------------------------------------------------*/
+TrackSource::~TrackSource() {
+    if (file != NULL) {
+        fclose(file);
+    }
+    delete decoder;
+    delete[] prefetch;
+}
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	prefetchThread
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	DWORD prefetchThread(LPVOID lpParameter)
+--                                   lpParameter - the TrackSource to open
+--
+-- RETURNS:     Returns true if the track can be streamed
+--
+-------------------------------------------------------------------------------------------------------------------*/
+DWORD WINAPI TrackSource::prefetchThread(LPVOID lpParameter) {
+    TrackSource *track = (TrackSource *)lpParameter;
+    return track->open() ? TRUE : FALSE;
+}
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	open
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:   October 19, 2026 - Hand compressed files to a decoder - agent
+--              October 19, 2026 - Note where the audio starts and how long it is, for seeking - agent
+--              October 19, 2026 - Rewind a raw file with _fseeki64 - agent
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	bool open()
+--
+-- RETURNS:     Returns false if the track cannot be streamed
+--
+-- NOTES:
+--              Opens the file, fills in the stream descriptor from its WAV header and reads the first
+--              TRACK_PREFETCH_MS of audio. Files without a WAV header are streamed from the start in the format
+--              the players used before descriptors existed. Compressed files are decoded instead. Marks the
+--              track ready whether or not it worked.
+--
+-------------------------------------------------------------------------------------------------------------------*/
+bool TrackSource::open() {
+    WavFormat wav;
+    if (DecodeAhead::handles(fileName)) {
+        bool opened = openDecoded();
+        InterlockedExchange(&ready, 1);
+        return opened;
+    }
+    if ((file = fopen(fileName.c_str(), "rb")) == NULL) {
+        qDebug() << "Failed to open track" << fileName.c_str() << "\n";
+        InterlockedExchange(&ready, 1);
+        return false;
+    }
+    setvbuf(file, NULL, _IOFBF, TRACK_FILE_BUFFER);
+    if (WavHeader::read(file, wav)) {
+        descriptor.sampleRate = (uint32_t)wav.sampleRate;
+        descriptor.channels = (uint8_t)wav.channels;
+        descriptor.sampleSize = (uint8_t)wav.bitsPerSample;
+        if (wav.isFloat) {
+            descriptor.sampleType = SAMPLE_FLOAT;
+        } else if (wav.bitsPerSample == 8) {
+            descriptor.sampleType = SAMPLE_UNSIGNED;
+        } else {
+            descriptor.sampleType = SAMPLE_SIGNED;
+        }
+        descriptor.frameSize = (uint16_t)wav.frameSize;
+        bytesRemaining = wav.dataSize;
+        dataOffset = wav.dataOffset;
+        dataSize = wav.dataSize;
+        if (dataSize < 0) {
+            // A header that was never finalized: the audio runs to the end of the file
+            _fseeki64(file, 0, SEEK_END);
+            dataSize = _ftelli64(file) - dataOffset;
+            _fseeki64(file, dataOffset, SEEK_SET);
+        }
+    } else {
+        qDebug() << "no WAV header, streaming raw 8000Hz stereo 16 bit \n";
+        descriptor.sampleRate = 8000;
+        descriptor.channels = 2;
+        descriptor.sampleSize = 16;
+        descriptor.sampleType = SAMPLE_UNSIGNED;
+        descriptor.frameSize = 4;
+        bytesRemaining = -1;
+        _fseeki64(file, 0, SEEK_END);
+        dataSize = _ftelli64(file);
+        _fseeki64(file, 0, SEEK_SET);
+    }
+
+    source = descriptor;
+    int frameSize = descriptor.frameSize;
+    int prefetchSize = (int)((uint64_t)descriptor.sampleRate * frameSize * TRACK_PREFETCH_MS / 1000);
+    prefetchSize -= prefetchSize % frameSize;
+    prefetch = new char[prefetchSize];
+    prefetchBytes = readFile(prefetch, prefetchSize);
+    usable = true;
+    InterlockedExchange(&ready, 1);
+    return true;
+}
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	openDecoded
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	bool openDecoded()
+--
+-- RETURNS:     Returns false if the file cannot be decoded
+--
+-- NOTES:
+--              Starts decoding and waits for the first TRACK_PREFETCH_MS of PCM, which stays in the decoder's
+--              ring rather than a prefetch buffer of its own.
+--
+-------------------------------------------------------------------------------------------------------------------*/
+bool TrackSource::openDecoded() {
+    decoder = new DecodeAhead(fileName);
+    if (!decoder->start(descriptor)) {
+        qDebug() << "Failed to decode track" << fileName.c_str() << "\n";
+        return false;
+    }
+    source = descriptor;
+    int prefetchSize = (int)((uint64_t)descriptor.sampleRate * descriptor.frameSize * TRACK_PREFETCH_MS / 1000);
+    if (!decoder->waitForAudio(prefetchSize, DECODE_OPEN_TIMEOUT_MS)) {
+        qDebug() << "No audio decoded from track" << fileName.c_str() << "\n";
+        return false;
+    }
+    usable = true;
+    return true;
+}
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	readFile
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:   October 19, 2026 - Read in the file's own format - agent
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	int readFile(char *buf, int bytes)
+--                           buf - destination
+--                           bytes - most bytes to read
+--
+-- RETURNS:     Returns the number of bytes read, always whole frames
+--
+-- NOTES:
+--              Stops at the end of the data chunk so trailing chunks such as LIST metadata are never played as
+--              samples. A partial frame at the end of the file is dropped.
+--
+-------------------------------------------------------------------------------------------------------------------*/
+int TrackSource::readFile(char *buf, int bytes) {
+    int frameSize = source.frameSize;
+    if (bytesRemaining >= 0 && bytesRemaining < bytes) {
+        bytes = (int)bytesRemaining;
+    }
+    bytes -= bytes % frameSize;
+    if (bytes <= 0) {
+        return 0;
+    }
+    int read = (int)fread(buf, 1, bytes, file);
+    read -= read % frameSize;
+    if (bytesRemaining >= 0) {
+        bytesRemaining -= read;
+    }
+    return read;
+}
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	read
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:   October 19, 2026 - Convert the audio to the output format - agent
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	int read(char *buf, int bytes)
+--                       buf - destination
+--                       bytes - most bytes to read, a multiple of the frame size
+--
+-- RETURNS:     Returns the number of bytes read, fewer than asked only at the end of the track
+--
+-- NOTES:
+--              Without a conversion this is readSource(). Otherwise about as much of the file as makes up the
+--              request is read and converted, and whatever the request does not take is kept for the next call.
+--
+-------------------------------------------------------------------------------------------------------------------*/
+int TrackSource::read(char *buf, int bytes) {
+    if (!converter.isActive()) {
+        return readSource(buf, bytes);
+    }
+    int read = 0;
+    while (read < bytes) {
+        if (convertedOffset >= convertedBytes) {
+            int want = converter.toInputBytes(bytes - read);
+            if (want < source.frameSize) {
+                want = source.frameSize;
+            }
+            raw.resize(want);
+            int length = readSource(raw.data(), want);
+            if (length <= 0) {
+                break;
+            }
+            converted = converter.convert(raw.data(), length);
+            convertedBytes = length;
+            convertedOffset = 0;
+            continue;
+        }
+        int count = convertedBytes - convertedOffset < bytes - read ? convertedBytes - convertedOffset : bytes - read;
+        memcpy(buf + read, converted + convertedOffset, count);
+        convertedOffset += count;
+        read += count;
+    }
+    return read;
+}
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	setOutputFormat
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	void setOutputFormat(const StreamDescriptor &format)
+--                                   format - PCM format read() should give out
+--
+-- RETURNS:     void
+--
+-- NOTES:
+--              Called on the pacing thread once the track is ready and before it is read. The descriptor
+--              becomes the output format, or stays the file's own if the file cannot be converted.
+--
+-------------------------------------------------------------------------------------------------------------------*/
+void TrackSource::setOutputFormat(const StreamDescriptor &format) {
+    descriptor = converter.setFormats(source, format) ? converter.getOutputFormat() : source;
+}
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	seek
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:   October 19, 2026 - Keep the data left in 64 bits past 2 GB - agent
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	bool seek(uint32_t positionMs)
+--                        positionMs - time in the track to carry on from
+--
+-- RETURNS:     Returns false if the track cannot seek there
+--
+-- NOTES:
+--              Called on the pacing thread, or with the pacing thread held off. A time past the end seeks to
+--              the end, so the next read ends the track. Audio converted but not yet read is dropped, and the
+--              converter starts again, since what comes next does not carry on from it.
+--
+-------------------------------------------------------------------------------------------------------------------*/
+bool TrackSource::seek(uint32_t positionMs) {
+    if (!usable) {
+        return false;
+    }
+    uint64_t frame = (uint64_t)positionMs * source.sampleRate / 1000;
+    if (decoder != nullptr) {
+        decoder->seek(frame * 1000000 / source.sampleRate);
+    } else {
+        int64_t offset = (int64_t)frame * source.frameSize;
+        if (dataSize >= 0 && offset > dataSize) {
+            offset = dataSize - dataSize % source.frameSize;
+        }
+        // The prefetched start stays in memory, so the file carries on from just after it
+        int64_t resume = offset < prefetchBytes ? prefetchBytes : offset;
+        if (_fseeki64(file, dataOffset + resume, SEEK_SET) != 0) {
+            qDebug() << "Failed to seek in track" << fileName.c_str() << "\n";
+            return false;
+        }
+        prefetchOffset = offset < prefetchBytes ? (int)offset : prefetchBytes;
+        if (bytesRemaining >= 0) {
+            bytesRemaining = dataSize - resume;
+        }
+        frame = (uint64_t)offset / source.frameSize;
+    }
+    framesRead = frame;
+    ended = false;
+    convertedBytes = 0;
+    convertedOffset = 0;
+    converter.reset();
+    return true;
+}
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	getPositionMs
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	uint32_t getPositionMs() const
+--
+-- RETURNS:     Returns how far into the track reading has got, in milliseconds
+--
+-------------------------------------------------------------------------------------------------------------------*/
+uint32_t TrackSource::getPositionMs() const {
+    if (source.sampleRate == 0) {
+        return 0;
+    }
+    return (uint32_t)(framesRead * 1000 / source.sampleRate);
+}
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	getLengthMs
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	uint32_t getLengthMs() const
+--
+-- RETURNS:     Returns the length of the track in milliseconds, or 0 if it is not known
+--
+-------------------------------------------------------------------------------------------------------------------*/
+uint32_t TrackSource::getLengthMs() const {
+    if (decoder != nullptr) {
+        int64_t duration = decoder->getDurationMs();
+        return duration > 0 ? (uint32_t)duration : 0;
+    }
+    if (dataSize < 0 || source.sampleRate == 0 || source.frameSize == 0) {
+        return 0;
+    }
+    return (uint32_t)((uint64_t)(dataSize / source.frameSize) * 1000 / source.sampleRate);
+}
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	readSource
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:   October 19, 2026 - Read decoded tracks from their decoder - agent
+--              October 19, 2026 - Split out of read() so the audio can be converted - agent
+--              October 19, 2026 - Count the frames read for the position - agent
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	int readSource(char *buf, int bytes)
+--                             buf - destination
+--                             bytes - most bytes to read, a multiple of the file's frame size
+--
+-- RETURNS:     Returns the number of bytes read, fewer than asked only at the end of the track
+--
+-- NOTES:
+--              Serves the prefetched audio first and then reads on from the file. A decoded track never
+--              waits for its decoder: if the decoder has fallen behind, the rest is filled with silence so the
+--              pacing schedule holds.
+--
+-------------------------------------------------------------------------------------------------------------------*/
+int TrackSource::readSource(char *buf, int bytes) {
+    int read = 0;
+    if (!usable || ended) {
+        return 0;
+    }
+    if (decoder != nullptr) {
+        read = decoder->read(buf, bytes);
+        framesRead += read / source.frameSize;
+        if (read < bytes) {
+            if (decoder->atEnd()) {
+                ended = true;
+            } else {
+                memset(buf + read, 0, bytes - read);
+                read = bytes;
+            }
+        }
+        return read;
+    }
+    if (prefetchOffset < prefetchBytes) {
+        read = prefetchBytes - prefetchOffset < bytes ? prefetchBytes - prefetchOffset : bytes;
+        memcpy(buf, prefetch + prefetchOffset, read);
+        prefetchOffset += read;
+    }
+    if (read < bytes) {
+        read += readFile(buf + read, bytes - read);
+    }
+    if (read < bytes) {
+        ended = true;
+    }
+    framesRead += read / source.frameSize;
+    return read;
+}
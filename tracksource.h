@@ -0,0 +1,82 @@
+#pragma once
+#include <windows.h>
+#include <cstdio>
+#include <string>
+#include <vector>
+#include <QDebug>
+#include "decodeahead.h"
+#include "formatconverter.h"
+#include "streampacket.h"
+#include "wavheader.h"
+
+#define TRACK_PREFETCH_MS 2000
+#define TRACK_FILE_BUFFER 65536
+
+class TrackSource {
+public:
+    TrackSource(const std::string &fileName, int index);
+    ~TrackSource();
+    TrackSource(const TrackSource&) = delete;
+    void operator=(const TrackSource&) = delete;
+
+    static DWORD WINAPI prefetchThread(LPVOID lpParameter);
+    bool open();
+    int read(char *buf, int bytes);
+    void setOutputFormat(const StreamDescriptor &format);
+    bool seek(uint32_t positionMs);
+    uint32_t getPositionMs() const;
+    uint32_t getLengthMs() const;
+
+    bool isReady() const {
+        return ready != 0;
+    }
+    bool isUsable() const {
+        return usable;
+    }
+    bool atEnd() const {
+        return ended && convertedOffset >= convertedBytes;
+    }
+    int getIndex() const {
+        return index;
+    }
+    const std::string &getTitle() const {
+        return title;
+    }
+    const StreamDescriptor &getDescriptor() const {
+        return descriptor;
+    }
+    DecodeAhead::Statistics getDecodeStatistics() const {
+        return decoder != nullptr ? decoder->getStatistics() : DecodeAhead::Statistics();
+    }
+    const FormatConverter::Statistics &getConvertStatistics() const {
+        return converter.getStatistics();
+    }
+
+private:
+    std::string fileName;
+    std::string title;
+    int index;
+    FILE *file = NULL;
+    DecodeAhead *decoder = nullptr;
+    StreamDescriptor descriptor = {};
+    StreamDescriptor source = {};
+    FormatConverter converter;
+    std::vector<char> raw;
+    const char *converted = nullptr;
+    int convertedBytes = 0;
+    int convertedOffset = 0;
+    int64_t bytesRemaining = -1;
+    int64_t dataOffset = 0;
+    int64_t dataSize = -1;
+    uint64_t framesRead = 0;
+    char *prefetch = nullptr;
+    int prefetchBytes = 0;
+    int prefetchOffset = 0;
+    bool usable = false;
+    bool ended = false;
+    volatile LONG ready = 0;
+
+    int readFile(char *buf, int bytes);
+    int readSource(char *buf, int bytes);
+    bool openDecoded();
+};
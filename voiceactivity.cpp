@@ -0,0 +1,255 @@
+/*------------------------------------------------------------------------------------------------------------------
+-- SOURCE FILE: 	voiceactivity.cpp - Tells speech from silence on the mic, and fills silence on the speaker.
+--
+--
+-- PROGRAM: 		Communication Audio Program
+--
+-- FUNCTIONS:
+--                  bool VoiceActivity::setFormat(const StreamDescriptor &format)
+--                  bool VoiceActivity::isSpeech(const char *pcm, int bytes)
+--                  uint8_t VoiceActivity::getNoiseLevel() const
+--                  bool ComfortNoise::setFormat(const StreamDescriptor &format)
+--                  void ComfortNoise::setLevel(uint8_t level)
+--                  int ComfortNoise::generate(char *pcm, int frames)
+--
+-- DATE: 			October 19, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: 		agent
+--
+-- PROGRAMMER: 		agent
+--
+-- NOTES:
+--      People on a call are quiet most of the time, and sending their silence costs as much as sending their
+--      voice. VoiceActivity looks at each captured frame before it is encoded and says whether it holds speech.
+--      It measures the frame's energy and how often the signal crosses zero, and compares the energy with a
+--      running estimate of the background noise. A frame well above the background is voiced speech; one only
+--      somewhat above it but crossing zero often is a hiss like "s" or "f", which is quiet but still speech.
+--      The background estimate falls quickly to quieter frames and rises slowly through silent ones, so it
+--      follows a fan switching on without taking a word for background. Speech is held for VAD_HANGOVER_MS
+--      after the last speech frame so the ends of words are not cut off.
+--
+--      While the caller is silent, only a small comfort noise marker with the background's level is sent, every
+--      CNG_REFRESH_FRAMES frames. On the other side ComfortNoise plays noise at that level, since dead silence
+--      between words sounds like the call has dropped, and it keeps the player fed instead of letting it run
+--      dry. Both work on 16 bit PCM; other formats are always taken as speech and get no comfort noise.
+--
+--------------------------------------------------------------------------------------------------------------------*/
+#include "voiceactivity.h"
+
+static int16_t readSample(const char *pcm, uint16_t signFlip) {
+    uint16_t value;
+    memcpy(&value, pcm, 2);
+    return (int16_t)(value ^ signFlip);
+}
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	VoiceActivity::setFormat
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	bool setFormat(const StreamDescriptor &format)
+--                             format - format of the captured frames
+--
+-- RETURNS:     True if frames in the format can be checked for speech
+--
+-------------------------------------------------------------------------------------------------------------------*/
+bool VoiceActivity::setFormat(const StreamDescriptor &format) {
+    channels = format.channels;
+    active = format.sampleSize == 16 && format.sampleType != SAMPLE_FLOAT && channels > 0;
+    signFlip = format.sampleType == SAMPLE_UNSIGNED ? 0x8000 : 0;
+    hangoverFrames = (int)(format.sampleRate * VAD_HANGOVER_MS / 1000);
+    hangoverLeft = 0;
+    noiseKnown = false;
+    return active;
+}
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	VoiceActivity::isSpeech
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	bool isSpeech(const char *pcm, int bytes)
+--                            pcm - one captured frame
+--                            bytes - size of the frame
+--
+-- RETURNS:     True if the frame should be sent as voice
+--
+-- NOTES:
+--              Frames are taken one after another, so the background estimate and the hangover carry over.
+--              Zero crossings are counted on the first channel.
+--
+-------------------------------------------------------------------------------------------------------------------*/
+bool VoiceActivity::isSpeech(const char *pcm, int bytes) {
+    int frames = active ? bytes / (2 * channels) : 0;
+    if (frames == 0) {
+        return true;
+    }
+
+    int64_t sum = 0;
+    int crossings = 0;
+    int16_t previous = readSample(pcm, signFlip);
+    for (int i = 0; i < frames; i++) {
+        const char *frame = pcm + i * 2 * channels;
+        int16_t first = readSample(frame, signFlip);
+        if ((first < 0) != (previous < 0)) {
+            crossings++;
+        }
+        previous = first;
+        for (int c = 0; c < channels; c++) {
+            int32_t sample = readSample(frame + 2 * c, signFlip);
+            sum += sample * sample;
+        }
+    }
+    double energy = (double)sum / ((double)frames * channels * 32768.0 * 32768.0);
+    double zeroCrossings = (double)crossings / frames;
+
+    if (!noiseKnown) {
+        noiseEnergy = energy > VAD_NOISE_FLOOR ? energy : VAD_NOISE_FLOOR;
+        noiseKnown = true;
+    }
+    double ratio = energy / noiseEnergy;
+    bool speech = energy > VAD_MIN_ENERGY &&
+                  (ratio > VAD_SPEECH_RATIO || (ratio > VAD_FRICATIVE_RATIO && zeroCrossings > VAD_FRICATIVE_ZCR));
+
+    double rate = energy < noiseEnergy ? VAD_NOISE_FALL : VAD_NOISE_RISE;
+    if (speech) {
+        rate /= 10;
+    }
+    noiseEnergy += (energy - noiseEnergy) * rate;
+    if (noiseEnergy < VAD_NOISE_FLOOR) {
+        noiseEnergy = VAD_NOISE_FLOOR;
+    }
+
+    if (speech) {
+        hangoverLeft = hangoverFrames;
+    } else if (hangoverLeft > 0) {
+        hangoverLeft -= frames;
+        speech = true;
+    }
+    if (speech) {
+        stats.speechFrames++;
+    } else {
+        stats.silentFrames++;
+    }
+    return speech;
+}
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	VoiceActivity::getNoiseLevel
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	uint8_t getNoiseLevel() const
+--
+-- RETURNS:     The background noise level in dB below full scale, 0 to CNG_MAX_LEVEL
+--
+-------------------------------------------------------------------------------------------------------------------*/
+uint8_t VoiceActivity::getNoiseLevel() const {
+    double level = -10 * log10(noiseKnown ? noiseEnergy : VAD_NOISE_FLOOR);
+    if (level < 0) {
+        return 0;
+    }
+    return level > CNG_MAX_LEVEL ? CNG_MAX_LEVEL : (uint8_t)(level + 0.5);
+}
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	ComfortNoise::setFormat
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	bool setFormat(const StreamDescriptor &format)
+--                             format - format the noise is played in
+--
+-- RETURNS:     True if noise can be made in the format
+--
+-------------------------------------------------------------------------------------------------------------------*/
+bool ComfortNoise::setFormat(const StreamDescriptor &format) {
+    channels = format.channels;
+    active = format.sampleSize == 16 && format.sampleType != SAMPLE_FLOAT && channels > 0;
+    signFlip = format.sampleType == SAMPLE_UNSIGNED ? 0x8000 : 0;
+    return active;
+}
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	ComfortNoise::setLevel
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	void setLevel(uint8_t level)
+--                            level - noise level in dB below full scale
+--
+-- RETURNS:     void
+--
+-- NOTES:
+--              The noise is even between plus and minus its amplitude, whose power is a third of its square.
+--
+-------------------------------------------------------------------------------------------------------------------*/
+void ComfortNoise::setLevel(uint8_t level) {
+    double rms = 32768.0 * pow(10.0, -(double)level / 20);
+    double peak = rms * sqrt(3.0);
+    amplitude = peak > 32767 ? 32767 : (int)peak;
+}
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	ComfortNoise::generate
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	int generate(char *pcm, int frames)
+--                           pcm - destination for the noise
+--                           frames - number of frames to make
+--
+-- RETURNS:     Number of bytes written
+--
+-------------------------------------------------------------------------------------------------------------------*/
+int ComfortNoise::generate(char *pcm, int frames) {
+    if (!active) {
+        return 0;
+    }
+    int samples = frames * channels;
+    for (int i = 0; i < samples; i++) {
+        seed = seed * 1664525 + 1013904223;
+        int32_t noise = ((int32_t)(seed >> 16) - 32768) * amplitude / 32768;
+        uint16_t value = (uint16_t)(int16_t)noise ^ signFlip;
+        memcpy(pcm + 2 * i, &value, 2);
+    }
+    return samples * 2;
+}
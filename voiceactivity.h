@@ -0,0 +1,63 @@
+#pragma once
+#include <cstdint>
+#include <cstring>
+#include <cmath>
+#include "streampacket.h"
+
+#define VAD_HANGOVER_MS 240
+#define VAD_SPEECH_RATIO 8.0
+#define VAD_FRICATIVE_RATIO 2.0
+#define VAD_FRICATIVE_ZCR 0.3
+#define VAD_MIN_ENERGY 1e-6
+#define VAD_NOISE_FLOOR 1e-10
+#define VAD_NOISE_RISE 0.02
+#define VAD_NOISE_FALL 0.5
+#define CNG_REFRESH_FRAMES 10
+#define CNG_MAX_LEVEL 127
+
+class VoiceActivity {
+public:
+    struct Statistics {
+        uint32_t speechFrames = 0;
+        uint32_t silentFrames = 0;
+    };
+
+    bool setFormat(const StreamDescriptor &format);
+    bool isSpeech(const char *pcm, int bytes);
+    uint8_t getNoiseLevel() const;
+
+    bool isActive() const {
+        return active;
+    }
+    const Statistics &getStatistics() const {
+        return stats;
+    }
+
+private:
+    bool active = false;
+    int channels = 0;
+    uint16_t signFlip = 0;
+    int hangoverFrames = 0;
+    int hangoverLeft = 0;
+    double noiseEnergy = 0;
+    bool noiseKnown = false;
+    Statistics stats;
+};
+
+class ComfortNoise {
+public:
+    bool setFormat(const StreamDescriptor &format);
+    void setLevel(uint8_t level);
+    int generate(char *pcm, int frames);
+
+    bool isActive() const {
+        return active;
+    }
+
+private:
+    bool active = false;
+    int channels = 0;
+    uint16_t signFlip = 0;
+    int amplitude = 0;
+    uint32_t seed = 0x2545F491;
+};
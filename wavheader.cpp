@@ -0,0 +1,170 @@
+/*------------------------------------------------------------------------------------------------------------------
+-- SOURCE FILE: 	wavheader.cpp - Reads the RIFF header of a WAV file.
+--
+--
+-- PROGRAM: 		Communication Audio Program
+--
+-- FUNCTIONS:
+--                  bool read(FILE *file, WavFormat &format)
+--                  bool readFromFile(const std::string &fileName, WavFormat &format)
+--                  bool parseFormatChunk(const unsigned char *chunk, int size, WavFormat &format)
+--
+-- DATE: 			October 19, 2026
+--
+-- REVISIONS:       October 19, 2026 - Parse from an already open file - agent
+--                  October 19, 2026 - Keep offsets and sizes in 64 bits - agent
+--
+-- DESIGNER: 		agent
+--
+-- PROGRAMMER: 		agent
+--
+-- NOTES:
+--      A WAV file is a RIFF container: a 12 byte "RIFF....WAVE" preamble followed by chunks that each start with
+--      a 4 byte id and a 4 byte little endian size. The "fmt " chunk describes the samples and the "data" chunk
+--      holds them. Other chunks (LIST, fact, ...) may appear before or after the data and are skipped.
+--
+--------------------------------------------------------------------------------------------------------------------*/
+#include "wavheader.h"
+#include <cstring>
+
+static uint32_t readLE32(const unsigned char *b) {
+    return (uint32_t)b[0] | ((uint32_t)b[1] << 8) | ((uint32_t)b[2] << 16) | ((uint32_t)b[3] << 24);
+}
+
+static uint16_t readLE16(const unsigned char *b) {
+    return (uint16_t)(b[0] | (b[1] << 8));
+}
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	parseFormatChunk
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:   October 19, 2026 - Reject frames padded past their samples - agent
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	bool parseFormatChunk(const unsigned char *chunk, int size, WavFormat &format)
+--                                    chunk - body of the "fmt " chunk
+--                                    size - size of the chunk body
+--                                    format - filled in with the sample format
+--
+-- RETURNS:     Returns false if the samples are not integer PCM or IEEE float, or are padded within the frame
+--
+-- NOTES:
+--              WAVE_FORMAT_EXTENSIBLE files keep the real format in the first two bytes of the sub format GUID.
+--
+-------------------------------------------------------------------------------------------------------------------*/
+bool WavHeader::parseFormatChunk(const unsigned char *chunk, int size, WavFormat &format) {
+    if (size < 16) {
+        return false;
+    }
+    uint16_t formatTag = readLE16(chunk);
+    format.channels = readLE16(chunk + 2);
+    format.sampleRate = (int)readLE32(chunk + 4);
+    format.frameSize = readLE16(chunk + 12);
+    format.bitsPerSample = readLE16(chunk + 14);
+    if (formatTag == WAVE_FORMAT_EXTENSIBLE && size >= 26) {
+        formatTag = readLE16(chunk + 24);
+    }
+    format.isFloat = formatTag == WAVE_FORMAT_IEEE_FLOAT;
+    if (formatTag != WAVE_FORMAT_PCM && formatTag != WAVE_FORMAT_IEEE_FLOAT) {
+        return false;
+    }
+    if (format.channels < 1 || format.sampleRate < 1 || format.bitsPerSample < 8) {
+        return false;
+    }
+    if (format.frameSize < 1) {
+        format.frameSize = format.channels * (format.bitsPerSample / 8);
+    }
+    // Listeners only accept frames made of whole bytes per sample, with no padding
+    return format.bitsPerSample % 8 == 0 && format.frameSize == format.channels * (format.bitsPerSample / 8);
+}
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	read
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:   October 19, 2026 - Read from an open file so callers can keep it open - agent
+--              October 19, 2026 - Find the data with _ftelli64 and _fseeki64 - agent
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	bool read(FILE *file, WavFormat &format)
+--                        file - file positioned at the start of the RIFF preamble
+--                        format - filled in with the sample format and the location of the samples
+--
+-- RETURNS:     Returns false if the file is not a WAV file this program can stream
+--
+-- NOTES:
+--              Walks the chunk list until the data chunk and leaves the file positioned at the first sample.
+--              A data size of 0 or 0xFFFFFFFF (written by recorders that never finalized the header) is
+--              reported as -1, meaning read to the end of the file. Offsets are 64 bit, as long is 32 bits
+--              on Windows and a file may hold more than 2 GB of samples.
+--
+-------------------------------------------------------------------------------------------------------------------*/
+bool WavHeader::read(FILE *file, WavFormat &format) {
+    unsigned char preamble[12];
+    unsigned char chunkHeader[8];
+    unsigned char fmt[40];
+    bool haveFormat = false;
+    if (fread(preamble, 1, sizeof(preamble), file) != sizeof(preamble) ||
+            memcmp(preamble, "RIFF", 4) != 0 || memcmp(preamble + 8, "WAVE", 4) != 0) {
+        return false;
+    }
+
+    while (fread(chunkHeader, 1, sizeof(chunkHeader), file) == sizeof(chunkHeader)) {
+        uint32_t chunkSize = readLE32(chunkHeader + 4);
+        // Chunks are padded to an even size
+        int64_t skip = (int64_t)chunkSize + (int64_t)(chunkSize & 1);
+        if (memcmp(chunkHeader, "fmt ", 4) == 0) {
+            int toRead = chunkSize < sizeof(fmt) ? (int)chunkSize : (int)sizeof(fmt);
+            if ((int)fread(fmt, 1, toRead, file) != toRead) {
+                return false;
+            }
+            haveFormat = parseFormatChunk(fmt, toRead, format);
+            skip -= toRead;
+        } else if (memcmp(chunkHeader, "data", 4) == 0) {
+            format.dataOffset = _ftelli64(file);
+            format.dataSize = (chunkSize == 0 || chunkSize == 0xFFFFFFFF) ? -1 : (int64_t)chunkSize;
+            return haveFormat;
+        }
+        if (_fseeki64(file, skip, SEEK_CUR) != 0) {
+            return false;
+        }
+    }
+    return false;
+}
+
+/*-----------------------------------------------------------------------------------------------------------------
+-- Function:	readFromFile
+--
+-- DATE:		October 19, 2026
+--
+-- REVISIONS:   October 19, 2026 - Moved the parsing into read - agent
+--
+-- DESIGNER: 	agent
+--
+-- PROGRAMMER: 	agent
+--
+-- INTERFACE:	bool readFromFile(const std::string &fileName, WavFormat &format)
+--                                fileName - path to the file
+--                                format - filled in with the sample format and the location of the samples
+--
+-- RETURNS:     Returns false if the file cannot be opened or is not a WAV file this program can stream
+--
+-------------------------------------------------------------------------------------------------------------------*/
+bool WavHeader::readFromFile(const std::string &fileName, WavFormat &format) {
+    FILE *file = fopen(fileName.c_str(), "rb");
+    if (file == NULL) {
+        return false;
+    }
+    bool valid = read(file, format);
+    fclose(file);
+    return valid;
+}
@@ -0,0 +1,26 @@
+#pragma once
+#include <cstdint>
+#include <cstdio>
+#include <string>
+
+#define WAVE_FORMAT_PCM 0x0001
+#define WAVE_FORMAT_IEEE_FLOAT 0x0003
+#define WAVE_FORMAT_EXTENSIBLE 0xFFFE
+
+struct WavFormat
+{
+    int sampleRate;
+    int channels;
+    int bitsPerSample;
+    bool isFloat;
+    int frameSize;
+    int64_t dataOffset;
+    int64_t dataSize;
+};
+
+class WavHeader {
+public:
+    static bool read(FILE *file, WavFormat &format);
+    static bool readFromFile(const std::string &fileName, WavFormat &format);
+    static bool parseFormatChunk(const unsigned char *chunk, int size, WavFormat &format);
+};